@@ -86,6 +86,10 @@ type HistoryRunOptions struct {
 	DiffCacheSize   int
 	BlobArenaSize   string
 	MemoryBudget    string
+	DiffAlgorithm   string
+	NativeDiff      bool
+	SkipLargeBlobs  bool
+	PooledAlloc     bool
 
 	Checkpoint      *bool
 	CheckpointDir   string
@@ -137,6 +141,10 @@ type RunCommand struct {
 	diffCacheSize   int
 	blobArenaSize   string
 	memoryBudget    string
+	diffAlgorithm   string
+	nativeDiff      bool
+	skipLargeBlobs  bool
+	pooledAlloc     bool
 
 	checkpointDir   string
 	clearCheckpoint bool
@@ -222,6 +230,14 @@ func newRunCommandWithDeps(
 	cmd.Flags().IntVar(&rc.diffCacheSize, "diff-cache-size", 0, "Max diff cache entries (0 = default 10000)")
 	cmd.Flags().StringVar(&rc.blobArenaSize, "blob-arena-size", "", "Memory arena size for blob loading (e.g., '4MB'; empty = default 4MB)")
 	cmd.Flags().StringVar(&rc.memoryBudget, "memory-budget", "", "Memory budget for auto-tuning (e.g., '512MB', '2GB')")
+	cmd.Flags().StringVar(&rc.diffAlgorithm, "diff-algorithm", "",
+		"Line diff algorithm: myers, minimal, patience, histogram (empty = myers)")
+	cmd.Flags().BoolVar(&rc.nativeDiff, "native-diff", false,
+		"Diff myers, minimal and histogram with the native line engine instead of libgit2")
+	cmd.Flags().BoolVar(&rc.skipLargeBlobs, "skip-large-blobs", false,
+		"Never load blobs above 2% of the memory budget (min 16MB); analyzers skip them")
+	cmd.Flags().BoolVar(&rc.pooledAlloc, "pooled-alloc", false,
+		"Serve libgit2's small allocations from a size-class pool (experimental)")
 
 	cmd.Flags().Bool("checkpoint", true, "Enable checkpointing for crash recovery")
 	cmd.Flags().StringVar(&rc.checkpointDir, "checkpoint-dir", "", "Checkpoint directory (default: ~/.codefang/checkpoints)")
@@ -578,6 +594,10 @@ func (rc *RunCommand) buildHistoryRunOptions(cmd *cobra.Command) HistoryRunOptio
 		DiffCacheSize:   rc.diffCacheSize,
 		BlobArenaSize:   rc.blobArenaSize,
 		MemoryBudget:    rc.memoryBudget,
+		DiffAlgorithm:   rc.diffAlgorithm,
+		NativeDiff:      rc.nativeDiff,
+		SkipLargeBlobs:  rc.skipLargeBlobs,
+		PooledAlloc:     rc.pooledAlloc,
 		CheckpointDir:   rc.checkpointDir,
 		ClearCheckpoint: rc.clearCheckpoint,
 		DebugTrace:      rc.debugTrace,
@@ -637,7 +657,8 @@ func runHistoryAnalyzers(
 	defer stopProfiler()
 	defer framework.MaybeWriteHeapProfile(opts.HeapProfile, nil)
 
-	configureLibgit2MemoryLimits(opts.MemoryBudget)
+	configureLibgit2MemoryLimits(opts)
+	configureNativeParallelism()
 
 	result, err := initHistoryPipeline(ctx, path, analyzerIDs, format, opts)
 	if err != nil {
@@ -881,6 +902,13 @@ func executeHistoryPipeline(
 
 	coordConfig.FirstParent = opts.FirstParent
 
+	coordConfig.DiffAlgorithm, err = gitlib.ParseDiffAlgorithm(opts.DiffAlgorithm)
+	if err != nil {
+		return err
+	}
+
+	gitlib.ConfigureNativeLineDiff(opts.NativeDiff)
+
 	if !needsUAST(selectedLeaves) {
 		coordConfig.UASTPipelineWorkers = 0
 	}
@@ -983,9 +1011,69 @@ func createRunMetrics() (*observability.REDMetrics, *observability.AnalysisMetri
 		return nil, nil, fmt.Errorf("create analysis metrics: %w", err)
 	}
 
+	err = observability.RegisterNativeMetrics(meter, nativeStatsSnapshot)
+	if err != nil {
+		return nil, nil, fmt.Errorf("register native metrics: %w", err)
+	}
+
 	return red, analysis, nil
 }
 
+// nativeStatsSnapshot reads the gitlib C layer counters for observability.
+func nativeStatsSnapshot() observability.NativeStats {
+	stats := gitlib.ReadNativeStats()
+
+	bounds := make([]time.Duration, gitlib.LatencyBucketCount-1)
+	for i := range bounds {
+		bounds[i] = gitlib.LatencyBucketBound(i)
+	}
+
+	latency := func(op string, hist gitlib.LatencyHistogram) observability.NativeLatency {
+		return observability.NativeLatency{Op: op, Count: hist.Count, Sum: hist.Sum, Bounds: bounds, Buckets: hist.Buckets}
+	}
+
+	return observability.NativeStats{
+		ObjectsRead:   stats.ObjectsRead,
+		BytesInflated: stats.BytesInflated,
+		PreloadDedups: stats.PreloadDedups,
+		Diffs:         stats.Diffs,
+		DiffOps:       stats.DiffOps,
+		OpBufferGrows: stats.OpBufferGrows,
+		OpArenaBytes:  stats.OpArenaBytes,
+		TreeDiffs:     stats.TreeDiffs,
+		TreeDeltas:    stats.TreeDeltas,
+		PoolAllocs:    stats.PoolAllocs,
+		PoolFallbacks: stats.PoolFallbacks,
+		PoolBytes:     stats.PoolBytes,
+		Latencies: []observability.NativeLatency{
+			latency("object_read", stats.ObjectRead),
+			latency("diff", stats.Diff),
+			latency("tree_diff", stats.TreeDiff),
+		},
+		Repositories: nativeRepoSnapshot(),
+	}
+}
+
+// nativeRepoSnapshot reads the accounting of the live repository budgets.
+func nativeRepoSnapshot() []observability.NativeRepo {
+	budgets := gitlib.ReadRepoBudgetStats()
+
+	repos := make([]observability.NativeRepo, len(budgets))
+	for i, b := range budgets {
+		repos[i] = observability.NativeRepo{
+			Name:          b.Name,
+			Batches:       b.Batches,
+			BytesInflated: b.BytesInflated,
+			PeakBytes:     b.PeakBytes,
+			WindowBytes:   b.WindowBytes,
+			WindowCloses:  b.WindowCloses,
+			CacheBytes:    b.Cache.Bytes,
+		}
+	}
+
+	return repos
+}
+
 // recordRunCompletion records RED metrics for a completed (or failed) CLI run
 // and decrements the in-flight gauge.
 func recordRunCompletion(ctx context.Context, red *observability.REDMetrics, done func(), start time.Time, runErr error) {
@@ -1220,12 +1308,15 @@ func (rc *RunCommand) progressf(silent bool, writer io.Writer, format string, ar
 
 // configureLibgit2MemoryLimits sets libgit2 global mwindow and object cache
 // limits proportional to the memory budget. Must be called before opening
-// any repository handles. When budgetStr is empty, uses auto-detected budget.
-func configureLibgit2MemoryLimits(budgetStr string) {
+// any repository handles. When opts.MemoryBudget is empty, uses auto-detected
+// budget. Blobs above the budget's large blob threshold are skipped only with
+// opts.SkipLargeBlobs, since analyzers see no content for them, and the
+// pooled allocator is installed only with opts.PooledAlloc.
+func configureLibgit2MemoryLimits(opts HistoryRunOptions) {
 	var budgetBytes int64
 
-	if budgetStr != "" {
-		parsed, err := humanize.ParseBytes(budgetStr)
+	if opts.MemoryBudget != "" {
+		parsed, err := humanize.ParseBytes(opts.MemoryBudget)
 		if err == nil {
 			budgetBytes = framework.SafeInt64(parsed)
 		}
@@ -1241,18 +1332,40 @@ func configureLibgit2MemoryLimits(budgetStr string) {
 
 	limits := budget.NativeLimitsForBudget(budgetBytes)
 
-	err := gitlib.ConfigureMemoryLimits(limits.MwindowMappedLimit, limits.CacheMaxSize, limits.MallocArenaMax)
+	if !opts.SkipLargeBlobs {
+		limits.LargeBlobThreshold = 0
+	}
+
+	if !opts.PooledAlloc {
+		limits.AllocatorPoolSize = 0
+	}
+
+	err := gitlib.ConfigureMemoryLimits(limits.MwindowMappedLimit, limits.CacheMaxSize, limits.MallocArenaMax,
+		limits.AllocatorPoolSize)
 	if err != nil {
 		slog.Default().Warn("failed to configure libgit2 memory limits", "error", err)
 
 		return
 	}
 
+	gitlib.ConfigureLargeBlobThreshold(limits.LargeBlobThreshold)
+
 	slog.Default().Info("native memory limits configured",
 		"budget_mib", budgetBytes/budget.MiB,
 		"mwindow_limit_mib", limits.MwindowMappedLimit/budget.MiB,
 		"cache_limit_mib", limits.CacheMaxSize/budget.MiB,
-		"malloc_arena_max", limits.MallocArenaMax)
+		"malloc_arena_max", limits.MallocArenaMax,
+		"large_blob_mib", limits.LargeBlobThreshold/budget.MiB,
+		"alloc_pool_mib", limits.AllocatorPoolSize/budget.MiB)
+}
+
+// configureNativeParallelism lets the C batch operations share all CPUs.
+// The budget is process-wide, so concurrent workers split it instead of
+// each running a full thread team.
+func configureNativeParallelism() {
+	threads := gitlib.ConfigureParallelism(runtime.NumCPU())
+
+	slog.Default().Info("native batch parallelism configured", "threads", threads)
 }
 
 func suppressStandardLogger(silent bool) func() {
@@ -345,6 +345,7 @@ func TestRunCommand_ForwardsResourceTuningFlags(t *testing.T) {
 		"--diff-cache-size", "5000",
 		"--blob-arena-size", "8MB",
 		"--memory-budget", "2GB",
+		"--diff-algorithm", "histogram",
 	})
 
 	err := command.Execute()
@@ -356,6 +357,7 @@ func TestRunCommand_ForwardsResourceTuningFlags(t *testing.T) {
 	require.Equal(t, 5000, seenOptions.DiffCacheSize)
 	require.Equal(t, "8MB", seenOptions.BlobArenaSize)
 	require.Equal(t, "2GB", seenOptions.MemoryBudget)
+	require.Equal(t, "histogram", seenOptions.DiffAlgorithm)
 }
 
 func TestRunCommand_ForwardsCheckpointFlags(t *testing.T) {
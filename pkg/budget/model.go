@@ -56,6 +56,21 @@ const (
 	// MwindowCacheRatio controls how the native allocation is split:
 	// 80% for mwindow (mmap'd pack data), 20% for object cache.
 	MwindowCacheRatio = 80
+
+	// LargeBlobPercent is the fraction of the budget above which a single
+	// blob is never loaded whole; its lines are counted in chunks instead.
+	LargeBlobPercent = 2
+
+	// MinLargeBlobThreshold keeps small budgets from skipping ordinary files.
+	MinLargeBlobThreshold = 16 * MiB
+
+	// AllocatorPoolPercent is the fraction of the budget reserved for the
+	// pool serving libgit2's small allocations. Pool pages are committed
+	// as they are used and recycled by size class, never freed.
+	AllocatorPoolPercent = 5
+
+	// MinAllocatorPool keeps the pool useful under small budgets.
+	MinAllocatorPool = 64 * MiB
 )
 
 // DefaultMallocArenaMax limits glibc malloc arenas to prevent RSS bloat.
@@ -69,6 +84,8 @@ type NativeLimits struct {
 	MwindowMappedLimit int64
 	CacheMaxSize       int64
 	MallocArenaMax     int
+	LargeBlobThreshold int64
+	AllocatorPoolSize  int64
 }
 
 // NativeLimitsForBudget computes libgit2 memory limits proportional to the
@@ -86,6 +103,8 @@ func NativeLimitsForBudget(budget int64) NativeLimits {
 		MwindowMappedLimit: mwindow,
 		CacheMaxSize:       cache,
 		MallocArenaMax:     DefaultMallocArenaMax,
+		LargeBlobThreshold: max(budget*LargeBlobPercent/percentDivisor, MinLargeBlobThreshold),
+		AllocatorPoolSize:  max(budget*AllocatorPoolPercent/percentDivisor, MinAllocatorPool),
 	}
 }
 
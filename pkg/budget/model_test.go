@@ -97,3 +97,19 @@ func TestEstimateMemoryUsage_Monotonic_DiffCache(t *testing.T) {
 
 	assert.Greater(t, moreEstimate, baseEstimate, "larger diff cache should increase memory")
 }
+
+func TestNativeLimitsForBudget_LargeBlobThreshold(t *testing.T) {
+	t.Parallel()
+
+	assert.Equal(t, int64(4*GiB)*LargeBlobPercent/100, NativeLimitsForBudget(4*GiB).LargeBlobThreshold)
+	assert.Equal(t, int64(MinLargeBlobThreshold), NativeLimitsForBudget(256*MiB).LargeBlobThreshold)
+	assert.Zero(t, NativeLimitsForBudget(0).LargeBlobThreshold)
+}
+
+func TestNativeLimitsForBudget_AllocatorPoolSize(t *testing.T) {
+	t.Parallel()
+
+	assert.Equal(t, int64(4*GiB)*AllocatorPoolPercent/100, NativeLimitsForBudget(4*GiB).AllocatorPoolSize)
+	assert.Equal(t, int64(MinAllocatorPool), NativeLimitsForBudget(256*MiB).AllocatorPoolSize)
+	assert.Zero(t, NativeLimitsForBudget(0).AllocatorPoolSize)
+}
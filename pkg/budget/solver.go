@@ -3,8 +3,10 @@ package budget
 import (
 	"errors"
 	"runtime"
+	"time"
 
 	"github.com/Sumatoshi-tech/codefang/pkg/framework"
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
 )
 
 // Allocation proportions for budget distribution.
@@ -61,6 +63,14 @@ const (
 	// OptimalWorkerRatio is the percentage of CPU cores to use for workers.
 	// Testing shows ~60% provides optimal performance due to contention overhead.
 	OptimalWorkerRatio = 60
+
+	// TargetBatchLatency is the duration native batch calls are sized for:
+	// long enough to amortize the CGO crossing, short enough to keep the
+	// pipeline stages overlapping.
+	TargetBatchLatency = 20 * time.Millisecond
+
+	// MinBatchMemory is the smallest memory budget of one native batch call.
+	MinBatchMemory = 4 * MiB
 )
 
 // Solver errors.
@@ -119,7 +129,13 @@ func deriveKnobs(cacheAlloc, workerAlloc, bufferAlloc int64) framework.Coordinat
 	// Use default arena size.
 	arenaSize := DefaultArenaSize
 
+	// Batches: sized adaptively, each worker's in flight within its share of the buffers.
+	batchConfig := gitlib.DefaultBatchConfig()
+	batchConfig.TargetBatchLatency = TargetBatchLatency
+	batchConfig.BatchMemoryBudget = max(MinBatchMemory, bufferAlloc/int64(workers))
+
 	return framework.CoordinatorConfig{
+		BatchConfig:     batchConfig,
 		Workers:         workers,
 		BufferSize:      bufferSize,
 		CommitBatchSize: DefaultCommitBatchSize,
@@ -200,3 +200,19 @@ func TestDeriveKnobs_HugeWorkerAllocation(t *testing.T) {
 
 	assert.LessOrEqual(t, cfg.Workers, runtime.NumCPU(), "workers capped at CPU count")
 }
+
+func TestDeriveKnobs_BatchConfig(t *testing.T) {
+	t.Parallel()
+
+	cfg := deriveKnobs(0, 0, 0)
+
+	assert.Positive(t, cfg.BatchConfig.BlobBatchSize, "should keep default blob batch size")
+	assert.Positive(t, cfg.BatchConfig.DiffBatchSize, "should keep default diff batch size")
+	assert.Equal(t, TargetBatchLatency, cfg.BatchConfig.TargetBatchLatency)
+	assert.Equal(t, int64(MinBatchMemory), cfg.BatchConfig.BatchMemoryBudget, "should use min batch memory")
+
+	cfg = deriveKnobs(100*MiB, 100*MiB, 1*GiB)
+
+	assert.Equal(t, 1*GiB/int64(cfg.Workers), cfg.BatchConfig.BatchMemoryBudget,
+		"should split buffer allocation across workers")
+}
@@ -71,6 +71,12 @@ func (m *Manager) CheckpointDir() string {
 	return filepath.Join(m.BaseDir, m.RepoHash)
 }
 
+// DiffStorePath returns the path of the repository's persistent diff store.
+// It sits beside the checkpoint directory, so Clear keeps it.
+func (m *Manager) DiffStorePath() string {
+	return filepath.Join(m.BaseDir, m.RepoHash+".diffs")
+}
+
 // MetadataPath returns the path to the metadata file.
 func (m *Manager) MetadataPath() string {
 	return filepath.Join(m.CheckpointDir(), "checkpoint.json")
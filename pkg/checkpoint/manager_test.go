@@ -40,6 +40,15 @@ func TestManager_MetadataPath(t *testing.T) {
 	assert.Equal(t, expected, m.MetadataPath())
 }
 
+func TestManager_DiffStorePath(t *testing.T) {
+	t.Parallel()
+
+	dir := t.TempDir()
+	m := NewManager(dir, "abc123")
+	assert.Equal(t, filepath.Join(dir, "abc123.diffs"), m.DiffStorePath())
+	assert.NotEqual(t, m.CheckpointDir(), filepath.Dir(m.DiffStorePath()))
+}
+
 func TestManager_Exists_NoCheckpoint(t *testing.T) {
 	t.Parallel()
 
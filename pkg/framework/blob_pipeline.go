@@ -28,6 +28,17 @@ type BlobPipeline struct {
 	WorkerCount    int
 	BlobCache      *GlobalBlobCache
 	ArenaSize      int
+	// BorrowBlobs makes workers lend libgit2's decompressed object buffers
+	// instead of copying blobs into arenas. Blob data then stays valid only
+	// while the CachedBlob holding it is reachable.
+	BorrowBlobs bool
+	// BatchTreeDiffs sends one TreeDiffBatchRequest per worker for each
+	// commit batch instead of one TreeDiffRequest per commit.
+	BatchTreeDiffs bool
+	// Sizer, if set, caps the blobs per request at sizes picked from the
+	// cost of earlier requests; otherwise each worker gets one request per
+	// commit batch.
+	Sizer *gitlib.BatchSizer
 }
 
 // NewBlobPipeline creates a new blob pipeline.
@@ -114,49 +125,10 @@ func (p *BlobPipeline) runProducer(ctx context.Context, commits <-chan CommitBat
 func (p *BlobPipeline) processBatch(
 	ctx context.Context, batch CommitBatch, previousHash gitlib.Hash, jobs chan<- blobJob,
 ) gitlib.Hash {
-	// First pass: Dispatch all tree diffs in parallel to the worker pool.
-	type treeDiffJob struct {
-		index    int
-		commit   *gitlib.Commit
-		respChan chan gitlib.TreeDiffResponse
-	}
-
-	diffJobs := make([]treeDiffJob, len(batch.Commits))
-
-	for i, commit := range batch.Commits {
-		respChan := make(chan gitlib.TreeDiffResponse, 1)
-
-		// With first-parent walk, previous in stream equals parent; diff base must match burndown state.
-		var prevHash gitlib.Hash
-
-		switch {
-		case commit.NumParents() > 0:
-			prevHash = commit.ParentHash(0)
-		case i > 0:
-			prevHash = batch.Commits[i-1].Hash()
-		default:
-			prevHash = previousHash
-		}
-
-		req := gitlib.TreeDiffRequest{
-			Ctx:                ctx,
-			PreviousCommitHash: prevHash,
-			CommitHash:         commit.Hash(),
-			Response:           respChan,
-		}
-
-		// Send to POOL workers for parallelism.
-		select {
-		case p.PoolWorkerChan <- req:
-		case <-ctx.Done():
-			return gitlib.Hash{}
-		}
-
-		diffJobs[i] = treeDiffJob{
-			index:    i,
-			commit:   commit,
-			respChan: respChan,
-		}
+	// First pass: tree diffs for every commit, in parallel on the worker pool.
+	responses, ok := p.treeDiffs(ctx, batch, previousHash)
+	if !ok {
+		return gitlib.Hash{}
 	}
 
 	// Collect Tree Diffs.
@@ -165,8 +137,8 @@ func (p *BlobPipeline) processBatch(
 
 	var lastCommitHash gitlib.Hash
 
-	for i, job := range diffJobs {
-		resp := <-job.respChan
+	for i, commit := range batch.Commits {
+		resp := responses[i]
 
 		// Helper to free tree if we don't need it (we don't pass it forward anymore).
 		if resp.CurrentTree != nil {
@@ -175,8 +147,8 @@ func (p *BlobPipeline) processBatch(
 
 		bJob := blobJob{
 			data: BlobData{
-				Commit:  job.commit,
-				Index:   batch.StartIndex + job.index,
+				Commit:  commit,
+				Index:   batch.StartIndex + i,
 				Changes: resp.Changes,
 				Error:   resp.Error,
 			},
@@ -192,7 +164,7 @@ func (p *BlobPipeline) processBatch(
 		}
 
 		batchJobs[i] = bJob
-		lastCommitHash = job.commit.Hash()
+		lastCommitHash = commit.Hash()
 	}
 
 	// Identify missing blobs across the entire batch.
@@ -224,6 +196,11 @@ func (p *BlobPipeline) processBatch(
 		chunkCount = p.WorkerCount
 	}
 
+	if p.Sizer != nil {
+		size := p.Sizer.Size()
+		chunkCount = max(chunkCount, (len(missingHashes)+size-1)/size)
+	}
+
 	chunks := make([][]gitlib.Hash, chunkCount)
 	for i, h := range missingHashes {
 		idx := i % chunkCount
@@ -236,14 +213,16 @@ func (p *BlobPipeline) processBatch(
 			continue
 		}
 
-		// Allocate arena for this batch
-		// We allocate one arena per request. It will be passed to CGO to fill.
-		arena := make([]byte, p.ArenaSize)
-
 		req := gitlib.BlobBatchRequest{
 			Ctx:    ctx,
 			Hashes: chunk,
-			Arena:  arena,
+			Borrow: p.BorrowBlobs,
+		}
+
+		if !p.BorrowBlobs {
+			// Allocate arena for this batch
+			// We allocate one arena per request. It will be passed to CGO to fill.
+			req.Arena = make([]byte, p.ArenaSize)
 		}
 		respChan := make(chan gitlib.BlobBatchResponse, 1)
 		req.Response = respChan
@@ -280,6 +259,112 @@ func (p *BlobPipeline) processBatch(
 	return lastCommitHash
 }
 
+// diffBase returns the commit the i-th commit of a batch is diffed against.
+// With first-parent walk, previous in stream equals parent; diff base must match burndown state.
+func diffBase(batch CommitBatch, i int, previousHash gitlib.Hash) gitlib.Hash {
+	commit := batch.Commits[i]
+
+	switch {
+	case commit.NumParents() > 0:
+		return commit.ParentHash(0)
+	case i > 0:
+		return batch.Commits[i-1].Hash()
+	default:
+		return previousHash
+	}
+}
+
+// treeDiffs computes the tree diff of every commit in the batch on the pool
+// workers and returns the responses in commit order. Returns false if the
+// context was cancelled while dispatching.
+func (p *BlobPipeline) treeDiffs(
+	ctx context.Context, batch CommitBatch, previousHash gitlib.Hash,
+) ([]gitlib.TreeDiffResponse, bool) {
+	if p.BatchTreeDiffs {
+		return p.batchTreeDiffs(ctx, batch, previousHash)
+	}
+
+	respChans := make([]chan gitlib.TreeDiffResponse, len(batch.Commits))
+
+	for i, commit := range batch.Commits {
+		respChan := make(chan gitlib.TreeDiffResponse, 1)
+
+		req := gitlib.TreeDiffRequest{
+			Ctx:                ctx,
+			PreviousCommitHash: diffBase(batch, i, previousHash),
+			CommitHash:         commit.Hash(),
+			Response:           respChan,
+		}
+
+		// Send to POOL workers for parallelism.
+		select {
+		case p.PoolWorkerChan <- req:
+		case <-ctx.Done():
+			return nil, false
+		}
+
+		respChans[i] = respChan
+	}
+
+	responses := make([]gitlib.TreeDiffResponse, len(batch.Commits))
+	for i, respChan := range respChans {
+		responses[i] = <-respChan
+	}
+
+	return responses, true
+}
+
+// batchTreeDiffs splits the batch into one contiguous run of commits per
+// worker and diffs each run with a single TreeDiffBatchRequest. Contiguous
+// runs let the C layer reuse each commit's tree as the next commit's base.
+func (p *BlobPipeline) batchTreeDiffs(
+	ctx context.Context, batch CommitBatch, previousHash gitlib.Hash,
+) ([]gitlib.TreeDiffResponse, bool) {
+	commitCount := len(batch.Commits)
+	workers := max(p.WorkerCount, 1)
+	chunkSize := max((commitCount+workers-1)/workers, 1)
+
+	type chunk struct {
+		start    int
+		respChan chan gitlib.TreeDiffBatchResponse
+	}
+
+	chunks := make([]chunk, 0, workers)
+
+	for start := 0; start < commitCount; start += chunkSize {
+		end := min(start+chunkSize, commitCount)
+
+		requests := make([]gitlib.CommitDiffRequest, 0, end-start)
+		for i := start; i < end; i++ {
+			requests = append(requests, gitlib.CommitDiffRequest{
+				CommitHash: batch.Commits[i].Hash(),
+				ParentHash: diffBase(batch, i, previousHash),
+			})
+		}
+
+		respChan := make(chan gitlib.TreeDiffBatchResponse, 1)
+
+		select {
+		case p.PoolWorkerChan <- gitlib.TreeDiffBatchRequest{Ctx: ctx, Requests: requests, Response: respChan}:
+		case <-ctx.Done():
+			return nil, false
+		}
+
+		chunks = append(chunks, chunk{start: start, respChan: respChan})
+	}
+
+	responses := make([]gitlib.TreeDiffResponse, commitCount)
+
+	for _, c := range chunks {
+		resp := <-c.respChan
+		for j, res := range resp.Results {
+			responses[c.start+j] = gitlib.TreeDiffResponse{Changes: res.Changes, Error: res.Error}
+		}
+	}
+
+	return responses, true
+}
+
 // runConsumer waits for blob responses and outputs blob data.
 func (p *BlobPipeline) runConsumer(ctx context.Context, jobs <-chan blobJob, out chan<- BlobData) {
 	defer close(out)
@@ -332,6 +417,10 @@ func (p *BlobPipeline) collectBlobResponse(ctx context.Context, job *blobJob) bo
 		for _, ch := range job.batchState.respChans {
 			select {
 			case resp := <-ch:
+				if p.Sizer != nil {
+					p.Sizer.Observe(resp.Cost)
+				}
+
 				// So we can just use resp.Blobs.
 				for _, blob := range resp.Blobs {
 					if blob != nil {
@@ -2,6 +2,7 @@ package framework_test
 
 import (
 	"context"
+	"sync/atomic"
 	"testing"
 	"time"
 
@@ -132,3 +133,150 @@ func TestBlobPipeline_CrossCommitBatching(t *testing.T) {
 		t.Errorf("Expected 2 output items, got %d", count)
 	}
 }
+
+func TestBlobPipeline_BorrowBlobs(t *testing.T) {
+	t.Parallel()
+
+	poolCh := make(chan gitlib.WorkerRequest, 10)
+
+	pipeline := framework.NewBlobPipeline(nil, poolCh, 10, 1)
+	pipeline.BorrowBlobs = true
+
+	blobHash := gitlib.Hash{0: 0xA}
+	commit := gitlib.NewCommitForTest(gitlib.Hash{0: 0x1})
+
+	inputCh := make(chan framework.CommitBatch, 1)
+	inputCh <- framework.CommitBatch{Commits: []*gitlib.Commit{commit}}
+
+	close(inputCh)
+
+	ctx, cancel := context.WithTimeout(context.Background(), 2*time.Second)
+	defer cancel()
+
+	outCh := pipeline.Process(ctx, inputCh)
+
+	go func() {
+		for {
+			select {
+			case req := <-poolCh:
+				switch typed := req.(type) {
+				case gitlib.TreeDiffRequest:
+					typed.Response <- gitlib.TreeDiffResponse{
+						Changes: gitlib.Changes{{Action: gitlib.Insert, To: gitlib.ChangeEntry{Hash: blobHash}}},
+					}
+				case gitlib.BlobBatchRequest:
+					if !typed.Borrow {
+						t.Error("expected Borrow to be set")
+					}
+
+					if typed.Arena != nil {
+						t.Error("expected no arena when borrowing")
+					}
+
+					typed.Response <- gitlib.BlobBatchResponse{
+						Blobs: []*gitlib.CachedBlob{gitlib.NewCachedBlobWithHashForTest(blobHash, []byte("data"))},
+					}
+				}
+			case <-ctx.Done():
+				return
+			}
+		}
+	}()
+
+	count := 0
+
+	for data := range outCh {
+		count++
+
+		if data.BlobCache[blobHash] == nil {
+			t.Error("expected borrowed blob in commit blob cache")
+		}
+	}
+
+	if count != 1 {
+		t.Errorf("Expected 1 output item, got %d", count)
+	}
+}
+
+func TestBlobPipeline_BatchTreeDiffs(t *testing.T) {
+	t.Parallel()
+
+	poolCh := make(chan gitlib.WorkerRequest, 10)
+
+	pipeline := framework.NewBlobPipeline(nil, poolCh, 10, 2)
+	pipeline.BatchTreeDiffs = true
+
+	commits := []*gitlib.Commit{
+		gitlib.NewCommitForTest(gitlib.Hash{0: 0x1}),
+		gitlib.NewCommitForTest(gitlib.Hash{0: 0x2}),
+		gitlib.NewCommitForTest(gitlib.Hash{0: 0x3}),
+	}
+
+	inputCh := make(chan framework.CommitBatch, 1)
+	inputCh <- framework.CommitBatch{Commits: commits}
+
+	close(inputCh)
+
+	ctx, cancel := context.WithTimeout(context.Background(), 2*time.Second)
+	defer cancel()
+
+	outCh := pipeline.Process(ctx, inputCh)
+
+	var treeRequests atomic.Int32
+
+	go func() {
+		for {
+			select {
+			case req := <-poolCh:
+				switch typed := req.(type) {
+				case gitlib.TreeDiffRequest:
+					t.Error("expected batched tree diff requests only")
+				case gitlib.TreeDiffBatchRequest:
+					treeRequests.Add(1)
+
+					results := make([]gitlib.CommitDiffResult, len(typed.Requests))
+					for i, r := range typed.Requests {
+						// Blob hash derived from the commit so outputs can be matched.
+						results[i].Changes = gitlib.Changes{
+							{Action: gitlib.Insert, To: gitlib.ChangeEntry{Hash: gitlib.Hash{0: r.CommitHash[0] + 0x10}}},
+						}
+					}
+
+					typed.Response <- gitlib.TreeDiffBatchResponse{Results: results}
+				case gitlib.BlobBatchRequest:
+					blobs := make([]*gitlib.CachedBlob, len(typed.Hashes))
+					for i, h := range typed.Hashes {
+						blobs[i] = gitlib.NewCachedBlobWithHashForTest(h, []byte("data"))
+					}
+
+					typed.Response <- gitlib.BlobBatchResponse{Blobs: blobs}
+				}
+			case <-ctx.Done():
+				return
+			}
+		}
+	}()
+
+	count := 0
+
+	for data := range outCh {
+		count++
+
+		want := gitlib.Hash{0: data.Commit.Hash()[0] + 0x10}
+		if len(data.Changes) != 1 || data.Changes[0].To.Hash != want {
+			t.Errorf("commit %d: unexpected changes %v", data.Index, data.Changes)
+		}
+
+		if data.BlobCache[want] == nil {
+			t.Errorf("commit %d: expected blob in commit blob cache", data.Index)
+		}
+	}
+
+	if count != len(commits) {
+		t.Errorf("Expected %d output items, got %d", len(commits), count)
+	}
+
+	if n := treeRequests.Load(); n == 0 || n > 2 {
+		t.Errorf("Expected one batched tree diff request per worker, got %d", n)
+	}
+}
@@ -73,6 +73,10 @@ type PipelineStats struct {
 	BlobCacheMisses int64
 	DiffCacheHits   int64
 	DiffCacheMisses int64
+
+	ObjectCacheHits      int64
+	ObjectCacheMisses    int64
+	ObjectCacheEvictions int64
 }
 
 // Add accumulates another PipelineStats into this one (cross-chunk aggregation).
@@ -84,6 +88,9 @@ func (s *PipelineStats) Add(other PipelineStats) {
 	s.BlobCacheMisses += other.BlobCacheMisses
 	s.DiffCacheHits += other.DiffCacheHits
 	s.DiffCacheMisses += other.DiffCacheMisses
+	s.ObjectCacheHits += other.ObjectCacheHits
+	s.ObjectCacheMisses += other.ObjectCacheMisses
+	s.ObjectCacheEvictions += other.ObjectCacheEvictions
 }
 
 // CoordinatorConfig configures the pipeline coordinator.
@@ -104,18 +111,70 @@ type CoordinatorConfig struct {
 	// Set to 0 to disable caching.
 	BlobCacheSize int64
 
+	// ObjectCacheSize is the byte budget of the C-side cache of decompressed
+	// blobs shared by all worker repository handles. Unlike BlobCacheSize it
+	// also serves the diff stage and never copies blob data. Set to 0 to
+	// disable it.
+	ObjectCacheSize int64
+
 	// DiffCacheSize is the maximum number of diff results to cache.
 	// Set to 0 to disable caching.
 	DiffCacheSize int
 
+	// DiffStore persists diff results across runs, so incremental runs only
+	// diff new history. Shared by every coordinator of a run; the caller
+	// opens and closes it. Unused when DiffCacheSize is 0 or FusedDiffs is set.
+	DiffStore *DiffStore
+
 	// BlobArenaSize is the size of the memory arena for blob loading.
 	// Defaults to 16MB if 0.
 	BlobArenaSize int
 
+	// BorrowBlobs lends libgit2's object buffers to the pipeline instead of
+	// copying each blob into an arena. Worth enabling when analyzers read
+	// each blob once; BlobArenaSize is unused when set.
+	BorrowBlobs bool
+
+	// FusedDiffs computes changes, blobs and line diffs of each run of
+	// commits in one native call per worker instead of separate blob and diff
+	// stages. BlobCacheSize, DiffCacheSize and BorrowBlobs are unused when
+	// set; ObjectCacheSize serves repeated blobs instead.
+	FusedDiffs bool
+
+	// SkipBlobData keeps blob contents out of CommitData.BlobCache in fused
+	// mode. Only safe when no analyzer reads blobs; ignored when the UAST
+	// pipeline stage is enabled.
+	SkipBlobData bool
+
+	// TreeDiffFilter drops changes by path, subtree or blob size inside the
+	// native tree diff, before their paths or blobs reach Go. Applies to the
+	// batched tree diffs of the pool workers; zero keeps every change.
+	TreeDiffFilter gitlib.TreeDiffFilterOptions
+
+	// DiffAlgorithm selects the line matching algorithm for blob diffs.
+	// Defaults to Myers; patience or histogram avoid Myers' quadratic
+	// blowup on large, heavily rewritten files.
+	DiffAlgorithm gitlib.DiffAlgorithm
+
+	// RepoBudget bounds the native memory of this repository when several
+	// are scanned in one process. It is attached to every repository handle
+	// for the run, serves as the object cache if it has one (ObjectCacheSize
+	// is then unused), and its ArenaBytes caps BlobArenaSize and the batch
+	// memory budget. The caller owns it, and releases its pack windows
+	// between runs once ReleaseDue; nil scans without a budget. It is
+	// set by embedders that scan several repositories in one process; the
+	// CLI scans one repository and leaves it nil.
+	RepoBudget *gitlib.RepoBudget
+
 	// UASTPipelineWorkers is the number of goroutines for parallel UAST parsing
 	// in the pipeline stage. Set to 0 to disable the UAST pipeline stage.
 	UASTPipelineWorkers int
 
+	// UASTTreeCacheSize is the number of per-path tree-sitter trees kept so
+	// modified files are reparsed incrementally from their line diffs.
+	// Set to 0 to parse every version from scratch.
+	UASTTreeCacheSize int
+
 	// LeafWorkers is the number of goroutines for parallel leaf analyzer consumption.
 	// Each worker processes a disjoint subset of commits via Fork/Merge.
 	// Set to 0 to disable parallel leaf consumption (serial path).
@@ -178,7 +237,7 @@ const (
 // accurately compute how much memory remains for analyzer state growth.
 func (c CoordinatorConfig) EstimatedOverhead() int64 {
 	workers := int64(c.Workers) * (repoHandleSize + int64(c.BlobArenaSize) + workerNativeOverhead)
-	caches := c.BlobCacheSize + int64(c.DiffCacheSize)*avgDiffEntrySize
+	caches := c.BlobCacheSize + c.ObjectCacheSize + int64(c.DiffCacheSize)*avgDiffEntrySize
 	buffers := int64(c.BufferSize) * avgCommitDataSize
 
 	return runtimeOverhead + workers + caches + buffers
@@ -196,14 +255,17 @@ type Coordinator struct {
 	commitStreamer *CommitStreamer
 	blobPipeline   *BlobPipeline
 	diffPipeline   *DiffPipeline
+	fusedPipeline  *FusedPipeline
 	uastPipeline   *UASTPipeline
 	blobCache      *GlobalBlobCache
 	diffCache      *DiffCache
+	objectCache    *gitlib.ObjectCache
+	treeDiffFilter *gitlib.TreeDiffFilter
+	budgetCache    gitlib.ObjectCacheStats
 
 	// Workers.
-	seqWorker   *gitlib.Worker
-	poolWorkers []*gitlib.Worker
-	poolRepos   []*gitlib.Repository
+	seqWorker  *gitlib.Worker
+	workerPool *gitlib.WorkerPool
 
 	// Channels.
 	seqRequests  chan gitlib.WorkerRequest
@@ -224,25 +286,18 @@ func NewCoordinator(repo *gitlib.Repository, config CoordinatorConfig) *Coordina
 		config.Workers = 1
 	}
 
+	applyArenaLimit(&config)
+
 	seqChan := make(chan gitlib.WorkerRequest, config.BufferSize)
 	poolChan := make(chan gitlib.WorkerRequest, config.BufferSize*config.Workers)
 
 	// Sequential worker uses the main repo (for commit stream + tree diffs).
 	seqWorker := gitlib.NewWorker(repo, seqChan)
 
-	// Pool workers use NEW repo handles.
-	poolWorkers := make([]*gitlib.Worker, config.Workers)
-	poolRepos := make([]*gitlib.Repository, config.Workers)
-
-	for i := range config.Workers {
-		// Clone repo handle.
-		newRepo, err := gitlib.OpenRepository(repo.Path())
-		if err != nil {
-			panic(fmt.Errorf("failed to open repo for worker: %w", err))
-		}
-
-		poolRepos[i] = newRepo
-		poolWorkers[i] = gitlib.NewWorker(newRepo, poolChan)
+	// Pool workers use NEW repo handles sharing the main repo's object database.
+	workerPool, poolErr := gitlib.NewWorkerPool(repo, config.Workers, poolChan)
+	if poolErr != nil {
+		panic(fmt.Errorf("failed to open repo for worker: %w", poolErr))
 	}
 
 	// Create blob cache if configured.
@@ -254,7 +309,7 @@ func NewCoordinator(repo *gitlib.Repository, config CoordinatorConfig) *Coordina
 	// Create diff cache if configured.
 	var diffCache *DiffCache
 	if config.DiffCacheSize > 0 {
-		diffCache = NewDiffCache(config.DiffCacheSize)
+		diffCache = NewDiffCacheWithStore(config.DiffCacheSize, config.DiffStore)
 	}
 
 	blobPipeline := NewBlobPipelineWithCache(seqChan, poolChan, config.BufferSize, config.Workers, blobCache)
@@ -262,6 +317,18 @@ func NewCoordinator(repo *gitlib.Repository, config CoordinatorConfig) *Coordina
 		blobPipeline.ArenaSize = config.BlobArenaSize
 	}
 
+	blobPipeline.BorrowBlobs = config.BorrowBlobs
+	blobPipeline.BatchTreeDiffs = true
+
+	diffPipeline := NewDiffPipelineWithCache(poolChan, config.BufferSize, diffCache)
+	diffPipeline.Algorithm = config.DiffAlgorithm
+
+	// Adaptive batch sizing, when the configuration asks for it.
+	if batch := config.BatchConfig; batch.TargetBatchLatency > 0 || batch.BatchMemoryBudget > 0 {
+		blobPipeline.Sizer = gitlib.NewBatchSizer(batch.BlobBatchSize, batch.TargetBatchLatency, batch.BatchMemoryBudget)
+		diffPipeline.Sizer = gitlib.NewBatchSizer(batch.DiffBatchSize, batch.TargetBatchLatency, batch.BatchMemoryBudget)
+	}
+
 	// Create UAST pipeline if workers are configured.
 	var uastPipeline *UASTPipeline
 
@@ -269,9 +336,21 @@ func NewCoordinator(repo *gitlib.Repository, config CoordinatorConfig) *Coordina
 		parser, err := uast.NewParser()
 		if err == nil {
 			uastPipeline = NewUASTPipeline(parser, config.UASTPipelineWorkers, config.BufferSize)
+
+			if config.UASTTreeCacheSize > 0 {
+				uastPipeline.TreeCache = uast.NewTreeCache(config.UASTTreeCacheSize)
+			}
 		}
 	}
 
+	var fusedPipeline *FusedPipeline
+
+	if config.FusedDiffs {
+		fusedPipeline = NewFusedPipeline(poolChan, config.BufferSize, config.Workers)
+		fusedPipeline.Algorithm = config.DiffAlgorithm
+		fusedPipeline.SkipBlobData = config.SkipBlobData && uastPipeline == nil
+	}
+
 	return &Coordinator{
 		repo:   repo,
 		config: config,
@@ -279,15 +358,15 @@ func NewCoordinator(repo *gitlib.Repository, config CoordinatorConfig) *Coordina
 			BatchSize: config.CommitBatchSize,
 			Lookahead: config.BufferSize,
 		},
-		blobPipeline: blobPipeline,
-		diffPipeline: NewDiffPipelineWithCache(poolChan, config.BufferSize, diffCache),
-		uastPipeline: uastPipeline,
-		blobCache:    blobCache,
-		diffCache:    diffCache,
+		blobPipeline:  blobPipeline,
+		diffPipeline:  diffPipeline,
+		fusedPipeline: fusedPipeline,
+		uastPipeline:  uastPipeline,
+		blobCache:     blobCache,
+		diffCache:     diffCache,
 
 		seqWorker:    seqWorker,
-		poolWorkers:  poolWorkers,
-		poolRepos:    poolRepos,
+		workerPool:   workerPool,
 		seqRequests:  seqChan,
 		poolRequests: poolChan,
 	}
@@ -430,9 +509,11 @@ func (c *Coordinator) Process(ctx context.Context, commits []*gitlib.Commit) <-c
 	// Start all workers.
 	c.seqWorker.Start()
 
-	for _, w := range c.poolWorkers {
-		w.Start()
-	}
+	c.workerPool.Start()
+
+	c.attachRepoBudget()
+	c.attachObjectCache()
+	c.attachTreeDiffFilter()
 
 	// Pipeline: Commits -> Blobs -> Diffs -> [UAST].
 	commitChan := c.commitStreamer.Stream(ctx, commits)
@@ -440,11 +521,25 @@ func (c *Coordinator) Process(ctx context.Context, commits []*gitlib.Commit) <-c
 	blobHitsBefore, blobMissesBefore := cacheStats(c.blobCache)
 	diffHitsBefore, diffMissesBefore := cacheStats(c.diffCache)
 
-	blobStart := time.Now()
-	blobOut, blobDone := signalOnDrain(c.blobPipeline.Process(ctx, commitChan))
+	var (
+		blobStart, diffStart time.Time
+		blobDone, diffDone   <-chan struct{}
+		diffOut              <-chan CommitData
+	)
+
+	if c.fusedPipeline != nil {
+		// Blob loading happens inside the diff stage; only DiffDuration is set.
+		diffStart = time.Now()
+		diffOut, diffDone = signalOnDrain(c.fusedPipeline.Process(ctx, commitChan))
+	} else {
+		var blobOut <-chan BlobData
+
+		blobStart = time.Now()
+		blobOut, blobDone = signalOnDrain(c.blobPipeline.Process(ctx, commitChan))
 
-	diffStart := time.Now()
-	diffOut, diffDone := signalOnDrain(c.diffPipeline.Process(ctx, blobOut))
+		diffStart = time.Now()
+		diffOut, diffDone = signalOnDrain(c.diffPipeline.Process(ctx, blobOut))
+	}
 
 	// Optionally add UAST pipeline stage for pre-computed UAST parsing.
 	var dataChan <-chan CommitData
@@ -488,23 +583,166 @@ func (c *Coordinator) Process(ctx context.Context, commits []*gitlib.Commit) <-c
 		c.stopWorkers()
 
 		// Free pool repos.
-		for _, r := range c.poolRepos {
-			r.Free()
+		c.workerPool.Free()
+
+		c.releaseRepoBudget()
+		c.releaseObjectCache()
+		c.releaseTreeDiffFilter()
+
+		if c.uastPipeline != nil && c.uastPipeline.TreeCache != nil {
+			c.uastPipeline.TreeCache.Close()
 		}
 	}()
 
 	return finalChan
 }
 
+// applyArenaLimit caps the blob arena and the batch memory budget at the
+// arena limit of the repository budget, if any.
+func applyArenaLimit(config *CoordinatorConfig) {
+	if config.RepoBudget == nil {
+		return
+	}
+
+	limit := config.RepoBudget.Limits().ArenaBytes
+	if limit <= 0 {
+		return
+	}
+
+	if config.BlobArenaSize <= 0 || int64(config.BlobArenaSize) > limit {
+		config.BlobArenaSize = SafeInt(uint64(limit))
+	}
+
+	if config.BatchConfig.BatchMemoryBudget <= 0 || config.BatchConfig.BatchMemoryBudget > limit {
+		config.BatchConfig.BatchMemoryBudget = limit
+	}
+}
+
+// budgetHasCache reports whether the repository budget owns an object cache.
+func (c *Coordinator) budgetHasCache() bool {
+	return c.config.RepoBudget != nil && c.config.RepoBudget.Limits().CacheBytes > 0
+}
+
+// attachRepoBudget charges the main and all pool repository handles to the
+// repository budget, if configured. Failing to attach it only loses the
+// memory bounds.
+func (c *Coordinator) attachRepoBudget() {
+	budget := c.config.RepoBudget
+	if budget == nil {
+		return
+	}
+
+	c.budgetCache = budget.Stats().Cache
+
+	for _, r := range append([]*gitlib.Repository{c.repo}, c.workerPool.Repositories()...) {
+		if r.AttachBudget(budget) != nil {
+			break
+		}
+	}
+}
+
+// releaseRepoBudget records the run's share of the budget's object cache
+// counters and detaches the budget from the main repository. Pool
+// repositories detach when they are freed. Pack windows stay open for the
+// next run on the repository: runs sharing a budget may overlap (chunk
+// prefetch), so only the budget owner knows when none of its handles is in
+// use and releases them there (RepoBudget.ReleaseWindows).
+func (c *Coordinator) releaseRepoBudget() {
+	budget := c.config.RepoBudget
+	if budget == nil {
+		return
+	}
+
+	if c.budgetHasCache() {
+		stats := budget.Stats().Cache
+		c.stats.ObjectCacheHits = stats.Hits - c.budgetCache.Hits
+		c.stats.ObjectCacheMisses = stats.Misses - c.budgetCache.Misses
+		c.stats.ObjectCacheEvictions = stats.Evictions - c.budgetCache.Evictions
+	}
+
+	c.repo.DetachBudget()
+}
+
+// attachObjectCache shares one object cache between the main and all pool
+// repository handles, if configured. Failing to set it up only costs speed.
+func (c *Coordinator) attachObjectCache() {
+	if c.config.ObjectCacheSize <= 0 || c.budgetHasCache() {
+		return
+	}
+
+	cache, err := gitlib.NewObjectCache(c.config.ObjectCacheSize)
+	if err != nil {
+		return
+	}
+
+	c.objectCache = cache
+
+	for _, r := range append([]*gitlib.Repository{c.repo}, c.workerPool.Repositories()...) {
+		if r.AttachObjectCache(cache) != nil {
+			break
+		}
+	}
+}
+
+// releaseObjectCache records the object cache counters and detaches it from
+// the main repository. Pool repositories detach when they are freed.
+func (c *Coordinator) releaseObjectCache() {
+	if c.objectCache == nil {
+		return
+	}
+
+	stats := c.objectCache.Stats()
+	c.stats.ObjectCacheHits = stats.Hits
+	c.stats.ObjectCacheMisses = stats.Misses
+	c.stats.ObjectCacheEvictions = stats.Evictions
+
+	c.repo.DetachObjectCache()
+	c.objectCache.Free()
+	c.objectCache = nil
+}
+
+// attachTreeDiffFilter compiles the configured tree diff filter once and sets
+// it on all pool repository handles. Without it, changes are filtered later
+// in Go only.
+func (c *Coordinator) attachTreeDiffFilter() {
+	if c.config.TreeDiffFilter.IsZero() {
+		return
+	}
+
+	filter, err := gitlib.NewTreeDiffFilter(c.config.TreeDiffFilter)
+	if err != nil {
+		return
+	}
+
+	c.treeDiffFilter = filter
+
+	for _, r := range c.workerPool.Repositories() {
+		r.SetTreeDiffFilter(filter)
+	}
+}
+
+// releaseTreeDiffFilter frees the tree diff filter once the pool repositories
+// using it are freed.
+func (c *Coordinator) releaseTreeDiffFilter() {
+	if c.treeDiffFilter == nil {
+		return
+	}
+
+	c.treeDiffFilter.Free()
+	c.treeDiffFilter = nil
+}
+
 // recordStageTiming waits for each pipeline stage to finish and records its duration.
 func (c *Coordinator) recordStageTiming(
 	blobDone <-chan struct{}, blobStart time.Time,
 	diffDone <-chan struct{}, diffStart time.Time,
 	uastDone <-chan struct{}, uastStart time.Time,
 ) {
-	<-blobDone
+	if blobDone != nil {
+		<-blobDone
 
-	c.stats.BlobDuration = time.Since(blobStart)
+		c.stats.BlobDuration = time.Since(blobStart)
+	}
 
 	<-diffDone
 
@@ -536,10 +774,7 @@ func (c *Coordinator) stopWorkers() {
 	close(c.poolRequests)
 
 	c.seqWorker.Stop()
-
-	for _, w := range c.poolWorkers {
-		w.Stop()
-	}
+	c.workerPool.Stop()
 }
 
 // cacheStatsProvider can report cache hit/miss counters.
@@ -151,6 +151,111 @@ func TestCoordinator_ProcessTwoCommitsWithModification(t *testing.T) {
 	}
 }
 
+func TestCoordinator_ProcessWithObjectCache(t *testing.T) {
+	t.Parallel()
+
+	repo := framework.NewTestRepo(t)
+	defer repo.Close()
+
+	repo.CreateFile("f.txt", "a\nb\n")
+	repo.Commit("first")
+	repo.CreateFile("f.txt", "a\nc\n")
+	repo.Commit("second")
+	repo.CreateFile("f.txt", "a\nd\n")
+	repo.Commit("third")
+
+	libRepo, err := gitlib.OpenRepository(repo.Path())
+	if err != nil {
+		t.Fatalf("OpenRepository: %v", err)
+	}
+	defer libRepo.Free()
+
+	commits := framework.CollectCommits(t, libRepo, 3)
+
+	config := framework.CoordinatorConfig{
+		CommitBatchSize: 1,
+		Workers:         2,
+		BufferSize:      2,
+		BatchConfig:     gitlib.DefaultBatchConfig(),
+		ObjectCacheSize: 1 << 20,
+	}
+	coord := framework.NewCoordinator(libRepo, config)
+	out := coord.Process(context.Background(), commits)
+
+	for d := range out {
+		if d.Error != nil {
+			t.Fatalf("result error: %v", d.Error)
+		}
+	}
+
+	stats := coord.Stats()
+	if stats.ObjectCacheMisses == 0 {
+		t.Errorf("ObjectCacheMisses = 0, want blob reads to go through the object cache")
+	}
+}
+
+func TestCoordinator_ProcessWithRepoBudget(t *testing.T) {
+	t.Parallel()
+
+	repo := framework.NewTestRepo(t)
+	defer repo.Close()
+
+	repo.CreateFile("f.txt", "a\nb\n")
+	repo.Commit("first")
+	repo.CreateFile("f.txt", "a\nc\n")
+	repo.Commit("second")
+
+	libRepo, err := gitlib.OpenRepository(repo.Path())
+	if err != nil {
+		t.Fatalf("OpenRepository: %v", err)
+	}
+	defer libRepo.Free()
+
+	budget, err := gitlib.NewRepoBudget("coordinator", gitlib.RepoLimits{CacheBytes: 1 << 20, ArenaBytes: 1 << 20})
+	if err != nil {
+		t.Fatalf("NewRepoBudget: %v", err)
+	}
+	defer budget.Free()
+
+	commits := framework.CollectCommits(t, libRepo, 2)
+
+	config := framework.CoordinatorConfig{
+		CommitBatchSize: 1,
+		Workers:         2,
+		BufferSize:      2,
+		BatchConfig:     gitlib.DefaultBatchConfig(),
+		BlobArenaSize:   16 << 20,
+		RepoBudget:      budget,
+	}
+	coord := framework.NewCoordinator(libRepo, config)
+
+	cfg := coord.Config()
+	if cfg.BlobArenaSize != 1<<20 || cfg.BatchConfig.BatchMemoryBudget != 1<<20 {
+		t.Errorf("arena = %d, batch memory = %d, want both capped at 1 MiB",
+			cfg.BlobArenaSize, cfg.BatchConfig.BatchMemoryBudget)
+	}
+
+	for d := range coord.Process(context.Background(), commits) {
+		if d.Error != nil {
+			t.Fatalf("result error: %v", d.Error)
+		}
+	}
+
+	stats := budget.Stats()
+	if stats.Batches == 0 {
+		t.Errorf("Batches = 0, want the run's batch calls charged to the budget")
+	}
+
+	if stats.Handles != 0 {
+		t.Errorf("Handles = %d, want all handles detached after the run", stats.Handles)
+	}
+
+	if coord.Stats().ObjectCacheMisses != stats.Cache.Misses {
+		t.Errorf("ObjectCacheMisses = %d, want the budget cache's %d",
+			coord.Stats().ObjectCacheMisses, stats.Cache.Misses)
+	}
+}
+
 func TestCoordinator_NewCoordinatorNormalizesConfig(t *testing.T) {
 	t.Parallel()
 
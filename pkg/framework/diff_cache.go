@@ -33,12 +33,20 @@ type DiffCache struct {
 	head       *diffCacheEntry // Most recently used.
 	tail       *diffCacheEntry // Least recently used.
 	maxEntries int
+	store      *DiffStore // Persistent backing; nil if none.
 	hits       atomic.Int64
 	misses     atomic.Int64
 }
 
 // NewDiffCache creates a new diff cache with the specified maximum entries.
 func NewDiffCache(maxEntries int) *DiffCache {
+	return NewDiffCacheWithStore(maxEntries, nil)
+}
+
+// NewDiffCacheWithStore creates a diff cache backed by store: misses are
+// looked up in the store and every Put is recorded in it. A nil store
+// disables the backing.
+func NewDiffCacheWithStore(maxEntries int, store *DiffStore) *DiffCache {
 	if maxEntries <= 0 {
 		maxEntries = DefaultDiffCacheSize
 	}
@@ -46,29 +54,59 @@ func NewDiffCache(maxEntries int) *DiffCache {
 	return &DiffCache{
 		entries:    make(map[DiffKey]*diffCacheEntry),
 		maxEntries: maxEntries,
+		store:      store,
 	}
 }
 
-// Get retrieves a cached diff result.
+// Get retrieves a cached diff result. A diff found in the backing store
+// counts as a hit.
 func (c *DiffCache) Get(key DiffKey) (plumbing.FileDiffData, bool) {
 	c.mu.Lock()
-	defer c.mu.Unlock()
 
 	entry, exists := c.entries[key]
-	if !exists {
-		c.misses.Add(1)
+	if exists {
+		c.moveToFront(entry)
+		diff := entry.diff
+		c.mu.Unlock()
+		c.hits.Add(1)
+
+		return diff, true
+	}
+
+	c.mu.Unlock()
 
-		return plumbing.FileDiffData{}, false
+	if c.store != nil {
+		diff, found := c.store.Get(key)
+		if found {
+			c.hits.Add(1)
+			c.put(key, diff)
+
+			return diff, true
+		}
 	}
 
-	c.hits.Add(1)
-	c.moveToFront(entry)
+	c.misses.Add(1)
 
-	return entry.diff, true
+	return plumbing.FileDiffData{}, false
 }
 
-// Put adds a diff result to the cache.
+// Put adds a diff result to the cache and the backing store.
 func (c *DiffCache) Put(key DiffKey, diff plumbing.FileDiffData) {
+	if c.store != nil {
+		c.store.Put(key, diff)
+	}
+
+	c.put(key, diff)
+}
+
+// PutUnstored adds a diff result to the cache but not to the backing store,
+// for diffs not computed by the store's DiffVariant.
+func (c *DiffCache) PutUnstored(key DiffKey, diff plumbing.FileDiffData) {
+	c.put(key, diff)
+}
+
+// put adds a diff result to the LRU only.
+func (c *DiffCache) put(key DiffKey, diff plumbing.FileDiffData) {
 	c.mu.Lock()
 	defer c.mu.Unlock()
 
@@ -29,8 +29,17 @@ type DiffPipeline struct {
 	PoolWorkerChan chan<- gitlib.WorkerRequest
 	BufferSize     int
 	DiffCache      *DiffCache
+	// Algorithm is the line matching algorithm requested for native diffs.
+	Algorithm gitlib.DiffAlgorithm
+	// Sizer, if set, picks how many diffs are batched across commits from
+	// the cost of earlier batches instead of the fixed maxDiffBatchSize.
+	Sizer *gitlib.BatchSizer
 }
 
+// maxDiffBatchSize is the number of diff requests batched across commits
+// when no Sizer is set.
+const maxDiffBatchSize = 1000
+
 // NewDiffPipeline creates a new diff pipeline.
 func NewDiffPipeline(workerChan chan<- gitlib.WorkerRequest, bufferSize int) *DiffPipeline {
 	return NewDiffPipelineWithCache(workerChan, bufferSize, nil)
@@ -86,9 +95,6 @@ func (p *DiffPipeline) runDiffProducer(ctx context.Context, blobs <-chan BlobDat
 	// or until input channel is dry.
 	// Since BlobPipeline emits BlobData which already contains multiple diffs per commit,
 	// we are effectively re-batching across commits.
-
-	const maxBatchSize = 1000
-
 	var (
 		currentBatchReqs []gitlib.DiffRequest
 		currentBatchJobs []*diffJob
@@ -117,6 +123,7 @@ func (p *DiffPipeline) runDiffProducer(ctx context.Context, blobs <-chan BlobDat
 			// Create a shared state for this batch.
 			sharedResp = &sharedDiffResponse{
 				respChan: respChan,
+				sizer:    p.Sizer,
 			}
 		}
 
@@ -163,7 +170,7 @@ func (p *DiffPipeline) runDiffProducer(ctx context.Context, blobs <-chan BlobDat
 
 		currentBatchJobs = append(currentBatchJobs, job)
 
-		if len(currentBatchReqs) >= maxBatchSize {
+		if len(currentBatchReqs) >= p.batchSize() {
 			flushBatch()
 		}
 	}
@@ -172,8 +179,18 @@ func (p *DiffPipeline) runDiffProducer(ctx context.Context, blobs <-chan BlobDat
 	flushBatch()
 }
 
+// batchSize returns the number of diff requests to batch across commits.
+func (p *DiffPipeline) batchSize() int {
+	if p.Sizer == nil {
+		return maxDiffBatchSize
+	}
+
+	return p.Sizer.Size()
+}
+
 type sharedDiffResponse struct {
 	respChan chan gitlib.DiffBatchResponse
+	sizer    *gitlib.BatchSizer
 	results  []gitlib.DiffResult
 	err      error
 	once     sync.Once
@@ -183,6 +200,10 @@ func (s *sharedDiffResponse) wait(ctx context.Context) {
 	s.once.Do(func() {
 		select {
 		case resp := <-s.respChan:
+			if s.sizer != nil {
+				s.sizer.Observe(resp.Cost)
+			}
+
 			s.results = resp.Results
 		case <-ctx.Done():
 			s.err = ctx.Err()
@@ -302,12 +323,13 @@ func (p *DiffPipeline) prepareDiffRequest(blobData BlobData) (
 		}
 
 		requests = append(requests, gitlib.DiffRequest{
-			OldHash: change.From.Hash,
-			NewHash: change.To.Hash,
-			OldData: oldBlob.Data,
-			NewData: newBlob.Data,
-			HasOld:  true,
-			HasNew:  true,
+			OldHash:   change.From.Hash,
+			NewHash:   change.To.Hash,
+			OldData:   oldBlob.Data,
+			NewData:   newBlob.Data,
+			HasOld:    true,
+			HasNew:    true,
+			Algorithm: p.Algorithm,
 		})
 		paths = append(paths, change.To.Name)
 		changes = append(changes, change)
@@ -343,7 +365,7 @@ func (p *DiffPipeline) processDiffResponse(
 		var fileDiff plumbing.FileDiffData
 
 		if diffRes.Error != nil {
-			fileDiff = p.fileDiffFromGoDiff(oldBlob, newBlob, oldLines, newLines)
+			fileDiff = fileDiffFromGoDiff(oldBlob, newBlob, oldLines, newLines)
 		} else {
 			diffs := convertDiffOpsToDMP(diffRes.Ops)
 			fileDiff = plumbing.FileDiffData{
@@ -355,10 +377,15 @@ func (p *DiffPipeline) processDiffResponse(
 
 		data.FileDiffs[path] = fileDiff
 
-		// Store in cache.
+		// Store in cache. Go diffs align lines differently from the native
+		// engine, so they are not persisted.
 		if p.DiffCache != nil {
 			key := DiffKey{OldHash: changes[i].From.Hash, NewHash: changes[i].To.Hash}
-			p.DiffCache.Put(key, fileDiff)
+			if diffRes.Error != nil {
+				p.DiffCache.PutUnstored(key, fileDiff)
+			} else {
+				p.DiffCache.Put(key, fileDiff)
+			}
 		}
 	}
 }
@@ -389,7 +416,8 @@ func convertDiffOpsToDMP(ops []gitlib.DiffOp) []diffmatchpatch.Diff {
 	return diffs
 }
 
-func (p *DiffPipeline) fileDiffFromGoDiff(oldBlob, newBlob *gitlib.CachedBlob, oldLines, newLines int) plumbing.FileDiffData {
+// fileDiffFromGoDiff diffs two blobs in Go, used when the native diff fails.
+func fileDiffFromGoDiff(oldBlob, newBlob *gitlib.CachedBlob, oldLines, newLines int) plumbing.FileDiffData {
 	strFrom, strTo := string(oldBlob.Data), string(newBlob.Data)
 
 	if strFrom == strTo {
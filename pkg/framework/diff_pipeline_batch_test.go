@@ -119,3 +119,209 @@ func TestDiffPipeline_CrossCommitBatching(t *testing.T) {
 		t.Errorf("Expected 2 output items, got %d", count)
 	}
 }
+
+func TestDiffPipeline_SizerBoundsBatches(t *testing.T) {
+	t.Parallel()
+
+	poolCh := make(chan gitlib.WorkerRequest, 10)
+
+	pipeline := framework.NewDiffPipeline(poolCh, 10)
+	// Every diff costs the whole target, so batches never grow past one.
+	pipeline.Sizer = gitlib.NewBatchSizer(1, time.Millisecond, 0)
+
+	const commits = 3
+
+	inputCh := make(chan framework.BlobData, commits)
+
+	for i := range commits {
+		oldHash, newHash := gitlib.Hash{0: byte(2 * i), 1: 1}, gitlib.Hash{0: byte(2*i + 1), 1: 1}
+		inputCh <- framework.BlobData{
+			Commit: gitlib.NewCommitForTest(gitlib.Hash{0: byte(i + 1)}),
+			Changes: gitlib.Changes{{
+				Action: gitlib.Modify,
+				From:   gitlib.ChangeEntry{Hash: oldHash, Name: "file"},
+				To:     gitlib.ChangeEntry{Hash: newHash, Name: "file"},
+			}},
+			BlobCache: map[gitlib.Hash]*gitlib.CachedBlob{
+				oldHash: gitlib.NewCachedBlobWithHashForTest(oldHash, []byte("a\n")),
+				newHash: gitlib.NewCachedBlobWithHashForTest(newHash, []byte("b\n")),
+			},
+		}
+	}
+
+	close(inputCh)
+
+	ctx, cancel := context.WithTimeout(context.Background(), 2*time.Second)
+	defer cancel()
+
+	outCh := pipeline.Process(ctx, inputCh)
+
+	batches := make(chan int, commits)
+
+	go func() {
+		for {
+			select {
+			case req := <-poolCh:
+				diffReq, ok := req.(gitlib.DiffBatchRequest)
+				if !ok {
+					continue
+				}
+
+				batches <- len(diffReq.Requests)
+
+				results := make([]gitlib.DiffResult, len(diffReq.Requests))
+				for i := range results {
+					results[i] = gitlib.DiffResult{
+						OldLines: 1,
+						NewLines: 1,
+						Ops:      []gitlib.DiffOp{{Type: gitlib.DiffOpDelete, LineCount: 1}, {Type: gitlib.DiffOpInsert, LineCount: 1}},
+					}
+				}
+
+				diffReq.Response <- gitlib.DiffBatchResponse{
+					Results: results,
+					Cost:    gitlib.BatchCost{Items: len(results), DiffTime: time.Duration(len(results)) * time.Millisecond},
+				}
+
+			case <-ctx.Done():
+				return
+			}
+		}
+	}()
+
+	count := 0
+	for range outCh {
+		count++
+	}
+
+	if count != commits {
+		t.Fatalf("Expected %d output items, got %d", commits, count)
+	}
+
+	close(batches)
+
+	seen := 0
+	for size := range batches {
+		seen++
+
+		if size != 1 {
+			t.Errorf("Expected batches of 1 diff, got %d", size)
+		}
+	}
+
+	if seen != commits {
+		t.Errorf("Expected %d batches, got %d", commits, seen)
+	}
+}
+
+func TestDiffPipeline_SizerFollowsSimulatedCost(t *testing.T) {
+	t.Parallel()
+
+	poolCh := make(chan gitlib.WorkerRequest, 10)
+
+	pipeline := framework.NewDiffPipeline(poolCh, 10)
+	pipeline.Sizer = gitlib.NewBatchSizer(1, 4*time.Millisecond, 0)
+
+	const commits = 7
+
+	inputCh := make(chan framework.BlobData, commits)
+
+	ctx, cancel := context.WithTimeout(context.Background(), 2*time.Second)
+	defer cancel()
+
+	outCh := pipeline.Process(ctx, inputCh)
+
+	// The first batch costs 1ms per diff, later ones 4ms.
+	batches := make(chan int, commits)
+
+	go func() {
+		itemCost := time.Millisecond
+
+		for {
+			select {
+			case req := <-poolCh:
+				diffReq, ok := req.(gitlib.DiffBatchRequest)
+				if !ok {
+					continue
+				}
+
+				batches <- len(diffReq.Requests)
+
+				results := make([]gitlib.DiffResult, len(diffReq.Requests))
+				for i := range results {
+					results[i] = gitlib.DiffResult{
+						OldLines: 1,
+						NewLines: 1,
+						Ops:      []gitlib.DiffOp{{Type: gitlib.DiffOpDelete, LineCount: 1}, {Type: gitlib.DiffOpInsert, LineCount: 1}},
+					}
+				}
+
+				diffReq.Response <- gitlib.DiffBatchResponse{
+					Results: results,
+					Cost:    gitlib.BatchCost{Items: len(results), DiffTime: time.Duration(len(results)) * itemCost},
+				}
+
+				itemCost = 4 * time.Millisecond
+
+			case <-ctx.Done():
+				return
+			}
+		}
+	}()
+
+	// Each wave is sent once the batches before it were observed: the
+	// initial size of 1, then 4ms/1ms = 4 diffs, then 4ms over the smoothed
+	// 1.75ms per diff = 2 diffs.
+	want := []int{1, 4, 2}
+	next := 0
+
+	for _, wave := range want {
+		for range wave {
+			oldHash, newHash := gitlib.Hash{0: byte(2 * next), 1: 2}, gitlib.Hash{0: byte(2*next + 1), 1: 2}
+			inputCh <- framework.BlobData{
+				Commit: gitlib.NewCommitForTest(gitlib.Hash{0: byte(next + 1)}),
+				Changes: gitlib.Changes{{
+					Action: gitlib.Modify,
+					From:   gitlib.ChangeEntry{Hash: oldHash, Name: "file"},
+					To:     gitlib.ChangeEntry{Hash: newHash, Name: "file"},
+				}},
+				BlobCache: map[gitlib.Hash]*gitlib.CachedBlob{
+					oldHash: gitlib.NewCachedBlobWithHashForTest(oldHash, []byte("a\n")),
+					newHash: gitlib.NewCachedBlobWithHashForTest(newHash, []byte("b\n")),
+				},
+			}
+			next++
+		}
+
+		for range wave {
+			if _, ok := <-outCh; !ok {
+				t.Fatalf("Output closed after %d of %d commits", next, commits)
+			}
+		}
+	}
+
+	close(inputCh)
+
+	for range outCh {
+		t.Error("Unexpected output after the last wave")
+	}
+
+	close(batches)
+
+	got := make([]int, 0, len(want))
+	for size := range batches {
+		got = append(got, size)
+	}
+
+	if len(got) != len(want) {
+		t.Fatalf("Expected batches %v, got %v", want, got)
+	}
+
+	for i := range want {
+		if got[i] != want[i] {
+			t.Errorf("Expected batches %v, got %v", want, got)
+
+			break
+		}
+	}
+}
@@ -0,0 +1,424 @@
+package framework
+
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"hash/crc32"
+	"os"
+	"path/filepath"
+	"strings"
+	"sync"
+	"syscall"
+	"unicode/utf8"
+
+	"github.com/sergi/go-diff/diffmatchpatch"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
+	"github.com/Sumatoshi-tech/codefang/pkg/plumbing"
+)
+
+// Diff store file layout. The file starts with a magic, a version and the
+// DiffVariant its diffs were computed with, followed by append-only records:
+//
+//	old hash [20] | new hash [20] | old lines u32 | new lines u32 |
+//	op count u32 | crc32 u32 | op count x (type i8 | line count u32)
+//
+// The checksum covers the record without itself, so a record torn by a
+// crash ends the valid part of the file.
+const (
+	diffStoreMagic   = "CFDS"
+	diffStoreVersion = 2
+
+	diffStoreHeaderSize = len(diffStoreMagic) + 3*4
+	diffRecordCRCOffset = 2*gitlib.HashSize + 3*4
+	diffRecordHeadSize  = diffRecordCRCOffset + 4
+	diffRecordOpSize    = 1 + 4
+
+	diffStoreFilePerm = 0o600
+	diffStoreDirPerm  = 0o750
+)
+
+// ErrDiffStoreLocked is returned when another process has the diff store open.
+var ErrDiffStoreLocked = errors.New("diff store is in use by another process")
+
+// DiffVariant is what a stored diff depends on besides its blob pair. Diffs
+// computed with another algorithm or engine differ, so a store is only
+// reused by runs of the same variant.
+type DiffVariant struct {
+	Algorithm gitlib.DiffAlgorithm
+	Engine    gitlib.DiffEngine
+}
+
+// CurrentDiffVariant returns the variant BatchDiffBlobs diffs with for
+// algorithm.
+func CurrentDiffVariant(algorithm gitlib.DiffAlgorithm) DiffVariant {
+	return DiffVariant{Algorithm: algorithm, Engine: gitlib.CurrentDiffEngine()}
+}
+
+// DiffStore persists diff results by blob hash pair across runs, so a
+// repeated or incremental analysis only diffs blob pairs it has not seen.
+// Records already on disk are read from a read-only memory map; new ones
+// are buffered and appended by Flush. The file is locked while open, so
+// only one process appends to it. Safe for concurrent use.
+type DiffStore struct {
+	mu      sync.RWMutex
+	file    *os.File
+	variant DiffVariant
+	data    []byte          // Memory-mapped file up to end.
+	index   map[DiffKey]int // Record offsets in data.
+	tail    []byte          // Records not yet on disk.
+	tailIdx map[DiffKey]int // Record offsets in tail.
+	end     int64           // End of the last valid record on disk.
+	maxSize int64
+}
+
+// OpenDiffStore opens or creates the diff store of variant at path and
+// indexes its records. A file of another format or variant is discarded.
+// The file never grows past maxSize bytes; zero means no limit. Returns
+// ErrDiffStoreLocked if another process has it open.
+func OpenDiffStore(path string, maxSize int64, variant DiffVariant) (*DiffStore, error) {
+	err := os.MkdirAll(filepath.Dir(path), diffStoreDirPerm)
+	if err != nil {
+		return nil, fmt.Errorf("create diff store dir: %w", err)
+	}
+
+	file, err := os.OpenFile(path, os.O_RDWR|os.O_CREATE, diffStoreFilePerm)
+	if err != nil {
+		return nil, fmt.Errorf("open diff store: %w", err)
+	}
+
+	err = syscall.Flock(int(file.Fd()), syscall.LOCK_EX|syscall.LOCK_NB)
+	if err != nil {
+		_ = file.Close()
+
+		if errors.Is(err, syscall.EWOULDBLOCK) {
+			return nil, ErrDiffStoreLocked
+		}
+
+		return nil, fmt.Errorf("lock diff store: %w", err)
+	}
+
+	s := &DiffStore{
+		file:    file,
+		variant: variant,
+		index:   make(map[DiffKey]int),
+		tailIdx: make(map[DiffKey]int),
+		maxSize: maxSize,
+	}
+
+	err = s.load()
+	if err != nil {
+		s.unmap()
+		_ = file.Close()
+
+		return nil, err
+	}
+
+	return s, nil
+}
+
+// load maps the file and indexes its valid records, or starts a new file.
+func (s *DiffStore) load() error {
+	info, err := s.file.Stat()
+	if err != nil {
+		return fmt.Errorf("stat diff store: %w", err)
+	}
+
+	if info.Size() > int64(diffStoreHeaderSize) {
+		err = s.remap(info.Size())
+		if err != nil {
+			return err
+		}
+
+		if s.validHeader() {
+			s.end = int64(s.scan())
+
+			return nil
+		}
+
+		s.unmap()
+	}
+
+	header := make([]byte, 0, diffStoreHeaderSize)
+	header = append(header, diffStoreMagic...)
+	header = binary.LittleEndian.AppendUint32(header, diffStoreVersion)
+	header = binary.LittleEndian.AppendUint32(header, uint32(s.variant.Algorithm))
+	header = binary.LittleEndian.AppendUint32(header, uint32(s.variant.Engine))
+
+	err = s.file.Truncate(0)
+	if err != nil {
+		return fmt.Errorf("reset diff store: %w", err)
+	}
+
+	_, err = s.file.WriteAt(header, 0)
+	if err != nil {
+		return fmt.Errorf("write diff store header: %w", err)
+	}
+
+	s.end = int64(diffStoreHeaderSize)
+
+	return nil
+}
+
+func (s *DiffStore) validHeader() bool {
+	fields := s.data[len(diffStoreMagic):]
+
+	return string(s.data[:len(diffStoreMagic)]) == diffStoreMagic &&
+		binary.LittleEndian.Uint32(fields) == diffStoreVersion &&
+		binary.LittleEndian.Uint32(fields[4:]) == uint32(s.variant.Algorithm) &&
+		binary.LittleEndian.Uint32(fields[8:]) == uint32(s.variant.Engine)
+}
+
+// scan indexes the records of data and returns the end of the last valid one.
+func (s *DiffStore) scan() int {
+	off := diffStoreHeaderSize
+
+	for {
+		n := diffRecordLen(s.data[off:])
+		if n == 0 {
+			return off
+		}
+
+		key := diffRecordKey(s.data[off:])
+		if _, dup := s.index[key]; !dup {
+			s.index[key] = off
+		}
+
+		off += n
+	}
+}
+
+// remap replaces the memory map with one of the first size bytes of the file.
+func (s *DiffStore) remap(size int64) error {
+	s.unmap()
+
+	data, err := syscall.Mmap(int(s.file.Fd()), 0, int(size), syscall.PROT_READ, syscall.MAP_SHARED)
+	if err != nil {
+		return fmt.Errorf("map diff store: %w", err)
+	}
+
+	s.data = data
+
+	return nil
+}
+
+func (s *DiffStore) unmap() {
+	if s.data != nil {
+		_ = syscall.Munmap(s.data)
+		s.data = nil
+	}
+}
+
+// Get returns the stored diff of key.
+func (s *DiffStore) Get(key DiffKey) (plumbing.FileDiffData, bool) {
+	s.mu.RLock()
+	defer s.mu.RUnlock()
+
+	if off, ok := s.index[key]; ok {
+		return decodeDiffRecord(s.data[off:]), true
+	}
+
+	if off, ok := s.tailIdx[key]; ok {
+		return decodeDiffRecord(s.tail[off:]), true
+	}
+
+	return plumbing.FileDiffData{}, false
+}
+
+// Put records the diff of key for the next Flush. Known keys and records
+// that would grow the file past its size limit are dropped.
+func (s *DiffStore) Put(key DiffKey, diff plumbing.FileDiffData) {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+
+	if s.file == nil {
+		return
+	}
+
+	if _, ok := s.index[key]; ok {
+		return
+	}
+
+	if _, ok := s.tailIdx[key]; ok {
+		return
+	}
+
+	size := diffRecordHeadSize + len(diff.Diffs)*diffRecordOpSize
+	if s.maxSize > 0 && s.end+int64(len(s.tail)+size) > s.maxSize {
+		return
+	}
+
+	s.tailIdx[key] = len(s.tail)
+	s.tail = appendDiffRecord(s.tail, key, diff)
+}
+
+// Flush appends the buffered records to the file and maps them.
+func (s *DiffStore) Flush() error {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+
+	return s.flush()
+}
+
+func (s *DiffStore) flush() error {
+	if s.file == nil || len(s.tail) == 0 {
+		return nil
+	}
+
+	// Drop a torn record left by an earlier run before appending.
+	err := s.file.Truncate(s.end)
+	if err != nil {
+		return fmt.Errorf("truncate diff store: %w", err)
+	}
+
+	_, err = s.file.WriteAt(s.tail, s.end)
+	if err != nil {
+		return fmt.Errorf("append diff store: %w", err)
+	}
+
+	base := int(s.end)
+	s.end += int64(len(s.tail))
+
+	err = s.remap(s.end)
+	if err != nil {
+		// Nothing is mapped anymore; the records stay on disk for the next run.
+		s.index = make(map[DiffKey]int)
+		s.tail = nil
+		s.tailIdx = make(map[DiffKey]int)
+
+		return err
+	}
+
+	for key, off := range s.tailIdx {
+		s.index[key] = base + off
+	}
+
+	s.tail = nil
+	s.tailIdx = make(map[DiffKey]int)
+
+	return nil
+}
+
+// Len returns the number of stored diffs, flushed or not.
+func (s *DiffStore) Len() int {
+	s.mu.RLock()
+	defer s.mu.RUnlock()
+
+	return len(s.index) + len(s.tailIdx)
+}
+
+// Close flushes the buffered records and closes the file, releasing its
+// lock. Later calls to Get and Put find nothing and store nothing.
+func (s *DiffStore) Close() error {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+
+	if s.file == nil {
+		return nil
+	}
+
+	flushErr := s.flush()
+
+	s.unmap()
+	closeErr := s.file.Close()
+
+	s.file = nil
+	s.index = nil
+	s.tail = nil
+	s.tailIdx = nil
+
+	if flushErr != nil {
+		return flushErr
+	}
+
+	if closeErr != nil {
+		return fmt.Errorf("close diff store: %w", closeErr)
+	}
+
+	return nil
+}
+
+// diffRecordLen returns the length of the valid record at the start of buf,
+// or 0 if it is truncated or fails its checksum.
+func diffRecordLen(buf []byte) int {
+	if len(buf) < diffRecordHeadSize {
+		return 0
+	}
+
+	opCount := int(binary.LittleEndian.Uint32(buf[diffRecordCRCOffset-4:]))
+	if opCount > (len(buf)-diffRecordHeadSize)/diffRecordOpSize {
+		return 0
+	}
+
+	n := diffRecordHeadSize + opCount*diffRecordOpSize
+
+	crc := crc32.ChecksumIEEE(buf[:diffRecordCRCOffset])
+	crc = crc32.Update(crc, crc32.IEEETable, buf[diffRecordHeadSize:n])
+
+	if crc != binary.LittleEndian.Uint32(buf[diffRecordCRCOffset:]) {
+		return 0
+	}
+
+	return n
+}
+
+func diffRecordKey(buf []byte) DiffKey {
+	var key DiffKey
+
+	copy(key.OldHash[:], buf[:gitlib.HashSize])
+	copy(key.NewHash[:], buf[gitlib.HashSize:2*gitlib.HashSize])
+
+	return key
+}
+
+// appendDiffRecord encodes diff as a record of key. Each diff's line count
+// is the rune count of its text, which holds for both native results and
+// line-mode Go diffs.
+func appendDiffRecord(buf []byte, key DiffKey, diff plumbing.FileDiffData) []byte {
+	start := len(buf)
+
+	buf = append(buf, key.OldHash[:]...)
+	buf = append(buf, key.NewHash[:]...)
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(diff.OldLinesOfCode))
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(diff.NewLinesOfCode))
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(len(diff.Diffs)))
+	buf = binary.LittleEndian.AppendUint32(buf, 0)
+
+	for _, d := range diff.Diffs {
+		buf = append(buf, byte(d.Type))
+		buf = binary.LittleEndian.AppendUint32(buf, uint32(utf8.RuneCountInString(d.Text)))
+	}
+
+	rec := buf[start:]
+	crc := crc32.ChecksumIEEE(rec[:diffRecordCRCOffset])
+	crc = crc32.Update(crc, crc32.IEEETable, rec[diffRecordHeadSize:])
+	binary.LittleEndian.PutUint32(rec[diffRecordCRCOffset:], crc)
+
+	return buf
+}
+
+// decodeDiffRecord decodes the valid record at the start of buf into the
+// form of native diff results.
+func decodeDiffRecord(buf []byte) plumbing.FileDiffData {
+	hashes := 2 * gitlib.HashSize
+	opCount := int(binary.LittleEndian.Uint32(buf[hashes+8:]))
+
+	diffs := make([]diffmatchpatch.Diff, opCount)
+	ops := buf[diffRecordHeadSize:]
+
+	for i := range diffs {
+		op := ops[i*diffRecordOpSize:]
+
+		diffs[i] = diffmatchpatch.Diff{
+			Type: diffmatchpatch.Operation(int8(op[0])),
+			Text: strings.Repeat("L", int(binary.LittleEndian.Uint32(op[1:]))),
+		}
+	}
+
+	return plumbing.FileDiffData{
+		Diffs:          diffs,
+		OldLinesOfCode: int(binary.LittleEndian.Uint32(buf[hashes:])),
+		NewLinesOfCode: int(binary.LittleEndian.Uint32(buf[hashes+4:])),
+	}
+}
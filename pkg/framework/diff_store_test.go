@@ -0,0 +1,223 @@
+package framework_test
+
+import (
+	"os"
+	"path/filepath"
+	"testing"
+
+	"github.com/sergi/go-diff/diffmatchpatch"
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/framework"
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
+	"github.com/Sumatoshi-tech/codefang/pkg/plumbing"
+)
+
+var testDiffVariant = framework.DiffVariant{Algorithm: gitlib.DiffAlgorithmMyers, Engine: gitlib.DiffEngineLibgit2}
+
+func storedDiff(equal, inserted int) plumbing.FileDiffData {
+	return plumbing.FileDiffData{
+		OldLinesOfCode: equal,
+		NewLinesOfCode: equal + inserted,
+		Diffs: []diffmatchpatch.Diff{
+			{Type: diffmatchpatch.DiffEqual, Text: "LLLLLLLLLL"[:equal]},
+			{Type: diffmatchpatch.DiffInsert, Text: "LLLLLLLLLL"[:inserted]},
+		},
+	}
+}
+
+func TestDiffStore_PersistsAcrossOpens(t *testing.T) {
+	t.Parallel()
+
+	path := filepath.Join(t.TempDir(), "repo.diffs")
+
+	store, err := framework.OpenDiffStore(path, 0, testDiffVariant)
+	require.NoError(t, err)
+
+	store.Put(makeDiffKey(1, 2), storedDiff(3, 2))
+	store.Put(makeDiffKey(3, 4), storedDiff(5, 1))
+
+	// Buffered records are served before they are flushed.
+	got, found := store.Get(makeDiffKey(1, 2))
+	require.True(t, found)
+	assert.Equal(t, storedDiff(3, 2), got)
+
+	require.NoError(t, store.Flush())
+
+	got, found = store.Get(makeDiffKey(3, 4))
+	require.True(t, found)
+	assert.Equal(t, storedDiff(5, 1), got)
+
+	store.Put(makeDiffKey(5, 6), storedDiff(1, 1))
+	require.NoError(t, store.Close())
+
+	store, err = framework.OpenDiffStore(path, 0, testDiffVariant)
+	require.NoError(t, err)
+
+	defer store.Close()
+
+	assert.Equal(t, 3, store.Len())
+
+	got, found = store.Get(makeDiffKey(5, 6))
+	require.True(t, found)
+	assert.Equal(t, storedDiff(1, 1), got)
+
+	_, found = store.Get(makeDiffKey(6, 5))
+	assert.False(t, found)
+}
+
+func TestDiffStore_DropsTornTail(t *testing.T) {
+	t.Parallel()
+
+	path := filepath.Join(t.TempDir(), "repo.diffs")
+
+	store, err := framework.OpenDiffStore(path, 0, testDiffVariant)
+	require.NoError(t, err)
+
+	store.Put(makeDiffKey(1, 2), storedDiff(3, 2))
+	store.Put(makeDiffKey(3, 4), storedDiff(5, 1))
+	require.NoError(t, store.Close())
+
+	// Cut the last record short, as a crash during the append would.
+	info, err := os.Stat(path)
+	require.NoError(t, err)
+	require.NoError(t, os.Truncate(path, info.Size()-3))
+
+	store, err = framework.OpenDiffStore(path, 0, testDiffVariant)
+	require.NoError(t, err)
+
+	assert.Equal(t, 1, store.Len())
+
+	store.Put(makeDiffKey(7, 8), storedDiff(2, 2))
+	require.NoError(t, store.Close())
+
+	store, err = framework.OpenDiffStore(path, 0, testDiffVariant)
+	require.NoError(t, err)
+
+	defer store.Close()
+
+	assert.Equal(t, 2, store.Len())
+
+	got, found := store.Get(makeDiffKey(7, 8))
+	require.True(t, found)
+	assert.Equal(t, storedDiff(2, 2), got)
+}
+
+func TestDiffStore_DiscardsForeignFile(t *testing.T) {
+	t.Parallel()
+
+	path := filepath.Join(t.TempDir(), "repo.diffs")
+	require.NoError(t, os.WriteFile(path, []byte("not a diff store at all"), 0o600))
+
+	store, err := framework.OpenDiffStore(path, 0, testDiffVariant)
+	require.NoError(t, err)
+
+	defer store.Close()
+
+	assert.Equal(t, 0, store.Len())
+}
+
+func TestDiffStore_DiscardsOtherVariant(t *testing.T) {
+	t.Parallel()
+
+	path := filepath.Join(t.TempDir(), "repo.diffs")
+
+	store, err := framework.OpenDiffStore(path, 0, testDiffVariant)
+	require.NoError(t, err)
+
+	store.Put(makeDiffKey(1, 2), storedDiff(3, 2))
+	require.NoError(t, store.Close())
+
+	others := []framework.DiffVariant{
+		{Algorithm: gitlib.DiffAlgorithmHistogram, Engine: testDiffVariant.Engine},
+		{Algorithm: testDiffVariant.Algorithm, Engine: gitlib.DiffEngineNative},
+	}
+
+	for _, variant := range others {
+		store, err = framework.OpenDiffStore(path, 0, variant)
+		require.NoError(t, err)
+
+		assert.Equal(t, 0, store.Len(), "variant %+v", variant)
+		require.NoError(t, store.Close())
+	}
+}
+
+func TestDiffStore_LocksFile(t *testing.T) {
+	t.Parallel()
+
+	path := filepath.Join(t.TempDir(), "repo.diffs")
+
+	store, err := framework.OpenDiffStore(path, 0, testDiffVariant)
+	require.NoError(t, err)
+
+	_, err = framework.OpenDiffStore(path, 0, testDiffVariant)
+	require.ErrorIs(t, err, framework.ErrDiffStoreLocked)
+
+	require.NoError(t, store.Close())
+
+	store, err = framework.OpenDiffStore(path, 0, testDiffVariant)
+	require.NoError(t, err)
+	require.NoError(t, store.Close())
+}
+
+func TestDiffStore_RespectsMaxSize(t *testing.T) {
+	t.Parallel()
+
+	store, err := framework.OpenDiffStore(filepath.Join(t.TempDir(), "repo.diffs"), 100, testDiffVariant)
+	require.NoError(t, err)
+
+	defer store.Close()
+
+	store.Put(makeDiffKey(1, 2), storedDiff(3, 2))
+	store.Put(makeDiffKey(3, 4), storedDiff(5, 1))
+
+	assert.Equal(t, 1, store.Len())
+}
+
+func TestDiffCache_FallsBackToStore(t *testing.T) {
+	t.Parallel()
+
+	path := filepath.Join(t.TempDir(), "repo.diffs")
+
+	store, err := framework.OpenDiffStore(path, 0, testDiffVariant)
+	require.NoError(t, err)
+
+	framework.NewDiffCacheWithStore(10, store).Put(makeDiffKey(1, 2), storedDiff(3, 2))
+	require.NoError(t, store.Close())
+
+	store, err = framework.OpenDiffStore(path, 0, testDiffVariant)
+	require.NoError(t, err)
+
+	defer store.Close()
+
+	cache := framework.NewDiffCacheWithStore(10, store)
+
+	got, found := cache.Get(makeDiffKey(1, 2))
+	require.True(t, found)
+	assert.Equal(t, storedDiff(3, 2), got)
+
+	_, found = cache.Get(makeDiffKey(2, 1))
+	assert.False(t, found)
+
+	stats := cache.Stats()
+	assert.Equal(t, int64(1), stats.Hits)
+	assert.Equal(t, int64(1), stats.Misses)
+	assert.Equal(t, 1, stats.Entries)
+}
+
+func TestDiffCache_PutUnstoredSkipsStore(t *testing.T) {
+	t.Parallel()
+
+	store, err := framework.OpenDiffStore(filepath.Join(t.TempDir(), "repo.diffs"), 0, testDiffVariant)
+	require.NoError(t, err)
+
+	defer store.Close()
+
+	cache := framework.NewDiffCacheWithStore(10, store)
+	cache.PutUnstored(makeDiffKey(1, 2), storedDiff(3, 2))
+
+	_, found := cache.Get(makeDiffKey(1, 2))
+	assert.True(t, found)
+	assert.Equal(t, 0, store.Len())
+}
@@ -246,11 +246,11 @@ func collectCommitsWithOpts(t *testing.T, repo *gitlib.Repository, limit int, op
 
 // FileDiffFromGoDiffForTest exposes fileDiffFromGoDiff for tests.
 func FileDiffFromGoDiffForTest(
-	p *DiffPipeline,
+	_ *DiffPipeline,
 	oldBlob, newBlob *gitlib.CachedBlob,
 	oldLines, newLines int,
 ) pkgplumbing.FileDiffData {
-	return p.fileDiffFromGoDiff(oldBlob, newBlob, oldLines, newLines)
+	return fileDiffFromGoDiff(oldBlob, newBlob, oldLines, newLines)
 }
 
 // RunnerBallastSizeForTest exposes runtime ballast size retained by a runner.
@@ -0,0 +1,210 @@
+package framework
+
+import (
+	"context"
+	"errors"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
+	"github.com/Sumatoshi-tech/codefang/pkg/plumbing"
+)
+
+// FusedPipeline computes the changes, blobs and line diffs of commit batches
+// with one CommitDiffsBatchRequest per worker, replacing BlobPipeline
+// followed by DiffPipeline. Blob contents and diff ops stay in C memory until
+// the batch is done, so each changed blob is resolved once instead of once
+// per stage. The global blob and diff caches are not consulted; the C object
+// cache serves repeated blobs.
+type FusedPipeline struct {
+	PoolWorkerChan chan<- gitlib.WorkerRequest
+	BufferSize     int
+	WorkerCount    int
+	// Algorithm is the line matching algorithm requested for native diffs.
+	Algorithm gitlib.DiffAlgorithm
+	// SkipBlobData keeps blob contents in C memory. CommitData.BlobCache is
+	// then nil, so only enable it when no consumer reads blobs (e.g. no UAST).
+	SkipBlobData bool
+}
+
+// NewFusedPipeline creates a new fused changes, blobs and diffs pipeline.
+func NewFusedPipeline(poolChan chan<- gitlib.WorkerRequest, bufferSize, workerCount int) *FusedPipeline {
+	if bufferSize <= 0 {
+		bufferSize = 1
+	}
+
+	if workerCount <= 0 {
+		workerCount = 1
+	}
+
+	return &FusedPipeline{
+		PoolWorkerChan: poolChan,
+		BufferSize:     bufferSize,
+		WorkerCount:    workerCount,
+	}
+}
+
+// fusedJob is one contiguous run of commits sent to a single worker.
+type fusedJob struct {
+	commits    []*gitlib.Commit
+	startIndex int
+	respChan   chan gitlib.CommitDiffsBatchResponse
+}
+
+// Process receives commit batches and outputs commit data with computed diffs.
+func (p *FusedPipeline) Process(ctx context.Context, commits <-chan CommitBatch) <-chan CommitData {
+	out := make(chan CommitData)
+	jobs := make(chan fusedJob, p.BufferSize)
+
+	go p.runProducer(ctx, commits, jobs)
+	go p.runConsumer(ctx, jobs, out)
+
+	return out
+}
+
+// runProducer splits each batch into one run of commits per worker and fires
+// the requests, queueing the jobs in commit order.
+func (p *FusedPipeline) runProducer(ctx context.Context, commits <-chan CommitBatch, jobs chan<- fusedJob) {
+	defer close(jobs)
+
+	var previousHash gitlib.Hash
+
+	for batch := range commits {
+		commitCount := len(batch.Commits)
+		chunkSize := max((commitCount+p.WorkerCount-1)/p.WorkerCount, 1)
+
+		for start := 0; start < commitCount; start += chunkSize {
+			end := min(start+chunkSize, commitCount)
+
+			requests := make([]gitlib.CommitDiffRequest, 0, end-start)
+			for i := start; i < end; i++ {
+				requests = append(requests, gitlib.CommitDiffRequest{
+					CommitHash: batch.Commits[i].Hash(),
+					ParentHash: diffBase(batch, i, previousHash),
+				})
+			}
+
+			respChan := make(chan gitlib.CommitDiffsBatchResponse, 1)
+			req := gitlib.CommitDiffsBatchRequest{
+				Ctx:       ctx,
+				Requests:  requests,
+				Algorithm: p.Algorithm,
+				WithBlobs: !p.SkipBlobData,
+				Response:  respChan,
+			}
+
+			select {
+			case p.PoolWorkerChan <- req:
+			case <-ctx.Done():
+				return
+			}
+
+			job := fusedJob{commits: batch.Commits[start:end], startIndex: batch.StartIndex + start, respChan: respChan}
+
+			select {
+			case jobs <- job:
+			case <-ctx.Done():
+				return
+			}
+		}
+
+		if commitCount > 0 {
+			previousHash = batch.Commits[commitCount-1].Hash()
+		}
+	}
+}
+
+// runConsumer waits for each job's response and outputs its commits in order.
+func (p *FusedPipeline) runConsumer(ctx context.Context, jobs <-chan fusedJob, out chan<- CommitData) {
+	defer close(out)
+
+	for job := range jobs {
+		var resp gitlib.CommitDiffsBatchResponse
+
+		select {
+		case resp = <-job.respChan:
+		case <-ctx.Done():
+			return
+		}
+
+		blobs := make(map[gitlib.Hash]*gitlib.CachedBlob, len(resp.Blobs))
+		for _, blob := range resp.Blobs {
+			if blob != nil {
+				blobs[blob.Hash()] = blob
+			}
+		}
+
+		for i, commit := range job.commits {
+			data := CommitData{Commit: commit, Index: job.startIndex + i}
+
+			if i < len(resp.Results) {
+				p.fillCommitData(&data, &resp.Results[i], blobs)
+			}
+
+			select {
+			case out <- data:
+			case <-ctx.Done():
+				return
+			}
+		}
+	}
+}
+
+// fillCommitData converts one fused commit result into the commit's changes,
+// blob cache and file diffs.
+func (p *FusedPipeline) fillCommitData(
+	data *CommitData, result *gitlib.CommitDiffsResult, blobs map[gitlib.Hash]*gitlib.CachedBlob,
+) {
+	data.Changes = result.Changes
+	data.Error = result.Error
+
+	if data.Error != nil {
+		return
+	}
+
+	if !p.SkipBlobData {
+		data.BlobCache = make(map[gitlib.Hash]*gitlib.CachedBlob)
+
+		for _, change := range result.Changes {
+			for _, hash := range []gitlib.Hash{change.From.Hash, change.To.Hash} {
+				if blob := blobs[hash]; blob != nil {
+					data.BlobCache[hash] = blob
+				}
+			}
+		}
+	}
+
+	data.FileDiffs = make(map[string]plumbing.FileDiffData, len(result.FileDiffs))
+
+	for _, fileDiff := range result.FileDiffs {
+		if errors.Is(fileDiff.Error, gitlib.ErrDiffBinary) {
+			continue
+		}
+
+		oldBlob := data.BlobCache[fileDiff.Change.From.Hash]
+		newBlob := data.BlobCache[fileDiff.Change.To.Hash]
+
+		oldLines, newLines := fileDiff.OldLines, fileDiff.NewLines
+
+		if oldBlob != nil && newBlob != nil {
+			// Use Go's counting, as DiffPipeline does.
+			var errOld, errNew error
+
+			oldLines, errOld = oldBlob.CountLines()
+			newLines, errNew = newBlob.CountLines()
+
+			if errOld != nil || errNew != nil {
+				continue
+			}
+		}
+
+		switch {
+		case fileDiff.Error == nil:
+			data.FileDiffs[fileDiff.Change.To.Name] = plumbing.FileDiffData{
+				OldLinesOfCode: oldLines,
+				NewLinesOfCode: newLines,
+				Diffs:          convertDiffOpsToDMP(fileDiff.Ops),
+			}
+		case oldBlob != nil && newBlob != nil:
+			data.FileDiffs[fileDiff.Change.To.Name] = fileDiffFromGoDiff(oldBlob, newBlob, oldLines, newLines)
+		}
+	}
+}
@@ -0,0 +1,135 @@
+package framework_test
+
+import (
+	"context"
+	"testing"
+	"time"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/framework"
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
+)
+
+// serveFusedRequests answers CommitDiffsBatchRequests with one modified file
+// and one binary file per commit, whose blob hashes derive from the commit.
+func serveFusedRequests(ctx context.Context, t *testing.T, poolCh <-chan gitlib.WorkerRequest, requests chan<- int) {
+	t.Helper()
+
+	for {
+		select {
+		case req := <-poolCh:
+			typed, ok := req.(gitlib.CommitDiffsBatchRequest)
+			if !ok {
+				t.Errorf("expected fused requests only, got %T", req)
+
+				continue
+			}
+
+			requests <- len(typed.Requests)
+
+			var resp gitlib.CommitDiffsBatchResponse
+
+			resp.Results = make([]gitlib.CommitDiffsResult, len(typed.Requests))
+
+			for i, r := range typed.Requests {
+				oldHash := gitlib.Hash{0: r.CommitHash[0], 1: 1}
+				newHash := gitlib.Hash{0: r.CommitHash[0], 1: 2}
+
+				text := &gitlib.Change{
+					Action: gitlib.Modify,
+					From:   gitlib.ChangeEntry{Name: "a.txt", Hash: oldHash},
+					To:     gitlib.ChangeEntry{Name: "a.txt", Hash: newHash},
+				}
+				binary := &gitlib.Change{
+					Action: gitlib.Modify,
+					From:   gitlib.ChangeEntry{Name: "bin", Hash: gitlib.Hash{0: r.CommitHash[0], 1: 3}},
+					To:     gitlib.ChangeEntry{Name: "bin", Hash: gitlib.Hash{0: r.CommitHash[0], 1: 4}},
+				}
+
+				resp.Results[i].Changes = gitlib.Changes{text, binary}
+				resp.Results[i].FileDiffs = []gitlib.FileDiff{
+					{Change: text, DiffResult: gitlib.DiffResult{
+						OldLines: 1, NewLines: 2,
+						Ops: []gitlib.DiffOp{{Type: gitlib.DiffOpEqual, LineCount: 1}, {Type: gitlib.DiffOpInsert, LineCount: 1}},
+					}},
+					{Change: binary, DiffResult: gitlib.DiffResult{Error: gitlib.ErrDiffBinary}},
+				}
+
+				if typed.WithBlobs {
+					resp.Blobs = append(resp.Blobs,
+						gitlib.NewCachedBlobWithHashForTest(oldHash, []byte("a\n")),
+						gitlib.NewCachedBlobWithHashForTest(newHash, []byte("a\nb\n")))
+				}
+			}
+
+			typed.Response <- resp
+		case <-ctx.Done():
+			return
+		}
+	}
+}
+
+func TestFusedPipeline_Process(t *testing.T) {
+	t.Parallel()
+
+	for _, skipBlobData := range []bool{false, true} {
+		poolCh := make(chan gitlib.WorkerRequest, 10)
+		requests := make(chan int, 10)
+
+		pipeline := framework.NewFusedPipeline(poolCh, 10, 2)
+		pipeline.SkipBlobData = skipBlobData
+
+		commits := []*gitlib.Commit{
+			gitlib.NewCommitForTest(gitlib.Hash{0: 0x1}),
+			gitlib.NewCommitForTest(gitlib.Hash{0: 0x2}),
+			gitlib.NewCommitForTest(gitlib.Hash{0: 0x3}),
+		}
+
+		inputCh := make(chan framework.CommitBatch, 1)
+		inputCh <- framework.CommitBatch{Commits: commits, StartIndex: 5}
+
+		close(inputCh)
+
+		ctx, cancel := context.WithTimeout(context.Background(), 2*time.Second)
+
+		go serveFusedRequests(ctx, t, poolCh, requests)
+
+		index := 5
+
+		for data := range pipeline.Process(ctx, inputCh) {
+			if data.Index != index || data.Commit != commits[index-5] {
+				t.Errorf("expected commit %d in order, got %d", index, data.Index)
+			}
+
+			index++
+
+			if len(data.Changes) != 2 || len(data.FileDiffs) != 1 {
+				t.Errorf("commit %d: expected 2 changes and 1 file diff, got %d and %d",
+					data.Index, len(data.Changes), len(data.FileDiffs))
+			}
+
+			diff, ok := data.FileDiffs["a.txt"]
+			if !ok || diff.OldLinesOfCode != 1 || diff.NewLinesOfCode != 2 || len(diff.Diffs) != 2 {
+				t.Errorf("commit %d: unexpected diff %+v", data.Index, diff)
+			}
+
+			if skipBlobData != (data.BlobCache == nil) {
+				t.Errorf("commit %d: blob cache %v with SkipBlobData=%v", data.Index, data.BlobCache, skipBlobData)
+			}
+
+			if !skipBlobData && len(data.BlobCache) != 2 {
+				t.Errorf("commit %d: expected 2 cached blobs, got %d", data.Index, len(data.BlobCache))
+			}
+		}
+
+		cancel()
+
+		if index != 5+len(commits) {
+			t.Errorf("Expected %d output items, got %d", len(commits), index-5)
+		}
+
+		// Two workers: runs of 2 and 1 commits.
+		if first, second := <-requests, <-requests; first != 2 || second != 1 {
+			t.Errorf("Expected contiguous runs of 2 and 1 commits, got %d and %d", first, second)
+		}
+	}
+}
@@ -1124,6 +1124,9 @@ func setPipelineAttributes(span trace.Span, ps PipelineStats) {
 		attribute.Int64("cache.blob.misses", ps.BlobCacheMisses),
 		attribute.Int64("cache.diff.hits", ps.DiffCacheHits),
 		attribute.Int64("cache.diff.misses", ps.DiffCacheMisses),
+		attribute.Int64("cache.object.hits", ps.ObjectCacheHits),
+		attribute.Int64("cache.object.misses", ps.ObjectCacheMisses),
+		attribute.Int64("cache.object.evictions", ps.ObjectCacheEvictions),
 	)
 }
 
@@ -114,6 +114,9 @@ func RunStreaming(
 
 	cpManager := initCheckpointManager(ctx, logger, config.Checkpoint, config.RepoPath, len(analyzers), len(checkpointables))
 
+	closeDiffStore := attachDiffStore(ctx, logger, runner, config.Checkpoint, config.RepoPath)
+	defer closeDiffStore()
+
 	useDoubleBuffer := schedule.BufferingFactor >= doubleBufferBudgetDivisor
 
 	logger.InfoContext(ctx, "streaming: planning chunks",
@@ -194,6 +197,9 @@ func RunStreamingFromIterator(
 
 	cpManager := initCheckpointManager(ctx, logger, config.Checkpoint, config.RepoPath, len(analyzers), len(checkpointables))
 
+	closeDiffStore := attachDiffStore(ctx, logger, runner, config.Checkpoint, config.RepoPath)
+	defer closeDiffStore()
+
 	logger.InfoContext(ctx, "streaming: planning chunks (iterator mode)",
 		"commits", commitCount, "chunks", len(chunks))
 
@@ -435,6 +441,38 @@ func initCheckpointManager(
 	return cpManager
 }
 
+// attachDiffStore opens the repository's persistent diff store for the
+// runner's pipeline when checkpointing is enabled. The returned function
+// appends the diffs computed by this run and closes the store.
+func attachDiffStore(
+	ctx context.Context, logger *slog.Logger, runner *Runner, cpConfig CheckpointParams, repoPath string,
+) func() {
+	if !cpConfig.Enabled || runner.Config.DiffCacheSize <= 0 || runner.Config.FusedDiffs {
+		return func() {}
+	}
+
+	cpManager := checkpoint.NewManager(cpConfig.Dir, checkpoint.RepoHash(repoPath))
+
+	store, err := OpenDiffStore(cpManager.DiffStorePath(), cpManager.MaxSize,
+		CurrentDiffVariant(runner.Config.DiffAlgorithm))
+	if err != nil {
+		logger.WarnContext(ctx, "diff store: disabled", "error", err)
+
+		return func() {}
+	}
+
+	runner.Config.DiffStore = store
+
+	return func() {
+		runner.Config.DiffStore = nil
+
+		closeErr := store.Close()
+		if closeErr != nil {
+			logger.WarnContext(ctx, "diff store: failed to save", "error", closeErr)
+		}
+	}
+}
+
 // resolveStartChunk determines which chunk to start from, attempting checkpoint
 // resume if configured and available. The chunks parameter is used to validate
 // that checkpoint boundaries align with the current plan (which may differ from
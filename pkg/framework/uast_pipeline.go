@@ -3,8 +3,12 @@ package framework
 import (
 	"context"
 	"sync"
+	"unicode/utf8"
+
+	"github.com/sergi/go-diff/diffmatchpatch"
 
 	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
+	"github.com/Sumatoshi-tech/codefang/pkg/plumbing"
 	"github.com/Sumatoshi-tech/codefang/pkg/uast"
 	"github.com/Sumatoshi-tech/codefang/pkg/uast/pkg/node"
 )
@@ -16,6 +20,9 @@ type UASTPipeline struct {
 	Parser     *uast.Parser
 	Workers    int
 	BufferSize int
+	// TreeCache, if set, keeps the tree-sitter tree of each path's last
+	// version so a modified file is reparsed incrementally from its line diff.
+	TreeCache *uast.TreeCache
 }
 
 // NewUASTPipeline creates a new UAST pipeline stage.
@@ -104,7 +111,7 @@ func (p *UASTPipeline) startWorkers(ctx context.Context, jobs <-chan *uastSlot)
 			defer wg.Done()
 
 			for slot := range jobs {
-				slot.data.UASTChanges = p.parseCommitChanges(ctx, slot.data.Changes, slot.data.BlobCache)
+				slot.data.UASTChanges = p.parseCommitChanges(ctx, slot.data.Changes, slot.data.BlobCache, slot.data.FileDiffs)
 				close(slot.done)
 			}
 		}()
@@ -144,16 +151,17 @@ func (p *UASTPipeline) parseCommitChanges(
 	ctx context.Context,
 	changes gitlib.Changes,
 	cache map[gitlib.Hash]*gitlib.CachedBlob,
+	fileDiffs map[string]plumbing.FileDiffData,
 ) []uast.Change {
 	if len(changes) == 0 {
 		return nil
 	}
 
 	if len(changes) <= intraCommitParallelThreshold {
-		return p.parseCommitSequential(ctx, changes, cache)
+		return p.parseCommitSequential(ctx, changes, cache, fileDiffs)
 	}
 
-	return p.parseCommitParallel(ctx, changes, cache)
+	return p.parseCommitParallel(ctx, changes, cache, fileDiffs)
 }
 
 // parseCommitSequential parses files one at a time within a commit.
@@ -161,12 +169,13 @@ func (p *UASTPipeline) parseCommitSequential(
 	ctx context.Context,
 	changes gitlib.Changes,
 	cache map[gitlib.Hash]*gitlib.CachedBlob,
+	fileDiffs map[string]plumbing.FileDiffData,
 ) []uast.Change {
 	var result []uast.Change
 
 	for _, change := range changes {
-		before := p.parseBlob(ctx, change.From.Hash, change.From.Name, cache, change.Action, true)
-		after := p.parseBlob(ctx, change.To.Hash, change.To.Name, cache, change.Action, false)
+		before := p.parseBlob(ctx, change, cache, fileDiffs, true)
+		after := p.parseBlob(ctx, change, cache, fileDiffs, false)
 
 		if before != nil || after != nil {
 			result = append(result, uast.Change{
@@ -193,6 +202,7 @@ func (p *UASTPipeline) parseCommitParallel(
 	ctx context.Context,
 	changes gitlib.Changes,
 	cache map[gitlib.Hash]*gitlib.CachedBlob,
+	fileDiffs map[string]plumbing.FileDiffData,
 ) []uast.Change {
 	jobs := make(chan *gitlib.Change, len(changes))
 	results := make(chan uastFileResult, len(changes))
@@ -212,8 +222,8 @@ func (p *UASTPipeline) parseCommitParallel(
 			defer wg.Done()
 
 			for change := range jobs {
-				before := p.parseBlob(ctx, change.From.Hash, change.From.Name, cache, change.Action, true)
-				after := p.parseBlob(ctx, change.To.Hash, change.To.Name, cache, change.Action, false)
+				before := p.parseBlob(ctx, change, cache, fileDiffs, true)
+				after := p.parseBlob(ctx, change, cache, fileDiffs, false)
 
 				if before != nil || after != nil {
 					results <- uastFileResult{before, after, change}
@@ -246,12 +256,20 @@ func (p *UASTPipeline) parseCommitParallel(
 // isBefore indicates whether this is the "before" (old) or "after" (new) version.
 func (p *UASTPipeline) parseBlob(
 	ctx context.Context,
-	hash gitlib.Hash,
-	filename string,
+	change *gitlib.Change,
 	cache map[gitlib.Hash]*gitlib.CachedBlob,
-	action gitlib.ChangeAction,
+	fileDiffs map[string]plumbing.FileDiffData,
 	isBefore bool,
 ) *node.Node {
+	action := change.Action
+
+	entry := change.To
+	if isBefore {
+		entry = change.From
+	}
+
+	hash, filename := entry.Hash, entry.Name
+
 	// Check action relevance: before only for Modify/Delete, after only for Modify/Insert.
 	if isBefore && action != gitlib.Modify && action != gitlib.Delete {
 		return nil
@@ -270,10 +288,71 @@ func (p *UASTPipeline) parseBlob(
 		return nil
 	}
 
-	parsed, err := p.Parser.Parse(ctx, filename, blob.Data)
+	var (
+		parsed *node.Node
+		err    error
+	)
+
+	if p.TreeCache == nil {
+		parsed, err = p.Parser.Parse(ctx, filename, blob.Data)
+	} else {
+		// The before version is the tree cached from the previous commit as
+		// is; the after version is reparsed from it through the line diff.
+		var edits []uast.TextEdit
+		if !isBefore {
+			edits = lineEdits(change, cache, fileDiffs)
+		}
+
+		parsed, err = p.Parser.ParseIncremental(ctx, p.TreeCache, filename, change.From.Hash, hash, blob.Data, edits)
+	}
+
 	if err != nil {
 		return nil
 	}
 
 	return parsed
 }
+
+// lineEdits converts the line diff of a modified file into tree-sitter edits,
+// or returns nil if the diff is not available or does not match the blobs.
+func lineEdits(
+	change *gitlib.Change,
+	cache map[gitlib.Hash]*gitlib.CachedBlob,
+	fileDiffs map[string]plumbing.FileDiffData,
+) []uast.TextEdit {
+	if change.Action != gitlib.Modify {
+		return nil
+	}
+
+	fileDiff, ok := fileDiffs[change.To.Name]
+	oldBlob, oldOK := cache[change.From.Hash]
+	newBlob, newOK := cache[change.To.Hash]
+
+	if !ok || !oldOK || !newOK {
+		return nil
+	}
+
+	ops := make([]gitlib.DiffOp, 0, len(fileDiff.Diffs))
+
+	for _, diff := range fileDiff.Diffs {
+		op := gitlib.DiffOp{LineCount: utf8.RuneCountInString(diff.Text)}
+
+		switch diff.Type {
+		case diffmatchpatch.DiffEqual:
+			op.Type = gitlib.DiffOpEqual
+		case diffmatchpatch.DiffInsert:
+			op.Type = gitlib.DiffOpInsert
+		case diffmatchpatch.DiffDelete:
+			op.Type = gitlib.DiffOpDelete
+		}
+
+		ops = append(ops, op)
+	}
+
+	edits, ok := uast.LineEdits(oldBlob.Data, newBlob.Data, ops)
+	if !ok {
+		return nil
+	}
+
+	return edits
+}
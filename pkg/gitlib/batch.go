@@ -3,6 +3,7 @@ package gitlib
 import (
 	"context"
 	"sync"
+	"time"
 )
 
 // Default batch processing configuration values.
@@ -15,14 +16,27 @@ const (
 
 // BatchConfig configures batch processing parameters.
 type BatchConfig struct {
-	// BlobBatchSize is the number of blobs to load per batch.
+	// BlobBatchSize is the number of blobs to load per batch, or the first
+	// batch size when batches are sized adaptively.
 	// Default: 100.
 	BlobBatchSize int
 
-	// DiffBatchSize is the number of diffs to compute per batch.
+	// DiffBatchSize is the number of diffs to compute per batch, or the first
+	// batch size when batches are sized adaptively.
 	// Default: 50.
 	DiffBatchSize int
 
+	// TargetBatchLatency makes the streamers and the coordinator's blob and
+	// diff pipelines size batches from the cost of earlier ones (see
+	// BatchSizer) so each native call takes about this long.
+	// Default: 0 (fixed batch sizes).
+	TargetBatchLatency time.Duration
+
+	// BatchMemoryBudget caps the memory one native batch call may hold, by
+	// the same adaptive sizing.
+	// Default: 0 (no limit).
+	BatchMemoryBudget int64
+
 	// Workers is the number of parallel workers for processing.
 	// Default: 1 (sequential processing within gitlib).
 	Workers int
@@ -37,6 +51,16 @@ func DefaultBatchConfig() BatchConfig {
 	}
 }
 
+// blobSizer returns a sizer for blob batches of the configuration.
+func (c BatchConfig) blobSizer() *BatchSizer {
+	return NewBatchSizer(c.BlobBatchSize, c.TargetBatchLatency, c.BatchMemoryBudget)
+}
+
+// diffSizer returns a sizer for diff batches of the configuration.
+func (c BatchConfig) diffSizer() *BatchSizer {
+	return NewBatchSizer(c.DiffBatchSize, c.TargetBatchLatency, c.BatchMemoryBudget)
+}
+
 // BlobBatch represents a batch of loaded blobs.
 type BlobBatch struct {
 	// Blobs contains the loaded blob data.
@@ -89,6 +113,7 @@ func NewBlobStreamer(repo *Repository, config BatchConfig) *BlobStreamer {
 type blobStreamState struct {
 	streamer *BlobStreamer
 	out      chan<- BlobBatch
+	sizer    *BatchSizer
 	batchID  int
 	buffer   []Hash
 }
@@ -100,6 +125,8 @@ func (st *blobStreamState) flush(ctx context.Context) bool {
 	}
 
 	results := st.streamer.bridge.BatchLoadBlobs(st.buffer)
+	st.sizer.Observe(st.streamer.bridge.LastCost())
+
 	blobs := make([]*CachedBlob, len(results))
 
 	for i, r := range results {
@@ -127,7 +154,7 @@ func (st *blobStreamState) processHashes(ctx context.Context, hashBatch []Hash)
 	for _, h := range hashBatch {
 		st.buffer = append(st.buffer, h)
 
-		if len(st.buffer) >= st.streamer.config.BlobBatchSize {
+		if len(st.buffer) >= st.sizer.Size() {
 			if !st.flush(ctx) {
 				return false
 			}
@@ -148,6 +175,7 @@ func (s *BlobStreamer) Stream(ctx context.Context, hashes <-chan []Hash) <-chan
 		st := &blobStreamState{
 			streamer: s,
 			out:      out,
+			sizer:    s.config.blobSizer(),
 			buffer:   make([]Hash, 0, s.config.BlobBatchSize),
 		}
 
@@ -190,37 +218,80 @@ func NewDiffStreamer(repo *Repository, config BatchConfig) *DiffStreamer {
 	}
 }
 
-// diffStreamState holds the state for diff streaming.
+// diffStreamState holds the state for diff streaming. Batches are double
+// buffered: batch k+1 is diffed natively (see CGOBridge.SubmitDiffBatch)
+// while batch k waits for and is processed by the consumer.
 type diffStreamState struct {
-	streamer *DiffStreamer
-	out      chan<- DiffBatch
-	batchID  int
-	buffer   []DiffRequest
+	streamer        *DiffStreamer
+	out             chan<- DiffBatch
+	sizer           *BatchSizer
+	batchID         int
+	buffer          []DiffRequest
+	pending         *DiffTicket
+	pendingRequests []DiffRequest
 }
 
-// flush sends the current buffer as a batch.
+// flush submits the buffered requests, then sends the batch submitted
+// before them.
 func (st *diffStreamState) flush(ctx context.Context) bool {
 	if len(st.buffer) == 0 {
 		return true
 	}
 
-	results := st.streamer.bridge.BatchDiffBlobs(st.buffer)
+	prev, hasPrev := st.collect()
+
+	st.pending = st.streamer.bridge.SubmitDiffBatch(st.buffer, false)
+	st.pendingRequests = append([]DiffRequest{}, st.buffer...)
+	st.buffer = st.buffer[:0]
+
+	if !hasPrev {
+		return true
+	}
+
+	return st.send(ctx, prev)
+}
+
+// collect waits for the submitted batch, if any.
+func (st *diffStreamState) collect() (DiffBatch, bool) {
+	if st.pending == nil {
+		return DiffBatch{}, false
+	}
+
 	batch := DiffBatch{
-		Diffs:    results,
-		Requests: append([]DiffRequest{}, st.buffer...),
+		Diffs:    st.pending.Wait(),
+		Requests: st.pendingRequests,
 		BatchID:  st.batchID,
 	}
 
+	st.sizer.Observe(st.pending.Cost())
+
+	st.pending = nil
+	st.pendingRequests = nil
+
+	return batch, true
+}
+
+// send sends a batch to the output channel.
+func (st *diffStreamState) send(ctx context.Context, batch DiffBatch) bool {
 	select {
 	case st.out <- batch:
 		st.batchID++
+
+		return true
 	case <-ctx.Done():
 		return false
 	}
+}
 
-	st.buffer = st.buffer[:0]
+// finish flushes the buffer and sends the last submitted batch.
+func (st *diffStreamState) finish(ctx context.Context) {
+	if !st.flush(ctx) {
+		return
+	}
 
-	return true
+	if batch, ok := st.collect(); ok {
+		st.send(ctx, batch)
+	}
 }
 
 // processRequests adds requests to the buffer, flushing when full.
@@ -228,7 +299,7 @@ func (st *diffStreamState) processRequests(ctx context.Context, reqBatch []DiffR
 	for _, req := range reqBatch {
 		st.buffer = append(st.buffer, req)
 
-		if len(st.buffer) >= st.streamer.config.DiffBatchSize {
+		if len(st.buffer) >= st.sizer.Size() {
 			if !st.flush(ctx) {
 				return false
 			}
@@ -255,16 +326,23 @@ func (s *DiffStreamer) runDiffStream(ctx context.Context, requests <-chan []Diff
 	st := &diffStreamState{
 		streamer: s,
 		out:      out,
+		sizer:    s.config.diffSizer(),
 		buffer:   make([]DiffRequest, 0, s.config.DiffBatchSize),
 	}
 
+	// A batch still running natively on cancellation must be collected
+	// before the repository can be used again; the worker thread is only
+	// kept for the stream.
+	defer s.bridge.Free()
+	defer st.collect()
+
 	for {
 		select {
 		case <-ctx.Done():
 			return
 		case reqBatch, ok := <-requests:
 			if !ok {
-				st.flush(ctx)
+				st.finish(ctx)
 
 				return
 			}
@@ -303,6 +381,14 @@ func (p *BatchProcessor) LoadBlobs(hashes []Hash) []BlobResult {
 	return p.bridge.BatchLoadBlobs(hashes)
 }
 
+// ProbeBlobs reports blob sizes (and optionally binary content) without loading them.
+func (p *BatchProcessor) ProbeBlobs(hashes []Hash, sniffBinary bool) []BlobProbe {
+	p.mu.Lock()
+	defer p.mu.Unlock()
+
+	return p.bridge.BatchProbeBlobs(hashes, sniffBinary)
+}
+
 // ComputeDiffs computes a batch of diffs synchronously.
 // Use this for simpler cases where streaming isn't needed.
 func (p *BatchProcessor) ComputeDiffs(requests []DiffRequest) []DiffResult {
@@ -0,0 +1,121 @@
+package gitlib
+
+/*
+#include "codefang_git.h"
+*/
+import "C"
+
+import (
+	"sync"
+	"time"
+)
+
+// BatchCost is what one native batch call spent, as reported by the C layer
+// (see CGOBridge.LastCost and DiffTicket.Cost).
+type BatchCost struct {
+	// Items is the number of requests in the batch.
+	Items int
+	// BytesInflated is the blob content read from the object database.
+	BytesInflated int64
+	// BytesCopied is the blob content and diff ops copied into results.
+	BytesCopied int64
+	// InflateTime and DiffTime are the wall time spent reading objects and
+	// diffing; blob reads not preloaded by a diff batch count as DiffTime.
+	InflateTime time.Duration
+	DiffTime    time.Duration
+	// PeakBytes is the result and preloaded memory the call held at once.
+	PeakBytes int64
+}
+
+func newBatchCost(c *C.cf_batch_cost, items int) BatchCost {
+	return BatchCost{
+		Items:         items,
+		BytesInflated: int64(c.bytes_inflated),
+		BytesCopied:   int64(c.bytes_copied),
+		InflateTime:   time.Duration(c.inflate_ns),
+		DiffTime:      time.Duration(c.diff_ns),
+		PeakBytes:     int64(c.peak_bytes),
+	}
+}
+
+// Duration returns the wall time of the call.
+func (c BatchCost) Duration() time.Duration {
+	return c.InflateTime + c.DiffTime
+}
+
+// Batch sizing parameters.
+const (
+	// batchCostSmoothing is the weight of the newest batch in the per-item
+	// averages.
+	batchCostSmoothing = 0.25
+	// maxBatchGrowth caps adaptive batches at this multiple of the
+	// configured size.
+	maxBatchGrowth = 8
+)
+
+// BatchSizer picks batch sizes from the costs of earlier batches so each
+// native call takes about the target latency and holds at most the memory
+// budget. Per-item time and memory are smoothed over batches, sizes stay
+// between 1 and maxBatchGrowth times the initial size, and until a batch
+// has been observed, or with neither a target nor a budget, the initial
+// size is used. Safe for concurrent use, so pipelines issuing batches from
+// one goroutine and collecting them in others can share one sizer.
+type BatchSizer struct {
+	mu        sync.Mutex
+	initial   int
+	target    time.Duration
+	budget    int64
+	itemNanos float64
+	itemBytes float64
+	observed  bool
+}
+
+// NewBatchSizer creates a sizer starting at initial items per batch.
+// A zero target or budget ignores that limit.
+func NewBatchSizer(initial int, target time.Duration, budget int64) *BatchSizer {
+	return &BatchSizer{initial: max(initial, 1), target: target, budget: budget}
+}
+
+// Observe records the cost of a finished batch.
+func (s *BatchSizer) Observe(cost BatchCost) {
+	if cost.Items <= 0 {
+		return
+	}
+
+	s.mu.Lock()
+	defer s.mu.Unlock()
+
+	nanos := float64(cost.Duration()) / float64(cost.Items)
+	bytes := float64(cost.PeakBytes) / float64(cost.Items)
+
+	if !s.observed {
+		s.itemNanos, s.itemBytes, s.observed = nanos, bytes, true
+
+		return
+	}
+
+	s.itemNanos += (nanos - s.itemNanos) * batchCostSmoothing
+	s.itemBytes += (bytes - s.itemBytes) * batchCostSmoothing
+}
+
+// Size returns the number of items for the next batch.
+func (s *BatchSizer) Size() int {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+
+	if !s.observed || (s.target <= 0 && s.budget <= 0) {
+		return s.initial
+	}
+
+	size := float64(s.initial * maxBatchGrowth)
+
+	if s.target > 0 && s.itemNanos > 0 {
+		size = min(size, float64(s.target)/s.itemNanos)
+	}
+
+	if s.budget > 0 && s.itemBytes > 0 {
+		size = min(size, float64(s.budget)/s.itemBytes)
+	}
+
+	return max(int(size), 1)
+}
@@ -2,6 +2,7 @@ package gitlib_test
 
 import (
 	"context"
+	"strings"
 	"testing"
 
 	"github.com/stretchr/testify/require"
@@ -356,3 +357,49 @@ func TestDiffStreamer_Stream(t *testing.T) {
 	require.NoError(t, batches[0].Diffs[0].Error)
 	require.NotEmpty(t, batches[0].Diffs[0].Ops)
 }
+
+func TestDiffStreamer_StreamDoubleBuffered(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	const batchCount = 3
+
+	reqCh := make(chan []gitlib.DiffRequest, batchCount)
+
+	for i := range batchCount {
+		reqCh <- []gitlib.DiffRequest{{
+			OldData: []byte("a\n"),
+			NewData: []byte(strings.Repeat("a\n", i+2)),
+			HasOld:  true,
+			HasNew:  true,
+		}}
+	}
+
+	close(reqCh)
+
+	streamer := gitlib.NewDiffStreamer(repo, gitlib.BatchConfig{DiffBatchSize: 1})
+
+	var batches []gitlib.DiffBatch
+	for b := range streamer.Stream(context.Background(), reqCh) {
+		batches = append(batches, b)
+	}
+
+	// Batches come out in order although each one is diffed while the one
+	// before it is consumed.
+	require.Len(t, batches, batchCount)
+
+	for i, b := range batches {
+		require.Equal(t, i, b.BatchID)
+		require.Len(t, b.Diffs, 1)
+		require.NoError(t, b.Diffs[0].Error)
+		require.Equal(t, i+2, b.Diffs[0].NewLines)
+		require.Len(t, b.Requests, 1)
+	}
+}
@@ -2,6 +2,7 @@ package gitlib_test
 
 import (
 	"testing"
+	"time"
 
 	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
 )
@@ -22,6 +23,80 @@ func TestDefaultBatchConfig(t *testing.T) {
 	if config.Workers != 1 {
 		t.Errorf("Workers = %d, want 1", config.Workers)
 	}
+
+	if config.TargetBatchLatency != 0 || config.BatchMemoryBudget != 0 {
+		t.Errorf("adaptive sizing should be off by default")
+	}
+}
+
+func TestBatchSizer_FixedWithoutTargets(t *testing.T) {
+	t.Parallel()
+
+	s := gitlib.NewBatchSizer(100, 0, 0)
+	s.Observe(gitlib.BatchCost{Items: 100, DiffTime: time.Second, PeakBytes: 1 << 30})
+
+	if got := s.Size(); got != 100 {
+		t.Errorf("Size = %d, want 100", got)
+	}
+}
+
+func TestBatchSizer_InitialUntilObserved(t *testing.T) {
+	t.Parallel()
+
+	s := gitlib.NewBatchSizer(50, 10*time.Millisecond, 0)
+
+	if got := s.Size(); got != 50 {
+		t.Errorf("Size = %d, want 50", got)
+	}
+
+	// Batches without items carry no cost information.
+	s.Observe(gitlib.BatchCost{})
+
+	if got := s.Size(); got != 50 {
+		t.Errorf("Size = %d, want 50", got)
+	}
+}
+
+func TestBatchSizer_TargetLatency(t *testing.T) {
+	t.Parallel()
+
+	s := gitlib.NewBatchSizer(50, 10*time.Millisecond, 0)
+
+	// 1ms per item: 10 items fit the target.
+	s.Observe(gitlib.BatchCost{Items: 50, InflateTime: 20 * time.Millisecond, DiffTime: 30 * time.Millisecond})
+
+	if got := s.Size(); got != 10 {
+		t.Errorf("Size = %d, want 10", got)
+	}
+
+	// Cheap items grow batches up to the cap.
+	for range 100 {
+		s.Observe(gitlib.BatchCost{Items: 10, DiffTime: time.Microsecond})
+	}
+
+	if got := s.Size(); got != 400 {
+		t.Errorf("Size = %d, want 400", got)
+	}
+}
+
+func TestBatchSizer_MemoryBudget(t *testing.T) {
+	t.Parallel()
+
+	s := gitlib.NewBatchSizer(100, time.Second, 1<<20)
+
+	// 64 KiB per item: 16 items fit the budget, well before the latency target.
+	s.Observe(gitlib.BatchCost{Items: 100, DiffTime: time.Millisecond, PeakBytes: 100 << 16})
+
+	if got := s.Size(); got != 16 {
+		t.Errorf("Size = %d, want 16", got)
+	}
+
+	// Never below one item.
+	s.Observe(gitlib.BatchCost{Items: 1, PeakBytes: 1 << 40})
+
+	if got := s.Size(); got != 1 {
+		t.Errorf("Size = %d, want 1", got)
+	}
 }
 
 func TestBlobBatch(t *testing.T) {
@@ -7,20 +7,32 @@ package gitlib
 
 // Link the C source files
 #include "clib/utils.c"
+#include "clib/stats.c"
+#include "clib/alloc_pool.c"
+#include "clib/text_scan.c"
+#include "clib/odb_cache.c"
+#include "clib/repo_budget.c"
+#include "clib/pack_order.c"
+#include "clib/rename_ops.c"
 #include "clib/blob_ops.c"
 #include "clib/diff_ops.c"
+#include "clib/async_ops.c"
+#include "clib/revwalk.c"
 */
 import "C"
 
 import (
 	"reflect"
 	"runtime"
+	"sync"
+	"sync/atomic"
 	"unsafe"
 )
 
 func init() {
-	// Initialize C library settings
-	// This sets OMP_NUM_THREADS=1 to prevent thread oversubscription
+	// Initialize C library settings.
+	// The thread budget starts at 1, so batches run sequentially until
+	// ConfigureParallelism raises it.
 	C.cf_init()
 }
 
@@ -28,9 +40,13 @@ func init() {
 // arena count. mwindowLimit caps mmap'd pack data (default 8 GiB on 64-bit).
 // cacheLimit caps the decompressed object cache (default 256 MiB).
 // mallocArenaMax caps glibc malloc arenas (default 8*cores, causes RSS bloat).
+// allocPoolSize installs a size-class pool of that many bytes for libgit2's
+// small allocations, so per-commit garbage does not fragment the heap; it is
+// installed once per process.
 // Pass 0 for any to leave unchanged. Must be called before opening repos.
-func ConfigureMemoryLimits(mwindowLimit, cacheLimit int64, mallocArenaMax int) error {
-	rc := C.cf_configure_memory(C.size_t(mwindowLimit), C.size_t(cacheLimit), C.int(mallocArenaMax))
+func ConfigureMemoryLimits(mwindowLimit, cacheLimit int64, mallocArenaMax int, allocPoolSize int64) error {
+	rc := C.cf_configure_memory(C.size_t(mwindowLimit), C.size_t(cacheLimit), C.int(mallocArenaMax),
+		C.size_t(allocPoolSize))
 	if rc != 0 {
 		return ErrConfigureMemory
 	}
@@ -38,12 +54,82 @@ func ConfigureMemoryLimits(mwindowLimit, cacheLimit int64, mallocArenaMax int) e
 	return nil
 }
 
+// ConfigureLargeBlobThreshold sets the process-wide size in bytes above
+// which the C layer never holds a blob in memory whole, so a few huge
+// generated files cannot blow up a batch. Such blobs load as BlobResults
+// with ErrBlobTooLarge, their line count and binary flag computed in
+// chunks, and their diffs fail with ErrDiffTooLarge. Worker responses and
+// streamed batches have no CachedBlob for them, so analyzers skip them like
+// unreadable blobs. 0, the default, disables the limit.
+func ConfigureLargeBlobThreshold(bytes int64) {
+	C.cf_set_large_blob_threshold(C.size_t(max(bytes, 0)))
+}
+
+// ConfigureNativeLineDiff makes the C layer diff Myers, minimal and
+// histogram requests with its native line engine, which emits run-length ops
+// without libgit2's per-line callbacks and matches the alignments of git's
+// xdiff. Off by default, when libgit2 diffs every request and histogram runs
+// as patience. Process-wide; set it before diffing.
+func ConfigureNativeLineDiff(enabled bool) {
+	var on C.int
+	if enabled {
+		on = 1
+	}
+
+	nativeLineDiff.Store(enabled)
+	C.cf_set_native_line_diff(on)
+}
+
+// nativeLineDiff mirrors the C switch set by ConfigureNativeLineDiff.
+var nativeLineDiff atomic.Bool
+
+// CurrentDiffEngine reports the engine BatchDiffBlobs currently diffs with.
+func CurrentDiffEngine() DiffEngine {
+	if nativeLineDiff.Load() {
+		return DiffEngineNative
+	}
+
+	return DiffEngineLibgit2
+}
+
+// ConfigureParallelism sets the process-wide number of threads the C batch
+// operations may use at once. Concurrent batches from several workers share
+// this budget rather than each spawning their own threads, so one worker can
+// use idle cores for a large batch without over-subscribing the machine.
+// Returns the effective budget, which is always 1 unless built with the
+// openmp build tag.
+func ConfigureParallelism(threads int) int {
+	return int(C.cf_set_parallelism(C.int(threads)))
+}
+
 // CGOBridge provides optimized batch operations using the C library.
-// It minimizes CGO overhead by processing multiple items per call.
+// It minimizes CGO overhead by processing multiple items per call. It
+// recycles its C buffers, so it is not safe for concurrent use.
 type CGOBridge struct {
-	repo       *Repository
-	requestBuf []C.cf_blob_request
-	resultBuf  []C.cf_blob_arena_result
+	repo      *Repository
+	resultBuf []C.cf_blob_arena_result
+	diffOpBuf []C.cf_diff_op
+	paths     *PathInterner
+
+	// C request and result arrays recycled across calls (see recycle), so
+	// the small batches of the streamers allocate nothing to set up.
+	blobResults    []C.cf_blob_result
+	probeResults   []C.cf_blob_probe_result
+	borrowResults  []C.cf_blob_borrow_result
+	diffRequests   []C.cf_diff_request
+	diffResults    []C.cf_diff_flat_result
+	commitRequests []C.cf_commit_diff_request
+	commitInfos    []C.cf_commit_diff_info
+
+	lastCost BatchCost
+
+	// Native diff worker of SubmitDiffBatch, started on first use, and the
+	// ticket submitted to it and not collected yet. While inFlight is set
+	// the worker owns the repository handle and every batch call fails
+	// with ErrBridgeBusy.
+	worker        *C.cf_diff_worker
+	workerCleanup runtime.Cleanup
+	inFlight      *DiffTicket
 }
 
 // NewCGOBridge creates a new CGO bridge for the given repository.
@@ -51,10 +137,69 @@ func NewCGOBridge(repo *Repository) *CGOBridge {
 	return &CGOBridge{repo: repo}
 }
 
-// getRepoPtr extracts the underlying C pointer from git2go.Repository.
+// LastCost returns what the most recent batch call of the bridge spent in
+// C. BatchProbeBlobs leaves it unchanged; a submitted diff batch counts
+// once its ticket is collected, when it also reports the cost through
+// DiffTicket.Cost.
+func (b *CGOBridge) LastCost() BatchCost {
+	return b.lastCost
+}
+
+// recordCost keeps the cost of a finished batch call for LastCost and
+// charges it to the budget of repoPtr, if one is attached. Charging here,
+// on the goroutine that made the call, keeps budget accounting out of the
+// native batch code and its threads.
+func (b *CGOBridge) recordCost(repoPtr unsafe.Pointer, cost *C.cf_batch_cost, items int) {
+	b.lastCost = newBatchCost(cost, items)
+
+	C.cf_repo_budget_charge((*C.git_repository)(repoPtr), cost)
+}
+
+// recycle returns *buf resized to n zeroed elements, growing it with
+// headroom when it is too small.
+func recycle[T any](buf *[]T, n int) []T {
+	if cap(*buf) < n {
+		*buf = make([]T, n, n*bufferGrowthFactor)
+	} else {
+		*buf = (*buf)[:n]
+		clear(*buf)
+	}
+
+	return *buf
+}
+
+// blobRequests passes hashes to C as a cf_blob_request array. A request is
+// exactly one raw OID (asserted in codefang_git.h), so the packed hashes
+// are used in place. They hold no Go pointers and C does not keep them, so
+// they need no pinning.
+func blobRequests(hashes []Hash) *C.cf_blob_request {
+	return (*C.cf_blob_request)(unsafe.Pointer(&hashes[0]))
+}
+
+// cOid returns h as a C object ID.
+func cOid(h *Hash) C.git_oid {
+	return *(*C.git_oid)(unsafe.Pointer(h))
+}
+
+// getRepoPtr returns the libgit2 repository pointer of the bridge's
+// repository, or ErrBridgeBusy while a submitted diff batch owns it.
+func (b *CGOBridge) getRepoPtr() (unsafe.Pointer, error) {
+	if b.inFlight != nil {
+		return nil, ErrBridgeBusy
+	}
+
+	repoPtr := b.repo.nativePtr()
+	if repoPtr == nil {
+		return nil, ErrRepositoryPointer
+	}
+
+	return repoPtr, nil
+}
+
+// nativePtr extracts the underlying C pointer from git2go.Repository.
 // Uses reflection to access the unexported 'ptr' field.
-func (b *CGOBridge) getRepoPtr() unsafe.Pointer {
-	v := reflect.ValueOf(b.repo.repo)
+func (r *Repository) nativePtr() unsafe.Pointer {
+	v := reflect.ValueOf(r.repo)
 	if v.Kind() == reflect.Ptr {
 		v = v.Elem()
 	}
@@ -67,7 +212,22 @@ func (b *CGOBridge) getRepoPtr() unsafe.Pointer {
 	return ptrField.UnsafePointer()
 }
 
+// forgetPackLocator drops the pack indexes the C layer mapped for this
+// handle. Called by Free.
+func (r *Repository) forgetPackLocator() {
+	if r.repo == nil {
+		return
+	}
+
+	if repoPtr := r.nativePtr(); repoPtr != nil {
+		C.cf_pack_locator_forget((*C.git_repository)(repoPtr))
+	}
+}
+
 // BlobResult represents the result of loading a single blob.
+// A blob above the large blob threshold (see ConfigureLargeBlobThreshold)
+// has Error ErrBlobTooLarge and no Data, but still its Size, IsBinary and
+// LineCount.
 type BlobResult struct {
 	Hash      Hash
 	Data      []byte
@@ -78,6 +238,29 @@ type BlobResult struct {
 	KeepAlive any
 }
 
+// setMeta fills the blob metadata reported by the C loaders.
+func (r *BlobResult) setMeta(size C.size_t, isBinary, lineCount C.int) {
+	r.Size = int64(size)
+	r.IsBinary = isBinary != 0
+	r.LineCount = int(lineCount)
+}
+
+// setTooLarge marks a blob the C loaders scanned instead of loading.
+func (r *BlobResult) setTooLarge(size C.size_t, isBinary, lineCount C.int) {
+	r.setMeta(size, isBinary, lineCount)
+	r.Error = ErrBlobTooLarge
+}
+
+// BlobProbe describes a blob without its content (see CGOBridge.BatchProbeBlobs).
+type BlobProbe struct {
+	Hash Hash
+	Size int64
+	// Sniffed reports whether IsBinary was computed.
+	Sniffed  bool
+	IsBinary bool
+	Error    error
+}
+
 // DiffOpType represents the type of diff operation.
 type DiffOpType int
 
@@ -97,99 +280,92 @@ type DiffOp struct {
 	LineCount int
 }
 
+// DiffOpPosition is where a DiffOp starts in the old and new blob. An insert
+// starts at the old line it is inserted before and a delete at the new line
+// it was removed before; an op ends where the next one starts.
+type DiffOpPosition struct {
+	OldLine   int   // 0-based first old line.
+	NewLine   int   // 0-based first new line.
+	OldOffset int64 // Byte offset of OldLine in the old blob.
+	NewOffset int64 // Byte offset of NewLine in the new blob.
+}
+
 // DiffResult represents the result of diffing two blobs.
 type DiffResult struct {
 	OldLines int
 	NewLines int
 	Ops      []DiffOp
-	Error    error
+	// Positions is parallel to Ops; only set by BatchDiffBlobsWithPositions
+	// and by SubmitDiffBatch with positions.
+	Positions []DiffOpPosition
+	Error     error
 }
 
 // DiffRequest represents a request to diff two blobs.
 type DiffRequest struct {
-	OldHash Hash
-	NewHash Hash
-	OldData []byte
-	NewData []byte
-	HasOld  bool
-	HasNew  bool
+	OldHash   Hash
+	NewHash   Hash
+	OldData   []byte
+	NewData   []byte
+	HasOld    bool
+	HasNew    bool
+	Algorithm DiffAlgorithm
 }
 
 // BatchLoadBlobsArena loads multiple blobs into a provided arena.
-// It uses internal recycled buffers for C requests/results to avoid allocation.
+// Hashes are passed to C in place and the C results use a recycled buffer,
+// so only the returned results are allocated.
 func (b *CGOBridge) BatchLoadBlobsArena(hashes []Hash, arena []byte) []BlobResult {
 	count := len(hashes)
 	if count == 0 {
 		return nil
 	}
 
-	repoPtr := b.getRepoPtr()
-	if repoPtr == nil {
+	repoPtr, ptrErr := b.getRepoPtr()
+	if ptrErr != nil {
 		results := make([]BlobResult, count)
 		for i := range results {
-			results[i].Error = ErrRepositoryPointer
+			results[i].Error = ptrErr
 		}
 
 		return results
 	}
 
-	// Ensure internal buffers are sufficient
-	if cap(b.requestBuf) < count {
-		b.requestBuf = make([]C.cf_blob_request, count, count*bufferGrowthFactor) // Grow with some headroom
-	} else {
-		b.requestBuf = b.requestBuf[:count]
-	}
-
-	if cap(b.resultBuf) < count {
-		b.resultBuf = make([]C.cf_blob_arena_result, count, count*bufferGrowthFactor)
-	} else {
-		b.resultBuf = b.resultBuf[:count]
-	}
-
-	// Prepare C requests
-	for i, h := range hashes {
-		for j := range 20 {
-			b.requestBuf[i].oid.id[j] = C.uchar(h[j])
-		}
-	}
-
-	// Pin memory
-	var pinner runtime.Pinner
-	pinner.Pin(&b.requestBuf[0])
-	pinner.Pin(&b.resultBuf[0])
-	if len(arena) > 0 {
-		pinner.Pin(&arena[0])
-	}
-	defer pinner.Unpin()
+	cResults := recycle(&b.resultBuf, count)
 
 	var arenaPtr unsafe.Pointer
 	if len(arena) > 0 {
 		arenaPtr = unsafe.Pointer(&arena[0])
 	}
 
+	var cCost C.cf_batch_cost
+
 	C.cf_batch_load_blobs_arena(
 		(*C.git_repository)(repoPtr),
-		&b.requestBuf[0],
+		blobRequests(hashes),
 		C.int(count),
 		arenaPtr,
 		C.size_t(len(arena)),
-		&b.resultBuf[0],
+		&cResults[0],
+		&cCost,
 	)
 
+	b.recordCost(repoPtr, &cCost, count)
+
 	// Convert results
 	results := make([]BlobResult, count)
-	for i, cRes := range b.resultBuf {
+	for i, cRes := range cResults {
 		results[i].Hash = hashes[i]
 
 		switch {
 		case cRes.error == C.CF_ERR_ARENA_FULL:
 			results[i].Error = ErrArenaFull
+		case cRes.error == C.CF_ERR_TOO_LARGE:
+			results[i].setTooLarge(cRes.size, cRes.is_binary, cRes.line_count)
 		case cRes.error != C.CF_OK:
 			results[i].Error = cgoBlobError(int(cRes.error))
 		default:
-			results[i].Size = int64(cRes.size)
-			results[i].IsBinary = cRes.is_binary != 0
-			results[i].LineCount = int(cRes.line_count)
+			results[i].setMeta(cRes.size, cRes.is_binary, cRes.line_count)
 
 			// Slice from arena
 			offset := int(cRes.offset)
@@ -212,58 +388,51 @@ func (b *CGOBridge) BatchLoadBlobs(hashes []Hash) []BlobResult {
 		return nil
 	}
 
-	repoPtr := b.getRepoPtr()
-	if repoPtr == nil {
+	repoPtr, ptrErr := b.getRepoPtr()
+	if ptrErr != nil {
 		// Return errors for all requests
 		results := make([]BlobResult, len(hashes))
 		for i := range results {
 			results[i].Hash = hashes[i]
-			results[i].Error = ErrRepositoryPointer
+			results[i].Error = ptrErr
 		}
 
 		return results
 	}
 
-	// Prepare C requests
-	cRequests := make([]C.cf_blob_request, len(hashes))
-	for i, h := range hashes {
-		for j := range 20 {
-			cRequests[i].oid.id[j] = C.uchar(h[j])
-		}
-	}
+	cResults := recycle(&b.blobResults, len(hashes))
 
-	// Prepare C results
-	cResults := make([]C.cf_blob_result, len(hashes))
-
-	// Pin memory to prevent GC movement during CGO call
-	var pinner runtime.Pinner
-	pinner.Pin(&cRequests[0])
-	pinner.Pin(&cResults[0])
+	var cCost C.cf_batch_cost
 
 	// Single CGO call to load all blobs
 	C.cf_batch_load_blobs(
 		(*C.git_repository)(repoPtr),
-		&cRequests[0],
+		blobRequests(hashes),
 		C.int(len(hashes)),
 		&cResults[0],
+		&cCost,
 	)
 
-	pinner.Unpin()
+	b.recordCost(repoPtr, &cCost, len(hashes))
 
 	// Convert C results to Go
 	results := make([]BlobResult, len(hashes))
 	for i, cRes := range cResults {
 		results[i].Hash = hashes[i]
 
+		if cRes.error == C.CF_ERR_TOO_LARGE {
+			results[i].setTooLarge(cRes.size, cRes.is_binary, cRes.line_count)
+
+			continue
+		}
+
 		if cRes.error != C.CF_OK {
 			results[i].Error = cgoBlobError(int(cRes.error))
 
 			continue
 		}
 
-		results[i].Size = int64(cRes.size)
-		results[i].IsBinary = cRes.is_binary != 0
-		results[i].LineCount = int(cRes.line_count)
+		results[i].setMeta(cRes.size, cRes.is_binary, cRes.line_count)
 
 		// Copy data from C to Go memory
 		if cRes.size > 0 && cRes.data != nil {
@@ -279,6 +448,161 @@ func (b *CGOBridge) BatchLoadBlobs(hashes []Hash) []BlobResult {
 	return results
 }
 
+// BatchProbeBlobs reports the size of multiple blobs in a single CGO call
+// without loading them. With sniffBinary, IsBinary is also computed from the
+// first bytes of each blob, matching CachedBlob.IsBinary. Lets callers skip
+// large or binary blobs before paying for a full load.
+func (b *CGOBridge) BatchProbeBlobs(hashes []Hash, sniffBinary bool) []BlobProbe {
+	if len(hashes) == 0 {
+		return nil
+	}
+
+	results := make([]BlobProbe, len(hashes))
+
+	repoPtr, ptrErr := b.getRepoPtr()
+	if ptrErr != nil {
+		for i := range results {
+			results[i].Hash = hashes[i]
+			results[i].Error = ptrErr
+		}
+
+		return results
+	}
+
+	cResults := recycle(&b.probeResults, len(hashes))
+
+	var flags C.int
+	if sniffBinary {
+		flags = C.CF_PROBE_SNIFF_BINARY
+	}
+
+	C.cf_batch_probe_blobs(
+		(*C.git_repository)(repoPtr),
+		blobRequests(hashes),
+		C.int(len(hashes)),
+		flags,
+		&cResults[0],
+	)
+
+	for i, cRes := range cResults {
+		results[i].Hash = hashes[i]
+
+		if cRes.error != C.CF_OK {
+			results[i].Error = cgoBlobError(int(cRes.error))
+
+			continue
+		}
+
+		results[i].Size = int64(cRes.size)
+		results[i].Sniffed = cRes.is_binary >= 0
+		results[i].IsBinary = cRes.is_binary > 0
+	}
+
+	return results
+}
+
+// BorrowedBlob owns the libgit2 object buffer behind a BlobResult returned by
+// BatchBorrowBlobs and is stored in its KeepAlive field. The buffer goes back
+// to libgit2 on Release or, failing that, once the BorrowedBlob is unreachable.
+type BorrowedBlob struct {
+	handle *blobHandle
+}
+
+// blobHandle is kept separate from BorrowedBlob so the GC cleanup can reach it
+// without keeping the BorrowedBlob itself alive.
+type blobHandle struct {
+	res  C.cf_blob_borrow_result
+	once sync.Once
+}
+
+func (h *blobHandle) release() {
+	h.once.Do(func() {
+		C.cf_release_blobs(&h.res, 1)
+	})
+}
+
+// Release returns the buffer to libgit2 immediately. Data borrowed through it
+// must not be used afterwards. Safe to call more than once.
+func (b *BorrowedBlob) Release() {
+	b.handle.release()
+}
+
+// BatchBorrowBlobs loads multiple blobs in a single CGO call without copying
+// them. Each result's Data points directly into libgit2's decompressed object
+// buffer and stays valid while its KeepAlive (a *BorrowedBlob) is reachable and
+// not released. Suited to single read-only passes; callers that retain Data on
+// its own must copy it (e.g. CachedBlob.Clone).
+func (b *CGOBridge) BatchBorrowBlobs(hashes []Hash) []BlobResult {
+	if len(hashes) == 0 {
+		return nil
+	}
+
+	repoPtr, ptrErr := b.getRepoPtr()
+	if ptrErr != nil {
+		results := make([]BlobResult, len(hashes))
+		for i := range results {
+			results[i].Hash = hashes[i]
+			results[i].Error = ptrErr
+		}
+
+		return results
+	}
+
+	// Each handle is copied out by borrowBlobData, so the buffer can be reused.
+	cResults := recycle(&b.borrowResults, len(hashes))
+
+	var cCost C.cf_batch_cost
+
+	C.cf_batch_borrow_blobs(
+		(*C.git_repository)(repoPtr),
+		blobRequests(hashes),
+		C.int(len(hashes)),
+		&cResults[0],
+		&cCost,
+	)
+
+	b.recordCost(repoPtr, &cCost, len(hashes))
+
+	results := make([]BlobResult, len(hashes))
+	for i := range cResults {
+		cRes := &cResults[i]
+		results[i].Hash = hashes[i]
+
+		if cRes.error == C.CF_ERR_TOO_LARGE {
+			results[i].setTooLarge(cRes.size, cRes.is_binary, cRes.line_count)
+
+			continue
+		}
+
+		if cRes.error != C.CF_OK {
+			results[i].Error = cgoBlobError(int(cRes.error))
+
+			continue
+		}
+
+		results[i].setMeta(cRes.size, cRes.is_binary, cRes.line_count)
+
+		results[i].Data, results[i].KeepAlive = borrowBlobData(cRes)
+	}
+
+	return results
+}
+
+// borrowBlobData wraps a successfully borrowed C blob in a BorrowedBlob that
+// takes over its handle.
+func borrowBlobData(cRes *C.cf_blob_borrow_result) ([]byte, *BorrowedBlob) {
+	var data []byte
+	if cRes.size > 0 && cRes.data != nil {
+		data = unsafe.Slice((*byte)(cRes.data), int(cRes.size))
+	}
+
+	handle := &blobHandle{res: *cRes}
+	owner := &BorrowedBlob{handle: handle}
+	runtime.AddCleanup(owner, (*blobHandle).release, handle)
+
+	return data, owner
+}
+
 // TreeDiff computes the difference between two trees in a single batch CGO call.
 // Skips libgit2 diff when both tree OIDs are equal (e.g. metadata-only commits).
 func (b *CGOBridge) TreeDiff(oldTreeHash, newTreeHash Hash) (Changes, error) {
@@ -290,22 +614,18 @@ func (b *CGOBridge) TreeDiff(oldTreeHash, newTreeHash Hash) (Changes, error) {
 	var pOldOid, pNewOid *C.git_oid
 
 	if !oldTreeHash.IsZero() {
-		for i := range 20 {
-			cOldOid.id[i] = C.uchar(oldTreeHash[i])
-		}
+		cOldOid = cOid(&oldTreeHash)
 		pOldOid = &cOldOid
 	}
 
 	if !newTreeHash.IsZero() {
-		for i := range 20 {
-			cNewOid.id[i] = C.uchar(newTreeHash[i])
-		}
+		cNewOid = cOid(&newTreeHash)
 		pNewOid = &cNewOid
 	}
 
-	repoPtr := b.getRepoPtr()
-	if repoPtr == nil {
-		return nil, ErrRepositoryPointer
+	repoPtr, ptrErr := b.getRepoPtr()
+	if ptrErr != nil {
+		return nil, ptrErr
 	}
 
 	var cResult C.cf_tree_diff_result
@@ -319,6 +639,7 @@ func (b *CGOBridge) TreeDiff(oldTreeHash, newTreeHash Hash) (Changes, error) {
 		(*C.git_repository)(repoPtr),
 		pOldOid,
 		pNewOid,
+		b.repo.treeDiffFilterPtr(),
 		&cResult,
 	)
 
@@ -331,18 +652,24 @@ func (b *CGOBridge) TreeDiff(oldTreeHash, newTreeHash Hash) (Changes, error) {
 		return make(Changes, 0), nil
 	}
 
-	changes := make(Changes, 0, cResult.count)
-
-	// Iterate C array
-	// Unsafe pointer arithmetic
 	cChanges := (*[1 << 30]C.cf_change)(unsafe.Pointer(cResult.changes))[:cResult.count:cResult.count]
+	paths := unsafe.Slice((*byte)(unsafe.Pointer(cResult.paths)), int(cResult.paths_size))
+
+	return b.convertChanges(cChanges, paths, nil), nil
+}
+
+// convertChanges converts C changes to Go, reading paths from the result's
+// path arena. If byIndex is non-nil, byIndex[i] is set to the Go change of
+// cChanges[i] (nil for filtered-out changes).
+func (b *CGOBridge) convertChanges(cChanges []C.cf_change, paths []byte, byIndex []*Change) Changes {
+	changes := make(Changes, 0, len(cChanges))
 
 	const (
 		fileModeCommit = 0o160000
 		fileModeTree   = 0o040000
 	)
 
-	for i := range int(cResult.count) {
+	for i := range cChanges {
 		cChange := cChanges[i]
 
 		// Filter out non-blob changes (submodules, trees) early
@@ -362,145 +689,569 @@ func (b *CGOBridge) TreeDiff(oldTreeHash, newTreeHash Hash) (Changes, error) {
 		switch cChange.status {
 		case C.GIT_DELTA_ADDED:
 			change.Action = Insert
-			change.To = ChangeEntry{
-				Name: C.GoString(cChange.new_path),
-				Size: int64(cChange.new_size),
-				Mode: uint16(cChange.new_mode),
-			}
-			copy(change.To.Hash[:], C.GoBytes(unsafe.Pointer(&cChange.new_oid[0]), 20))
+			change.To = b.newChangeEntry(paths, &cChange, false)
 
 		case C.GIT_DELTA_DELETED:
 			change.Action = Delete
-			change.From = ChangeEntry{
-				Name: C.GoString(cChange.old_path),
-				Size: int64(cChange.old_size),
-				Mode: uint16(cChange.old_mode),
-			}
-			copy(change.From.Hash[:], C.GoBytes(unsafe.Pointer(&cChange.old_oid[0]), 20))
+			change.From = b.newChangeEntry(paths, &cChange, true)
 
 		case C.GIT_DELTA_MODIFIED, C.GIT_DELTA_RENAMED, C.GIT_DELTA_COPIED:
 			change.Action = Modify
-			change.From = ChangeEntry{
-				Name: C.GoString(cChange.old_path),
-				Size: int64(cChange.old_size),
-				Mode: uint16(cChange.old_mode),
-			}
-			copy(change.From.Hash[:], C.GoBytes(unsafe.Pointer(&cChange.old_oid[0]), 20))
+			change.From = b.newChangeEntry(paths, &cChange, true)
 
-			change.To = ChangeEntry{
-				Name: C.GoString(cChange.new_path),
-				Size: int64(cChange.new_size),
-				Mode: uint16(cChange.new_mode),
+			if cChange.old_path_off == cChange.new_path_off {
+				change.To = change.From
+				change.To.Hash = cOidToHash(&cChange.new_oid)
+				change.To.Size = int64(cChange.new_size)
+				change.To.Mode = uint16(cChange.new_mode)
+			} else {
+				change.To = b.newChangeEntry(paths, &cChange, false)
 			}
-			copy(change.To.Hash[:], C.GoBytes(unsafe.Pointer(&cChange.new_oid[0]), 20))
 		default:
 			continue
 		}
 
 		changes = append(changes, change)
+
+		if byIndex != nil {
+			byIndex[i] = change
+		}
 	}
 
-	return changes, nil
+	return changes
+}
+
+// CommitDiffRequest asks for the changes a commit introduces.
+type CommitDiffRequest struct {
+	CommitHash Hash
+	// ParentHash is the diff base. Zero means the commit's first parent, or
+	// the empty tree for root commits.
+	ParentHash Hash
+}
+
+// CommitDiffResult holds the changes of one CommitDiffRequest.
+type CommitDiffResult struct {
+	Changes  Changes
+	TreeHash Hash
+	Error    error
+}
+
+// BatchTreeDiff tree-diffs multiple commits in a single CGO call. Commit
+// lookups, parent resolution and tree diffs all happen in C, and a linear
+// run of commits reuses each tree as the next commit's base.
+func (b *CGOBridge) BatchTreeDiff(requests []CommitDiffRequest) []CommitDiffResult {
+	if len(requests) == 0 {
+		return nil
+	}
+
+	results := make([]CommitDiffResult, len(requests))
+
+	repoPtr, ptrErr := b.getRepoPtr()
+	if ptrErr != nil {
+		for i := range results {
+			results[i].Error = ptrErr
+		}
+
+		return results
+	}
+
+	cRequests := b.commitDiffRequests(requests)
+	cInfos := recycle(&b.commitInfos, len(requests))
+
+	var (
+		cResult C.cf_tree_diff_result
+		cCost   C.cf_batch_cost
+	)
+
+	C.cf_batch_tree_diff(
+		(*C.git_repository)(repoPtr),
+		&cRequests[0],
+		C.int(len(requests)),
+		b.repo.treeDiffFilterPtr(),
+		&cResult,
+		&cInfos[0],
+		&cCost,
+	)
+
+	b.recordCost(repoPtr, &cCost, len(requests))
+
+	defer C.cf_free_tree_diff_result(&cResult)
+
+	var cChanges []C.cf_change
+	if cResult.count > 0 {
+		cChanges = unsafe.Slice(cResult.changes, int(cResult.count))
+	}
+
+	paths := unsafe.Slice((*byte)(unsafe.Pointer(cResult.paths)), int(cResult.paths_size))
+
+	for i := range cInfos {
+		info := &cInfos[i]
+
+		if info.error != C.CF_OK {
+			results[i].Error = cgoDiffError(int(info.error))
+
+			continue
+		}
+
+		first := int(info.change_offset)
+		results[i].Changes = b.convertChanges(cChanges[first:first+int(info.change_count)], paths, nil)
+		results[i].TreeHash = cOidToHash(&info.tree_oid)
+	}
+
+	return results
+}
+
+// commitDiffRequests converts commit diff requests to C in the bridge's
+// recycled request buffer.
+func (b *CGOBridge) commitDiffRequests(requests []CommitDiffRequest) []C.cf_commit_diff_request {
+	cRequests := recycle(&b.commitRequests, len(requests))
+
+	for i := range requests {
+		req := &requests[i]
+		cRequests[i].commit_oid = cOid(&req.CommitHash)
+
+		if !req.ParentHash.IsZero() {
+			cRequests[i].parent_oid = cOid(&req.ParentHash)
+			cRequests[i].has_parent = 1
+		}
+	}
+
+	return cRequests
+}
+
+// FileDiff is the line diff of one modified file of a CommitDiffsResult.
+type FileDiff struct {
+	Change *Change
+	DiffResult
+}
+
+// CommitDiffsResult holds the changes of one CommitDiffRequest together with
+// the line diffs of its modified files.
+type CommitDiffsResult struct {
+	CommitDiffResult
+	FileDiffs []FileDiff
+}
+
+// BatchCommitDiffs tree-diffs multiple commits, loads their changed blobs and
+// line-diffs every modified file in a single CGO call, replacing separate
+// BatchTreeDiff, BatchLoadBlobs and BatchDiffBlobs round trips. Binary files
+// get ErrDiffBinary instead of ops.
+//
+// With withBlobs, the unique changed blobs of the whole batch are returned as
+// borrowed BlobResults (see BatchBorrowBlobs); otherwise blob data never
+// leaves C memory.
+func (b *CGOBridge) BatchCommitDiffs(
+	requests []CommitDiffRequest, algorithm DiffAlgorithm, withBlobs bool,
+) ([]CommitDiffsResult, []BlobResult) {
+	if len(requests) == 0 {
+		return nil, nil
+	}
+
+	results := make([]CommitDiffsResult, len(requests))
+
+	repoPtr, ptrErr := b.getRepoPtr()
+	if ptrErr != nil {
+		for i := range results {
+			results[i].Error = ptrErr
+		}
+
+		return results, nil
+	}
+
+	cRequests := b.commitDiffRequests(requests)
+	cInfos := recycle(&b.commitInfos, len(requests))
+
+	var flags C.int
+	if withBlobs {
+		flags = C.CF_FUSED_WANT_BLOBS
+	}
+
+	var (
+		cResult C.cf_commit_diffs_result
+		cCost   C.cf_batch_cost
+	)
+
+	C.cf_batch_commit_diffs(
+		(*C.git_repository)(repoPtr),
+		&cRequests[0],
+		C.int(len(requests)),
+		C.int(algorithm),
+		flags,
+		b.repo.treeDiffFilterPtr(),
+		&cResult,
+		&cInfos[0],
+		&cCost,
+	)
+
+	b.recordCost(repoPtr, &cCost, len(requests))
+
+	defer C.cf_free_commit_diffs_result(&cResult)
+
+	var (
+		cChanges []C.cf_change
+		cDiffs   []C.cf_diff_flat_result
+	)
+
+	if cResult.changes.count > 0 {
+		cChanges = unsafe.Slice(cResult.changes.changes, int(cResult.changes.count))
+		cDiffs = unsafe.Slice(cResult.diffs, int(cResult.changes.count))
+	}
+
+	paths := unsafe.Slice((*byte)(unsafe.Pointer(cResult.changes.paths)), int(cResult.changes.paths_size))
+
+	// Convert the whole op arena with one Go allocation; diffs slice into it.
+	ops := make([]DiffOp, int(cResult.op_count))
+	if cResult.op_count > 0 {
+		for j, op := range unsafe.Slice(cResult.ops, int(cResult.op_count)) {
+			ops[j] = DiffOp{Type: DiffOpType(op.type_), LineCount: int(op.line_count)}
+		}
+	}
+
+	for i := range cInfos {
+		info := &cInfos[i]
+
+		if info.error != C.CF_OK {
+			results[i].Error = cgoDiffError(int(info.error))
+
+			continue
+		}
+
+		first, count := int(info.change_offset), int(info.change_count)
+		byIndex := make([]*Change, count)
+
+		results[i].Changes = b.convertChanges(cChanges[first:first+count], paths, byIndex)
+		results[i].TreeHash = cOidToHash(&info.tree_oid)
+
+		for k, change := range byIndex {
+			if change == nil || change.Action != Modify {
+				continue
+			}
+
+			results[i].FileDiffs = append(results[i].FileDiffs, FileDiff{
+				Change:     change,
+				DiffResult: newFlatDiffResult(&cDiffs[first+k], ops),
+			})
+		}
+	}
+
+	return results, takeBorrowedBlobs(&cResult)
+}
+
+// newFlatDiffResult converts one flat C diff result, slicing its ops from the
+// converted op arena.
+func newFlatDiffResult(cRes *C.cf_diff_flat_result, ops []DiffOp) DiffResult {
+	if cRes.error != C.CF_OK {
+		return DiffResult{Error: cgoDiffError(int(cRes.error))}
+	}
+
+	result := DiffResult{OldLines: int(cRes.old_lines), NewLines: int(cRes.new_lines)}
+
+	if cRes.op_count > 0 {
+		start := int(cRes.op_offset)
+		end := start + int(cRes.op_count)
+		result.Ops = ops[start:end:end]
+	}
+
+	return result
+}
+
+// takeBorrowedBlobs converts the borrowed blobs of a fused result, moving
+// their handles to Go so cf_free_commit_diffs_result leaves them alone.
+func takeBorrowedBlobs(cResult *C.cf_commit_diffs_result) []BlobResult {
+	if cResult.blob_count == 0 {
+		return nil
+	}
+
+	cBlobs := unsafe.Slice(cResult.blobs, int(cResult.blob_count))
+	blobs := make([]BlobResult, len(cBlobs))
+
+	for i := range cBlobs {
+		cRes := &cBlobs[i]
+		blobs[i].Hash = cOidToHash(&cRes.oid)
+
+		if cRes.error == C.CF_ERR_TOO_LARGE {
+			blobs[i].setTooLarge(cRes.size, cRes.is_binary, cRes.line_count)
+
+			continue
+		}
+
+		if cRes.error != C.CF_OK {
+			blobs[i].Error = cgoBlobError(int(cRes.error))
+
+			continue
+		}
+
+		blobs[i].setMeta(cRes.size, cRes.is_binary, cRes.line_count)
+		blobs[i].Data, blobs[i].KeepAlive = borrowBlobData(cRes)
+		cRes.handle = nil
+	}
+
+	return blobs
+}
+
+// SetPathInterner attaches a path interner to the bridge. Tree diffs then
+// return interned path strings and set ChangeEntry.PathID. Pass nil to detach.
+func (b *CGOBridge) SetPathInterner(interner *PathInterner) {
+	b.paths = interner
+}
+
+// newChangeEntry converts one side of a C change, reading its path from the
+// result's path arena.
+func (b *CGOBridge) newChangeEntry(paths []byte, cChange *C.cf_change, old bool) ChangeEntry {
+	off, length := cChange.new_path_off, cChange.new_path_len
+	entry := ChangeEntry{
+		Hash: cOidToHash(&cChange.new_oid),
+		Size: int64(cChange.new_size),
+		Mode: uint16(cChange.new_mode),
+	}
+
+	if old {
+		off, length = cChange.old_path_off, cChange.old_path_len
+		entry.Hash = cOidToHash(&cChange.old_oid)
+		entry.Size = int64(cChange.old_size)
+		entry.Mode = uint16(cChange.old_mode)
+	}
+
+	name := paths[off : off+length]
+	if b.paths != nil {
+		entry.Name, entry.PathID = b.paths.Intern(name)
+	} else {
+		entry.Name = string(name)
+	}
+
+	return entry
+}
+
+// cOidToHash copies a raw C object ID into a Hash.
+func cOidToHash(oid *[20]C.uchar) Hash {
+	return *(*Hash)(unsafe.Pointer(oid))
 }
 
 // BatchDiffBlobs computes diffs for multiple blob pairs in a single CGO call.
-// This minimizes CGO overhead by processing all requests together.
+// This minimizes CGO overhead by processing all requests together. All ops of
+// the batch are produced in one flat C arena and converted with a single Go
+// allocation that every result's Ops slices into.
 func (b *CGOBridge) BatchDiffBlobs(requests []DiffRequest) []DiffResult {
 	if len(requests) == 0 {
 		return nil
 	}
 
-	repoPtr := b.getRepoPtr()
-	if repoPtr == nil {
+	repoPtr, ptrErr := b.getRepoPtr()
+	if ptrErr != nil {
 		// Return errors for all requests
 		results := make([]DiffResult, len(requests))
 		for i := range results {
-			results[i].Error = ErrRepositoryPointer
+			results[i].Error = ptrErr
 		}
 
 		return results
 	}
 
-	// Pin memory to prevent GC movement during CGO call.
-	// CRITICAL: We must pin blob data slices BEFORE setting pointers in cRequests,
-	// as the GC could move Go-allocated memory during the CGO call.
 	var pinner runtime.Pinner
 
-	// Prepare C requests
-	cRequests := make([]C.cf_diff_request, len(requests))
-	for i, req := range requests {
-		if req.HasOld {
-			for j := range 20 {
-				cRequests[i].old_oid.id[j] = C.uchar(req.OldHash[j])
-			}
-			cRequests[i].has_old = 1
-			if len(req.OldData) > 0 {
-				// Pin the underlying byte slice to prevent GC movement
-				pinner.Pin(&req.OldData[0])
-				cRequests[i].old_data = unsafe.Pointer(&req.OldData[0])
-				cRequests[i].old_size = C.size_t(len(req.OldData))
-			}
-		}
-		if req.HasNew {
-			for j := range 20 {
-				cRequests[i].new_oid.id[j] = C.uchar(req.NewHash[j])
-			}
-			cRequests[i].has_new = 1
-			if len(req.NewData) > 0 {
-				// Pin the underlying byte slice to prevent GC movement
-				pinner.Pin(&req.NewData[0])
-				cRequests[i].new_data = unsafe.Pointer(&req.NewData[0])
-				cRequests[i].new_size = C.size_t(len(req.NewData))
-			}
-		}
-	}
+	cRequests := b.diffRequestsFor(requests, &pinner)
+	cResults := recycle(&b.diffResults, len(requests))
 
-	// Prepare C results
-	cResults := make([]C.cf_diff_result, len(requests))
+	// Ops land in the recycled op buffer when it is large enough.
+	var opsBufPtr *C.cf_diff_op
+	if len(b.diffOpBuf) > 0 {
+		pinner.Pin(&b.diffOpBuf[0])
+		opsBufPtr = &b.diffOpBuf[0]
+	}
 
-	// Pin the request and result arrays
-	pinner.Pin(&cRequests[0])
-	pinner.Pin(&cResults[0])
+	var (
+		cOps     *C.cf_diff_op
+		cOpCount C.size_t
+		cCost    C.cf_batch_cost
+	)
 
-	// Single CGO call to diff all blobs
-	C.cf_batch_diff_blobs(
+	// Single CGO call to diff all blobs into one flat op arena
+	C.cf_batch_diff_blobs_flat(
 		(*C.git_repository)(repoPtr),
 		&cRequests[0],
 		C.int(len(requests)),
+		opsBufPtr,
+		C.size_t(len(b.diffOpBuf)),
+		&cOps,
+		&cOpCount,
 		&cResults[0],
+		&cCost,
 	)
 
 	pinner.Unpin()
+	clear(cRequests)
+
+	b.recordCost(repoPtr, &cCost, len(requests))
+
+	// Convert the whole arena with one Go allocation; results slice into it.
+	opCount := int(cOpCount)
+	flatOps := b.diffOpBuf[:0]
+
+	if cOps != nil {
+		flatOps = unsafe.Slice(cOps, opCount)
+	} else if opCount > 0 {
+		flatOps = b.diffOpBuf[:opCount]
+	}
+
+	ops := make([]DiffOp, opCount)
+	for j, op := range flatOps {
+		ops[j] = DiffOp{Type: DiffOpType(op.type_), LineCount: int(op.line_count)}
+	}
+
+	if cOps != nil {
+		// The arena outgrew the recycled buffer; free it and grow for next time.
+		C.free(unsafe.Pointer(cOps))
+
+		b.diffOpBuf = make([]C.cf_diff_op, opCount*bufferGrowthFactor)
+	}
 
-	// Convert C results to Go
 	results := make([]DiffResult, len(requests))
-	for i, cRes := range cResults {
-		if cRes.error != C.CF_OK {
-			results[i].Error = cgoDiffError(int(cRes.error))
+	for i := range cResults {
+		results[i] = newFlatDiffResult(&cResults[i], ops)
+	}
 
-			continue
+	return results
+}
+
+// BatchDiffBlobsWithPositions is BatchDiffBlobs for callers that map changes
+// onto source ranges: every result also gets Positions, the line and byte
+// offset where each op starts in both blobs, computed by the diff itself
+// instead of a second pass over the blobs in Go.
+func (b *CGOBridge) BatchDiffBlobsWithPositions(requests []DiffRequest) []DiffResult {
+	if len(requests) == 0 {
+		return nil
+	}
+
+	repoPtr, ptrErr := b.getRepoPtr()
+	if ptrErr != nil {
+		return diffErrorResults(len(requests), ptrErr)
+	}
+
+	var pinner runtime.Pinner
+
+	cRequests := b.diffRequestsFor(requests, &pinner)
+	cResults := recycle(&b.diffResults, len(requests))
+
+	var (
+		cOps     *C.cf_diff_op
+		cPos     *C.cf_diff_op_pos
+		cOpCount C.size_t
+		cCost    C.cf_batch_cost
+	)
+
+	C.cf_batch_diff_blobs_positions(
+		(*C.git_repository)(repoPtr),
+		&cRequests[0],
+		C.int(len(requests)),
+		&cOps,
+		&cPos,
+		&cOpCount,
+		&cResults[0],
+		&cCost,
+	)
+
+	pinner.Unpin()
+	clear(cRequests)
+
+	b.recordCost(repoPtr, &cCost, len(requests))
+
+	return takeFlatDiffResults(cOps, cPos, cOpCount, cResults)
+}
+
+// diffErrorResults returns count results failed with err.
+func diffErrorResults(count int, err error) []DiffResult {
+	results := make([]DiffResult, count)
+	for i := range results {
+		results[i].Error = err
+	}
+
+	return results
+}
+
+// takeFlatDiffResults converts a flat diff batch whose op (and position)
+// arenas were malloc'd by C and frees them. cPos is nil when positions were
+// not requested.
+func takeFlatDiffResults(
+	cOps *C.cf_diff_op, cPos *C.cf_diff_op_pos, cOpCount C.size_t, cResults []C.cf_diff_flat_result,
+) []DiffResult {
+	defer C.free(unsafe.Pointer(cOps))
+	defer C.free(unsafe.Pointer(cPos))
+
+	opCount := int(cOpCount)
+	ops := make([]DiffOp, opCount)
+
+	var positions []DiffOpPosition
+
+	if opCount > 0 && cOps != nil {
+		for j, op := range unsafe.Slice(cOps, opCount) {
+			ops[j] = DiffOp{Type: DiffOpType(op.type_), LineCount: int(op.line_count)}
 		}
+	}
 
-		results[i].OldLines = int(cRes.old_lines)
-		results[i].NewLines = int(cRes.new_lines)
+	if opCount > 0 && cPos != nil {
+		positions = make([]DiffOpPosition, opCount)
 
-		// Copy ops from C to Go
-		if cRes.op_count > 0 && cRes.ops != nil {
-			results[i].Ops = make([]DiffOp, cRes.op_count)
-			cOps := (*[1 << 20]C.cf_diff_op)(unsafe.Pointer(cRes.ops))[:cRes.op_count:cRes.op_count]
-			for j := range int(cRes.op_count) {
-				results[i].Ops[j].Type = DiffOpType(cOps[j].type_)
-				results[i].Ops[j].LineCount = int(cOps[j].line_count)
+		for j, pos := range unsafe.Slice(cPos, opCount) {
+			positions[j] = DiffOpPosition{
+				OldLine:   int(pos.old_start),
+				NewLine:   int(pos.new_start),
+				OldOffset: int64(pos.old_offset),
+				NewOffset: int64(pos.new_offset),
 			}
 		}
 	}
 
-	// Free C-allocated memory
-	C.cf_free_diff_results(&cResults[0], C.int(len(cResults)))
+	results := make([]DiffResult, len(cResults))
+
+	for i := range cResults {
+		results[i] = newFlatDiffResult(&cResults[i], ops)
+
+		if positions != nil && cResults[i].op_count > 0 && results[i].Error == nil {
+			start := int(cResults[i].op_offset)
+			end := start + int(cResults[i].op_count)
+			results[i].Positions = positions[start:end:end]
+		}
+	}
 
 	return results
 }
 
+// diffRequestsFor converts diff requests to C in the bridge's recycled
+// request buffer, pinning any supplied blob data with pinner so the GC
+// cannot move it during the CGO call. The buffer then references that data;
+// callers clear it once C is done so it does not keep the blobs alive.
+func (b *CGOBridge) diffRequestsFor(requests []DiffRequest, pinner *runtime.Pinner) []C.cf_diff_request {
+	cRequests := recycle(&b.diffRequests, len(requests))
+	pinner.Pin(&cRequests[0])
+
+	for i := range requests {
+		req := &requests[i]
+		cRequests[i].algorithm = C.int(req.Algorithm)
+		if req.HasOld {
+			cRequests[i].old_oid = cOid(&req.OldHash)
+			cRequests[i].has_old = 1
+			if len(req.OldData) > 0 {
+				// Pin the underlying byte slice to prevent GC movement
+				pinner.Pin(&req.OldData[0])
+				cRequests[i].old_data = unsafe.Pointer(&req.OldData[0])
+				cRequests[i].old_size = C.size_t(len(req.OldData))
+			}
+		}
+		if req.HasNew {
+			cRequests[i].new_oid = cOid(&req.NewHash)
+			cRequests[i].has_new = 1
+			if len(req.NewData) > 0 {
+				// Pin the underlying byte slice to prevent GC movement
+				pinner.Pin(&req.NewData[0])
+				cRequests[i].new_data = unsafe.Pointer(&req.NewData[0])
+				cRequests[i].new_size = C.size_t(len(req.NewData))
+			}
+		}
+	}
+
+	return cRequests
+}
+
 // Error types for CGO operations
 type cgoError string
 
@@ -508,16 +1259,28 @@ func (e cgoError) Error() string { return string(e) }
 
 // CGO operation errors.
 var (
-	ErrRepositoryPointer = cgoError("failed to get repository pointer")
-	ErrBlobLookup        = cgoError("blob lookup failed")
-	ErrBlobMemory        = cgoError("memory allocation failed for blob")
-	ErrBlobBinary        = cgoError("blob is binary")
-	ErrDiffLookup        = cgoError("diff blob lookup failed")
-	ErrDiffMemory        = cgoError("memory allocation failed for diff")
-	ErrDiffBinary        = cgoError("diff blob is binary")
-	ErrDiffCompute       = cgoError("diff computation failed")
-	ErrArenaFull         = cgoError("arena full")
-	ErrConfigureMemory   = cgoError("cf_configure_memory failed")
+	ErrRepositoryPointer    = cgoError("failed to get repository pointer")
+	ErrBlobLookup           = cgoError("blob lookup failed")
+	ErrBlobMemory           = cgoError("memory allocation failed for blob")
+	ErrBlobBinary           = cgoError("blob is binary")
+	ErrBlobTooLarge         = cgoError("blob above the large blob threshold")
+	ErrDiffLookup           = cgoError("diff blob lookup failed")
+	ErrDiffMemory           = cgoError("memory allocation failed for diff")
+	ErrDiffBinary           = cgoError("diff blob is binary")
+	ErrDiffCompute          = cgoError("diff computation failed")
+	ErrDiffTooLarge         = cgoError("diff blob above the large blob threshold")
+	ErrArenaFull            = cgoError("arena full")
+	ErrBridgeBusy           = cgoError("bridge repository in use by a submitted diff batch")
+	ErrConfigureMemory      = cgoError("cf_configure_memory failed")
+	ErrObjectCacheSize      = cgoError("object cache size must be positive")
+	ErrObjectCacheMemory    = cgoError("memory allocation failed for object cache")
+	ErrTreeDiffFilterMemory = cgoError("memory allocation failed for tree diff filter")
+	ErrRepoBudgetMemory     = cgoError("memory allocation failed for repository budget")
+	ErrRepoBudgetFreed      = cgoError("repository budget was freed")
+	ErrRepoBudgetRelease    = cgoError("cf_repo_budget_release_windows failed")
+	ErrFleetLimit           = cgoError("cf_repo_budget_set_fleet_limit failed")
+	ErrShareODB             = cgoError("cf_repository_share_odb failed")
+	ErrCommitWalk           = cgoError("commit walk failed")
 )
 
 func cgoBlobError(code int) error {
@@ -530,6 +1293,8 @@ func cgoBlobError(code int) error {
 		return ErrBlobBinary
 	case C.CF_ERR_ARENA_FULL:
 		return ErrArenaFull
+	case C.CF_ERR_TOO_LARGE:
+		return ErrBlobTooLarge
 	default:
 		return cgoError("unknown blob error")
 	}
@@ -545,6 +1310,8 @@ func cgoDiffError(code int) error {
 		return ErrDiffBinary
 	case C.CF_ERR_DIFF:
 		return ErrDiffCompute
+	case C.CF_ERR_TOO_LARGE:
+		return ErrDiffTooLarge
 	default:
 		return cgoError("unknown diff error")
 	}
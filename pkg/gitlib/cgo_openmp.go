@@ -0,0 +1,12 @@
+//go:build openmp
+
+package gitlib
+
+// Building with -tags openmp compiles the clib batch kernels with OpenMP so
+// ConfigureParallelism can spread large batches over several cores.
+
+/*
+#cgo CFLAGS: -fopenmp
+#cgo LDFLAGS: -fopenmp
+*/
+import "C"
@@ -33,6 +33,9 @@ type ChangeEntry struct {
 	Hash Hash
 	Size int64
 	Mode uint16
+	// PathID is the interned ID of Name, or 0 when the producer has no
+	// PathInterner (see CGOBridge.SetPathInterner).
+	PathID uint32
 }
 
 // Changes is a collection of Change objects.
@@ -0,0 +1,312 @@
+/*
+ * Codefang Git Library - Pooled libgit2 Allocator
+ *
+ * Tree diffs and commit parsing make libgit2 allocate and free a stream of
+ * small objects (paths, deltas, tree entries) on every commit. Interleaved
+ * with long-lived buffers they fragment the glibc heap, so RSS drifts well
+ * above the live heap on long runs. Installed through GIT_OPT_SET_ALLOCATOR,
+ * this allocator serves small requests from a dedicated region instead:
+ * 1. Size classes up to CF_POOL_MAX_SMALL, carved from 64 KiB slabs of one
+ *    reserved address range; larger requests go straight to malloc
+ * 2. Per-thread free lists, so the allocation fast path takes no lock
+ * 3. Freed blocks are only ever reused by their own size class, so per-commit
+ *    garbage is recycled instead of splitting the heap
+ * 4. cf_alloc_batch_end hands a thread's free blocks back to the shared lists
+ *    when a batch call finishes, so the next call on any thread reuses them
+ * 5. Counters are kept per thread and published in bulk
+ *
+ * Pointers outside the region (allocated before installation or by malloc
+ * fallbacks) are passed to free and realloc unchanged, so installing the
+ * allocator after libgit2 is initialized is safe.
+ *
+ * There is no per-batch bump region reset when a call ends: libgit2
+ * allocates memory during a call that outlives it (cached objects, pack
+ * windows, the blobs handed to Go), so a reset would free live memory.
+ * The per-thread free lists recycle a call's garbage instead. Tested by
+ * bench/clib_test.c (make test-clib).
+ */
+
+#include "codefang_git.h"
+#include <git2/sys/alloc.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define CF_POOL_SLAB_SIZE (64 * 1024)
+#define CF_POOL_MAX_SMALL 1024
+#define CF_POOL_CLASS_COUNT 16
+
+/* Free blocks per class a thread keeps before spilling half of them */
+#define CF_POOL_THREAD_CAP 256
+
+/* Blocks taken from a shared list at once */
+#define CF_POOL_REFILL 32
+
+/* Thread-local events between counter publications */
+#define CF_POOL_PUBLISH_EVERY 1024
+
+static const uint32_t cf_pool_class_size[CF_POOL_CLASS_COUNT] = {
+    16, 32, 48, 64, 80, 96, 128, 160, 192, 256, 320, 384, 512, 640, 768, 1024
+};
+
+typedef struct cf_pool_block {
+    struct cf_pool_block* next;
+} cf_pool_block;
+
+typedef struct {
+    pthread_mutex_t lock;
+    cf_pool_block* head;
+} cf_pool_list;
+
+typedef struct {
+    cf_pool_block* head[CF_POOL_CLASS_COUNT];
+    uint32_t count[CF_POOL_CLASS_COUNT];
+    uint64_t pool_allocs;           /* Not yet published */
+    uint64_t fallbacks;
+    int registered;                 /* Thread exit flushes the lists */
+} cf_pool_cache;
+
+/* Request size / 16 (rounded up) -> size class */
+static uint8_t cf_pool_class_of[CF_POOL_MAX_SMALL / 16 + 1];
+
+static char* cf_pool_base;
+static size_t cf_pool_size;
+static atomic_size_t cf_pool_used;
+static uint8_t* cf_pool_slab_class;     /* Size class of each carved slab */
+static cf_pool_list cf_pool_shared[CF_POOL_CLASS_COUNT];
+static pthread_key_t cf_pool_key;
+static atomic_int cf_pool_state;        /* 0 = not installed, 1 = installing or failed, 2 = installed */
+
+static __thread cf_pool_cache cf_thread_pool;
+
+static int in_pool(const void* ptr) {
+    return cf_pool_base != NULL && (const char*)ptr >= cf_pool_base &&
+           (const char*)ptr < cf_pool_base + cf_pool_size;
+}
+
+static void publish_counters(cf_pool_cache* tc) {
+    if (tc->pool_allocs > 0) {
+        cf_stats_add(CF_STAT_POOL_ALLOCS, tc->pool_allocs);
+        tc->pool_allocs = 0;
+    }
+    if (tc->fallbacks > 0) {
+        cf_stats_add(CF_STAT_POOL_FALLBACKS, tc->fallbacks);
+        tc->fallbacks = 0;
+    }
+}
+
+/* Move the first n blocks of a thread list to the shared list */
+static void spill_blocks(cf_pool_cache* tc, int cls, uint32_t n) {
+    cf_pool_block* first = tc->head[cls];
+    cf_pool_block* last = first;
+    for (uint32_t i = 1; i < n; i++) {
+        last = last->next;
+    }
+    tc->head[cls] = last->next;
+    tc->count[cls] -= n;
+
+    cf_pool_list* shared = &cf_pool_shared[cls];
+    pthread_mutex_lock(&shared->lock);
+    last->next = shared->head;
+    shared->head = first;
+    pthread_mutex_unlock(&shared->lock);
+}
+
+static void flush_thread_pool(cf_pool_cache* tc) {
+    for (int cls = 0; cls < CF_POOL_CLASS_COUNT; cls++) {
+        if (tc->count[cls] > 0) {
+            spill_blocks(tc, cls, tc->count[cls]);
+        }
+    }
+    publish_counters(tc);
+}
+
+/* Blocks freed by later destructors register the thread again */
+static void pool_thread_exit(void* arg) {
+    cf_pool_cache* tc = (cf_pool_cache*)arg;
+    tc->registered = 0;
+    flush_thread_pool(tc);
+}
+
+/* Fill an empty thread list from the shared list or a new slab */
+static cf_pool_block* refill_blocks(cf_pool_cache* tc, int cls) {
+    if (!tc->registered) {
+        tc->registered = 1;
+        pthread_setspecific(cf_pool_key, tc);
+    }
+
+    cf_pool_list* shared = &cf_pool_shared[cls];
+    pthread_mutex_lock(&shared->lock);
+    cf_pool_block* head = shared->head;
+    if (head != NULL) {
+        cf_pool_block* last = head;
+        uint32_t n = 1;
+        while (n < CF_POOL_REFILL && last->next != NULL) {
+            last = last->next;
+            n++;
+        }
+        shared->head = last->next;
+        last->next = NULL;
+        tc->head[cls] = head;
+        tc->count[cls] = n;
+    }
+    pthread_mutex_unlock(&shared->lock);
+
+    if (head != NULL) {
+        return head;
+    }
+
+    size_t off = atomic_fetch_add_explicit(&cf_pool_used, CF_POOL_SLAB_SIZE, memory_order_relaxed);
+    if (off + CF_POOL_SLAB_SIZE > cf_pool_size) {
+        return NULL;
+    }
+    cf_pool_slab_class[off / CF_POOL_SLAB_SIZE] = (uint8_t)cls;
+    cf_stats_add(CF_STAT_POOL_BYTES, CF_POOL_SLAB_SIZE);
+
+    size_t block = cf_pool_class_size[cls];
+    size_t n = CF_POOL_SLAB_SIZE / block;
+    char* slab = cf_pool_base + off;
+    for (size_t i = 0; i < n; i++) {
+        cf_pool_block* b = (cf_pool_block*)(slab + (n - 1 - i) * block);
+        b->next = tc->head[cls];
+        tc->head[cls] = b;
+    }
+    tc->count[cls] = (uint32_t)n;
+    return tc->head[cls];
+}
+
+static void* pool_malloc(size_t n, const char* file, int line) {
+    (void)file;
+    (void)line;
+    cf_pool_cache* tc = &cf_thread_pool;
+
+    if (n <= CF_POOL_MAX_SMALL) {
+        int cls = cf_pool_class_of[(n + 15) / 16];
+        cf_pool_block* b = tc->head[cls];
+        if (b == NULL) {
+            b = refill_blocks(tc, cls);
+        }
+        if (b != NULL) {
+            tc->head[cls] = b->next;
+            tc->count[cls]--;
+            if (++tc->pool_allocs >= CF_POOL_PUBLISH_EVERY) {
+                publish_counters(tc);
+            }
+            return b;
+        }
+    }
+
+    if (++tc->fallbacks >= CF_POOL_PUBLISH_EVERY) {
+        publish_counters(tc);
+    }
+    return malloc(n);
+}
+
+static void pool_free(void* ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    if (!in_pool(ptr)) {
+        free(ptr);
+        return;
+    }
+
+    cf_pool_cache* tc = &cf_thread_pool;
+    int cls = cf_pool_slab_class[((char*)ptr - cf_pool_base) / CF_POOL_SLAB_SIZE];
+    cf_pool_block* b = (cf_pool_block*)ptr;
+
+    if (!tc->registered) {
+        tc->registered = 1;
+        pthread_setspecific(cf_pool_key, tc);
+    }
+    b->next = tc->head[cls];
+    tc->head[cls] = b;
+    if (++tc->count[cls] > CF_POOL_THREAD_CAP) {
+        spill_blocks(tc, cls, CF_POOL_THREAD_CAP / 2);
+    }
+}
+
+static void* pool_realloc(void* ptr, size_t n, const char* file, int line) {
+    if (ptr == NULL) {
+        return pool_malloc(n, file, line);
+    }
+    if (!in_pool(ptr)) {
+        return realloc(ptr, n);
+    }
+
+    size_t have = cf_pool_class_size[cf_pool_slab_class[((char*)ptr - cf_pool_base) / CF_POOL_SLAB_SIZE]];
+    if (n <= have) {
+        return ptr;
+    }
+
+    void* grown = pool_malloc(n, file, line);
+    if (grown == NULL) {
+        return NULL;
+    }
+    memcpy(grown, ptr, have);
+    pool_free(ptr);
+    return grown;
+}
+
+/*
+ * Reserve pool_bytes of address space and make libgit2 allocate through the
+ * pool. Pages are only committed as slabs are carved. Installation happens
+ * once per process; later calls return CF_OK without effect.
+ */
+int cf_alloc_pool_install(size_t pool_bytes) {
+    size_t size = pool_bytes / CF_POOL_SLAB_SIZE * CF_POOL_SLAB_SIZE;
+    if (size == 0) {
+        return CF_OK;
+    }
+
+    int expected = 0;
+    if (!atomic_compare_exchange_strong(&cf_pool_state, &expected, 1)) {
+        return CF_OK;
+    }
+
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        return CF_ERR_NOMEM;
+    }
+
+    cf_pool_slab_class = (uint8_t*)calloc(size / CF_POOL_SLAB_SIZE, 1);
+    if (cf_pool_slab_class == NULL || pthread_key_create(&cf_pool_key, pool_thread_exit) != 0) {
+        free(cf_pool_slab_class);
+        cf_pool_slab_class = NULL;
+        munmap(base, size);
+        return CF_ERR_NOMEM;
+    }
+
+    int cls = 0;
+    for (size_t i = 0; i <= CF_POOL_MAX_SMALL / 16; i++) {
+        while (cf_pool_class_size[cls] < i * 16) cls++;
+        cf_pool_class_of[i] = (uint8_t)cls;
+    }
+    for (int i = 0; i < CF_POOL_CLASS_COUNT; i++) {
+        pthread_mutex_init(&cf_pool_shared[i].lock, NULL);
+    }
+
+    cf_pool_base = (char*)base;
+    cf_pool_size = size;
+
+    git_allocator allocator = { pool_malloc, pool_realloc, pool_free };
+    if (git_libgit2_opts(GIT_OPT_SET_ALLOCATOR, &allocator) != 0) {
+        /* Nothing was handed out from the region yet */
+        cf_pool_base = NULL;
+        cf_pool_size = 0;
+        munmap(base, size);
+        return CF_ERR_NOMEM;
+    }
+
+    atomic_store(&cf_pool_state, 2);
+    return CF_OK;
+}
+
+/* Return the calling thread's free blocks to the shared lists */
+void cf_alloc_batch_end(void) {
+    if (atomic_load_explicit(&cf_pool_state, memory_order_relaxed) == 2) {
+        flush_thread_pool(&cf_thread_pool);
+    }
+}
@@ -0,0 +1,251 @@
+/*
+ * Codefang Git Library - Asynchronous Diff Batches
+ *
+ * A synchronous batch call leaves the native side idle while Go consumes
+ * its results, and Go idle while the next batch runs. Submitting batch k+1
+ * before consuming batch k double-buffers the two:
+ * 1. A diff worker owns one persistent pthread bound to one repository
+ *    handle, so submitting a batch creates no thread
+ * 2. The worker has a single slot: a batch is submitted into it, run by
+ *    the thread and collected out of it before the next one is accepted
+ * 3. Requests are copied and results land in worker-owned buffers, reused
+ *    across batches, so the caller's buffers are free while the batch runs
+ * 4. Completion is a release/acquire store of the slot state, so polling
+ *    never blocks
+ * 5. Collecting hands the malloc'd op arenas over instead of copying them
+ */
+
+#include "codefang_git.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Slot states */
+enum {
+    CF_SLOT_EMPTY = 0,              /* Accepts a batch */
+    CF_SLOT_QUEUED,                 /* Submitted, owned by the worker thread */
+    CF_SLOT_DONE                    /* Finished, waiting to be collected */
+};
+
+struct cf_diff_worker {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;            /* Signals a submitted batch, its completion or stop */
+    git_repository* repo;
+    atomic_int state;               /* Written under lock */
+    int stop;                       /* Under lock */
+
+    /* The slot; owned by the thread while queued, by the caller otherwise */
+    cf_diff_request* requests;
+    cf_diff_flat_result* results;
+    int capacity;
+    int count;
+    int want_positions;
+    cf_diff_op* ops;
+    cf_diff_op_pos* positions;
+    size_t op_count;
+    int success_count;
+    cf_batch_cost cost;
+};
+
+static void* run_diff_worker(void* arg) {
+    cf_diff_worker* w = (cf_diff_worker*)arg;
+
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        while (atomic_load_explicit(&w->state, memory_order_relaxed) != CF_SLOT_QUEUED && !w->stop) {
+            pthread_cond_wait(&w->cond, &w->lock);
+        }
+        if (atomic_load_explicit(&w->state, memory_order_relaxed) != CF_SLOT_QUEUED) {
+            break;
+        }
+        pthread_mutex_unlock(&w->lock);
+
+        w->success_count = batch_diff_flat(w->repo, w->requests, w->count, NULL, 0, &w->ops,
+                                           w->want_positions ? &w->positions : NULL, &w->op_count, w->results,
+                                           &w->cost);
+
+        pthread_mutex_lock(&w->lock);
+        atomic_store_explicit(&w->state, CF_SLOT_DONE, memory_order_release);
+        pthread_cond_broadcast(&w->cond);
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    return NULL;
+}
+
+cf_diff_worker* cf_diff_worker_new(git_repository* repo) {
+    cf_diff_worker* w = (cf_diff_worker*)calloc(1, sizeof(cf_diff_worker));
+    if (w == NULL) {
+        return NULL;
+    }
+
+    w->repo = repo;
+    atomic_init(&w->state, CF_SLOT_EMPTY);
+    if (pthread_mutex_init(&w->lock, NULL) != 0) {
+        free(w);
+        return NULL;
+    }
+    if (pthread_cond_init(&w->cond, NULL) != 0) {
+        pthread_mutex_destroy(&w->lock);
+        free(w);
+        return NULL;
+    }
+    if (pthread_create(&w->thread, NULL, run_diff_worker, w) != 0) {
+        pthread_cond_destroy(&w->cond);
+        pthread_mutex_destroy(&w->lock);
+        free(w);
+        return NULL;
+    }
+
+    return w;
+}
+
+void cf_diff_worker_free(cf_diff_worker* worker) {
+    if (worker == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+    worker->stop = 1;
+    pthread_cond_broadcast(&worker->cond);
+    pthread_mutex_unlock(&worker->lock);
+    pthread_join(worker->thread, NULL);
+
+    if (atomic_load_explicit(&worker->state, memory_order_relaxed) == CF_SLOT_DONE) {
+        free(worker->ops);
+        free(worker->positions);
+    }
+    pthread_cond_destroy(&worker->cond);
+    pthread_mutex_destroy(&worker->lock);
+    free(worker->requests);
+    free(worker->results);
+    free(worker);
+}
+
+/* Grow the slot buffers to hold count requests (caller owns the slot) */
+static int reserve_slot(cf_diff_worker* w, int count) {
+    if (count <= w->capacity) {
+        return CF_OK;
+    }
+
+    cf_diff_request* requests = (cf_diff_request*)realloc(w->requests, (size_t)count * sizeof(cf_diff_request));
+    if (requests == NULL) {
+        return CF_ERR_NOMEM;
+    }
+    w->requests = requests;
+
+    cf_diff_flat_result* results =
+        (cf_diff_flat_result*)realloc(w->results, (size_t)count * sizeof(cf_diff_flat_result));
+    if (results == NULL) {
+        return CF_ERR_NOMEM;
+    }
+    w->results = results;
+    w->capacity = count;
+
+    return CF_OK;
+}
+
+int cf_submit_diff_batch(
+    cf_diff_worker* worker,
+    const cf_diff_request* requests,
+    int count,
+    int want_positions
+) {
+    if (atomic_load_explicit(&worker->state, memory_order_acquire) != CF_SLOT_EMPTY) {
+        return CF_ERR_BUSY;
+    }
+    if (reserve_slot(worker, count) != CF_OK) {
+        return CF_ERR_NOMEM;
+    }
+
+    if (count > 0) {
+        memcpy(worker->requests, requests, (size_t)count * sizeof(cf_diff_request));
+        memset(worker->results, 0, (size_t)count * sizeof(cf_diff_flat_result));
+    }
+    worker->count = count;
+    worker->want_positions = want_positions;
+    worker->ops = NULL;
+    worker->positions = NULL;
+    worker->op_count = 0;
+
+    pthread_mutex_lock(&worker->lock);
+    atomic_store_explicit(&worker->state, CF_SLOT_QUEUED, memory_order_relaxed);
+    pthread_cond_broadcast(&worker->cond);
+    pthread_mutex_unlock(&worker->lock);
+
+    return CF_OK;
+}
+
+/* Move the results of a finished batch out and empty the slot */
+static int collect_slot(
+    cf_diff_worker* w,
+    cf_diff_op** out_ops,
+    cf_diff_op_pos** out_positions,
+    size_t* out_op_count,
+    cf_diff_flat_result* results,
+    cf_batch_cost* cost
+) {
+    if (w->count > 0) {
+        memcpy(results, w->results, (size_t)w->count * sizeof(cf_diff_flat_result));
+    }
+    *out_ops = w->ops;
+    *out_op_count = w->op_count;
+    if (out_positions != NULL) {
+        *out_positions = w->positions;
+    } else {
+        free(w->positions);
+    }
+    if (cost != NULL) {
+        *cost = w->cost;
+    }
+    int success_count = w->success_count;
+    w->ops = NULL;
+    w->positions = NULL;
+
+    pthread_mutex_lock(&w->lock);
+    atomic_store_explicit(&w->state, CF_SLOT_EMPTY, memory_order_relaxed);
+    pthread_mutex_unlock(&w->lock);
+
+    return success_count;
+}
+
+int cf_try_collect_diff_batch(
+    cf_diff_worker* worker,
+    cf_diff_op** out_ops,
+    cf_diff_op_pos** out_positions,
+    size_t* out_op_count,
+    cf_diff_flat_result* results,
+    cf_batch_cost* cost
+) {
+    int state = atomic_load_explicit(&worker->state, memory_order_acquire);
+    if (state == CF_SLOT_QUEUED) {
+        return CF_PENDING;
+    }
+    if (state == CF_SLOT_EMPTY) {
+        return CF_ERR_LOOKUP;
+    }
+    return collect_slot(worker, out_ops, out_positions, out_op_count, results, cost);
+}
+
+int cf_wait_diff_batch(
+    cf_diff_worker* worker,
+    cf_diff_op** out_ops,
+    cf_diff_op_pos** out_positions,
+    size_t* out_op_count,
+    cf_diff_flat_result* results,
+    cf_batch_cost* cost
+) {
+    pthread_mutex_lock(&worker->lock);
+    while (atomic_load_explicit(&worker->state, memory_order_relaxed) == CF_SLOT_QUEUED) {
+        pthread_cond_wait(&worker->cond, &worker->lock);
+    }
+    int state = atomic_load_explicit(&worker->state, memory_order_relaxed);
+    pthread_mutex_unlock(&worker->lock);
+
+    if (state == CF_SLOT_EMPTY) {
+        return CF_ERR_LOOKUP;
+    }
+    return collect_slot(worker, out_ops, out_positions, out_op_count, results, cost);
+}
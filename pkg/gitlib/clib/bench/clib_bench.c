@@ -0,0 +1,660 @@
+/*
+ * Codefang Git Library - Kernel Microbenchmarks
+ *
+ * Drives the clib kernels directly, without Go and CGO around them, so a
+ * regression in a kernel is not hidden by (or blamed on) the bridge:
+ * 1. Text scanning (cf_count_lines, cf_is_binary, cf_scan_text) on
+ *    synthetic tiny, typical, large, CRLF, binary and single-line buffers
+ * 2. The line diff kernel (compute_diff_generic) for every algorithm on
+ *    small edits, rewrites, repetitive content and CRLF text
+ * 3. Blob preloading, tree diffs and whole diff batches against a fixture
+ *    repository generated from a fixed seed, so every run sees the same
+ *    objects in the same pack
+ *
+ * The sources are included like cgo_bridge.go does, which gives access to
+ * static kernels and lets clib allocations (not libgit2's) be counted.
+ *
+ * Output uses the Go benchmark format, one line per run, so two runs can be
+ * compared with benchstat:
+ *   BenchmarkScanText/typical   200000   812.0 ns/op   20177.34 MB/s   0.00 allocs/op
+ *
+ * Usage: clib-bench [-benchtime ms] [-count n] [-threads n] [-fixture dir] [filter]
+ */
+
+#include <git2.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Allocations made by clib code, counted through the macros below */
+static uint64_t bench_allocs;
+
+static void* bench_malloc(size_t size) {
+    __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+static void* bench_calloc(size_t count, size_t size) {
+    __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED);
+    return calloc(count, size);
+}
+
+static void* bench_realloc(void* ptr, size_t size) {
+    __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED);
+    return realloc(ptr, size);
+}
+
+#define malloc(size) bench_malloc(size)
+#define calloc(count, size) bench_calloc(count, size)
+#define realloc(ptr, size) bench_realloc(ptr, size)
+
+#include "../utils.c"
+#include "../stats.c"
+#include "../alloc_pool.c"
+#include "../text_scan.c"
+#include "../odb_cache.c"
+#include "../repo_budget.c"
+#include "../pack_order.c"
+#include "../rename_ops.c"
+#include "../blob_ops.c"
+#include "../diff_ops.c"
+
+#undef malloc
+#undef calloc
+#undef realloc
+
+/* ============================================================================
+ * Harness
+ * ============================================================================ */
+
+/* Run the kernel n times */
+typedef void (*bench_fn)(void* arg, int64_t n);
+
+static int64_t bench_time_ns = 1000000000LL;
+static int bench_count = 1;
+static const char* bench_filter = NULL;
+
+/* A benchmark runs when its name contains the filter */
+static int bench_selected(const char* name) {
+    return bench_filter == NULL || strstr(name, bench_filter) != NULL;
+}
+
+/*
+ * Run one benchmark: grow n like Go's testing package until a run takes
+ * at least the bench time, then print that run. bytes is the input size of
+ * one op (0 to omit MB/s).
+ */
+static void run_bench(const char* name, size_t bytes, bench_fn fn, void* arg) {
+    if (!bench_selected(name)) {
+        return;
+    }
+
+    for (int c = 0; c < bench_count; c++) {
+        int64_t n = 1;
+        int64_t elapsed;
+        uint64_t allocs;
+
+        for (;;) {
+            __atomic_store_n(&bench_allocs, 0, __ATOMIC_RELAXED);
+            uint64_t start = cf_stats_now();
+            fn(arg, n);
+            elapsed = (int64_t)(cf_stats_now() - start);
+            allocs = __atomic_load_n(&bench_allocs, __ATOMIC_RELAXED);
+
+            if (elapsed >= bench_time_ns || n >= 1000000000LL) {
+                break;
+            }
+
+            int64_t next = elapsed > 0 ? (int64_t)((double)n * 1.2 * (double)bench_time_ns / (double)elapsed)
+                                       : n * 100;
+            if (next > n * 100) next = n * 100;
+            if (next <= n) next = n + 1;
+            n = next;
+        }
+
+        double ns_per_op = (double)elapsed / (double)n;
+        printf("Benchmark%s\t%10lld\t%14.1f ns/op", name, (long long)n, ns_per_op);
+        if (bytes > 0) {
+            printf("\t%12.2f MB/s", (double)bytes * 1e3 / ns_per_op);
+        }
+        printf("\t%10.2f allocs/op\n", (double)allocs / (double)n);
+        fflush(stdout);
+    }
+}
+
+/* Deterministic generator, so fixtures are the same on every run */
+static uint64_t bench_rand(uint64_t* state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state >> 33;
+}
+
+/* Growable byte buffer for building inputs */
+typedef struct {
+    char* data;
+    size_t size;
+    size_t capacity;
+} bench_buf;
+
+static void buf_append(bench_buf* b, const char* data, size_t size) {
+    if (b->size + size > b->capacity) {
+        size_t capacity = b->capacity > 0 ? b->capacity : 4096;
+        while (capacity < b->size + size) capacity *= 2;
+        b->data = realloc(b->data, capacity);
+        if (b->data == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+        b->capacity = capacity;
+    }
+    memcpy(b->data + b->size, data, size);
+    b->size += size;
+}
+
+/* Append one source-like line derived from seed */
+static void buf_line(bench_buf* b, uint32_t seed, const char* eol) {
+    char line[128];
+    int len = snprintf(line, sizeof(line), "    value_%08x = compute(value_%05u, %u);%s",
+                       seed, seed % 100000u, seed % 977u, eol);
+    buf_append(b, line, (size_t)len);
+}
+
+/* ============================================================================
+ * Text Scanning
+ * ============================================================================ */
+
+typedef struct {
+    const char* data;
+    size_t size;
+} text_arg;
+
+static volatile int bench_sink;
+
+static void bench_count_lines(void* arg, int64_t n) {
+    const text_arg* t = (const text_arg*)arg;
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink = cf_count_lines(t->data, t->size);
+    }
+}
+
+static void bench_is_binary(void* arg, int64_t n) {
+    const text_arg* t = (const text_arg*)arg;
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink = cf_is_binary(t->data, t->size);
+    }
+}
+
+static void bench_scan_text(void* arg, int64_t n) {
+    const text_arg* t = (const text_arg*)arg;
+    int lines;
+    for (int64_t i = 0; i < n; i++) {
+        bench_sink = cf_scan_text(t->data, t->size, &lines);
+    }
+}
+
+/* Text of about size bytes, lines ending in eol */
+static bench_buf make_text(size_t size, const char* eol, uint64_t seed) {
+    bench_buf b = {0};
+    while (b.size < size) {
+        buf_line(&b, (uint32_t)bench_rand(&seed), eol);
+    }
+    return b;
+}
+
+static void run_text_benchmarks(void) {
+    struct {
+        const char* name;
+        bench_buf buf;
+    } inputs[7];
+    int count = 0;
+
+    inputs[count].name = "tiny";
+    inputs[count++].buf = make_text(64, "\n", 1);
+    inputs[count].name = "typical";
+    inputs[count++].buf = make_text(16 << 10, "\n", 2);
+    inputs[count].name = "large";
+    inputs[count++].buf = make_text(4 << 20, "\n", 3);
+    inputs[count].name = "crlf";
+    inputs[count++].buf = make_text(16 << 10, "\r\n", 4);
+
+    /* Binary: a NUL inside the sniff window, then more text */
+    inputs[count].name = "binary";
+    inputs[count].buf = make_text(16 << 10, "\n", 5);
+    inputs[count++].buf.data[CF_BINARY_CHECK_LEN - 1] = '\0';
+
+    /* Random bytes, NUL free, so the whole buffer has to be looked at */
+    bench_buf noise = {0};
+    uint64_t seed = 6;
+    while (noise.size < (1 << 20)) {
+        char c = (char)(bench_rand(&seed) % 255 + 1);
+        buf_append(&noise, &c, 1);
+    }
+    inputs[count].name = "noise";
+    inputs[count++].buf = noise;
+
+    /* One 1 MiB line without a line break */
+    bench_buf longline = {0};
+    while (longline.size < (1 << 20)) {
+        buf_append(&longline, "abcdefghijklmnopqrstuvwxyz012345", 32);
+    }
+    inputs[count].name = "longline";
+    inputs[count++].buf = longline;
+
+    for (int i = 0; i < count; i++) {
+        text_arg arg = { inputs[i].buf.data, inputs[i].buf.size };
+        char name[128];
+
+        snprintf(name, sizeof(name), "CountLines/%s", inputs[i].name);
+        run_bench(name, arg.size, bench_count_lines, &arg);
+        /* cf_is_binary only looks at the sniff window */
+        snprintf(name, sizeof(name), "IsBinary/%s", inputs[i].name);
+        run_bench(name, arg.size < CF_BINARY_CHECK_LEN ? arg.size : CF_BINARY_CHECK_LEN, bench_is_binary, &arg);
+        snprintf(name, sizeof(name), "ScanText/%s", inputs[i].name);
+        run_bench(name, arg.size, bench_scan_text, &arg);
+    }
+
+    for (int i = 0; i < count; i++) {
+        free(inputs[i].buf.data);
+    }
+}
+
+/* ============================================================================
+ * Line Diff Kernel
+ * ============================================================================ */
+
+typedef struct {
+    bench_buf old_text;
+    bench_buf new_text;
+    int algorithm;
+} diff_arg;
+
+static void bench_diff(void* arg, int64_t n) {
+    const diff_arg* d = (const diff_arg*)arg;
+    cf_op_buffer buf = {0};
+    cf_diff_result result;
+
+    for (int64_t i = 0; i < n; i++) {
+        buf.count = 0;
+        cf_init_diff_result(&result, 0);
+        compute_diff_generic(d->old_text.data, d->old_text.size,
+                             d->new_text.data, d->new_text.size,
+                             d->algorithm, 0, &buf, &result);
+    }
+    free(buf.ops);
+}
+
+/*
+ * Build a diff pair of lines lines. Every line of the new side is replaced
+ * with probability change_pct percent; distinct bounds the number of
+ * distinct line contents (0 = all distinct).
+ */
+static void make_diff_pair(diff_arg* d, int lines, int change_pct, int distinct, const char* eol, uint64_t seed) {
+    memset(d, 0, sizeof(*d));
+    for (int i = 0; i < lines; i++) {
+        uint32_t content = distinct > 0 ? (uint32_t)(bench_rand(&seed) % (uint64_t)distinct)
+                                        : (uint32_t)bench_rand(&seed);
+        buf_line(&d->old_text, content, eol);
+
+        if ((int)(bench_rand(&seed) % 100) < change_pct) {
+            content = distinct > 0 ? (uint32_t)(bench_rand(&seed) % (uint64_t)distinct)
+                                   : (uint32_t)bench_rand(&seed);
+        }
+        buf_line(&d->new_text, content, eol);
+    }
+}
+
+static void run_diff_benchmarks(void) {
+    static const struct {
+        const char* name;
+        int algorithm;
+    } algorithms[] = {
+        { "myers", CF_DIFF_ALGO_MYERS },
+        { "minimal", CF_DIFF_ALGO_MINIMAL },
+        { "patience", CF_DIFF_ALGO_PATIENCE },
+        { "histogram", CF_DIFF_ALGO_HISTOGRAM },
+    };
+    struct {
+        const char* name;
+        diff_arg arg;
+    } pairs[5];
+    int count = 0;
+
+    pairs[count].name = "small-edit";
+    make_diff_pair(&pairs[count++].arg, 2000, 1, 0, "\n", 11);
+    pairs[count].name = "rewrite";
+    make_diff_pair(&pairs[count++].arg, 2000, 100, 0, "\n", 12);
+    pairs[count].name = "repetitive";
+    make_diff_pair(&pairs[count++].arg, 4000, 20, 8, "\n", 13);
+    pairs[count].name = "crlf";
+    make_diff_pair(&pairs[count++].arg, 2000, 1, 0, "\r\n", 14);
+    pairs[count].name = "identical";
+    make_diff_pair(&pairs[count++].arg, 2000, 0, 0, "\n", 15);
+
+    for (int p = 0; p < count; p++) {
+        diff_arg* d = &pairs[p].arg;
+        for (size_t a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); a++) {
+            char name[128];
+            snprintf(name, sizeof(name), "DiffBuffers/%s/%s", pairs[p].name, algorithms[a].name);
+            d->algorithm = algorithms[a].algorithm;
+            run_bench(name, d->old_text.size + d->new_text.size, bench_diff, d);
+        }
+        free(d->old_text.data);
+        free(d->new_text.data);
+    }
+}
+
+/* ============================================================================
+ * Fixture Repository
+ * ============================================================================ */
+
+#define FIXTURE_DIRS 5
+#define FIXTURE_FILES_PER_DIR 10
+#define FIXTURE_FILES (FIXTURE_DIRS * FIXTURE_FILES_PER_DIR)
+#define FIXTURE_COMMITS 200
+#define FIXTURE_EDITS_PER_COMMIT 5
+#define FIXTURE_MAX_LINES 4000
+
+typedef struct {
+    git_repository* repo;
+    git_oid trees[FIXTURE_COMMITS];
+    cf_diff_request* requests;      /* Modified files of all consecutive tree pairs */
+    int request_count;
+    size_t request_bytes;           /* Blob bytes of all requests */
+} fixture;
+
+/* Line seeds of one fixture file */
+typedef struct {
+    uint32_t* lines;
+    int count;
+} fixture_file;
+
+static void check(int err, const char* what) {
+    if (err < 0) {
+        const git_error* e = git_error_last();
+        fprintf(stderr, "%s: %s\n", what, e != NULL ? e->message : "unknown error");
+        exit(1);
+    }
+}
+
+/* Replace, insert or delete a few lines of a file */
+static void edit_file(fixture_file* f, uint64_t* seed) {
+    int edits = 1 + (int)(bench_rand(seed) % 8);
+    for (int e = 0; e < edits; e++) {
+        int at = (int)(bench_rand(seed) % (uint64_t)(f->count + 1));
+        switch (bench_rand(seed) % 3) {
+        case 0:
+            if (at < f->count) {
+                f->lines[at] = (uint32_t)bench_rand(seed);
+                break;
+            }
+            /* fall through */
+        case 1:
+            if (f->count < FIXTURE_MAX_LINES) {
+                memmove(&f->lines[at + 1], &f->lines[at], (size_t)(f->count - at) * sizeof(uint32_t));
+                f->lines[at] = (uint32_t)bench_rand(seed);
+                f->count++;
+            }
+            break;
+        default:
+            if (at < f->count && f->count > 1) {
+                memmove(&f->lines[at], &f->lines[at + 1], (size_t)(f->count - at - 1) * sizeof(uint32_t));
+                f->count--;
+            }
+            break;
+        }
+    }
+}
+
+static void write_tree(fixture* fx, fixture_file* files, git_oid* out) {
+    git_treebuilder* root;
+    check(git_treebuilder_new(&root, fx->repo, NULL), "treebuilder");
+
+    for (int d = 0; d < FIXTURE_DIRS; d++) {
+        git_treebuilder* dir;
+        check(git_treebuilder_new(&dir, fx->repo, NULL), "treebuilder");
+
+        for (int i = 0; i < FIXTURE_FILES_PER_DIR; i++) {
+            fixture_file* f = &files[d * FIXTURE_FILES_PER_DIR + i];
+            bench_buf content = {0};
+            for (int l = 0; l < f->count; l++) {
+                buf_line(&content, f->lines[l], "\n");
+            }
+
+            git_oid blob;
+            char name[32];
+            check(git_blob_create_from_buffer(&blob, fx->repo, content.data, content.size), "blob");
+            snprintf(name, sizeof(name), "file%02d.c", i);
+            check(git_treebuilder_insert(NULL, dir, name, &blob, GIT_FILEMODE_BLOB), "insert blob");
+            free(content.data);
+        }
+
+        git_oid dir_oid;
+        char name[32];
+        check(git_treebuilder_write(&dir_oid, dir), "write tree");
+        snprintf(name, sizeof(name), "dir%d", d);
+        check(git_treebuilder_insert(NULL, root, name, &dir_oid, GIT_FILEMODE_TREE), "insert tree");
+        git_treebuilder_free(dir);
+    }
+
+    check(git_treebuilder_write(out, root), "write tree");
+    git_treebuilder_free(root);
+}
+
+/* Pack every tree, so reads go through a pack like in real repositories */
+static void pack_fixture(fixture* fx) {
+    git_packbuilder* pb;
+    check(git_packbuilder_new(&pb, fx->repo), "packbuilder");
+    for (int c = 0; c < FIXTURE_COMMITS; c++) {
+        check(git_packbuilder_insert_tree(pb, &fx->trees[c]), "pack tree");
+    }
+    check(git_packbuilder_write(pb, NULL, 0, NULL, NULL), "write pack");
+    git_packbuilder_free(pb);
+}
+
+/* Collect the modified files of all consecutive tree pairs as diff requests */
+static void collect_requests(fixture* fx) {
+    int capacity = 1024;
+    fx->requests = calloc((size_t)capacity, sizeof(cf_diff_request));
+
+    for (int c = 1; c < FIXTURE_COMMITS; c++) {
+        cf_tree_diff_result changes;
+        check(cf_tree_diff(fx->repo, &fx->trees[c - 1], &fx->trees[c], NULL, &changes), "tree diff");
+
+        for (int i = 0; i < changes.count; i++) {
+            const cf_change* change = &changes.changes[i];
+            if (change->status != GIT_DELTA_MODIFIED) {
+                continue;
+            }
+            if (fx->request_count == capacity) {
+                capacity *= 2;
+                fx->requests = realloc(fx->requests, (size_t)capacity * sizeof(cf_diff_request));
+            }
+
+            cf_diff_request* req = &fx->requests[fx->request_count++];
+            memset(req, 0, sizeof(*req));
+            memcpy(req->old_oid.id, change->old_oid, GIT_OID_RAWSZ);
+            memcpy(req->new_oid.id, change->new_oid, GIT_OID_RAWSZ);
+            req->has_old = 1;
+            req->has_new = 1;
+            fx->request_bytes += change->old_size + change->new_size;
+        }
+        cf_free_tree_diff_result(&changes);
+    }
+}
+
+/*
+ * Open the fixture at path, or generate it there first. The content only
+ * depends on the constants above, so a kept fixture stays comparable.
+ */
+static void open_fixture(fixture* fx, const char* path) {
+    memset(fx, 0, sizeof(*fx));
+
+    char marker[PATH_MAX];
+    snprintf(marker, sizeof(marker), "%s/bench-trees", path);
+
+    FILE* trees = fopen(marker, "rb");
+    if (trees != NULL) {
+        check(git_repository_open(&fx->repo, path), "open fixture");
+        size_t read = fread(fx->trees, sizeof(git_oid), FIXTURE_COMMITS, trees);
+        fclose(trees);
+        if (read != FIXTURE_COMMITS) {
+            fprintf(stderr, "%s: truncated\n", marker);
+            exit(1);
+        }
+        collect_requests(fx);
+        return;
+    }
+
+    fprintf(stderr, "generating fixture repository in %s\n", path);
+    check(git_repository_init(&fx->repo, path, 1), "init fixture");
+
+    fixture_file files[FIXTURE_FILES];
+    uint64_t seed = 42;
+    for (int i = 0; i < FIXTURE_FILES; i++) {
+        files[i].lines = malloc(FIXTURE_MAX_LINES * sizeof(uint32_t));
+        files[i].count = 50 + (int)(bench_rand(&seed) % 1500);
+        for (int l = 0; l < files[i].count; l++) {
+            files[i].lines[l] = (uint32_t)bench_rand(&seed);
+        }
+    }
+
+    for (int c = 0; c < FIXTURE_COMMITS; c++) {
+        if (c > 0) {
+            for (int e = 0; e < FIXTURE_EDITS_PER_COMMIT; e++) {
+                edit_file(&files[bench_rand(&seed) % FIXTURE_FILES], &seed);
+            }
+        }
+        write_tree(fx, files, &fx->trees[c]);
+    }
+    for (int i = 0; i < FIXTURE_FILES; i++) {
+        free(files[i].lines);
+    }
+
+    pack_fixture(fx);
+
+    trees = fopen(marker, "wb");
+    if (trees == NULL || fwrite(fx->trees, sizeof(git_oid), FIXTURE_COMMITS, trees) != FIXTURE_COMMITS) {
+        fprintf(stderr, "%s: cannot write\n", marker);
+        exit(1);
+    }
+    fclose(trees);
+
+    collect_requests(fx);
+}
+
+/* ============================================================================
+ * Repository Kernels
+ * ============================================================================ */
+
+static void bench_tree_diff(void* arg, int64_t n) {
+    fixture* fx = (fixture*)arg;
+    for (int64_t i = 0; i < n; i++) {
+        int c = 1 + (int)(i % (FIXTURE_COMMITS - 1));
+        cf_tree_diff_result changes;
+        cf_tree_diff(fx->repo, &fx->trees[c - 1], &fx->trees[c], NULL, &changes);
+        cf_free_tree_diff_result(&changes);
+    }
+}
+
+static void bench_preload(void* arg, int64_t n) {
+    fixture* fx = (fixture*)arg;
+    git_odb* odb;
+    check(git_repository_odb(&odb, fx->repo), "odb");
+
+    for (int64_t i = 0; i < n; i++) {
+        cf_preloaded_blob* blobs = NULL;
+        int blob_count = 0;
+        preload_blobs_for_diff(fx->repo, odb, NULL, fx->requests, fx->request_count, &blobs, &blob_count);
+        free_preloaded_blobs(blobs, blob_count);
+    }
+    git_odb_free(odb);
+}
+
+static void bench_batch_diff(void* arg, int64_t n) {
+    fixture* fx = (fixture*)arg;
+    cf_diff_flat_result* results = malloc((size_t)fx->request_count * sizeof(cf_diff_flat_result));
+
+    for (int64_t i = 0; i < n; i++) {
+        cf_diff_op* ops = NULL;
+        size_t op_count = 0;
+        cf_batch_diff_blobs_flat(fx->repo, fx->requests, fx->request_count, NULL, 0, &ops, &op_count, results, NULL);
+        free(ops);
+    }
+    free(results);
+}
+
+static void run_repository_benchmarks(const char* fixture_path) {
+    if (!bench_selected("TreeDiff/fixture") && !bench_selected("PreloadBlobs/fixture") &&
+        !bench_selected("BatchDiffBlobs/fixture")) {
+        return;
+    }
+
+    char generated[] = "/tmp/clib-bench-XXXXXX";
+    const char* path = fixture_path;
+
+    if (path == NULL) {
+        path = mkdtemp(generated);
+        if (path == NULL) {
+            perror("mkdtemp");
+            exit(1);
+        }
+    }
+
+    fixture fx;
+    open_fixture(&fx, path);
+
+    run_bench("TreeDiff/fixture", 0, bench_tree_diff, &fx);
+    run_bench("PreloadBlobs/fixture", fx.request_bytes, bench_preload, &fx);
+    run_bench("BatchDiffBlobs/fixture", fx.request_bytes, bench_batch_diff, &fx);
+
+    free(fx.requests);
+    git_repository_free(fx.repo);
+    if (fixture_path == NULL) {
+        fprintf(stderr, "fixture left in %s (pass -fixture to reuse it)\n", path);
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* fixture_path = NULL;
+    int threads = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-benchtime") == 0 && i + 1 < argc) {
+            bench_time_ns = atoll(argv[++i]) * 1000000LL;
+        } else if (strcmp(argv[i], "-count") == 0 && i + 1 < argc) {
+            bench_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-fixture") == 0 && i + 1 < argc) {
+            fixture_path = argv[++i];
+        } else if (argv[i][0] != '-') {
+            bench_filter = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s [-benchtime ms] [-count n] [-threads n] [-fixture dir] [filter]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    git_libgit2_init();
+    cf_init();
+    cf_set_parallelism(threads);
+
+    printf("pkg: clib\n");
+    printf("threads: %d\n", threads);
+
+    run_text_benchmarks();
+    run_diff_benchmarks();
+    run_repository_benchmarks(fixture_path);
+
+    git_libgit2_shutdown();
+    return 0;
+}
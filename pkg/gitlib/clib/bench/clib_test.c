@@ -0,0 +1,505 @@
+/*
+ * Codefang Git Library - Native Tests
+ *
+ * Checks clib code that the Go tests cannot reach through the bridge, with
+ * the sources included like cgo_bridge.go does so static functions and
+ * internal state can be inspected:
+ * 1. The pooled allocator (alloc_pool.c): size classes, realloc between
+ *    classes and out of the pool, frees on other threads, flushing a
+ *    thread's blocks when it exits, running out of the reserved range, and
+ *    libgit2 reading and writing objects through it
+ *
+ * The allocator is installed once per process, so the tests share one pool
+ * and run in order; the one that exhausts the pool runs last.
+ *
+ * Output follows go test:
+ *   --- PASS: TestPoolSizeClasses
+ *   PASS
+ *
+ * Usage: clib-test [filter]
+ */
+
+#define _GNU_SOURCE /* nftw flags */
+
+#include <git2.h>
+#include <ftw.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../stats.c"
+#include "../alloc_pool.c"
+
+/* Reserved range of the pool under test: 256 slabs */
+#define TEST_POOL_BYTES (256 * CF_POOL_SLAB_SIZE)
+
+static const char* test_filter = NULL;
+static int test_failed;
+
+#define CHECK(cond)                                                           \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            printf("    %s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failed = 1;                                                  \
+            return;                                                           \
+        }                                                                     \
+    } while (0)
+
+typedef void (*test_fn)(void);
+
+/* Run one test when its name contains the filter; reports whether it passed */
+static int run_test(const char* name, test_fn fn) {
+    if (test_filter != NULL && strstr(name, test_filter) == NULL) {
+        return 1;
+    }
+
+    test_failed = 0;
+    fn();
+    printf("--- %s: %s\n", test_failed ? "FAIL" : "PASS", name);
+    fflush(stdout);
+    return !test_failed;
+}
+
+/* Size of the block behind a pooled pointer */
+static size_t block_size(const void* ptr) {
+    return cf_pool_class_size[cf_pool_slab_class[((const char*)ptr - cf_pool_base) / CF_POOL_SLAB_SIZE]];
+}
+
+static int class_index(size_t n) {
+    return cf_pool_class_of[(n + 15) / 16];
+}
+
+/* Fill and verify a buffer with a pattern derived from seed */
+static void fill(void* ptr, size_t n, unsigned seed) {
+    unsigned char* p = (unsigned char*)ptr;
+    for (size_t i = 0; i < n; i++) {
+        p[i] = (unsigned char)(seed + i * 31);
+    }
+}
+
+static int intact(const void* ptr, size_t n, unsigned seed) {
+    const unsigned char* p = (const unsigned char*)ptr;
+    for (size_t i = 0; i < n; i++) {
+        if (p[i] != (unsigned char)(seed + i * 31)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Whether ptr is on the shared free list of its class */
+static int on_shared_list(const void* ptr, int cls) {
+    cf_pool_list* shared = &cf_pool_shared[cls];
+    int found = 0;
+
+    pthread_mutex_lock(&shared->lock);
+    for (cf_pool_block* b = shared->head; b != NULL && !found; b = b->next) {
+        found = (const void*)b == ptr;
+    }
+    pthread_mutex_unlock(&shared->lock);
+    return found;
+}
+
+static uint64_t pool_counter(int which) {
+    cf_stats st;
+    cf_get_stats(&st);
+    return which == CF_STAT_POOL_ALLOCS ? st.pool_allocs : st.pool_fallbacks;
+}
+
+/* ============================================================================
+ * Pooled Allocator
+ * ============================================================================ */
+
+/* Every size up to CF_POOL_MAX_SMALL gets the smallest class that fits */
+static void test_pool_size_classes(void) {
+    enum { MAX = CF_POOL_MAX_SMALL + 1, LARGE = 4 };
+    static void* small[MAX];
+    static const size_t large_sizes[LARGE] = { CF_POOL_MAX_SMALL + 1, 4096, 65536, 1 << 20 };
+    void* large[LARGE];
+    cf_alloc_batch_end();
+    uint64_t allocs = pool_counter(CF_STAT_POOL_ALLOCS);
+    uint64_t fallbacks = pool_counter(CF_STAT_POOL_FALLBACKS);
+
+    for (size_t n = 0; n < MAX; n++) {
+        small[n] = pool_malloc(n, __FILE__, __LINE__);
+        CHECK(small[n] != NULL);
+        CHECK(in_pool(small[n]));
+        CHECK(((uintptr_t)small[n] & 15) == 0);
+        CHECK(block_size(small[n]) >= n);
+        int cls = class_index(n);
+        CHECK(cls == 0 || cf_pool_class_size[cls - 1] < n);
+        fill(small[n], n, (unsigned)n);
+    }
+    for (int i = 0; i < LARGE; i++) {
+        large[i] = pool_malloc(large_sizes[i], __FILE__, __LINE__);
+        CHECK(large[i] != NULL);
+        CHECK(!in_pool(large[i]));
+        fill(large[i], large_sizes[i], (unsigned)i);
+    }
+
+    /* No block overlaps another */
+    for (size_t n = 0; n < MAX; n++) {
+        CHECK(intact(small[n], n, (unsigned)n));
+    }
+    for (int i = 0; i < LARGE; i++) {
+        CHECK(intact(large[i], large_sizes[i], (unsigned)i));
+    }
+
+    for (size_t n = 0; n < MAX; n++) {
+        pool_free(small[n]);
+    }
+    for (int i = 0; i < LARGE; i++) {
+        pool_free(large[i]);
+    }
+    pool_free(NULL);
+
+    cf_alloc_batch_end();
+    CHECK(pool_counter(CF_STAT_POOL_ALLOCS) - allocs == MAX);
+    CHECK(pool_counter(CF_STAT_POOL_FALLBACKS) - fallbacks == LARGE);
+}
+
+/* realloc keeps the content within a class, across classes and out of the pool */
+static void test_pool_realloc(void) {
+    void* p = pool_realloc(NULL, 20, __FILE__, __LINE__);
+    CHECK(in_pool(p));
+    fill(p, 20, 7);
+
+    /* Room left in the block: unchanged */
+    CHECK(pool_realloc(p, 30, __FILE__, __LINE__) == p);
+    CHECK(pool_realloc(p, 4, __FILE__, __LINE__) == p);
+    CHECK(intact(p, 20, 7));
+
+    /* Into a larger class */
+    void* grown = pool_realloc(p, 300, __FILE__, __LINE__);
+    CHECK(in_pool(grown));
+    CHECK(grown != p);
+    CHECK(block_size(grown) >= 300);
+    CHECK(intact(grown, 20, 7));
+    fill(grown, 300, 9);
+
+    /* The old block is reused first by its class */
+    void* again = pool_malloc(20, __FILE__, __LINE__);
+    CHECK(again == p);
+    pool_free(again);
+
+    /* Out of the pool, and the pooled block freed */
+    void* large = pool_realloc(grown, 5000, __FILE__, __LINE__);
+    CHECK(large != NULL);
+    CHECK(!in_pool(large));
+    CHECK(intact(large, 300, 9));
+    again = pool_malloc(300, __FILE__, __LINE__);
+    CHECK(again == grown);
+    pool_free(again);
+
+    /* Unpooled blocks stay with malloc, growing or shrinking */
+    fill(large, 5000, 11);
+    large = pool_realloc(large, 100000, __FILE__, __LINE__);
+    CHECK(large != NULL);
+    CHECK(!in_pool(large));
+    CHECK(intact(large, 5000, 11));
+    large = pool_realloc(large, 8, __FILE__, __LINE__);
+    CHECK(large != NULL);
+    CHECK(!in_pool(large));
+    CHECK(intact(large, 8, 11));
+    pool_free(large);
+
+    cf_alloc_batch_end();
+}
+
+typedef struct {
+    void** blocks;
+    int count;
+    size_t size;
+} block_set;
+
+static void* free_blocks_thread(void* arg) {
+    block_set* set = (block_set*)arg;
+    for (int i = 0; i < set->count; i++) {
+        pool_free(set->blocks[i]);
+    }
+    return NULL;
+}
+
+static void* alloc_blocks_thread(void* arg) {
+    block_set* set = (block_set*)arg;
+    for (int i = 0; i < set->count; i++) {
+        set->blocks[i] = pool_malloc(set->size, __FILE__, __LINE__);
+    }
+    return NULL;
+}
+
+static int in_set(const void* ptr, void* const* blocks, int count) {
+    for (int i = 0; i < count; i++) {
+        if (blocks[i] == ptr) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Blocks freed on another thread go to that thread's lists, reach the
+ * shared lists when it exits and are handed to the next thread that needs
+ * their class
+ */
+static void test_pool_cross_thread_free(void) {
+    enum { N = 100 };
+    void* allocated[N];
+    void* reused[N];
+    const size_t size = 200;
+    int cls = class_index(size);
+
+    for (int i = 0; i < N; i++) {
+        allocated[i] = pool_malloc(size, __FILE__, __LINE__);
+        CHECK(in_pool(allocated[i]));
+        fill(allocated[i], size, (unsigned)i);
+    }
+    for (int i = 0; i < N; i++) {
+        CHECK(intact(allocated[i], size, (unsigned)i));
+    }
+
+    pthread_t thread;
+    block_set frees = { allocated, N, size };
+    CHECK(pthread_create(&thread, NULL, free_blocks_thread, &frees) == 0);
+    pthread_join(thread, NULL);
+
+    for (int i = 0; i < N; i++) {
+        CHECK(on_shared_list(allocated[i], cls));
+    }
+
+    block_set allocs = { reused, N, size };
+    CHECK(pthread_create(&thread, NULL, alloc_blocks_thread, &allocs) == 0);
+    pthread_join(thread, NULL);
+
+    for (int i = 0; i < N; i++) {
+        CHECK(in_set(reused[i], allocated, N));
+        CHECK(!in_set(reused[i], reused, i));
+        pool_free(reused[i]);
+    }
+    cf_alloc_batch_end();
+}
+
+typedef struct churn_arg {
+    struct churn_arg* next;         /* Thread whose blocks this one frees */
+    int seed;
+    void** slots;
+    size_t* sizes;
+    int count;
+    pthread_barrier_t* barrier;
+    int rounds;
+    int corrupt;
+} churn_arg;
+
+/* Each round allocates a slot set, then frees the set of the next thread */
+static void* churn_thread(void* arg) {
+    churn_arg* c = (churn_arg*)arg;
+    churn_arg* next = c->next;
+    uint64_t rng = (uint64_t)c->seed * 2654435761u + 1;
+
+    for (int r = 0; r < c->rounds; r++) {
+        for (int i = 0; i < c->count; i++) {
+            rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+            size_t n = (size_t)(rng >> 33) % (CF_POOL_MAX_SMALL * 2);
+            c->sizes[i] = n;
+            c->slots[i] = pool_malloc(n, __FILE__, __LINE__);
+            if ((rng >> 20) % 4 == 0) {
+                size_t grow = n + (size_t)(rng >> 40) % 512;
+                c->slots[i] = pool_realloc(c->slots[i], grow, __FILE__, __LINE__);
+                c->sizes[i] = n = grow;
+            }
+            fill(c->slots[i], n, (unsigned)(c->seed + i));
+        }
+        pthread_barrier_wait(c->barrier);
+
+        for (int i = 0; i < next->count; i++) {
+            if (!intact(next->slots[i], next->sizes[i], (unsigned)(next->seed + i))) {
+                c->corrupt = 1;
+            }
+            pool_free(next->slots[i]);
+        }
+        cf_alloc_batch_end();
+        pthread_barrier_wait(c->barrier);
+    }
+    return NULL;
+}
+
+/* Threads allocating, reallocating and freeing each other's blocks at once */
+static void test_pool_concurrent_churn(void) {
+    enum { THREADS = 4, COUNT = 2000 };
+    static void* slots[THREADS][COUNT];
+    static size_t sizes[THREADS][COUNT];
+    churn_arg args[THREADS];
+    pthread_t threads[THREADS];
+    pthread_barrier_t barrier;
+
+    pthread_barrier_init(&barrier, NULL, THREADS);
+    for (int t = 0; t < THREADS; t++) {
+        args[t] = (churn_arg){ &args[(t + 1) % THREADS], t, slots[t], sizes[t], COUNT, &barrier, 20, 0 };
+    }
+    for (int t = 0; t < THREADS; t++) {
+        CHECK(pthread_create(&threads[t], NULL, churn_thread, &args[t]) == 0);
+    }
+    for (int t = 0; t < THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    pthread_barrier_destroy(&barrier);
+
+    for (int t = 0; t < THREADS; t++) {
+        CHECK(!args[t].corrupt);
+    }
+}
+
+static void* alloc_and_free_thread(void* arg) {
+    block_set* set = (block_set*)arg;
+    alloc_blocks_thread(set);
+    free_blocks_thread(set);
+    return NULL;
+}
+
+/* A thread's free blocks and unpublished counters are flushed when it exits */
+static void test_pool_thread_exit_flush(void) {
+    enum { N = 50 };
+    void* blocks[N];
+    const size_t size = 500;
+    int cls = class_index(size);
+    uint64_t allocs = pool_counter(CF_STAT_POOL_ALLOCS);
+
+    pthread_t thread;
+    block_set set = { blocks, N, size };
+    CHECK(pthread_create(&thread, NULL, alloc_and_free_thread, &set) == 0);
+    pthread_join(thread, NULL);
+
+    for (int i = 0; i < N; i++) {
+        CHECK(in_pool(blocks[i]));
+        CHECK(on_shared_list(blocks[i], cls));
+    }
+    CHECK(pool_counter(CF_STAT_POOL_ALLOCS) - allocs == N);
+}
+
+static int remove_entry(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    return remove(path);
+}
+
+/* libgit2 writes and reads objects through the installed allocator */
+static void test_pool_libgit2_objects(void) {
+    enum { N = 300 };
+    char dir[] = "/tmp/clib-test-XXXXXX";
+    CHECK(mkdtemp(dir) != NULL);
+
+    git_repository* repo = NULL;
+    git_oid ids[N];
+    char content[4096];
+    uint64_t allocs = pool_counter(CF_STAT_POOL_ALLOCS);
+    int ok = git_repository_init(&repo, dir, 1) == 0;
+
+    for (int i = 0; ok && i < N; i++) {
+        size_t n = (size_t)(i * 13) % sizeof(content);
+        fill(content, n, (unsigned)i);
+        ok = git_blob_create_from_buffer(&ids[i], repo, content, n) == 0;
+    }
+    for (int i = 0; ok && i < N; i++) {
+        git_blob* blob = NULL;
+        size_t n = (size_t)(i * 13) % sizeof(content);
+        ok = git_blob_lookup(&blob, repo, &ids[i]) == 0 && (size_t)git_blob_rawsize(blob) == n &&
+             intact(git_blob_rawcontent(blob), n, (unsigned)i);
+        git_blob_free(blob);
+    }
+    git_repository_free(repo);
+    cf_alloc_batch_end();
+    nftw(dir, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+
+    CHECK(ok);
+    CHECK(pool_counter(CF_STAT_POOL_ALLOCS) > allocs);
+}
+
+/*
+ * Past the reserved range requests fall back to malloc, reallocs out of
+ * the pool keep their content, and freed blocks are reused afterwards
+ */
+static void test_pool_exhaustion(void) {
+    const size_t size = CF_POOL_MAX_SMALL;
+    size_t max_blocks = TEST_POOL_BYTES / size + 1;
+    void** blocks = (void**)malloc(max_blocks * sizeof(void*));
+    CHECK(blocks != NULL);
+
+    void* small = pool_malloc(40, __FILE__, __LINE__);
+    CHECK(in_pool(small));
+    fill(small, 40, 3);
+
+    cf_alloc_batch_end();
+    uint64_t fallbacks = pool_counter(CF_STAT_POOL_FALLBACKS);
+    size_t count = 0;
+    void* overflow = NULL;
+    while (count < max_blocks) {
+        void* p = pool_malloc(size, __FILE__, __LINE__);
+        CHECK(p != NULL);
+        if (!in_pool(p)) {
+            overflow = p;
+            break;
+        }
+        fill(p, size, (unsigned)count);
+        blocks[count++] = p;
+    }
+    CHECK(overflow != NULL);
+    fill(overflow, size, 99);
+
+    /* A reallocation that needs a new block of an exhausted class */
+    void* moved = pool_realloc(small, size, __FILE__, __LINE__);
+    CHECK(moved != NULL);
+    CHECK(!in_pool(moved));
+    CHECK(intact(moved, 40, 3));
+
+    for (size_t i = 0; i < count; i++) {
+        CHECK(intact(blocks[i], size, (unsigned)i));
+    }
+    CHECK(intact(overflow, size, 99));
+    cf_alloc_batch_end();
+    CHECK(pool_counter(CF_STAT_POOL_FALLBACKS) - fallbacks == 2);
+
+    pool_free(overflow);
+    pool_free(moved);
+    for (size_t i = 0; i < count; i++) {
+        pool_free(blocks[i]);
+    }
+
+    void* p = pool_malloc(size, __FILE__, __LINE__);
+    CHECK(in_set(p, blocks, (int)count));
+    pool_free(p);
+    free(blocks);
+    cf_alloc_batch_end();
+}
+
+int main(int argc, char** argv) {
+    if (argc > 2 || (argc == 2 && argv[1][0] == '-')) {
+        fprintf(stderr, "usage: %s [filter]\n", argv[0]);
+        return 2;
+    }
+    if (argc == 2) {
+        test_filter = argv[1];
+    }
+
+    git_libgit2_init();
+    if (cf_alloc_pool_install(TEST_POOL_BYTES) != CF_OK || atomic_load(&cf_pool_state) != 2) {
+        printf("--- FAIL: installing the pooled allocator\nFAIL\n");
+        return 1;
+    }
+
+    int ok = 1;
+    ok &= run_test("TestPoolSizeClasses", test_pool_size_classes);
+    ok &= run_test("TestPoolRealloc", test_pool_realloc);
+    ok &= run_test("TestPoolCrossThreadFree", test_pool_cross_thread_free);
+    ok &= run_test("TestPoolConcurrentChurn", test_pool_concurrent_churn);
+    ok &= run_test("TestPoolThreadExitFlush", test_pool_thread_exit_flush);
+    ok &= run_test("TestPoolLibgit2Objects", test_pool_libgit2_objects);
+    ok &= run_test("TestPoolExhaustion", test_pool_exhaustion);
+
+    git_libgit2_shutdown();
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
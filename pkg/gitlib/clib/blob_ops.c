@@ -4,8 +4,10 @@
  * Optimized for batch loading with pack-aware strategies:
  * 1. Uses ODB API directly for faster raw object access
  * 2. Pre-validates OIDs in batch to reduce redundant lookups
- * 3. Sorts OIDs for better pack cache locality
+ * 3. Reads objects in pack storage order for better pack cache locality
  * 4. OpenMP parallel loading (git_odb is thread-safe for reading)
+ * 5. Reads go through the repository's object cache when one is attached
+ * 6. Blobs above the large blob threshold are scanned in chunks, never copied
  */
 
 #include "codefang_git.h"
@@ -19,14 +21,92 @@
 /* Structure for sorting OIDs while tracking original indices */
 typedef struct {
     git_oid oid;
+    cf_pack_pos pos;
     int original_index;
 } cf_oid_with_index;
 
-/* Comparison function for sorting OIDs (improves pack cache locality) */
-static int compare_oids(const void* a, const void* b) {
+/* Comparison function for pack order; OID order for equal positions (loose objects) */
+static int compare_pack_order(const void* a, const void* b) {
     const cf_oid_with_index* oid_a = (const cf_oid_with_index*)a;
     const cf_oid_with_index* oid_b = (const cf_oid_with_index*)b;
-    return memcmp(oid_a->oid.id, oid_b->oid.id, GIT_OID_RAWSZ);
+    int cmp = cf_pack_pos_compare(&oid_a->pos, &oid_b->pos);
+    return cmp != 0 ? cmp : memcmp(oid_a->oid.id, oid_b->oid.id, GIT_OID_RAWSZ);
+}
+
+/*
+ * Sort requests by where they are stored, so reads walk each pack forwards
+ * and delta chains are resolved while their bases are still cached.
+ * Falls back to OID order when the pack indexes cannot be mapped.
+ */
+static void sort_by_pack_order(git_repository* repo, cf_oid_with_index* sorted, int count) {
+    cf_pack_locator* loc = cf_pack_locator_acquire(repo);
+    for (int i = 0; i < count; i++) {
+        cf_pack_locator_find(loc, &sorted[i].oid, &sorted[i].pos);
+    }
+    cf_pack_locator_free(loc);
+
+    qsort(sorted, count, sizeof(cf_oid_with_index), compare_pack_order);
+}
+
+/* Read size of cf_scan_blob_stream */
+#define CF_STREAM_CHUNK_SIZE (256 * 1024)
+
+int cf_blob_too_large(git_odb* odb, const git_oid* oid, size_t* size) {
+    size_t limit = cf_large_blob_threshold();
+    git_object_t type;
+
+    /* A failed header read is left to the load to report */
+    if (limit == 0 || git_odb_read_header(size, &type, odb, oid) != 0) {
+        return 0;
+    }
+    return *size > limit;
+}
+
+int cf_scan_blob_stream(git_odb* odb, const git_oid* oid, int* is_binary, int* line_count) {
+    cf_text_scanner scan;
+    cf_text_scanner_init(&scan);
+
+    git_odb_stream* stream = NULL;
+    size_t stream_len = 0;
+    git_object_t stream_type;
+    if (git_odb_open_rstream(&stream, &stream_len, &stream_type, odb, oid) == 0) {
+        char* chunk = (char*)malloc(CF_STREAM_CHUNK_SIZE);
+        int n = 0;
+        while (chunk != NULL && !scan.is_binary &&
+               (n = git_odb_stream_read(stream, chunk, CF_STREAM_CHUNK_SIZE)) > 0) {
+            cf_text_scanner_update(&scan, chunk, (size_t)n);
+        }
+        git_odb_stream_free(stream);
+        free(chunk);
+
+        if (chunk == NULL) {
+            return CF_ERR_NOMEM;
+        }
+        if (n < 0) {
+            return CF_ERR_LOOKUP;
+        }
+    } else {
+        /* Bypass the object cache so the inflated buffer is freed at once */
+        git_odb_object* obj = NULL;
+        if (git_odb_read(&obj, odb, oid) != 0) {
+            return CF_ERR_LOOKUP;
+        }
+        cf_text_scanner_update(&scan, (const char*)git_odb_object_data(obj), git_odb_object_size(obj));
+        git_odb_object_free(obj);
+    }
+
+    *is_binary = cf_text_scanner_finish(&scan, line_count);
+    return CF_OK;
+}
+
+/*
+ * Fill the metadata of a blob above the large blob threshold instead of
+ * loading it. Always returns an error: CF_ERR_TOO_LARGE once scanned.
+ */
+static int scan_large_blob(git_odb* odb, const git_oid* oid, int* error, int* is_binary, int* line_count) {
+    int err = cf_scan_blob_stream(odb, oid, is_binary, line_count);
+    *error = err != CF_OK ? err : CF_ERR_TOO_LARGE;
+    return *error;
 }
 
 /*
@@ -34,13 +114,18 @@ static int compare_oids(const void* a, const void* b) {
  */
 static int load_single_blob_odb(
     git_odb* odb,
+    cf_odb_cache* cache,
     const git_oid* oid,
     cf_blob_result* res
 ) {
     git_odb_object* obj = NULL;
 
+    if (cf_blob_too_large(odb, oid, &res->size)) {
+        return scan_large_blob(odb, oid, &res->error, &res->is_binary, &res->line_count);
+    }
+
     /* Use ODB directly - faster than git_blob_lookup */
-    int err = git_odb_read(&obj, odb, oid);
+    int err = cf_odb_cache_read(&obj, cache, odb, oid);
     if (err != 0) {
         res->error = CF_ERR_LOOKUP;
         return CF_ERR_LOOKUP;
@@ -57,15 +142,8 @@ static int load_single_blob_odb(
     const void* content = git_odb_object_data(obj);
     size_t size = git_odb_object_size(obj);
 
-    /* Check for binary content */
-    if (size > 0) {
-        res->is_binary = cf_is_binary((const char*)content, size);
-    }
-
-    /* Count lines if not binary */
-    if (!res->is_binary && size > 0) {
-        res->line_count = cf_count_lines((const char*)content, size);
-    }
+    /* Check for binary content and count lines in one pass */
+    res->is_binary = cf_scan_text((const char*)content, size, &res->line_count);
 
     /* Copy data to malloc'd memory */
     if (size > 0) {
@@ -84,10 +162,23 @@ static int load_single_blob_odb(
     return CF_OK;
 }
 
+/*
+ * Cost of a blob batch that started at start_ns, from its finished results.
+ * Blobs scanned in chunks were inflated but not copied or kept.
+ */
+static void blob_batch_cost(cf_batch_cost* cost, uint64_t start_ns, uint64_t inflated, uint64_t copied,
+                            uint64_t held) {
+    cost->bytes_inflated = inflated;
+    cost->bytes_copied = copied;
+    cost->inflate_ns = cf_stats_now() - start_ns;
+    cost->diff_ns = 0;
+    cost->peak_bytes = held;
+}
+
 /*
  * Load multiple blobs in a single call with pack-aware optimizations.
  */
-int cf_batch_load_blobs(
+static int load_blobs(
     git_repository* repo,
     const cf_blob_request* requests,
     int count,
@@ -110,6 +201,7 @@ int cf_batch_load_blobs(
 
     /* Refresh ODB once for the entire batch */
     git_odb_refresh(odb);
+    cf_odb_cache* cache = cf_odb_cache_acquire(repo);
 
     /* Initialize all results */
     for (int i = 0; i < count; i++) {
@@ -127,10 +219,11 @@ int cf_batch_load_blobs(
     /* For small batches, skip sorting overhead */
     if (count <= 4) {
         for (int i = 0; i < count; i++) {
-            if (load_single_blob_odb(odb, &requests[i].oid, &results[i]) == CF_OK) {
+            if (load_single_blob_odb(odb, cache, &requests[i].oid, &results[i]) == CF_OK) {
                 success_count++;
             }
         }
+        cf_odb_cache_free(cache);
         git_odb_free(odb);
         return success_count;
     }
@@ -140,10 +233,11 @@ int cf_batch_load_blobs(
     if (sorted == NULL) {
         /* Fall back to unsorted loading on allocation failure */
         for (int i = 0; i < count; i++) {
-            if (load_single_blob_odb(odb, &requests[i].oid, &results[i]) == CF_OK) {
+            if (load_single_blob_odb(odb, cache, &requests[i].oid, &results[i]) == CF_OK) {
                 success_count++;
             }
         }
+        cf_odb_cache_free(cache);
         git_odb_free(odb);
         return success_count;
     }
@@ -154,16 +248,17 @@ int cf_batch_load_blobs(
         sorted[i].original_index = i;
     }
 
-    /* Sort OIDs for better pack cache locality */
-    qsort(sorted, count, sizeof(cf_oid_with_index), compare_oids);
+    /* Sort by pack position for better pack cache locality */
+    sort_by_pack_order(repo, sorted, count);
 
     /* Load blobs in sorted order - parallelized with OpenMP. */
+    int threads = cf_acquire_threads(count);
 #ifdef _OPENMP
-    if (count >= 8) {
-        #pragma omp parallel for reduction(+:success_count) schedule(dynamic, 4)
+    if (threads > 1) {
+        #pragma omp parallel for num_threads(threads) reduction(+:success_count) schedule(dynamic, 4)
         for (int i = 0; i < count; i++) {
             int orig_idx = sorted[i].original_index;
-            if (load_single_blob_odb(odb, &sorted[i].oid, &results[orig_idx]) == CF_OK) {
+            if (load_single_blob_odb(odb, cache, &sorted[i].oid, &results[orig_idx]) == CF_OK) {
                 success_count++;
             }
         }
@@ -172,13 +267,338 @@ int cf_batch_load_blobs(
     {
         for (int i = 0; i < count; i++) {
             int orig_idx = sorted[i].original_index;
-            if (load_single_blob_odb(odb, &sorted[i].oid, &results[orig_idx]) == CF_OK) {
+            if (load_single_blob_odb(odb, cache, &sorted[i].oid, &results[orig_idx]) == CF_OK) {
                 success_count++;
             }
         }
     }
+    cf_release_threads(threads);
 
     free(sorted);
+    cf_odb_cache_free(cache);
+    git_odb_free(odb);
+
+    return success_count;
+}
+
+int cf_batch_load_blobs(
+    git_repository* repo,
+    const cf_blob_request* requests,
+    int count,
+    cf_blob_result* results,
+    cf_batch_cost* cost
+) {
+    uint64_t start_ns = cf_stats_now();
+    int success_count = load_blobs(repo, requests, count, results);
+
+    if (cost != NULL) {
+        uint64_t inflated = 0, copied = 0;
+        for (int i = 0; i < count; i++) {
+            if (results[i].error == CF_OK) {
+                copied += results[i].size;
+            }
+            if (results[i].error == CF_OK || results[i].error == CF_ERR_TOO_LARGE) {
+                inflated += results[i].size;
+            }
+        }
+        blob_batch_cost(cost, start_ns, inflated, copied, copied);
+    }
+    return success_count;
+}
+
+/*
+ * Borrow a single blob from the ODB, keeping the object as its owner.
+ */
+static int borrow_single_blob_odb(
+    git_odb* odb,
+    cf_odb_cache* cache,
+    const git_oid* oid,
+    cf_blob_borrow_result* res
+) {
+    git_odb_object* obj = NULL;
+
+    if (cf_blob_too_large(odb, oid, &res->size)) {
+        return scan_large_blob(odb, oid, &res->error, &res->is_binary, &res->line_count);
+    }
+
+    int err = cf_odb_cache_read(&obj, cache, odb, oid);
+    if (err != 0) {
+        res->error = CF_ERR_LOOKUP;
+        return CF_ERR_LOOKUP;
+    }
+
+    if (git_odb_object_type(obj) != GIT_OBJECT_BLOB) {
+        git_odb_object_free(obj);
+        res->error = CF_ERR_LOOKUP;
+        return CF_ERR_LOOKUP;
+    }
+
+    res->data = git_odb_object_data(obj);
+    res->size = git_odb_object_size(obj);
+    res->is_binary = cf_scan_text((const char*)res->data, res->size, &res->line_count);
+    res->handle = obj;
+
+    return CF_OK;
+}
+
+/*
+ * Borrow multiple blobs in a single call. Same access pattern as
+ * cf_batch_load_blobs, minus the per-blob malloc and memcpy.
+ */
+static int borrow_blobs(
+    git_repository* repo,
+    const cf_blob_request* requests,
+    int count,
+    cf_blob_borrow_result* results
+) {
+    if (count == 0) {
+        return 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        cf_blob_borrow_result* res = &results[i];
+        memcpy(res->oid, requests[i].oid.id, GIT_OID_RAWSZ);
+        res->data = NULL;
+        res->size = 0;
+        res->handle = NULL;
+        res->error = CF_OK;
+        res->is_binary = 0;
+        res->line_count = 0;
+    }
+
+    git_odb* odb = NULL;
+    if (git_repository_odb(&odb, repo) != 0) {
+        for (int i = 0; i < count; i++) {
+            results[i].error = CF_ERR_LOOKUP;
+        }
+        return 0;
+    }
+
+    git_odb_refresh(odb);
+    cf_odb_cache* cache = cf_odb_cache_acquire(repo);
+
+    /* Sort by pack position; load in request order if that fails */
+    cf_oid_with_index* sorted = NULL;
+    if (count > 4) {
+        sorted = (cf_oid_with_index*)malloc(count * sizeof(cf_oid_with_index));
+    }
+    if (sorted != NULL) {
+        for (int i = 0; i < count; i++) {
+            memcpy(&sorted[i].oid, &requests[i].oid, sizeof(git_oid));
+            sorted[i].original_index = i;
+        }
+        sort_by_pack_order(repo, sorted, count);
+    }
+
+    int success_count = 0;
+    int threads = sorted != NULL ? cf_acquire_threads(count) : 1;
+
+#ifdef _OPENMP
+    if (threads > 1) {
+        #pragma omp parallel for num_threads(threads) reduction(+:success_count) schedule(dynamic, 4)
+        for (int i = 0; i < count; i++) {
+            int idx = sorted[i].original_index;
+            if (borrow_single_blob_odb(odb, cache, &requests[idx].oid, &results[idx]) == CF_OK) {
+                success_count++;
+            }
+        }
+    } else
+#endif
+    {
+        for (int i = 0; i < count; i++) {
+            int idx = sorted != NULL ? sorted[i].original_index : i;
+            if (borrow_single_blob_odb(odb, cache, &requests[idx].oid, &results[idx]) == CF_OK) {
+                success_count++;
+            }
+        }
+    }
+    cf_release_threads(threads);
+    free(sorted);
+    cf_odb_cache_free(cache);
+    git_odb_free(odb);
+
+    return success_count;
+}
+
+int cf_batch_borrow_blobs(
+    git_repository* repo,
+    const cf_blob_request* requests,
+    int count,
+    cf_blob_borrow_result* results,
+    cf_batch_cost* cost
+) {
+    uint64_t start_ns = cf_stats_now();
+    int success_count = borrow_blobs(repo, requests, count, results);
+
+    if (cost != NULL) {
+        uint64_t inflated = 0, held = 0;
+        for (int i = 0; i < count; i++) {
+            if (results[i].error == CF_OK) {
+                held += results[i].size;
+            }
+            if (results[i].error == CF_OK || results[i].error == CF_ERR_TOO_LARGE) {
+                inflated += results[i].size;
+            }
+        }
+        blob_batch_cost(cost, start_ns, inflated, 0, held);
+    }
+    return success_count;
+}
+
+/*
+ * Release borrowed blobs.
+ */
+void cf_release_blobs(cf_blob_borrow_result* results, int count) {
+    for (int i = 0; i < count; i++) {
+        if (results[i].handle != NULL) {
+            git_odb_object_free(results[i].handle);
+            results[i].handle = NULL;
+        }
+        results[i].data = NULL;
+    }
+}
+
+/*
+ * Detect binary content from the first CF_BINARY_CHECK_LEN bytes of a blob.
+ * Streams just that prefix when the backend supports read streams; otherwise
+ * reads the object (through the cache) and scans it in place.
+ */
+static int sniff_blob_binary(git_odb* odb, cf_odb_cache* cache, const git_oid* oid, size_t size, int* is_binary) {
+    size_t want = size < CF_BINARY_CHECK_LEN ? size : CF_BINARY_CHECK_LEN;
+    if (want == 0) {
+        *is_binary = 0;
+        return CF_OK;
+    }
+
+    git_odb_stream* stream = NULL;
+    size_t stream_len = 0;
+    git_object_t stream_type;
+    if (git_odb_open_rstream(&stream, &stream_len, &stream_type, odb, oid) == 0) {
+        char prefix[CF_BINARY_CHECK_LEN];
+        size_t got = 0;
+        while (got < want) {
+            int n = git_odb_stream_read(stream, prefix + got, want - got);
+            if (n <= 0) {
+                break;
+            }
+            got += (size_t)n;
+        }
+        git_odb_stream_free(stream);
+        if (got == want) {
+            *is_binary = cf_is_binary(prefix, got);
+            return CF_OK;
+        }
+    }
+
+    git_odb_object* obj = NULL;
+    if (cf_odb_cache_read(&obj, cache, odb, oid) != 0) {
+        return CF_ERR_LOOKUP;
+    }
+    *is_binary = cf_is_binary((const char*)git_odb_object_data(obj), git_odb_object_size(obj));
+    git_odb_object_free(obj);
+    return CF_OK;
+}
+
+/*
+ * Probe a single blob: header lookup, then an optional binary sniff.
+ */
+static int probe_single_blob_odb(
+    git_odb* odb,
+    cf_odb_cache* cache,
+    const git_oid* oid,
+    int flags,
+    cf_blob_probe_result* res
+) {
+    size_t size = 0;
+    git_object_t type;
+
+    if (git_odb_read_header(&size, &type, odb, oid) != 0 || type != GIT_OBJECT_BLOB) {
+        res->error = CF_ERR_LOOKUP;
+        return CF_ERR_LOOKUP;
+    }
+    res->size = size;
+
+    if (flags & CF_PROBE_SNIFF_BINARY) {
+        int err = sniff_blob_binary(odb, cache, oid, size, &res->is_binary);
+        if (err != CF_OK) {
+            res->error = err;
+            return err;
+        }
+    }
+
+    return CF_OK;
+}
+
+/*
+ * Probe multiple blobs without loading their content.
+ */
+int cf_batch_probe_blobs(
+    git_repository* repo,
+    const cf_blob_request* requests,
+    int count,
+    int flags,
+    cf_blob_probe_result* results
+) {
+    if (count == 0) {
+        return 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        memcpy(results[i].oid, requests[i].oid.id, GIT_OID_RAWSZ);
+        results[i].size = 0;
+        results[i].error = CF_OK;
+        results[i].is_binary = -1;
+    }
+
+    git_odb* odb = NULL;
+    if (git_repository_odb(&odb, repo) != 0) {
+        for (int i = 0; i < count; i++) {
+            results[i].error = CF_ERR_LOOKUP;
+        }
+        return 0;
+    }
+
+    git_odb_refresh(odb);
+    cf_odb_cache* cache = (flags & CF_PROBE_SNIFF_BINARY) ? cf_odb_cache_acquire(repo) : NULL;
+
+    /* Sort by pack position; probe in request order if that fails */
+    cf_oid_with_index* sorted = NULL;
+    if (count > 4) {
+        sorted = (cf_oid_with_index*)malloc(count * sizeof(cf_oid_with_index));
+    }
+    if (sorted != NULL) {
+        for (int i = 0; i < count; i++) {
+            memcpy(&sorted[i].oid, &requests[i].oid, sizeof(git_oid));
+            sorted[i].original_index = i;
+        }
+        sort_by_pack_order(repo, sorted, count);
+    }
+
+    int success_count = 0;
+    int threads = sorted != NULL ? cf_acquire_threads(count) : 1;
+
+#ifdef _OPENMP
+    if (threads > 1) {
+        #pragma omp parallel for num_threads(threads) reduction(+:success_count) schedule(dynamic, 16)
+        for (int i = 0; i < count; i++) {
+            int idx = sorted[i].original_index;
+            if (probe_single_blob_odb(odb, cache, &requests[idx].oid, flags, &results[idx]) == CF_OK) {
+                success_count++;
+            }
+        }
+    } else
+#endif
+    {
+        for (int i = 0; i < count; i++) {
+            int idx = sorted != NULL ? sorted[i].original_index : i;
+            if (probe_single_blob_odb(odb, cache, &requests[idx].oid, flags, &results[idx]) == CF_OK) {
+                success_count++;
+            }
+        }
+    }
+    cf_release_threads(threads);
+    free(sorted);
+    cf_odb_cache_free(cache);
     git_odb_free(odb);
 
     return success_count;
@@ -186,8 +606,13 @@ int cf_batch_load_blobs(
 
 /*
  * Load multiple blobs into a provided memory arena.
+ * Blobs are read in pack order (request order if sorting fails) and copied
+ * back to back, so one sequential pass assigns the arena offsets; a blob
+ * that no longer fits gets CF_ERR_ARENA_FULL and the pass continues with
+ * the next, which may still fit. Blobs over the large blob threshold are
+ * scanned in chunks and never copied.
  */
-int cf_batch_load_blobs_arena(
+static int load_blobs_arena(
     git_repository* repo,
     const cf_blob_request* requests,
     int count,
@@ -195,42 +620,102 @@ int cf_batch_load_blobs_arena(
     size_t arena_capacity,
     cf_blob_arena_result* results
 ) {
-    // ... [Same implementation as before, keeping it for backward compat if needed]
-    // For brevity, I'll just use the previous implementation if I hadn't deleted it mentally.
-    // But honestly, we deprecated it for Flat strategy.
-    // I'll keep the implementation provided in previous step.
     if (count == 0) return 0;
+
     git_odb* odb = NULL;
-    int err = git_repository_odb(&odb, repo);
-    if (err != 0) { for (int i = 0; i < count; i++) results[i].error = CF_ERR_LOOKUP; return 0; }
+    if (git_repository_odb(&odb, repo) != 0) {
+        for (int i = 0; i < count; i++) {
+            results[i].error = CF_ERR_LOOKUP;
+        }
+        return 0;
+    }
     git_odb_refresh(odb);
+
     for (int i = 0; i < count; i++) {
         memcpy(results[i].oid, requests[i].oid.id, GIT_OID_RAWSZ);
-        results[i].offset = 0; results[i].size = 0; results[i].error = CF_OK; results[i].is_binary = 0; results[i].line_count = 0;
+        results[i].offset = 0;
+        results[i].size = 0;
+        results[i].error = CF_OK;
+        results[i].is_binary = 0;
+        results[i].line_count = 0;
     }
+
     cf_oid_with_index* sorted = (cf_oid_with_index*)malloc(count * sizeof(cf_oid_with_index));
-    if (sorted == NULL) { git_odb_free(odb); return CF_ERR_NOMEM; } // Simplified error handling
-    for (int i = 0; i < count; i++) { memcpy(&sorted[i].oid, &requests[i].oid, sizeof(git_oid)); sorted[i].original_index = i; }
-    qsort(sorted, count, sizeof(cf_oid_with_index), compare_oids);
-    int success_count = 0;
-    volatile size_t global_offset = 0;
+    if (sorted != NULL) {
+        for (int i = 0; i < count; i++) {
+            memcpy(&sorted[i].oid, &requests[i].oid, sizeof(git_oid));
+            sorted[i].original_index = i;
+        }
+        sort_by_pack_order(repo, sorted, count);
+    }
+
+    cf_odb_cache* cache = cf_odb_cache_acquire(repo);
     char* arena_base = (char*)arena_start;
-    for (int i = 0; i < count; i++) { /* Simplified sequential fallback for now to save chars */
-        int orig_idx = sorted[i].original_index;
+    size_t offset = 0;
+    int success_count = 0;
+
+    for (int i = 0; i < count; i++) {
+        int idx = sorted != NULL ? sorted[i].original_index : i;
+        const git_oid* oid = &requests[idx].oid;
+        cf_blob_arena_result* result = &results[idx];
         git_odb_object* obj = NULL;
-        if (git_odb_read(&obj, odb, &sorted[i].oid) == 0 && git_odb_object_type(obj) == GIT_OBJECT_BLOB) {
-            size_t size = git_odb_object_size(obj);
-            if (global_offset + size <= arena_capacity) {
-                memcpy(arena_base + global_offset, git_odb_object_data(obj), size);
-                results[orig_idx].offset = global_offset; results[orig_idx].size = size;
-                if (size > 0 && !cf_is_binary((char*)git_odb_object_data(obj), size)) results[orig_idx].line_count = cf_count_lines((char*)git_odb_object_data(obj), size);
-                else results[orig_idx].is_binary = 1;
-                global_offset += size; success_count++;
-            } else results[orig_idx].error = CF_ERR_ARENA_FULL;
-            git_odb_object_free(obj);
-        } else results[orig_idx].error = CF_ERR_LOOKUP;
+
+        if (cf_blob_too_large(odb, oid, &result->size)) {
+            scan_large_blob(odb, oid, &result->error, &result->is_binary, &result->line_count);
+            continue;
+        }
+        if (cf_odb_cache_read(&obj, cache, odb, oid) != 0 || git_odb_object_type(obj) != GIT_OBJECT_BLOB) {
+            if (obj) git_odb_object_free(obj);
+            result->error = CF_ERR_LOOKUP;
+            continue;
+        }
+
+        size_t size = git_odb_object_size(obj);
+        if (size <= arena_capacity - offset) {
+            const char* data = (const char*)git_odb_object_data(obj);
+            memcpy(arena_base + offset, data, size);
+            result->offset = offset;
+            result->size = size;
+            result->is_binary = size == 0 || cf_scan_text(data, size, &result->line_count);
+            offset += size;
+            success_count++;
+        } else {
+            result->error = CF_ERR_ARENA_FULL;
+        }
+        git_odb_object_free(obj);
     }
-    free(sorted); git_odb_free(odb); return success_count;
+
+    free(sorted);
+    cf_odb_cache_free(cache);
+    git_odb_free(odb);
+    return success_count;
+}
+
+int cf_batch_load_blobs_arena(
+    git_repository* repo,
+    const cf_blob_request* requests,
+    int count,
+    void* arena_start,
+    size_t arena_capacity,
+    cf_blob_arena_result* results,
+    cf_batch_cost* cost
+) {
+    uint64_t start_ns = cf_stats_now();
+    int success_count = load_blobs_arena(repo, requests, count, arena_start, arena_capacity, results);
+
+    if (cost != NULL) {
+        uint64_t inflated = 0, copied = 0;
+        for (int i = 0; i < count; i++) {
+            if (results[i].error == CF_OK) {
+                copied += results[i].size;
+            }
+            if (results[i].error == CF_OK || results[i].error == CF_ERR_TOO_LARGE) {
+                inflated += results[i].size;
+            }
+        }
+        blob_batch_cost(cost, start_ns, inflated, copied, copied);
+    }
+    return success_count;
 }
 
 /* Internal struct for 2-pass loading */
@@ -269,20 +754,28 @@ int cf_batch_load_blobs_flat(
     cf_oid_with_index* sorted = (cf_oid_with_index*)malloc(count * sizeof(cf_oid_with_index));
     if (sorted == NULL) { git_odb_free(odb); return CF_ERR_NOMEM; }
     for (int i = 0; i < count; i++) { memcpy(&sorted[i].oid, &requests[i].oid, sizeof(git_oid)); sorted[i].original_index = i; }
-    qsort(sorted, count, sizeof(cf_oid_with_index), compare_oids);
+    sort_by_pack_order(repo, sorted, count);
 
     /* Phase 1: Load objects (Parallel) */
     cf_temp_obj* temps = (cf_temp_obj*)calloc(count, sizeof(cf_temp_obj));
     if (!temps) { free(sorted); git_odb_free(odb); return CF_ERR_NOMEM; }
+    cf_odb_cache* cache = cf_odb_cache_acquire(repo);
 
     int success_count = 0;
 
+    /* One thread grant covers both parallel phases */
+    int threads = cf_acquire_threads(count);
+
 #ifdef _OPENMP
-    if (count >= 8) {
-        #pragma omp parallel for reduction(+:success_count) schedule(dynamic, 4)
+    if (threads > 1) {
+        #pragma omp parallel for num_threads(threads) reduction(+:success_count) schedule(dynamic, 4)
         for (int i = 0; i < count; i++) {
             int orig_idx = sorted[i].original_index;
-            if (git_odb_read(&temps[i].obj, odb, &sorted[i].oid) != 0) {
+            if (cf_blob_too_large(odb, &sorted[i].oid, &results[orig_idx].size)) {
+                /* Kept out of the arena; phase 2 only sizes loaded objects */
+                scan_large_blob(odb, &sorted[i].oid, &results[orig_idx].error,
+                                &results[orig_idx].is_binary, &results[orig_idx].line_count);
+            } else if (cf_odb_cache_read(&temps[i].obj, cache, odb, &sorted[i].oid) != 0) {
                 results[orig_idx].error = CF_ERR_LOOKUP;
             } else if (git_odb_object_type(temps[i].obj) != GIT_OBJECT_BLOB) {
                 git_odb_object_free(temps[i].obj); temps[i].obj = NULL;
@@ -296,7 +789,11 @@ int cf_batch_load_blobs_flat(
     {
         for (int i = 0; i < count; i++) {
             int orig_idx = sorted[i].original_index;
-            if (git_odb_read(&temps[i].obj, odb, &sorted[i].oid) != 0) {
+            if (cf_blob_too_large(odb, &sorted[i].oid, &results[orig_idx].size)) {
+                /* Kept out of the arena; phase 2 only sizes loaded objects */
+                scan_large_blob(odb, &sorted[i].oid, &results[orig_idx].error,
+                                &results[orig_idx].is_binary, &results[orig_idx].line_count);
+            } else if (cf_odb_cache_read(&temps[i].obj, cache, odb, &sorted[i].oid) != 0) {
                 results[orig_idx].error = CF_ERR_LOOKUP;
             } else if (git_odb_object_type(temps[i].obj) != GIT_OBJECT_BLOB) {
                 git_odb_object_free(temps[i].obj); temps[i].obj = NULL;
@@ -323,14 +820,15 @@ int cf_batch_load_blobs_flat(
     char* arena = (char*)malloc(total_size > 0 ? total_size : 1);
     if (!arena) {
         for(int i=0; i<count; i++) if(temps[i].obj) git_odb_object_free(temps[i].obj);
-        free(temps); free(sorted); git_odb_free(odb);
+        cf_release_threads(threads);
+        free(temps); free(sorted); cf_odb_cache_free(cache); git_odb_free(odb);
         return CF_ERR_NOMEM;
     }
 
     /* Phase 4: Copy & Analyze (Parallel) */
 #ifdef _OPENMP
-    if (count >= 8) {
-        #pragma omp parallel for schedule(dynamic, 4)
+    if (threads > 1) {
+        #pragma omp parallel for num_threads(threads) schedule(dynamic, 4)
         for (int i = 0; i < count; i++) {
             int orig_idx = sorted[i].original_index;
             if (temps[i].obj) {
@@ -339,10 +837,7 @@ int cf_batch_load_blobs_flat(
                 
                 if (size > 0) {
                     memcpy(arena + results[orig_idx].offset, data, size);
-                    results[orig_idx].is_binary = cf_is_binary(data, size);
-                    if (!results[orig_idx].is_binary) {
-                        results[orig_idx].line_count = cf_count_lines(data, size);
-                    }
+                    results[orig_idx].is_binary = cf_scan_text(data, size, &results[orig_idx].line_count);
                 }
                 git_odb_object_free(temps[i].obj);
             }
@@ -358,18 +853,18 @@ int cf_batch_load_blobs_flat(
                 
                 if (size > 0) {
                     memcpy(arena + results[orig_idx].offset, data, size);
-                    results[orig_idx].is_binary = cf_is_binary(data, size);
-                    if (!results[orig_idx].is_binary) {
-                        results[orig_idx].line_count = cf_count_lines(data, size);
-                    }
+                    results[orig_idx].is_binary = cf_scan_text(data, size, &results[orig_idx].line_count);
                 }
                 git_odb_object_free(temps[i].obj);
             }
         }
     }
 
+    cf_release_threads(threads);
+
     free(temps);
     free(sorted);
+    cf_odb_cache_free(cache);
     git_odb_free(odb);
 
     *out_arena = arena;
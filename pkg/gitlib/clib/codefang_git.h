@@ -20,8 +20,11 @@ extern "C" {
  * Constants
  * ============================================================================ */
 
-/* Maximum operations per diff result (for pre-allocation) */
-#define CF_MAX_DIFF_OPS 100000
+/* Initial capacity of the per-thread diff op scratch buffer (grows on demand) */
+#define CF_DIFF_OPS_INITIAL 64
+
+/* Minimum independent items per thread before a batch call goes parallel */
+#define CF_PARALLEL_MIN_ITEMS_PER_THREAD 4
 
 /* Number of bytes to check for binary detection */
 #define CF_BINARY_CHECK_LEN 8000
@@ -31,6 +34,13 @@ extern "C" {
 #define CF_DIFF_INSERT 1
 #define CF_DIFF_DELETE 2
 
+/* Diff algorithms (cf_diff_request.algorithm) */
+#define CF_DIFF_ALGO_MYERS     0  /* Myers with git's cost heuristics (default) */
+#define CF_DIFF_ALGO_MINIMAL   1  /* Myers searching for the smallest diff */
+#define CF_DIFF_ALGO_PATIENCE  2  /* Anchors on unique lines, resists Myers blowup (libgit2) */
+#define CF_DIFF_ALGO_HISTOGRAM 3  /* Anchors on the rarest lines, as git's histogram;
+                                     runs as patience unless the native engine is on */
+
 /* Error codes */
 #define CF_OK           0
 #define CF_ERR_NOMEM   -1
@@ -38,6 +48,9 @@ extern "C" {
 #define CF_ERR_LOOKUP  -3
 #define CF_ERR_DIFF    -4
 #define CF_ERR_ARENA_FULL -5
+#define CF_PENDING     -6   /* Asynchronous batch still running */
+#define CF_ERR_TOO_LARGE -7 /* Blob above the large blob threshold, not loaded */
+#define CF_ERR_BUSY    -8   /* Diff worker still holds an uncollected batch */
 
 /* ============================================================================
  * Blob Operations Types
@@ -63,11 +76,38 @@ typedef struct {
     int line_count;         /* Number of lines (0 if binary) */
 } cf_blob_arena_result;
 
-/* Request for batch blob loading */
+/* Result of borrowing a blob without copying it (see cf_batch_borrow_blobs) */
+typedef struct {
+    unsigned char oid[20];  /* The blob's OID */
+    const void* data;       /* Points into libgit2's object buffer, valid until released */
+    size_t size;            /* Size of the blob data */
+    git_odb_object* handle; /* Owner of data (NULL on error), release with cf_release_blobs */
+    int error;              /* 0 on success, negative on error */
+    int is_binary;          /* 1 if binary content detected */
+    int line_count;         /* Number of lines (0 if binary) */
+} cf_blob_borrow_result;
+
+/* Blob metadata without content (see cf_batch_probe_blobs) */
+typedef struct {
+    unsigned char oid[20];  /* The blob's OID */
+    size_t size;            /* Size of the blob data */
+    int error;              /* 0 on success, negative on error */
+    int is_binary;          /* 1 if binary, -1 if not sniffed */
+} cf_blob_probe_result;
+
+/* cf_batch_probe_blobs flag: check the first CF_BINARY_CHECK_LEN bytes for binary content */
+#define CF_PROBE_SNIFF_BINARY 1
+
+/*
+ * Request for batch blob loading. A request is exactly one raw OID, so a
+ * packed array of 20-byte OIDs (e.g. a Go []Hash) is a valid request array.
+ */
 typedef struct {
     git_oid oid;            /* The blob OID to load */
 } cf_blob_request;
 
+_Static_assert(sizeof(cf_blob_request) == GIT_OID_RAWSZ, "cf_blob_request must be a packed raw OID");
+
 /* ============================================================================
  * Diff Operations Types
  * ============================================================================ */
@@ -78,16 +118,38 @@ typedef struct {
     int line_count;         /* Number of lines affected */
 } cf_diff_op;
 
+/*
+ * Where a diff operation starts on both sides. An insert starts at the
+ * old line it is inserted before, a delete at the new line it was removed
+ * before. An op ends where the next op of its diff starts, the last op at
+ * the end of both blobs.
+ */
+typedef struct {
+    int old_start;          /* 0-based first old line */
+    int new_start;          /* 0-based first new line */
+    uint64_t old_offset;    /* Byte offset of old_start in the old blob */
+    uint64_t new_offset;    /* Byte offset of new_start in the new blob */
+} cf_diff_op_pos;
+
 /* Result of diffing two blobs */
 typedef struct {
     int old_lines;          /* Total lines in old blob */
     int new_lines;          /* Total lines in new blob */
-    cf_diff_op* ops;        /* Array of diff operations (malloc'd, caller must free) */
+    cf_diff_op* ops;        /* Array of diff operations (malloc'd, exact size, caller must free) */
     int op_count;           /* Number of operations in ops array */
-    int op_capacity;        /* Capacity of ops array */
+    int op_capacity;        /* Capacity of ops array (equals op_count once computed) */
     int error;              /* 0 on success, negative on error */
 } cf_diff_result;
 
+/* Result of diffing two blobs into a flat op arena shared by the whole batch */
+typedef struct {
+    int old_lines;          /* Total lines in old blob */
+    int new_lines;          /* Total lines in new blob */
+    uint64_t op_offset;     /* Index of the first op in the flat op arena */
+    int op_count;           /* Number of ops belonging to this result */
+    int error;              /* 0 on success, negative on error */
+} cf_diff_flat_result;
+
 /* Request for diffing two blobs */
 typedef struct {
     git_oid old_oid;        /* OID of old blob (zero OID if new file) */
@@ -98,8 +160,29 @@ typedef struct {
     size_t new_size;        /* Size of new data */
     int has_old;            /* 1 if old_oid is valid */
     int has_new;            /* 1 if new_oid is valid */
+    int algorithm;          /* CF_DIFF_ALGO_* (0 = Myers) */
 } cf_diff_request;
 
+/* ============================================================================
+ * Batch Costs
+ * ============================================================================ */
+
+/*
+ * What one batch call spent, so callers can size their next batch. Batch
+ * calls taking a cf_batch_cost* overwrite it when it is not NULL. Times are
+ * wall clock on the calling thread, whatever threads did the work.
+ */
+typedef struct {
+    uint64_t bytes_inflated;    /* Blob content read from the object database */
+    uint64_t bytes_copied;      /* Blob content and ops copied into results */
+    uint64_t inflate_ns;        /* Time spent reading objects */
+    uint64_t diff_ns;           /* Time spent in tree and line diffs */
+    uint64_t peak_bytes;        /* Result and preloaded memory held at once */
+} cf_batch_cost;
+
+/* Add part to cost (for calls made of other batch calls) */
+void cf_cost_add(cf_batch_cost* cost, const cf_batch_cost* part);
+
 /* ============================================================================
  * Tree Diff Operations Types
  * ============================================================================ */
@@ -107,12 +190,15 @@ typedef struct {
 /* Single file change (equivalent to git_diff_delta) */
 typedef struct {
     int status;             /* GIT_DELTA_ADDED, DELETED, MODIFIED, etc. */
-    char* old_path;         /* Path of old file (malloc'd) */
+    int commit_index;       /* Request index in cf_batch_tree_diff (0 for cf_tree_diff) */
+    uint32_t old_path_off;  /* Offset of old path in the result's path arena */
+    uint32_t old_path_len;  /* Length of old path (without NUL) */
     unsigned char old_oid[20];
     size_t old_size;
     uint16_t old_mode;
-    
-    char* new_path;         /* Path of new file (malloc'd) */
+
+    uint32_t new_path_off;  /* Offset of new path in the result's path arena */
+    uint32_t new_path_len;  /* Length of new path (without NUL) */
     unsigned char new_oid[20];
     size_t new_size;
     uint16_t new_mode;
@@ -124,16 +210,90 @@ typedef struct {
     int count;              /* Number of changes */
     int capacity;           /* Capacity of changes array */
     int error;              /* 0 on success */
+    char* paths;            /* Path arena, NUL-terminated strings (malloc'd) */
+    size_t paths_size;      /* Bytes used in paths */
 } cf_tree_diff_result;
 
+/* Commit to tree-diff in cf_batch_tree_diff */
+typedef struct {
+    git_oid commit_oid;     /* Commit whose changes are wanted */
+    git_oid parent_oid;     /* Diff base commit, used when has_parent is set */
+    int has_parent;         /* 0 = diff against the first parent (empty tree for roots) */
+} cf_commit_diff_request;
+
+/* Per-commit slice of a cf_batch_tree_diff result */
+typedef struct {
+    int change_offset;      /* Index of the commit's first change */
+    int change_count;       /* Number of changes (0 on error) */
+    int error;              /* 0 on success, negative on error */
+    unsigned char tree_oid[20]; /* The commit's tree */
+} cf_commit_diff_info;
+
+/* Compiled path and size filter for tree diffs (see cf_tree_filter_new) */
+typedef struct cf_tree_filter cf_tree_filter;
+
+/*
+ * Compile a tree diff filter once so every tree diff it is passed to drops
+ * unwanted changes inside libgit2's delta callback, before their paths are
+ * copied, marshalled to Go or their blobs loaded. The filter's rules are
+ * immutable and it may be shared by concurrent diffs on different
+ * repository handles.
+ *
+ * @param pathspecs      git pathspecs; a leading '!' makes a pattern exclude.
+ *                       A path passes if it matches any include (or there are
+ *                       none) and no exclude
+ * @param pathspec_count Number of pathspecs
+ * @param skip_dirs      Directories whose whole subtree is skipped, e.g.
+ *                       "node_modules". Matched at any depth unless they
+ *                       start with '/', which anchors them to the root
+ * @param skip_dir_count Number of skip_dirs
+ * @param max_blob_size  Drop changes with a blob larger than this (0 = no limit)
+ * @return               The filter, or NULL on allocation failure
+ */
+cf_tree_filter* cf_tree_filter_new(
+    const char* const* pathspecs,
+    int pathspec_count,
+    const char* const* skip_dirs,
+    int skip_dir_count,
+    size_t max_blob_size
+);
+
+/* Free a filter. Safe to call with NULL. */
+void cf_tree_filter_free(cf_tree_filter* filter);
+
+/* 1 if the filter lets path through (size limits aside) */
+int cf_tree_filter_matches(const cf_tree_filter* filter, const char* path);
+
+/* Rename detection defaults, see cf_tree_filter_set_renames */
+#define CF_RENAME_DEFAULT_THRESHOLD 50      /* Similarity percent */
+#define CF_RENAME_DEFAULT_LIMIT 1000        /* Like git's diff.renameLimit */
+#define CF_RENAME_DEFAULT_SIGNATURES 8192   /* Cached similarity signatures */
+
+/*
+ * Make every tree diff the filter is passed to report renames. Deleted and
+ * added files are paired into GIT_DELTA_RENAMED changes: identical blobs
+ * first, then files at least threshold percent similar by hashsig. The
+ * pairwise search is skipped (exact renames only) when deleted times added
+ * files exceed limit squared. Signatures are cached by blob OID across diffs,
+ * up to max_signatures of them; the cache is locked internally, so the
+ * filter may still be shared. Zero arguments select the CF_RENAME_DEFAULT_*
+ * values and a negative limit finds exact renames only. Must be called
+ * before the filter is used. Returns CF_OK or CF_ERR_NOMEM.
+ */
+int cf_tree_filter_set_renames(cf_tree_filter* filter, int threshold, int limit, size_t max_signatures);
+
 /*
  * Compute diff between two trees.
- * Returns a compact array of changes.
+ * Returns a compact array of changes. All paths live in one string arena;
+ * when old and new path are equal they share the same arena slice.
+ * Changes rejected by filter (may be NULL) are left out, and renames are
+ * paired if the filter detects them.
  */
 int cf_tree_diff(
     git_repository* repo,
     git_oid* old_tree_oid,
     git_oid* new_tree_oid,
+    const cf_tree_filter* filter,
     cf_tree_diff_result* result
 );
 
@@ -142,22 +302,68 @@ int cf_tree_diff(
  */
 void cf_free_tree_diff_result(cf_tree_diff_result* result);
 
+/*
+ * Tree-diff multiple commits against their parents in one call.
+ *
+ * Commit lookups, parent resolution and tree diffs all happen here. The
+ * changes of every commit go into one flat result sharing one path arena,
+ * tagged by commit_index and sliced per commit through infos. When a base
+ * commit is the previous request's commit (a linear walk), its tree is
+ * reused instead of looked up again.
+ *
+ * @param repo     The git repository
+ * @param requests Array of commit diff requests
+ * @param count    Number of requests
+ * @param filter   Optional change filter (may be NULL)
+ * @param result   Flat change list, free with cf_free_tree_diff_result
+ * @param infos    Pre-allocated array of per-commit slices
+ * @param cost     Optional cost of the call (may be NULL)
+ * @return         Number of successfully diffed commits
+ */
+int cf_batch_tree_diff(
+    git_repository* repo,
+    const cf_commit_diff_request* requests,
+    int count,
+    const cf_tree_filter* filter,
+    cf_tree_diff_result* result,
+    cf_commit_diff_info* infos,
+    cf_batch_cost* cost
+);
+
+/* ============================================================================
+ * Fused Commit Diff Types
+ * ============================================================================ */
+
+/* cf_batch_commit_diffs flag: also return the changed blobs (borrowed) */
+#define CF_FUSED_WANT_BLOBS 1
+
+/* Changes, line diffs and optionally blobs of a batch of commits */
+typedef struct {
+    cf_tree_diff_result changes;    /* Flat change list, as from cf_batch_tree_diff */
+    cf_diff_flat_result* diffs;     /* One per change (malloc'd); ops only for modified text files */
+    cf_diff_op* ops;                /* Flat op arena shared by all diffs (malloc'd) */
+    size_t op_count;                /* Number of ops in the arena */
+    cf_blob_borrow_result* blobs;   /* Unique changed blobs with CF_FUSED_WANT_BLOBS (malloc'd) */
+    int blob_count;                 /* Number of entries in blobs */
+} cf_commit_diffs_result;
+
 /* ============================================================================
  * Batch Operations - Core API
  * ============================================================================ */
 
 /*
- * Load multiple blobs in a single call.
+ * Load multiple blobs in a single call. cost may be NULL.
  */
 int cf_batch_load_blobs(
     git_repository* repo,
     const cf_blob_request* requests,
     int count,
-    cf_blob_result* results
+    cf_blob_result* results,
+    cf_batch_cost* cost
 );
 
 /*
- * Load multiple blobs into a provided memory arena.
+ * Load multiple blobs into a provided memory arena. cost may be NULL.
  */
 int cf_batch_load_blobs_arena(
     git_repository* repo,
@@ -165,7 +371,8 @@ int cf_batch_load_blobs_arena(
     int count,
     void* arena_start,
     size_t arena_capacity,
-    cf_blob_arena_result* results
+    cf_blob_arena_result* results,
+    cf_batch_cost* cost
 );
 
 /*
@@ -191,6 +398,101 @@ int cf_batch_load_blobs_flat(
     cf_blob_arena_result* results
 );
 
+/*
+ * Borrow multiple blobs without copying their content.
+ *
+ * Each successful result points directly at the decompressed buffer libgit2
+ * already holds for the object, and owns a reference to it through handle.
+ * The data stays valid until the result is passed to cf_release_blobs.
+ *
+ * @param repo     The git repository
+ * @param requests Array of blob requests
+ * @param count    Number of requests
+ * @param results  Pre-allocated array to store results
+ * @param cost     Optional cost of the call (may be NULL)
+ * @return         Number of successfully borrowed blobs
+ */
+int cf_batch_borrow_blobs(
+    git_repository* repo,
+    const cf_blob_request* requests,
+    int count,
+    cf_blob_borrow_result* results,
+    cf_batch_cost* cost
+);
+
+/*
+ * Release borrowed blobs. Clears handle and data; safe to call on results
+ * that failed or were already released.
+ */
+void cf_release_blobs(cf_blob_borrow_result* results, int count);
+
+/*
+ * Probe multiple blobs for size and, optionally, binary content without
+ * loading them.
+ *
+ * Sizes and types come from object headers. With CF_PROBE_SNIFF_BINARY, only
+ * the first CF_BINARY_CHECK_LEN bytes are streamed where the object storage
+ * supports it (loose objects); packed objects are read through the object
+ * cache, so a later load of the same blob does not inflate it again. No blob
+ * data is copied.
+ *
+ * @param repo     The git repository
+ * @param requests Array of blob requests
+ * @param count    Number of requests
+ * @param flags    0 or CF_PROBE_SNIFF_BINARY
+ * @param results  Pre-allocated array to store results
+ * @return         Number of successfully probed blobs
+ */
+int cf_batch_probe_blobs(
+    git_repository* repo,
+    const cf_blob_request* requests,
+    int count,
+    int flags,
+    cf_blob_probe_result* results
+);
+
+/*
+ * Tree-diff, load and line-diff a batch of commits in one call.
+ *
+ * Runs cf_batch_tree_diff over the commits, then diffs every modified blob
+ * pair with the given algorithm. Changed blobs are deduplicated across the
+ * batch and read once; binary files are detected while scanning and get
+ * CF_ERR_BINARY instead of ops. Blob data only leaves C memory with
+ * CF_FUSED_WANT_BLOBS, in which case every unique changed blob is borrowed
+ * (see cf_batch_borrow_blobs) and the diffs reuse those buffers.
+ *
+ * diffs[i] belongs to changes.changes[i]. Changes other than modifications
+ * of blobs (additions, deletions, submodules) have op_count 0 and error 0.
+ *
+ * @param repo      The git repository
+ * @param requests  Array of commit diff requests
+ * @param count     Number of requests
+ * @param algorithm CF_DIFF_ALGO_* used for every diff
+ * @param flags     0 or CF_FUSED_WANT_BLOBS
+ * @param filter    Optional change filter (may be NULL)
+ * @param result    Output, free with cf_free_commit_diffs_result
+ * @param infos     Pre-allocated array of per-commit slices of result->changes
+ * @param cost      Optional cost of the call (may be NULL)
+ * @return          Number of successfully diffed commits
+ */
+int cf_batch_commit_diffs(
+    git_repository* repo,
+    const cf_commit_diff_request* requests,
+    int count,
+    int algorithm,
+    int flags,
+    const cf_tree_filter* filter,
+    cf_commit_diffs_result* result,
+    cf_commit_diff_info* infos,
+    cf_batch_cost* cost
+);
+
+/*
+ * Free a fused result. Borrowed blobs whose handle is still set are
+ * released; callers taking ownership of a blob clear its handle first.
+ */
+void cf_free_commit_diffs_result(cf_commit_diffs_result* result);
+
 /*
  * Compute diffs for multiple blob pairs in a single call.
  */
@@ -201,6 +503,129 @@ int cf_batch_diff_blobs(
     cf_diff_result* results
 );
 
+/*
+ * Compute diffs for multiple blob pairs into one flat op arena (flat).
+ *
+ * All results share a single contiguous ops buffer and reference their
+ * slice of it by offset and count, so the whole batch costs one buffer
+ * instead of one allocation per result.
+ *
+ * If ops_buf is large enough, ops are written there and *out_ops is NULL.
+ * Otherwise one buffer is malloc'd, returned in *out_ops, and the caller
+ * is responsible for freeing it.
+ *
+ * @param repo           The git repository
+ * @param requests       Array of diff requests
+ * @param count          Number of requests
+ * @param ops_buf        Optional caller-provided op buffer (may be NULL)
+ * @param ops_capacity   Capacity of ops_buf in ops
+ * @param out_ops        Output: malloc'd op arena, or NULL if ops_buf was used
+ * @param out_op_count   Output: Total number of ops in the arena
+ * @param results        Pre-allocated array to store results
+ * @param cost           Optional cost of the call (may be NULL)
+ * @return               Number of successfully computed diffs
+ */
+int cf_batch_diff_blobs_flat(
+    git_repository* repo,
+    const cf_diff_request* requests,
+    int count,
+    cf_diff_op* ops_buf,
+    size_t ops_capacity,
+    cf_diff_op** out_ops,
+    size_t* out_op_count,
+    cf_diff_flat_result* results,
+    cf_batch_cost* cost
+);
+
+/*
+ * Compute diffs like cf_batch_diff_blobs_flat, also returning where every
+ * op starts in the two blobs. positions is parallel to the op arena, so
+ * callers that map changes onto source ranges need no second pass over
+ * the blobs. Both arenas are malloc'd and must be freed by the caller.
+ *
+ * @param repo           The git repository
+ * @param requests       Array of diff requests
+ * @param count          Number of requests
+ * @param out_ops        Output: malloc'd op arena
+ * @param out_positions  Output: malloc'd position arena, one entry per op
+ * @param out_op_count   Output: Total number of ops in the arenas
+ * @param results        Pre-allocated array to store results
+ * @param cost           Optional cost of the call (may be NULL)
+ * @return               Number of successfully computed diffs
+ */
+int cf_batch_diff_blobs_positions(
+    git_repository* repo,
+    const cf_diff_request* requests,
+    int count,
+    cf_diff_op** out_ops,
+    cf_diff_op_pos** out_positions,
+    size_t* out_op_count,
+    cf_diff_flat_result* results,
+    cf_batch_cost* cost
+);
+
+/* ============================================================================
+ * Asynchronous Diff Batches
+ * ============================================================================ */
+
+/* A persistent background thread diffing batches on one repository handle (opaque) */
+typedef struct cf_diff_worker cf_diff_worker;
+
+/*
+ * Start a diff worker for repo. While it holds a batch, repo must not be
+ * used by anyone else. Returns NULL if the thread could not be started.
+ */
+cf_diff_worker* cf_diff_worker_new(git_repository* repo);
+
+/*
+ * Stop the worker, waiting for a running batch, and free it together with
+ * the results of a batch that was not collected. NULL is a no-op.
+ */
+void cf_diff_worker_free(cf_diff_worker* worker);
+
+/*
+ * Start diffing a batch like cf_batch_diff_blobs_positions on the worker's
+ * thread, so the caller can consume the previous batch meanwhile. The
+ * requests are copied; blob data they point to must stay valid until the
+ * batch is collected. Positions are computed only if want_positions is set.
+ *
+ * @return CF_OK, CF_ERR_BUSY if the previous batch was not collected yet,
+ *         or CF_ERR_NOMEM
+ */
+int cf_submit_diff_batch(
+    cf_diff_worker* worker,
+    const cf_diff_request* requests,
+    int count,
+    int want_positions
+);
+
+/*
+ * Collect a finished batch: copies its count results into results and
+ * hands over the malloc'd arenas (out_positions may be NULL), freeing the
+ * worker for the next batch. cost (may be NULL) gets the batch's cost as
+ * measured on its thread. Returns CF_PENDING while the batch still runs,
+ * CF_ERR_LOOKUP if none was submitted, otherwise the number of
+ * successfully computed diffs.
+ */
+int cf_try_collect_diff_batch(
+    cf_diff_worker* worker,
+    cf_diff_op** out_ops,
+    cf_diff_op_pos** out_positions,
+    size_t* out_op_count,
+    cf_diff_flat_result* results,
+    cf_batch_cost* cost
+);
+
+/* Wait for the batch to finish, then collect it like cf_try_collect_diff_batch */
+int cf_wait_diff_batch(
+    cf_diff_worker* worker,
+    cf_diff_op** out_ops,
+    cf_diff_op_pos** out_positions,
+    size_t* out_op_count,
+    cf_diff_flat_result* results,
+    cf_batch_cost* cost
+);
+
 /* ============================================================================
  * Initialization
  * ============================================================================ */
@@ -216,9 +641,398 @@ void cf_init();
  * mwindow_mapped_limit: max bytes of mmap'd pack data (0 = no change).
  * cache_max_size: max bytes for object cache (0 = no change).
  * malloc_arena_max: max glibc malloc arenas (0 = no change).
+ * alloc_pool_size: install the pooled libgit2 allocator with this much
+ *   address space (0 = keep libgit2's allocator), see cf_alloc_pool_install.
  * Returns 0 on success.
  */
-int cf_configure_memory(size_t mwindow_mapped_limit, size_t cache_max_size, int malloc_arena_max);
+int cf_configure_memory(size_t mwindow_mapped_limit, size_t cache_max_size, int malloc_arena_max,
+                        size_t alloc_pool_size);
+
+/*
+ * Make libgit2 allocate through a size-class pool: requests up to 1 KiB
+ * are carved from slabs of a pool_bytes address range reserved up front,
+ * with lock-free per-thread free lists; larger ones and those that no
+ * longer fit go to malloc. Pool memory is recycled by size class and never
+ * returned to the system. Installs once per process; later calls do nothing.
+ * Returns CF_OK or CF_ERR_NOMEM.
+ */
+int cf_alloc_pool_install(size_t pool_bytes);
+
+/*
+ * Hand the calling thread's cached free pool blocks back to the shared
+ * lists and publish its counters. Called when a batch call finishes, and
+ * by each thread of a parallel batch. No-op without the pool.
+ */
+void cf_alloc_batch_end(void);
+
+/*
+ * Make repo read all objects through the object database of source, so
+ * handles opened on the same repository share one set of ODB backends, pack
+ * windows and decompressed-object cache. The ODB is reference counted and
+ * stays alive until every handle using it is freed.
+ * Returns 0 on success, or a libgit2 error code.
+ */
+int cf_repository_share_odb(git_repository* repo, git_repository* source);
+
+/* ============================================================================
+ * Large Blobs
+ * ============================================================================ */
+
+/*
+ * Set the process-wide size in bytes above which blobs are never held in
+ * memory whole (0, the default, loads blobs of any size). The blob loaders
+ * report such blobs with CF_ERR_TOO_LARGE and no data, but with their size,
+ * binary flag and line count scanned in chunks; they take no room in arenas.
+ * Diffs of such blobs fail with CF_ERR_TOO_LARGE.
+ */
+void cf_set_large_blob_threshold(size_t bytes);
+
+/* Current threshold, 0 if none */
+size_t cf_large_blob_threshold(void);
+
+/*
+ * Report whether a blob is above the threshold, from its object header
+ * alone. *size is set whenever the header could be read.
+ */
+int cf_blob_too_large(git_odb* odb, const git_oid* oid, size_t* size);
+
+/*
+ * Detect binary content and count lines of a blob like cf_scan_text without
+ * holding it whole: loose objects are streamed in chunks, packed objects
+ * (which cannot be streamed) are inflated once outside the object cache.
+ * Returns CF_OK, CF_ERR_LOOKUP or CF_ERR_NOMEM.
+ */
+int cf_scan_blob_stream(git_odb* odb, const git_oid* oid, int* is_binary, int* line_count);
+
+/* ============================================================================
+ * Native Line Diff
+ * ============================================================================ */
+
+/*
+ * Diff Myers, minimal and histogram requests with the native line engine
+ * instead of libgit2 (0, the default, uses libgit2 for every algorithm).
+ * The engine emits run-length ops without libgit2's patch callbacks and runs
+ * a real histogram diff. Process-wide; set it before diffing.
+ */
+void cf_set_native_line_diff(int enabled);
+
+/* ============================================================================
+ * Parallelism
+ * ============================================================================ */
+
+/*
+ * Set the process-wide thread budget shared by all cf_batch_* calls.
+ * Concurrent calls split the budget between them instead of each spawning
+ * their own team, so several workers never over-subscribe the machine.
+ * Returns the effective budget (1 when built without OpenMP).
+ */
+int cf_set_parallelism(int max_threads);
+
+/*
+ * Reserve up to one thread per CF_PARALLEL_MIN_ITEMS_PER_THREAD work items
+ * from the budget. Always grants at least 1 (the calling thread).
+ */
+int cf_acquire_threads(int work_items);
+
+/* Return a grant obtained from cf_acquire_threads. */
+void cf_release_threads(int granted);
+
+/* ============================================================================
+ * Object Cache
+ * ============================================================================ */
+
+/* Size-bounded LRU of decompressed objects shared across batches (opaque) */
+typedef struct cf_odb_cache cf_odb_cache;
+
+/* Counters of an object cache */
+typedef struct {
+    uint64_t hits;          /* Reads served from the cache */
+    uint64_t misses;        /* Reads that went to the ODB */
+    uint64_t evictions;     /* Objects dropped to stay under max_bytes */
+    uint64_t entries;       /* Objects currently cached */
+    uint64_t bytes;         /* Object data currently cached */
+    uint64_t max_bytes;     /* Capacity */
+} cf_odb_cache_stats;
+
+/*
+ * Create a cache holding at most max_bytes of object data (NULL if 0).
+ * The caller owns one reference.
+ */
+cf_odb_cache* cf_odb_cache_new(size_t max_bytes);
+
+/* Drop a reference; the last one releases all cached objects. NULL is a no-op. */
+void cf_odb_cache_free(cf_odb_cache* cache);
+
+/*
+ * Attach a cache to a repository handle (NULL detaches). Every cf_batch_*
+ * call on the handle then reads blobs through it. Handles on the same
+ * repository may share a cache; detach before freeing the handle.
+ */
+int cf_odb_cache_attach(git_repository* repo, cf_odb_cache* cache);
+
+/* Reference to the cache attached to repo, or NULL. Drop with cf_odb_cache_free. */
+cf_odb_cache* cf_odb_cache_acquire(git_repository* repo);
+
+/*
+ * git_odb_read through the cache (plain git_odb_read if cache is NULL).
+ * The returned object is always a reference of its own for the caller.
+ */
+int cf_odb_cache_read(git_odb_object** out, cf_odb_cache* cache, git_odb* odb, const git_oid* oid);
+
+/* Snapshot the counters of a cache */
+void cf_odb_cache_get_stats(cf_odb_cache* cache, cf_odb_cache_stats* stats);
+
+/* ============================================================================
+ * Repository Budgets
+ * ============================================================================ */
+
+/* Memory bounds of the handles opened on one repository (opaque) */
+typedef struct cf_repo_budget cf_repo_budget;
+
+/* Limits of a budget; 0 disables each */
+typedef struct {
+    size_t window_bytes;        /* Blob bytes read before a release of the pack windows is due */
+    size_t cache_bytes;         /* Object cache shared by the budget's handles */
+} cf_repo_limits;
+
+/* Accounting of a budget */
+typedef struct {
+    uint64_t batches;           /* Batch calls charged */
+    uint64_t bytes_inflated;    /* Blob content read by them */
+    uint64_t peak_bytes;        /* Largest peak of a single call */
+    uint64_t window_bytes;      /* Blob bytes read since the windows were last released */
+    uint64_t window_closes;     /* Times the pack windows were released */
+    uint64_t handles;           /* Attached repository handles */
+    uint64_t idle_ns;           /* Time since the last charged call */
+    int release_due;            /* window_bytes is past the window share */
+    cf_odb_cache_stats cache;   /* All zero without a cache */
+} cf_repo_budget_stats;
+
+/*
+ * Create a budget (NULL on allocation failure). With cache_bytes, the budget
+ * owns an object cache of that size. The caller owns one reference.
+ */
+cf_repo_budget* cf_repo_budget_new(const cf_repo_limits* limits);
+
+/* Drop a reference; attached handles keep the budget alive. NULL is a no-op. */
+void cf_repo_budget_free(cf_repo_budget* budget);
+
+/*
+ * Attach a budget to a repository handle (NULL detaches), together with the
+ * budget's object cache if it has one. Detach before freeing the handle.
+ */
+int cf_repo_budget_attach(git_repository* repo, cf_repo_budget* budget);
+
+/*
+ * Charge a finished batch call on repo to its budget; no-op without one.
+ * The cf_batch_* entry points do not charge themselves: their caller does,
+ * with the cost they filled in. Only accounts, so it may be called from any
+ * thread: past the window share the stats report a release as due, and the
+ * caller releases the windows at a point where the budget's handles are idle.
+ */
+void cf_repo_budget_charge(git_repository* repo, const cf_batch_cost* cost);
+
+/*
+ * Release the pack windows of all handles attached to budget by dropping
+ * their object databases and reopening one for them. The packs are unmapped
+ * unless handles outside the budget read them. None of the handles may be in
+ * use meanwhile. Returns CF_OK, CF_ERR_NOMEM or CF_ERR_LOOKUP.
+ */
+int cf_repo_budget_release_windows(cf_repo_budget* budget);
+
+/*
+ * Set libgit2's process-wide limits on mapped pack bytes and open pack files
+ * (0 restores the limit in force before). Past them libgit2 closes the least
+ * recently used windows and packs. Return 0 or a libgit2 error code.
+ */
+int cf_repo_budget_set_fleet_limit(size_t window_bytes);
+int cf_repo_budget_set_fleet_file_limit(size_t files);
+
+/* Snapshot the accounting of a budget */
+void cf_repo_budget_get_stats(cf_repo_budget* budget, cf_repo_budget_stats* stats);
+
+/* ============================================================================
+ * Pack Locality
+ * ============================================================================ */
+
+/* Mapped pack indexes of a repository, used to order reads by storage position (opaque) */
+typedef struct cf_pack_locator cf_pack_locator;
+
+/* Pack assigned to objects that are not found in any pack index */
+#define CF_PACK_POS_UNPACKED UINT32_MAX
+
+/* Storage position of an object */
+typedef struct {
+    uint32_t pack;          /* Pack rank, CF_PACK_POS_UNPACKED for loose objects */
+    uint64_t offset;        /* Byte offset within the pack */
+} cf_pack_pos;
+
+/*
+ * Map the pack indexes (.idx v2) under the repository's objects/pack.
+ * Returns NULL if there are none; a NULL locator reports every object as unpacked.
+ */
+cf_pack_locator* cf_pack_locator_open(git_repository* repo);
+
+/*
+ * Reference to the locator cached for repo, rebuilt when its pack directory
+ * changed since the last call. NULL if there are no indexes. Thread-safe.
+ */
+cf_pack_locator* cf_pack_locator_acquire(git_repository* repo);
+
+/* Drop the locator cached for repo. Call before freeing the handle. */
+void cf_pack_locator_forget(git_repository* repo);
+
+/* Drop a locator reference; the last one unmaps the indexes. NULL is a no-op. */
+void cf_pack_locator_free(cf_pack_locator* loc);
+
+/* Look up the storage position of oid. Thread-safe. */
+void cf_pack_locator_find(const cf_pack_locator* loc, const git_oid* oid, cf_pack_pos* pos);
+
+/* Order positions by pack, then offset */
+int cf_pack_pos_compare(const cf_pack_pos* a, const cf_pack_pos* b);
+
+/* ============================================================================
+ * Commit Walk
+ * ============================================================================ */
+
+/* Revision walk that reads commit metadata in batches (opaque) */
+typedef struct cf_revwalk cf_revwalk;
+
+/* Walk options */
+typedef struct {
+    unsigned int sort;      /* git_sort_t flags */
+    int first_parent;       /* Follow only the first parent of merges */
+    int has_since;          /* Stop at the first commit authored before since */
+    int64_t since;          /* Seconds since the epoch */
+} cf_revwalk_options;
+
+/* A string in the string arena of a cf_commit_batch (not NUL-terminated) */
+typedef struct {
+    uint32_t offset;
+    uint32_t len;
+} cf_arena_str;
+
+/* A signature as recorded in a commit header */
+typedef struct {
+    cf_arena_str name;
+    cf_arena_str email;
+    int64_t time;           /* Seconds since the epoch */
+    int32_t offset;         /* UTC offset in minutes */
+} cf_commit_sig;
+
+/* Metadata of one commit */
+typedef struct {
+    git_oid oid;
+    git_oid tree_oid;
+    uint32_t parent_start;  /* Index of the first parent in the batch parent array */
+    uint32_t parent_count;
+    cf_commit_sig author;
+    cf_commit_sig committer;
+} cf_commit_info;
+
+/* Caller-provided buffers filled by cf_revwalk_next_batch */
+typedef struct {
+    cf_commit_info* commits;
+    size_t commit_cap;
+    size_t commit_count;    /* Out */
+    git_oid* parents;
+    size_t parent_cap;
+    size_t parent_count;    /* Out */
+    char* strings;
+    size_t string_cap;
+    size_t string_len;      /* Out */
+} cf_commit_batch;
+
+/*
+ * Start a walk from start (HEAD if NULL). libgit2 reads parents and commit
+ * times from the commit-graph file while sorting, if the repository has one.
+ */
+int cf_revwalk_new(cf_revwalk** out, git_repository* repo, const git_oid* start, const cf_revwalk_options* opts);
+
+/* Free a walk. NULL is a no-op. */
+void cf_revwalk_free(cf_revwalk* walk);
+
+/*
+ * Fill batch with the next commits of the walk, as many as fit its buffers.
+ * Commits that cannot be read or parsed are skipped. Returns the number of
+ * commits filled (0 once the walk is over), CF_ERR_ARENA_FULL if the next
+ * commit alone does not fit the buffers (it stays pending for a retry with
+ * larger ones), or CF_ERR_LOOKUP if the walk failed.
+ */
+int cf_revwalk_next_batch(cf_revwalk* walk, cf_commit_batch* batch);
+
+/* ============================================================================
+ * Statistics
+ * ============================================================================ */
+
+/* Process-wide counters, see cf_stats for their meaning */
+typedef enum {
+    CF_STAT_OBJECTS_READ,
+    CF_STAT_BYTES_INFLATED,
+    CF_STAT_PRELOAD_DEDUPS,
+    CF_STAT_DIFFS,
+    CF_STAT_DIFF_OPS,
+    CF_STAT_OP_BUFFER_GROWS,
+    CF_STAT_OP_ARENA_BYTES,
+    CF_STAT_TREE_DIFFS,
+    CF_STAT_TREE_DELTAS,
+    CF_STAT_POOL_ALLOCS,
+    CF_STAT_POOL_FALLBACKS,
+    CF_STAT_POOL_BYTES,
+    CF_STAT_COUNT
+} cf_stat;
+
+/* Timed operations */
+typedef enum {
+    CF_LATENCY_OBJECT_READ,
+    CF_LATENCY_DIFF,
+    CF_LATENCY_TREE_DIFF,
+    CF_LATENCY_COUNT
+} cf_latency;
+
+/*
+ * Latency histogram buckets: bucket i counts latencies below
+ * CF_STATS_LATENCY_BASE_NS << i, the last one everything above.
+ */
+#define CF_STATS_LATENCY_BUCKETS 24
+#define CF_STATS_LATENCY_BASE_NS 1024ULL
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t buckets[CF_STATS_LATENCY_BUCKETS];     /* Not cumulative */
+} cf_latency_stats;
+
+/* Snapshot of all counters since process start */
+typedef struct {
+    uint64_t objects_read;      /* Objects read from the ODB (object cache hits excluded) */
+    uint64_t bytes_inflated;    /* Inflated size of those objects */
+    uint64_t preload_dedups;    /* Duplicate blob OIDs dropped by diff batch preloading */
+    uint64_t diffs;             /* Line diffs computed successfully */
+    uint64_t diff_ops;          /* Ops emitted by those diffs */
+    uint64_t op_buffer_grows;   /* Per-thread op buffer reallocations */
+    uint64_t op_arena_bytes;    /* Bytes of op (and position) arenas built */
+    uint64_t tree_diffs;        /* Tree-to-tree diffs computed */
+    uint64_t tree_deltas;       /* Changes kept by those tree diffs */
+    uint64_t pool_allocs;       /* libgit2 allocations served by the pooled allocator */
+    uint64_t pool_fallbacks;    /* libgit2 allocations it passed to malloc */
+    uint64_t pool_bytes;        /* Bytes of pool slabs carved */
+    cf_latency_stats object_read;   /* git_odb_read */
+    cf_latency_stats diff;          /* One line diff, including binary checks */
+    cf_latency_stats tree_diff;     /* One tree diff, including delta copy */
+} cf_stats;
+
+/* Snapshot all statistics. Thread-safe. */
+void cf_get_stats(cf_stats* out);
+
+/* Monotonic clock in nanoseconds, for cf_stats_record */
+uint64_t cf_stats_now(void);
+
+/* Add value to a counter (relaxed atomic) */
+void cf_stats_add(cf_stat stat, uint64_t value);
+
+/* Record the latency of an operation that started at start_ns */
+void cf_stats_record(cf_latency latency, uint64_t start_ns);
 
 /* ============================================================================
  * Utility Functions
@@ -227,6 +1041,29 @@ int cf_configure_memory(size_t mwindow_mapped_limit, size_t cache_max_size, int
 int cf_count_lines(const char* data, size_t size);
 int cf_is_binary(const char* data, size_t size);
 
+/*
+ * Detect binary content and count lines in a single pass.
+ * Returns 1 for binary data (*line_count set to 0), otherwise 0 with
+ * *line_count equal to cf_count_lines(data, size).
+ */
+int cf_scan_text(const char* data, size_t size, int* line_count);
+
+/* Incremental cf_scan_text over a buffer fed in chunks */
+typedef struct {
+    size_t scanned;         /* Bytes fed so far */
+    size_t newlines;        /* Newlines seen so far */
+    int is_binary;          /* NUL found within the first CF_BINARY_CHECK_LEN bytes */
+    char last;              /* Last byte fed */
+} cf_text_scanner;
+
+void cf_text_scanner_init(cf_text_scanner* scan);
+
+/* Feed the next chunk; chunks after binary content is found are ignored */
+void cf_text_scanner_update(cf_text_scanner* scan, const char* data, size_t size);
+
+/* Same result as cf_scan_text over the concatenation of all chunks */
+int cf_text_scanner_finish(const cf_text_scanner* scan, int* line_count);
+
 /* ============================================================================
  * Memory Management
  * ============================================================================ */
@@ -3,12 +3,22 @@
  *
  * Optimized for batch diff computation with:
  * 1. ODB-based blob preloading for better cache efficiency
- * 2. Sorted OID processing for pack locality
- * 3. Single ODB refresh per batch
- * 4. OpenMP parallel diff computation (pure buffer operations)
+ * 2. Blobs read in pack storage order for pack locality
+ * 3. Single ODB refresh per batch, reads through the repository's object
+ *    cache so blobs shared with earlier batches are not inflated again
+ * 4. OpenMP parallel diff computation (pure buffer operations), sized from
+ *    the process-wide thread budget (see cf_set_parallelism)
+ * 5. Optional native line diff engine emitting run-length ops directly
+ *    (see cf_set_native_line_diff); libgit2 diffs otherwise
+ * 6. Tree diff filters applied in libgit2's delta callback, so filtered
+ *    changes are never copied into the result
+ * 7. Optional native rename pairing with cached similarity signatures
+ *    (see rename_ops.c)
  */
 
 #include "codefang_git.h"
+#include <limits.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -16,23 +26,80 @@
 #include <omp.h>
 #endif
 
+/*
+ * Growable buffer for diff operations.
+ *
+ * Each thread of a batch appends the ops of every diff it computes to its own
+ * buffer, so it only grows with the real op count. The per-thread buffers are
+ * then stitched into one flat op arena for the whole batch.
+ */
+typedef struct {
+    cf_diff_op* ops;
+    cf_diff_op_pos* pos;    /* Parallel to ops, only grown when want_pos is set */
+    int count;
+    int capacity;
+    int want_pos;
+} cf_op_buffer;
+
+/* Append an operation, growing the buffer geometrically when full */
+static int op_buffer_push(cf_op_buffer* buf, int type, int count) {
+    if (buf->count == buf->capacity) {
+        int new_capacity = buf->capacity > 0 ? buf->capacity * 2 : CF_DIFF_OPS_INITIAL;
+        cf_diff_op* grown = (cf_diff_op*)realloc(buf->ops, (size_t)new_capacity * sizeof(cf_diff_op));
+        if (grown == NULL) {
+            return CF_ERR_NOMEM;
+        }
+        buf->ops = grown;
+        cf_stats_add(CF_STAT_OP_BUFFER_GROWS, 1);
+
+        if (buf->want_pos) {
+            cf_diff_op_pos* grown_pos = (cf_diff_op_pos*)realloc(buf->pos, (size_t)new_capacity * sizeof(cf_diff_op_pos));
+            if (grown_pos == NULL) {
+                return CF_ERR_NOMEM;
+            }
+            buf->pos = grown_pos;
+        }
+        buf->capacity = new_capacity;
+    }
+
+    buf->ops[buf->count].type_ = type;
+    buf->ops[buf->count].line_count = count;
+    buf->count++;
+    return CF_OK;
+}
+
+/* Copy ops into an exact-size array owned by the result */
+static int commit_ops(const cf_diff_op* ops, int count, cf_diff_result* result) {
+    if (count == 0) {
+        return CF_OK;
+    }
+
+    result->ops = (cf_diff_op*)malloc((size_t)count * sizeof(cf_diff_op));
+    if (result->ops == NULL) {
+        result->error = CF_ERR_NOMEM;
+        return CF_ERR_NOMEM;
+    }
+    memcpy(result->ops, ops, (size_t)count * sizeof(cf_diff_op));
+    result->op_count = count;
+    result->op_capacity = count;
+    return CF_OK;
+}
+
 /* Context for diff callbacks */
 typedef struct {
-    cf_diff_result* result;
+    cf_op_buffer* ops;
     int current_type;
     int current_count;
     int old_line_pos;
     int new_line_pos;
+    int error;
 } diff_ctx_t;
 
-/* Flush pending diff operation to result */
+/* Flush pending diff operation to the scratch buffer */
 static void flush_op(diff_ctx_t* ctx) {
     if (ctx->current_count > 0) {
-        cf_diff_result* res = ctx->result;
-        if (res->op_count < res->op_capacity) {
-            res->ops[res->op_count].type_ = ctx->current_type;
-            res->ops[res->op_count].line_count = ctx->current_count;
-            res->op_count++;
+        if (ctx->error == CF_OK) {
+            ctx->error = op_buffer_push(ctx->ops, ctx->current_type, ctx->current_count);
         }
         ctx->current_count = 0;
     }
@@ -77,7 +144,8 @@ static int line_callback(
         break;
     }
 
-    return 0;
+    /* Non-zero aborts the diff; only happens when the op buffer cannot grow */
+    return ctx->error != CF_OK ? -1 : 0;
 }
 
 /* Callback for each hunk in the diff */
@@ -98,219 +166,1138 @@ static int hunk_callback(
         ctx->new_line_pos += skipped;
     }
 
-    return 0;
+    return ctx->error != CF_OK ? -1 : 0;
 }
 
-/* Compute diff for a single blob pair */
-static int compute_single_diff(
-    git_repository* repo,
-    const cf_diff_request* req,
-    cf_diff_result* result
-) {
-    git_blob* old_blob = NULL;
-    git_blob* new_blob = NULL;
-    int ret = CF_OK;
+/*
+ * Finish a diff: flush the pending op and append the trailing equal block
+ * for lines after the last hunk.
+ */
+static int finish_diff(diff_ctx_t* ctx, cf_diff_result* result) {
+    flush_op(ctx);
 
-    /* Initialize result */
-    ret = cf_init_diff_result(result, CF_MAX_DIFF_OPS);
-    if (ret != CF_OK) {
-        return ret;
+    if (result->old_lines > ctx->old_line_pos) {
+        add_op(ctx, CF_DIFF_EQUAL, result->old_lines - ctx->old_line_pos);
+        flush_op(ctx);
     }
 
-    /* Load old blob if exists */
-    if (req->has_old) {
-        int err = git_blob_lookup(&old_blob, repo, &req->old_oid);
-        if (err != 0) {
-            result->error = CF_ERR_LOOKUP;
-            return CF_ERR_LOOKUP;
+    if (ctx->error != CF_OK) {
+        result->error = ctx->error;
+        return ctx->error;
+    }
+
+    return CF_OK;
+}
+
+/* Translate CF_DIFF_ALGO_* into libgit2 diff option flags */
+static void apply_diff_algorithm(git_diff_options* opts, int algorithm) {
+    switch (algorithm) {
+    case CF_DIFF_ALGO_MINIMAL:
+        opts->flags |= GIT_DIFF_MINIMAL;
+        break;
+    case CF_DIFF_ALGO_PATIENCE:
+    case CF_DIFF_ALGO_HISTOGRAM:
+        /* libgit2 has no histogram flag; patience is its nearest relative */
+        opts->flags |= GIT_DIFF_PATIENCE;
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Emit the single op of a diff that needs no line matching: both sides
+ * identical, or one side empty (added / deleted file). Line counts must
+ * already be set. Returns 1 when the diff was handled here.
+ */
+static int emit_trivial_diff(int identical, cf_op_buffer* buf, cf_diff_result* result) {
+    int type;
+    int lines;
+
+    if (identical) {
+        type = CF_DIFF_EQUAL;
+        lines = result->old_lines;
+    } else if (result->old_lines == 0) {
+        type = CF_DIFF_INSERT;
+        lines = result->new_lines;
+    } else if (result->new_lines == 0) {
+        type = CF_DIFF_DELETE;
+        lines = result->old_lines;
+    } else {
+        return 0;
+    }
+
+    if (lines > 0 && op_buffer_push(buf, type, lines) != CF_OK) {
+        result->error = CF_ERR_NOMEM;
+    }
+    return 1;
+}
+
+/* Skip count lines of data starting at the line that begins at offset */
+static size_t skip_lines(const char* data, size_t size, size_t offset, int count) {
+    while (count-- > 0 && offset < size) {
+        const char* newline = memchr(data + offset, '\n', size - offset);
+        offset = newline ? (size_t)(newline - data) + 1 : size;
+    }
+    return offset;
+}
+
+/*
+ * Record where every op from index start on begins on both sides. Ops are
+ * in diff order, so this is a running sum of their line counts; the byte
+ * offsets follow the same lines through the buffers, which are still hot
+ * from the diff. Nothing past the start of the last op is scanned.
+ */
+static void fill_op_positions(
+    cf_op_buffer* buf, int start,
+    const char* old_data, size_t old_size,
+    const char* new_data, size_t new_size
+) {
+    int old_line = 0, new_line = 0;
+    size_t old_offset = 0, new_offset = 0;
+
+    for (int i = start; i < buf->count; i++) {
+        const cf_diff_op* op = &buf->ops[i];
+
+        buf->pos[i].old_start = old_line;
+        buf->pos[i].new_start = new_line;
+        buf->pos[i].old_offset = (uint64_t)old_offset;
+        buf->pos[i].new_offset = (uint64_t)new_offset;
+
+        if (i + 1 == buf->count) {
+            break;
         }
+        if (op->type_ != CF_DIFF_INSERT) {
+            old_offset = skip_lines(old_data, old_size, old_offset, op->line_count);
+            old_line += op->line_count;
+        }
+        if (op->type_ != CF_DIFF_DELETE) {
+            new_offset = skip_lines(new_data, new_size, new_offset, op->line_count);
+            new_line += op->line_count;
+        }
+    }
+}
 
-        const char* content = (const char*)git_blob_rawcontent(old_blob);
-        size_t size = git_blob_rawsize(old_blob);
+/* Both sides of a request name the same blob (zero OIDs only carry data) */
+static int same_blob(const cf_diff_request* req) {
+    return req->has_old && req->has_new && !git_oid_iszero(&req->old_oid) &&
+           git_oid_equal(&req->old_oid, &req->new_oid);
+}
 
-        /* Check for binary */
-        if (size > 0 && cf_is_binary(content, size)) {
-            git_blob_free(old_blob);
-            result->error = CF_ERR_BINARY;
-            return CF_ERR_BINARY;
+/* ============================================================================
+ * Native Line Diff Engine
+ *
+ * Burndown only consumes EQUAL/INSERT/DELETE run-lengths, so the engine
+ * produces them directly instead of going through libgit2's patch pipeline
+ * and its per-line callbacks:
+ * 1. Lines are split once and interned into dense class IDs (hash plus
+ *    exact compare), so all later matching is integer comparison
+ * 2. Common prefix and suffix are trimmed
+ * 3. Lines that never occur on the other side are marked changed up front
+ * 4. Myers (linear-space split with xdiff's cost heuristics) or histogram
+ *    marks the remaining changed lines
+ * 5. Change groups are slid like xdiff's compaction, so ambiguous hunks
+ *    land where git puts them
+ * ============================================================================ */
+
+/* Myers cost heuristics, same values as libgit2's bundled xdiff */
+#define LD_SNAKE_CNT     20
+#define LD_HEUR_MIN_COST 256
+#define LD_MAX_COST_MIN  256
+#define LD_K_HEUR        4
+
+/* Histogram gives up and falls back to Myers above this many occurrences */
+#define LD_MAX_CHAIN_LENGTH 64
+
+#define LD_LINE_MAX LONG_MAX
+
+/* One distinct line content */
+typedef struct {
+    const char* ptr;
+    size_t len;
+    uint32_t hash;
+    int count[2];           /* Occurrences in old (0) and new (1) */
+} ld_class;
+
+/* Interning table shared by both sides of a diff */
+typedef struct {
+    ld_class* classes;
+    long class_count;
+    uint32_t* slots;        /* Open addressing, class index + 1 (0 = empty) */
+    uint32_t mask;
+} ld_classifier;
+
+/* One side of a diff */
+typedef struct {
+    uint32_t* ids;          /* Class ID of every line */
+    char* rchg;             /* 1 if the line is changed; [-1] and [n] are sentinels */
+    long n;
+} ld_side;
+
+static uint32_t ld_hash_line(const char* p, size_t len) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ (uint64_t)len;
+    uint64_t w;
+
+    while (len >= 8) {
+        memcpy(&w, p, 8);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+        p += 8;
+        len -= 8;
+    }
+    if (len > 0) {
+        w = 0;
+        memcpy(&w, p, len);
+        h = (h ^ w) * 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 29;
+    }
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+/*
+ * Split one side into lines (each keeps its '\n', so a missing final
+ * newline makes the last line differ, as in git) and intern them.
+ */
+static void ld_classify(ld_classifier* lc, const char* data, size_t size, int which, ld_side* side) {
+    const char* p = data;
+    const char* end = data + size;
+    long n = 0;
+
+    while (p < end) {
+        const char* newline = memchr(p, '\n', (size_t)(end - p));
+        const char* next = newline ? newline + 1 : end;
+        size_t len = (size_t)(next - p);
+        uint32_t hash = ld_hash_line(p, len);
+        uint32_t slot = hash & lc->mask;
+        long id;
+
+        for (;;) {
+            uint32_t entry = lc->slots[slot];
+            if (entry == 0) {
+                id = lc->class_count++;
+                lc->classes[id].ptr = p;
+                lc->classes[id].len = len;
+                lc->classes[id].hash = hash;
+                lc->classes[id].count[0] = 0;
+                lc->classes[id].count[1] = 0;
+                lc->slots[slot] = (uint32_t)id + 1;
+                break;
+            }
+            const ld_class* c = &lc->classes[entry - 1];
+            if (c->hash == hash && c->len == len && memcmp(c->ptr, p, len) == 0) {
+                id = entry - 1;
+                break;
+            }
+            slot = (slot + 1) & lc->mask;
         }
 
-        result->old_lines = cf_count_lines(content, size);
+        lc->classes[id].count[which]++;
+        side->ids[n++] = (uint32_t)id;
+        p = next;
     }
 
-    /* Load new blob if exists */
-    if (req->has_new) {
-        int err = git_blob_lookup(&new_blob, repo, &req->new_oid);
-        if (err != 0) {
-            if (old_blob) git_blob_free(old_blob);
-            result->error = CF_ERR_LOOKUP;
-            return CF_ERR_LOOKUP;
+    side->n = n;
+}
+
+/* ---- Myers ---------------------------------------------------------------- */
+
+typedef struct {
+    long i1, i2;
+    int min_lo, min_hi;
+} ld_split_t;
+
+typedef struct {
+    const uint32_t* ha1;    /* Class IDs of the lines taking part */
+    const uint32_t* ha2;
+    const long* rindex1;    /* Maps those lines back to their side index */
+    const long* rindex2;
+    char* rchg1;
+    char* rchg2;
+    long* kvdf;             /* Furthest forward / backward reaching paths */
+    long* kvdb;
+    long mxcost;
+} ld_myers_ctx;
+
+/*
+ * Find the middle snake of ha1[off1, lim1) against ha2[off2, lim2).
+ * Unless need_min is set, gives up on a minimal split once the edit cost
+ * passes the heuristic limits and picks a good-enough diagonal instead.
+ */
+static void ld_split(const ld_myers_ctx* mc, long off1, long lim1, long off2, long lim2,
+                     int need_min, ld_split_t* spl) {
+    const uint32_t* ha1 = mc->ha1;
+    const uint32_t* ha2 = mc->ha2;
+    long* kvdf = mc->kvdf;
+    long* kvdb = mc->kvdb;
+    long dmin = off1 - lim2, dmax = lim1 - off2;
+    long fmid = off1 - off2, bmid = lim1 - lim2;
+    long odd = (fmid - bmid) & 1;
+    long fmin = fmid, fmax = fmid;
+    long bmin = bmid, bmax = bmid;
+    long ec, d, i1, i2, prev1, best, dd, v, k;
+
+    kvdf[fmid] = off1;
+    kvdb[bmid] = lim1;
+
+    for (ec = 1;; ec++) {
+        int got_snake = 0;
+
+        /* Forward path */
+        if (fmin > dmin) kvdf[--fmin - 1] = -1; else ++fmin;
+        if (fmax < dmax) kvdf[++fmax + 1] = -1; else --fmax;
+
+        for (d = fmax; d >= fmin; d -= 2) {
+            i1 = kvdf[d - 1] >= kvdf[d + 1] ? kvdf[d - 1] + 1 : kvdf[d + 1];
+            prev1 = i1;
+            i2 = i1 - d;
+            for (; i1 < lim1 && i2 < lim2 && ha1[i1] == ha2[i2]; i1++, i2++);
+            if (i1 - prev1 > LD_SNAKE_CNT) got_snake = 1;
+            kvdf[d] = i1;
+            if (odd && bmin <= d && d <= bmax && kvdb[d] <= i1) {
+                spl->i1 = i1;
+                spl->i2 = i2;
+                spl->min_lo = spl->min_hi = 1;
+                return;
+            }
         }
 
-        const char* content = (const char*)git_blob_rawcontent(new_blob);
-        size_t size = git_blob_rawsize(new_blob);
+        /* Backward path */
+        if (bmin > dmin) kvdb[--bmin - 1] = LD_LINE_MAX; else ++bmin;
+        if (bmax < dmax) kvdb[++bmax + 1] = LD_LINE_MAX; else --bmax;
+
+        for (d = bmax; d >= bmin; d -= 2) {
+            i1 = kvdb[d - 1] < kvdb[d + 1] ? kvdb[d - 1] : kvdb[d + 1] - 1;
+            prev1 = i1;
+            i2 = i1 - d;
+            for (; i1 > off1 && i2 > off2 && ha1[i1 - 1] == ha2[i2 - 1]; i1--, i2--);
+            if (prev1 - i1 > LD_SNAKE_CNT) got_snake = 1;
+            kvdb[d] = i1;
+            if (!odd && fmin <= d && d <= fmax && i1 <= kvdf[d]) {
+                spl->i1 = i1;
+                spl->i2 = i2;
+                spl->min_lo = spl->min_hi = 1;
+                return;
+            }
+        }
 
-        /* Check for binary */
-        if (size > 0 && cf_is_binary(content, size)) {
-            if (old_blob) git_blob_free(old_blob);
-            git_blob_free(new_blob);
-            result->error = CF_ERR_BINARY;
-            return CF_ERR_BINARY;
+        if (need_min) {
+            continue;
+        }
+
+        /* Expensive diff: settle for a diagonal that ends in a long snake */
+        if (got_snake && ec > LD_HEUR_MIN_COST) {
+            best = 0;
+            for (d = fmax; d >= fmin; d -= 2) {
+                dd = d > fmid ? d - fmid : fmid - d;
+                i1 = kvdf[d];
+                i2 = i1 - d;
+                v = (i1 - off1) + (i2 - off2) - dd;
+
+                if (v > LD_K_HEUR * ec && v > best &&
+                    off1 + LD_SNAKE_CNT <= i1 && i1 < lim1 &&
+                    off2 + LD_SNAKE_CNT <= i2 && i2 < lim2) {
+                    for (k = 1; ha1[i1 - k] == ha2[i2 - k]; k++) {
+                        if (k == LD_SNAKE_CNT) {
+                            best = v;
+                            spl->i1 = i1;
+                            spl->i2 = i2;
+                            break;
+                        }
+                    }
+                }
+            }
+            if (best > 0) {
+                spl->min_lo = 1;
+                spl->min_hi = 0;
+                return;
+            }
+
+            best = 0;
+            for (d = bmax; d >= bmin; d -= 2) {
+                dd = d > bmid ? d - bmid : bmid - d;
+                i1 = kvdb[d];
+                i2 = i1 - d;
+                v = (lim1 - i1) + (lim2 - i2) - dd;
+
+                if (v > LD_K_HEUR * ec && v > best &&
+                    off1 < i1 && i1 <= lim1 - LD_SNAKE_CNT &&
+                    off2 < i2 && i2 <= lim2 - LD_SNAKE_CNT) {
+                    for (k = 0; ha1[i1 + k] == ha2[i2 + k]; k++) {
+                        if (k == LD_SNAKE_CNT - 1) {
+                            best = v;
+                            spl->i1 = i1;
+                            spl->i2 = i2;
+                            break;
+                        }
+                    }
+                }
+            }
+            if (best > 0) {
+                spl->min_lo = 0;
+                spl->min_hi = 1;
+                return;
+            }
         }
 
-        result->new_lines = cf_count_lines(content, size);
+        /* Cost limit reached: split at the furthest reaching path */
+        if (ec >= mc->mxcost) {
+            long fbest = -1, fbest1 = -1;
+            long bbest = LD_LINE_MAX, bbest1 = LD_LINE_MAX;
+
+            for (d = fmax; d >= fmin; d -= 2) {
+                i1 = kvdf[d] < lim1 ? kvdf[d] : lim1;
+                i2 = i1 - d;
+                if (lim2 < i2) {
+                    i1 = lim2 + d;
+                    i2 = lim2;
+                }
+                if (fbest < i1 + i2) {
+                    fbest = i1 + i2;
+                    fbest1 = i1;
+                }
+            }
+
+            for (d = bmax; d >= bmin; d -= 2) {
+                i1 = kvdb[d] > off1 ? kvdb[d] : off1;
+                i2 = i1 - d;
+                if (i2 < off2) {
+                    i1 = off2 + d;
+                    i2 = off2;
+                }
+                if (i1 + i2 < bbest) {
+                    bbest = i1 + i2;
+                    bbest1 = i1;
+                }
+            }
+
+            if ((lim1 + lim2) - bbest < fbest - (off1 + off2)) {
+                spl->i1 = fbest1;
+                spl->i2 = fbest - fbest1;
+                spl->min_lo = 1;
+                spl->min_hi = 0;
+            } else {
+                spl->i1 = bbest1;
+                spl->i2 = bbest - bbest1;
+                spl->min_lo = 0;
+                spl->min_hi = 1;
+            }
+            return;
+        }
     }
+}
 
-    /* Setup diff context */
-    diff_ctx_t ctx = {
-        .result = result,
-        .current_type = -1,
-        .current_count = 0,
-        .old_line_pos = 0,
-        .new_line_pos = 0
-    };
+/* Divide and conquer over ha1[off1, lim1) and ha2[off2, lim2) */
+static void ld_recs_cmp(const ld_myers_ctx* mc, long off1, long lim1, long off2, long lim2, int need_min) {
+    const uint32_t* ha1 = mc->ha1;
+    const uint32_t* ha2 = mc->ha2;
 
-    /* Compute diff using libgit2 */
-    git_diff_options opts = GIT_DIFF_OPTIONS_INIT;
-    int err = git_diff_blobs(
-        old_blob, NULL,
-        new_blob, NULL,
-        &opts,
-        NULL,           /* file_cb */
-        NULL,           /* binary_cb */
-        hunk_callback,
-        line_callback,
-        &ctx
-    );
+    for (; off1 < lim1 && off2 < lim2 && ha1[off1] == ha2[off2]; off1++, off2++);
+    for (; off1 < lim1 && off2 < lim2 && ha1[lim1 - 1] == ha2[lim2 - 1]; lim1--, lim2--);
 
-    if (err != 0) {
-        if (old_blob) git_blob_free(old_blob);
-        if (new_blob) git_blob_free(new_blob);
-        result->error = CF_ERR_DIFF;
-        return CF_ERR_DIFF;
+    if (off1 == lim1) {
+        for (; off2 < lim2; off2++) mc->rchg2[mc->rindex2[off2]] = 1;
+    } else if (off2 == lim2) {
+        for (; off1 < lim1; off1++) mc->rchg1[mc->rindex1[off1]] = 1;
+    } else {
+        ld_split_t spl = {0, 0, 0, 0};
+        ld_split(mc, off1, lim1, off2, lim2, need_min, &spl);
+        ld_recs_cmp(mc, off1, spl.i1, off2, spl.i2, spl.min_lo);
+        ld_recs_cmp(mc, spl.i1, lim1, spl.i2, lim2, spl.min_hi);
     }
+}
+
+/* Approximate square root, as xdiff sizes its cost limit */
+static long ld_bogosqrt(long n) {
+    long i;
+    for (i = 1; n > 0; n >>= 2) i <<= 1;
+    return i;
+}
+
+/* xdiff's limits for discarding lines with many matches */
+#define LD_MAX_EQLIMIT     1024
+#define LD_SIMSCAN_WINDOW  100
+#define LD_KPDIS_RUN       4
 
-    /* Flush any pending operation */
-    flush_op(&ctx);
+/*
+ * Decide whether a line with many matches at dis[i] is discarded: only when
+ * it sits in a run of mostly unmatched lines within [s, e] (xdiff's
+ * xdl_clean_mmatch).
+ */
+static int ld_clean_mmatch(const char* dis, long i, long s, long e) {
+    long r, rdis0, rpdis0, rdis1, rpdis1;
 
-    /* Add trailing equal block for remaining unchanged lines */
-    if (result->old_lines > ctx.old_line_pos) {
-        int remaining = result->old_lines - ctx.old_line_pos;
-        add_op(&ctx, CF_DIFF_EQUAL, remaining);
-        flush_op(&ctx);
+    if (i - s > LD_SIMSCAN_WINDOW) s = i - LD_SIMSCAN_WINDOW;
+    if (e - i > LD_SIMSCAN_WINDOW) e = i + LD_SIMSCAN_WINDOW;
+
+    for (r = 1, rdis0 = 0, rpdis0 = 1; i - r >= s; r++) {
+        if (!dis[i - r]) rdis0++;
+        else if (dis[i - r] == 2) rpdis0++;
+        else break;
     }
+    if (rdis0 == 0) return 0;
 
-    if (old_blob) git_blob_free(old_blob);
-    if (new_blob) git_blob_free(new_blob);
+    for (r = 1, rdis1 = 0, rpdis1 = 1; i + r <= e; r++) {
+        if (!dis[i + r]) rdis1++;
+        else if (dis[i + r] == 2) rpdis1++;
+        else break;
+    }
+    if (rdis1 == 0) return 0;
 
-    return CF_OK;
+    rdis1 += rdis0;
+    rpdis1 += rpdis0;
+    return rpdis1 * LD_KPDIS_RUN < rpdis1 + rdis1;
 }
 
-/* Structure for preloaded blob data */
-typedef struct {
-    git_oid oid;
-    const char* data;
-    size_t size;
-    git_odb_object* obj;  /* Keep reference for cleanup */
-    int is_binary;
-    int line_count;
-    int valid;
-} cf_preloaded_blob;
-
-/* OID comparison for sorting */
-static int compare_oids_diff(const void* a, const void* b) {
-    return memcmp(a, b, GIT_OID_RAWSZ);
+/*
+ * Classify side lines [s, e) for discarding: 0 = no match on the other side,
+ * 1 = matched, 2 = matched so often it may be discarded. other counts the
+ * occurrences of each class on the other side; nrec is the size of the side
+ * before trimming. A minimal diff discards nothing that has a match, as in
+ * xdl_cleanup_records.
+ */
+static void ld_discard_classes(const ld_side* side, long s, long e, const int* other, long nrec, int need_min,
+                               char* dis) {
+    long mlim = ld_bogosqrt(nrec);
+    if (mlim > LD_MAX_EQLIMIT) mlim = LD_MAX_EQLIMIT;
+
+    for (long i = s; i < e; i++) {
+        int nm = other[side->ids[i]];
+        dis[i - s] = nm == 0 ? 0 : nm >= mlim && !need_min ? 2 : 1;
+    }
 }
 
 /*
- * Preload unique blobs from a batch of diff requests.
- * Returns a map of OID -> preloaded blob data.
+ * Run Myers over a[s1, e1) against b[s2, e2) the way xdiff prepares a diff
+ * of those ranges: the common ends are trimmed, then lines without a match
+ * on the other side, and lines with many matches amid unmatched ones, are
+ * marked changed without taking part in the search. cnt_a and cnt_b count
+ * the occurrences of each class within the ranges.
  */
-static int preload_blobs_for_diff(
-    git_odb* odb,
-    const cf_diff_request* requests,
-    int count,
-    cf_preloaded_blob** out_blobs,
-    int* out_blob_count
-) {
-    /* Collect all unique OIDs */
-    git_oid* all_oids = (git_oid*)malloc(count * 2 * sizeof(git_oid));
-    if (all_oids == NULL) {
+static int ld_myers(ld_side* a, long s1, long e1, ld_side* b, long s2, long e2,
+                    const int* cnt_a, const int* cnt_b, int need_min) {
+    long nrec1 = e1 - s1, nrec2 = e2 - s2;
+
+    while (s1 < e1 && s2 < e2 && a->ids[s1] == b->ids[s2]) {
+        s1++;
+        s2++;
+    }
+    while (e1 > s1 && e2 > s2 && a->ids[e1 - 1] == b->ids[e2 - 1]) {
+        e1--;
+        e2--;
+    }
+
+    long n1 = e1 - s1, n2 = e2 - s2;
+    uint32_t* ha = (uint32_t*)malloc((size_t)(n1 + n2 + 1) * sizeof(uint32_t));
+    long* rindex = (long*)malloc((size_t)(n1 + n2 + 1) * sizeof(long));
+    char* dis = (char*)malloc((size_t)(n1 + n2 + 2));
+    long* kvd = NULL;
+    long r1 = 0, r2 = 0;
+
+    if (ha == NULL || rindex == NULL || dis == NULL) {
+        free(ha);
+        free(rindex);
+        free(dis);
         return CF_ERR_NOMEM;
     }
 
-    int oid_count = 0;
-    for (int i = 0; i < count; i++) {
-        if (requests[i].has_old && requests[i].old_data == NULL) {
-            memcpy(&all_oids[oid_count++], &requests[i].old_oid, sizeof(git_oid));
+    char* dis1 = dis;
+    char* dis2 = dis + n1 + 1;
+    ld_discard_classes(a, s1, e1, cnt_b, nrec1, need_min, dis1);
+    ld_discard_classes(b, s2, e2, cnt_a, nrec2, need_min, dis2);
+
+    for (long i = 0; i < n1; i++) {
+        if (dis1[i] == 1 || (dis1[i] == 2 && !ld_clean_mmatch(dis1, i, 0, n1 - 1))) {
+            ha[r1] = a->ids[s1 + i];
+            rindex[r1++] = s1 + i;
+        } else {
+            a->rchg[s1 + i] = 1;
         }
-        if (requests[i].has_new && requests[i].new_data == NULL) {
-            memcpy(&all_oids[oid_count++], &requests[i].new_oid, sizeof(git_oid));
+    }
+    for (long i = 0; i < n2; i++) {
+        if (dis2[i] == 1 || (dis2[i] == 2 && !ld_clean_mmatch(dis2, i, 0, n2 - 1))) {
+            ha[r1 + r2] = b->ids[s2 + i];
+            rindex[r1 + r2++] = s2 + i;
+        } else {
+            b->rchg[s2 + i] = 1;
         }
     }
+    free(dis);
+
+    if (r1 > 0 || r2 > 0) {
+        long ndiags = r1 + r2 + 3;
+        kvd = (long*)malloc((size_t)(2 * ndiags + 2) * sizeof(long));
+        if (kvd == NULL) {
+            free(ha);
+            free(rindex);
+            return CF_ERR_NOMEM;
+        }
 
-    if (oid_count == 0) {
-        free(all_oids);
-        *out_blobs = NULL;
-        *out_blob_count = 0;
-        return CF_OK;
+        ld_myers_ctx mc = {
+            .ha1 = ha,
+            .ha2 = ha + r1,
+            .rindex1 = rindex,
+            .rindex2 = rindex + r1,
+            .rchg1 = a->rchg,
+            .rchg2 = b->rchg,
+            .kvdf = kvd + r2 + 1,
+            .kvdb = kvd + ndiags + r2 + 1,
+            .mxcost = need_min ? LD_LINE_MAX : ld_bogosqrt(ndiags),
+        };
+        if (mc.mxcost < LD_MAX_COST_MIN) {
+            mc.mxcost = LD_MAX_COST_MIN;
+        }
+
+        ld_recs_cmp(&mc, 0, r1, 0, r2, need_min);
     }
 
-    /* Sort OIDs for pack locality and deduplication */
-    qsort(all_oids, oid_count, sizeof(git_oid), compare_oids_diff);
+    free(kvd);
+    free(ha);
+    free(rindex);
+    return CF_OK;
+}
 
-    /* Count unique OIDs */
-    int unique_count = 1;
-    for (int i = 1; i < oid_count; i++) {
-        if (memcmp(&all_oids[i], &all_oids[i-1], sizeof(git_oid)) != 0) {
-            unique_count++;
-        }
-    }
+/* ---- Histogram ------------------------------------------------------------ */
 
-    /* Allocate preloaded blob array */
-    cf_preloaded_blob* blobs = (cf_preloaded_blob*)calloc(unique_count, sizeof(cf_preloaded_blob));
-    if (blobs == NULL) {
-        free(all_oids);
-        return CF_ERR_NOMEM;
-    }
+typedef struct {
+    ld_side* a;
+    ld_side* b;
+    int* cnt;               /* Per class: occurrences in the current old region */
+    int* fallback_cnt;      /* Per side and class: occurrences in a Myers fallback region, else 0 */
+    long class_count;
+    long* first;            /* Per class: first occurrence in the current old region */
+    long* next;             /* Per old line: next occurrence of the same class, -1 at the end */
+} ld_histogram;
+
+/* Pending region of the histogram recursion */
+typedef struct {
+    long s1, e1, s2, e2;
+} ld_region;
 
-    /* Load unique blobs in sorted order (maximizes pack cache hits) */
-    int blob_idx = 0;
-    git_oid prev_oid;
-    memset(&prev_oid, 0, sizeof(git_oid));
+/* Longest common run anchored on the rarest lines (inclusive ends, -1 if none) */
+typedef struct {
+    long b1, e1, b2, e2;
+    int has_common;
+    int min_cnt;
+} ld_lcs;
+
+/* Extend every occurrence of b[bp] in the old region into a common run */
+static long ld_try_lcs(ld_histogram* h, ld_lcs* lcs, long bp, long s1, long e1, long s2, long e2) {
+    const uint32_t* ida = h->a->ids;
+    const uint32_t* idb = h->b->ids;
+    long b_next = bp + 1;
+    uint32_t id = idb[bp];
+    long as, ae, bs, be, np;
+    int rc;
+
+    if (h->cnt[id] == 0) {
+        return b_next;
+    }
+    lcs->has_common = 1;
+    if (h->cnt[id] > lcs->min_cnt) {
+        return b_next;
+    }
 
-    for (int i = 0; i < oid_count; i++) {
-        /* Skip duplicates */
-        if (i > 0 && memcmp(&all_oids[i], &prev_oid, sizeof(git_oid)) == 0) {
-            continue;
+    as = h->first[id];
+    for (;;) {
+        np = h->next[as];
+        bs = bp;
+        ae = as;
+        be = bs;
+        rc = h->cnt[id];
+
+        while (s1 < as && s2 < bs && ida[as - 1] == idb[bs - 1]) {
+            as--;
+            bs--;
+            if (rc > 1 && h->cnt[ida[as]] < rc) rc = h->cnt[ida[as]];
+        }
+        while (ae < e1 - 1 && be < e2 - 1 && ida[ae + 1] == idb[be + 1]) {
+            ae++;
+            be++;
+            if (rc > 1 && h->cnt[ida[ae]] < rc) rc = h->cnt[ida[ae]];
         }
-        memcpy(&prev_oid, &all_oids[i], sizeof(git_oid));
-
-        cf_preloaded_blob* blob = &blobs[blob_idx];
-        memcpy(&blob->oid, &all_oids[i], sizeof(git_oid));
 
-        git_odb_object* obj = NULL;
-        int err = git_odb_read(&obj, odb, &all_oids[i]);
-        if (err != 0 || git_odb_object_type(obj) != GIT_OBJECT_BLOB) {
-            if (obj) git_odb_object_free(obj);
-            blob->valid = 0;
-            blob_idx++;
-            continue;
+        if (b_next <= be) {
+            b_next = be + 1;
+        }
+        if (lcs->e1 - lcs->b1 < ae - as || rc < lcs->min_cnt) {
+            lcs->b1 = as;
+            lcs->b2 = bs;
+            lcs->e1 = ae;
+            lcs->e2 = be;
+            lcs->min_cnt = rc;
         }
 
-        blob->obj = obj;
-        blob->data = (const char*)git_odb_object_data(obj);
-        blob->size = git_odb_object_size(obj);
-        blob->is_binary = (blob->size > 0) ? cf_is_binary(blob->data, blob->size) : 0;
-        blob->line_count = (!blob->is_binary && blob->size > 0) ? cf_count_lines(blob->data, blob->size) : 0;
-        blob->valid = 1;
-        blob_idx++;
+        /* Skip occurrences already covered by this run */
+        while (np >= 0 && np <= ae) {
+            np = h->next[np];
+        }
+        if (np < 0) {
+            break;
+        }
+        as = np;
     }
 
-    free(all_oids);
-    *out_blobs = blobs;
-    *out_blob_count = unique_count;
-    return CF_OK;
+    return b_next;
+}
+
+static void ld_mark_changed(ld_side* side, long s, long e) {
+    for (long i = s; i < e; i++) side->rchg[i] = 1;
+}
+
+/*
+ * Diff a region whose lines are all too common to anchor on with Myers, as
+ * a separate diff of just those lines (xdiff's xdl_fall_back_diff).
+ */
+static int ld_histogram_fallback(ld_histogram* h, const ld_region* r) {
+    int* cnt_a = h->fallback_cnt;
+    int* cnt_b = h->fallback_cnt + h->class_count;
+
+    for (long i = r->s1; i < r->e1; i++) cnt_a[h->a->ids[i]]++;
+    for (long i = r->s2; i < r->e2; i++) cnt_b[h->b->ids[i]]++;
+
+    int ret = ld_myers(h->a, r->s1, r->e1, h->b, r->s2, r->e2, cnt_a, cnt_b, 0);
+
+    for (long i = r->s1; i < r->e1; i++) cnt_a[h->a->ids[i]] = 0;
+    for (long i = r->s2; i < r->e2; i++) cnt_b[h->b->ids[i]] = 0;
+    return ret;
+}
+
+/*
+ * Histogram diff: split each region around the longest common run of its
+ * least frequent lines, falling back to Myers where every candidate is too
+ * common to be a meaningful anchor.
+ */
+static int ld_histogram_diff(ld_histogram* h, long s1, long e1, long s2, long e2) {
+    long stack_cap = 64, stack_len = 0;
+    ld_region* stack = (ld_region*)malloc((size_t)stack_cap * sizeof(ld_region));
+    int ret = CF_OK;
+
+    if (stack == NULL) {
+        return CF_ERR_NOMEM;
+    }
+    stack[stack_len++] = (ld_region){s1, e1, s2, e2};
+
+    while (stack_len > 0 && ret == CF_OK) {
+        ld_region r = stack[--stack_len];
+
+        if (r.s1 == r.e1 || r.s2 == r.e2) {
+            ld_mark_changed(h->a, r.s1, r.e1);
+            ld_mark_changed(h->b, r.s2, r.e2);
+            continue;
+        }
+
+        /* Index the old region, chaining occurrences front to back */
+        for (long i = r.e1 - 1; i >= r.s1; i--) {
+            uint32_t id = h->a->ids[i];
+            h->next[i] = h->cnt[id] > 0 ? h->first[id] : -1;
+            h->first[id] = i;
+            h->cnt[id]++;
+        }
+
+        ld_lcs lcs = {-1, -1, -1, -1, 0, LD_MAX_CHAIN_LENGTH + 1};
+        for (long bp = r.s2; bp < r.e2;) {
+            bp = ld_try_lcs(h, &lcs, bp, r.s1, r.e1, r.s2, r.e2);
+        }
+
+        for (long i = r.s1; i < r.e1; i++) {
+            h->cnt[h->a->ids[i]] = 0;
+        }
+
+        if (lcs.has_common && lcs.min_cnt > LD_MAX_CHAIN_LENGTH) {
+            ret = ld_histogram_fallback(h, &r);
+            continue;
+        }
+        if (lcs.b1 < 0 && lcs.b2 < 0) {
+            ld_mark_changed(h->a, r.s1, r.e1);
+            ld_mark_changed(h->b, r.s2, r.e2);
+            continue;
+        }
+
+        if (stack_len + 2 > stack_cap) {
+            ld_region* grown = (ld_region*)realloc(stack, (size_t)stack_cap * 2 * sizeof(ld_region));
+            if (grown == NULL) {
+                ret = CF_ERR_NOMEM;
+                break;
+            }
+            stack = grown;
+            stack_cap *= 2;
+        }
+        stack[stack_len++] = (ld_region){lcs.e1 + 1, r.e1, lcs.e2 + 1, r.e2};
+        stack[stack_len++] = (ld_region){r.s1, lcs.b1, r.s2, lcs.b2};
+    }
+
+    free(stack);
+    return ret;
+}
+
+/* ---- Compaction ----------------------------------------------------------- */
+
+/* A run of changed lines [start, end) */
+typedef struct {
+    long start, end;
+} ld_group;
+
+static void ld_group_init(const ld_side* s, ld_group* g) {
+    g->start = g->end = 0;
+    while (s->rchg[g->end]) g->end++;
+}
+
+static int ld_group_next(const ld_side* s, ld_group* g) {
+    if (g->end == s->n) return -1;
+    g->start = g->end + 1;
+    for (g->end = g->start; s->rchg[g->end]; g->end++);
+    return 0;
+}
+
+static int ld_group_previous(const ld_side* s, ld_group* g) {
+    if (g->start == 0) return -1;
+    g->end = g->start - 1;
+    for (g->start = g->end; s->rchg[g->start - 1]; g->start--);
+    return 0;
+}
+
+static int ld_group_slide_down(ld_side* s, ld_group* g) {
+    if (g->end < s->n && s->ids[g->start] == s->ids[g->end]) {
+        s->rchg[g->start++] = 0;
+        s->rchg[g->end++] = 1;
+        while (s->rchg[g->end]) g->end++;
+        return 0;
+    }
+    return -1;
+}
+
+static int ld_group_slide_up(ld_side* s, ld_group* g) {
+    if (g->start > 0 && s->ids[g->start - 1] == s->ids[g->end - 1]) {
+        s->rchg[--g->start] = 1;
+        s->rchg[--g->end] = 0;
+        while (s->rchg[g->start - 1]) g->start--;
+        return 0;
+    }
+    return -1;
+}
+
+/*
+ * Slide every change group in s as far down as it goes, merging groups it
+ * bumps into, then back up to line up with a change on the other side when
+ * there is one (xdiff's xdl_change_compact without the indent heuristic).
+ */
+static void ld_change_compact(ld_side* s, const ld_side* other) {
+    ld_group g, go;
+
+    ld_group_init(s, &g);
+    ld_group_init(other, &go);
+
+    for (;;) {
+        if (g.end != g.start) {
+            long groupsize, earliest_end, end_matching_other;
+
+            do {
+                groupsize = g.end - g.start;
+                end_matching_other = -1;
+
+                while (ld_group_slide_up(s, &g) == 0) {
+                    ld_group_previous(other, &go);
+                }
+                earliest_end = g.end;
+                if (go.end > go.start) {
+                    end_matching_other = g.end;
+                }
+
+                while (ld_group_slide_down(s, &g) == 0) {
+                    ld_group_next(other, &go);
+                    if (go.end > go.start) {
+                        end_matching_other = g.end;
+                    }
+                }
+            } while (groupsize != g.end - g.start);
+
+            if (g.end != earliest_end && end_matching_other != -1) {
+                while (go.end == go.start) {
+                    ld_group_slide_up(s, &g);
+                    ld_group_previous(other, &go);
+                }
+            }
+        }
+
+        if (ld_group_next(s, &g) != 0) {
+            break;
+        }
+        ld_group_next(other, &go);
+    }
+}
+
+/* ---- Driver --------------------------------------------------------------- */
+
+/* Walk both change maps and append the run-length ops */
+static int ld_emit_ops(const ld_side* a, const ld_side* b, cf_op_buffer* buf) {
+    long i1 = 0, i2 = 0;
+
+    while (i1 < a->n || i2 < b->n) {
+        long start1 = i1, start2 = i2;
+
+        while (i1 < a->n && a->rchg[i1]) i1++;
+        if (i1 > start1 && op_buffer_push(buf, CF_DIFF_DELETE, (int)(i1 - start1)) != CF_OK) {
+            return CF_ERR_NOMEM;
+        }
+
+        while (i2 < b->n && b->rchg[i2]) i2++;
+        if (i2 > start2 && op_buffer_push(buf, CF_DIFF_INSERT, (int)(i2 - start2)) != CF_OK) {
+            return CF_ERR_NOMEM;
+        }
+
+        long equal_start = i1;
+        while (i1 < a->n && i2 < b->n && !a->rchg[i1] && !b->rchg[i2]) {
+            i1++;
+            i2++;
+        }
+        if (i1 > equal_start && op_buffer_push(buf, CF_DIFF_EQUAL, (int)(i1 - equal_start)) != CF_OK) {
+            return CF_ERR_NOMEM;
+        }
+
+        /* Unchanged lines must pair up; anything else is an engine bug */
+        if (i1 == start1 && i2 == start2) {
+            return CF_ERR_DIFF;
+        }
+    }
+
+    return CF_OK;
+}
+
+/*
+ * Diff two non-empty text buffers with the native engine, appending the
+ * ops to buf. The line counts must be those of cf_scan_text.
+ */
+static int native_line_diff(
+    const char* old_data, size_t old_size, int old_lines,
+    const char* new_data, size_t new_size, int new_lines,
+    int algorithm,
+    cf_op_buffer* buf
+) {
+    long total = (long)old_lines + (long)new_lines;
+    uint32_t capacity = 16;
+    int ret = CF_OK;
+
+    while ((long)capacity < total * 2) capacity <<= 1;
+
+    ld_classifier lc = {
+        .classes = (ld_class*)malloc((size_t)total * sizeof(ld_class)),
+        .class_count = 0,
+        .slots = (uint32_t*)calloc(capacity, sizeof(uint32_t)),
+        .mask = capacity - 1,
+    };
+    uint32_t* ids = (uint32_t*)malloc((size_t)total * sizeof(uint32_t));
+    char* rchg = (char*)calloc((size_t)total + 4, 1);
+    int* counts = NULL;
+    ld_histogram h = {0};
+
+    if (lc.classes == NULL || lc.slots == NULL || ids == NULL || rchg == NULL) {
+        ret = CF_ERR_NOMEM;
+        goto cleanup;
+    }
+
+    ld_side a = {.ids = ids, .rchg = rchg + 1, .n = 0};
+    ld_side b = {.ids = ids + old_lines, .rchg = rchg + old_lines + 3, .n = 0};
+
+    ld_classify(&lc, old_data, old_size, 0, &a);
+    ld_classify(&lc, new_data, new_size, 1, &b);
+    if (a.n != old_lines || b.n != new_lines) {
+        ret = CF_ERR_DIFF;
+        goto cleanup;
+    }
+
+    /* Per side and class occurrence counts for Myers' discarding */
+    counts = (int*)calloc((size_t)lc.class_count * 2, sizeof(int));
+    if (counts == NULL) {
+        ret = CF_ERR_NOMEM;
+        goto cleanup;
+    }
+
+    /* Histogram, like xdiff's, runs over the whole files without trimming */
+    if (algorithm == CF_DIFF_ALGO_HISTOGRAM) {
+        h.a = &a;
+        h.b = &b;
+        h.fallback_cnt = counts;
+        h.class_count = lc.class_count;
+        h.cnt = (int*)calloc((size_t)lc.class_count, sizeof(int));
+        h.first = (long*)malloc((size_t)lc.class_count * sizeof(long));
+        h.next = (long*)malloc((size_t)a.n * sizeof(long));
+        if (h.cnt == NULL || h.first == NULL || h.next == NULL) {
+            ret = CF_ERR_NOMEM;
+            goto cleanup;
+        }
+        ret = ld_histogram_diff(&h, 0, a.n, 0, b.n);
+    } else {
+        for (long i = 0; i < lc.class_count; i++) {
+            counts[i] = lc.classes[i].count[0];
+            counts[lc.class_count + i] = lc.classes[i].count[1];
+        }
+        ret = ld_myers(&a, 0, a.n, &b, 0, b.n, counts, counts + lc.class_count,
+                       algorithm == CF_DIFF_ALGO_MINIMAL);
+    }
+    if (ret != CF_OK) {
+        goto cleanup;
+    }
+
+    ld_change_compact(&a, &b);
+    ld_change_compact(&b, &a);
+
+    ret = ld_emit_ops(&a, &b, buf);
+
+cleanup:
+    free(counts);
+    free(h.cnt);
+    free(h.first);
+    free(h.next);
+    free(lc.classes);
+    free(lc.slots);
+    free(ids);
+    free(rchg);
+    return ret;
+}
+
+/* Process-wide native line diff switch, see cf_set_native_line_diff */
+static atomic_int cf_native_line_diff_on = 0;
+
+void cf_set_native_line_diff(int enabled) {
+    atomic_store_explicit(&cf_native_line_diff_on, enabled != 0, memory_order_relaxed);
+}
+
+/* Structure for preloaded blob data */
+typedef struct {
+    git_oid oid;
+    const char* data;
+    size_t size;
+    git_odb_object* obj;  /* Keep reference for cleanup */
+    int is_binary;
+    int line_count;
+    int valid;
+    int too_large;        /* Above the large blob threshold, not loaded */
+} cf_preloaded_blob;
+
+/* OID comparison for sorting */
+static int compare_oids_diff(const void* a, const void* b) {
+    return memcmp(a, b, GIT_OID_RAWSZ);
+}
+
+/* Load order entry: a preloaded blob slot and where its object is stored */
+typedef struct {
+    cf_pack_pos pos;
+    int blob_index;
+} cf_preload_order;
+
+static int compare_preload_order(const void* a, const void* b) {
+    const cf_preload_order* pa = (const cf_preload_order*)a;
+    const cf_preload_order* pb = (const cf_preload_order*)b;
+    int cmp = cf_pack_pos_compare(&pa->pos, &pb->pos);
+    return cmp != 0 ? cmp : pa->blob_index - pb->blob_index;
+}
+
+/*
+ * Preload unique blobs from a batch of diff requests.
+ * Returns a map of OID -> preloaded blob data, sorted by OID for lookup
+ * but read from the ODB in pack storage order.
+ */
+static int preload_blobs_for_diff(
+    git_repository* repo,
+    git_odb* odb,
+    cf_odb_cache* cache,
+    const cf_diff_request* requests,
+    int count,
+    cf_preloaded_blob** out_blobs,
+    int* out_blob_count
+) {
+    /* Collect all unique OIDs */
+    git_oid* all_oids = (git_oid*)malloc(count * 2 * sizeof(git_oid));
+    if (all_oids == NULL) {
+        return CF_ERR_NOMEM;
+    }
+
+    int oid_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (requests[i].has_old && requests[i].old_data == NULL) {
+            memcpy(&all_oids[oid_count++], &requests[i].old_oid, sizeof(git_oid));
+        }
+        if (requests[i].has_new && requests[i].new_data == NULL) {
+            memcpy(&all_oids[oid_count++], &requests[i].new_oid, sizeof(git_oid));
+        }
+    }
+
+    if (oid_count == 0) {
+        free(all_oids);
+        *out_blobs = NULL;
+        *out_blob_count = 0;
+        return CF_OK;
+    }
+
+    /* Sort OIDs for deduplication and lookup */
+    qsort(all_oids, oid_count, sizeof(git_oid), compare_oids_diff);
+
+    /* Count unique OIDs */
+    int unique_count = 1;
+    for (int i = 1; i < oid_count; i++) {
+        if (memcmp(&all_oids[i], &all_oids[i-1], sizeof(git_oid)) != 0) {
+            unique_count++;
+        }
+    }
+    cf_stats_add(CF_STAT_PRELOAD_DEDUPS, (uint64_t)(oid_count - unique_count));
+
+    /* Allocate preloaded blob array */
+    cf_preloaded_blob* blobs = (cf_preloaded_blob*)calloc(unique_count, sizeof(cf_preloaded_blob));
+    cf_preload_order* order = (cf_preload_order*)malloc(unique_count * sizeof(cf_preload_order));
+    if (blobs == NULL || order == NULL) {
+        free(blobs);
+        free(order);
+        free(all_oids);
+        return CF_ERR_NOMEM;
+    }
+
+    int blob_idx = 0;
+    for (int i = 0; i < oid_count; i++) {
+        /* Skip duplicates */
+        if (i > 0 && memcmp(&all_oids[i], &all_oids[i-1], sizeof(git_oid)) == 0) {
+            continue;
+        }
+        memcpy(&blobs[blob_idx].oid, &all_oids[i], sizeof(git_oid));
+        blob_idx++;
+    }
+    free(all_oids);
+
+    /* Order the reads by pack position (maximizes pack cache hits) */
+    cf_pack_locator* loc = cf_pack_locator_acquire(repo);
+    for (int i = 0; i < unique_count; i++) {
+        order[i].blob_index = i;
+        cf_pack_locator_find(loc, &blobs[i].oid, &order[i].pos);
+    }
+    cf_pack_locator_free(loc);
+    qsort(order, unique_count, sizeof(cf_preload_order), compare_preload_order);
+
+    for (int i = 0; i < unique_count; i++) {
+        cf_preloaded_blob* blob = &blobs[order[i].blob_index];
+
+        git_odb_object* obj = NULL;
+        if (cf_blob_too_large(odb, &blob->oid, &blob->size)) {
+            blob->too_large = 1;
+            continue;
+        }
+
+        int err = cf_odb_cache_read(&obj, cache, odb, &blob->oid);
+        if (err != 0 || git_odb_object_type(obj) != GIT_OBJECT_BLOB) {
+            if (obj) git_odb_object_free(obj);
+            blob->valid = 0;
+            continue;
+        }
+
+        blob->obj = obj;
+        blob->data = (const char*)git_odb_object_data(obj);
+        blob->size = git_odb_object_size(obj);
+        blob->is_binary = cf_scan_text(blob->data, blob->size, &blob->line_count);
+        blob->valid = 1;
+    }
+
+    free(order);
+    *out_blobs = blobs;
+    *out_blob_count = unique_count;
+    return CF_OK;
 }
 
 /* Find a preloaded blob by OID using binary search */
@@ -345,47 +1332,68 @@ static void free_preloaded_blobs(cf_preloaded_blob* blobs, int count) {
     free(blobs);
 }
 
-/* Compute diff using buffers */
-static int compute_diff_generic(
+/*
+ * Compute diff using buffers, appending its ops to buf.
+ * The result must already be initialized. identical is set when both
+ * sides are known to be the same blob.
+ */
+static int compute_diff_ops(
     const char* old_data, size_t old_size,
     const char* new_data, size_t new_size,
+    int algorithm,
+    int identical,
+    cf_op_buffer* buf,
     cf_diff_result* result
 ) {
-    /* Initialize result */
-    int ret = cf_init_diff_result(result, CF_MAX_DIFF_OPS);
-    if (ret != CF_OK) {
-        return ret;
-    }
-
     /* Check old blob */
     if (old_data != NULL || old_size > 0) {
-        if (old_size > 0 && cf_is_binary(old_data, old_size)) {
+        if (cf_scan_text(old_data, old_size, &result->old_lines)) {
             result->error = CF_ERR_BINARY;
             return CF_ERR_BINARY;
         }
-        result->old_lines = cf_count_lines(old_data, old_size);
     }
 
     /* Check new blob */
     if (new_data != NULL || new_size > 0) {
-        if (new_size > 0 && cf_is_binary(new_data, new_size)) {
+        if (cf_scan_text(new_data, new_size, &result->new_lines)) {
             result->error = CF_ERR_BINARY;
             return CF_ERR_BINARY;
         }
-        result->new_lines = cf_count_lines(new_data, new_size);
+    }
+
+    /* Same bytes on both sides: nothing to match */
+    if (!identical && old_size == new_size && old_size > 0) {
+        identical = old_data == new_data || memcmp(old_data, new_data, old_size) == 0;
+    }
+
+    if (emit_trivial_diff(identical, buf, result)) {
+        return result->error;
+    }
+
+    if (algorithm != CF_DIFF_ALGO_PATIENCE &&
+        atomic_load_explicit(&cf_native_line_diff_on, memory_order_relaxed)) {
+        int err = native_line_diff(old_data, old_size, result->old_lines,
+                                   new_data, new_size, result->new_lines,
+                                   algorithm, buf);
+        if (err != CF_OK) {
+            result->error = err;
+        }
+        return err;
     }
 
     /* Setup diff context */
     diff_ctx_t ctx = {
-        .result = result,
+        .ops = buf,
         .current_type = -1,
         .current_count = 0,
         .old_line_pos = 0,
-        .new_line_pos = 0
+        .new_line_pos = 0,
+        .error = CF_OK
     };
 
     git_diff_options opts = GIT_DIFF_OPTIONS_INIT;
-    
+    apply_diff_algorithm(&opts, algorithm);
+
     int err = git_diff_buffers(
         old_data, old_size,
         NULL,  /* old_as_path */
@@ -400,190 +1408,887 @@ static int compute_diff_generic(
     );
 
     if (err != 0) {
-        result->error = CF_ERR_DIFF;
-        return CF_ERR_DIFF;
+        result->error = ctx.error != CF_OK ? ctx.error : CF_ERR_DIFF;
+        return result->error;
     }
 
-    /* Flush any pending operation */
-    flush_op(&ctx);
+    return finish_diff(&ctx, result);
+}
+
+/*
+ * Compute diff using buffers like compute_diff_ops, also recording the op
+ * positions when the buffer collects them.
+ */
+static int compute_diff_generic(
+    const char* old_data, size_t old_size,
+    const char* new_data, size_t new_size,
+    int algorithm,
+    int identical,
+    cf_op_buffer* buf,
+    cf_diff_result* result
+) {
+    int start = buf->count;
+    int ret = compute_diff_ops(old_data, old_size, new_data, new_size,
+                               algorithm, identical, buf, result);
+
+    if (ret == CF_OK && buf->want_pos) {
+        fill_op_positions(buf, start, old_data, old_size, new_data, new_size);
+    }
+    return ret;
+}
+
+/*
+ * Compute diff for a single blob pair, appending its ops to buf.
+ * Used when the batch could not preload through the ODB; the blobs are
+ * looked up individually and diffed like preloaded buffers.
+ */
+static int compute_single_diff(
+    git_repository* repo,
+    const cf_diff_request* req,
+    cf_op_buffer* buf,
+    cf_diff_result* result
+) {
+    git_blob* old_blob = NULL;
+    git_blob* new_blob = NULL;
+    const char* old_data = NULL;
+    const char* new_data = NULL;
+    size_t old_size = 0, new_size = 0;
+
+    /* Initialize result */
+    int ret = cf_init_diff_result(result, 0);
+    if (ret != CF_OK) {
+        return ret;
+    }
+
+    if (req->has_old) {
+        if (git_blob_lookup(&old_blob, repo, &req->old_oid) != 0) {
+            result->error = CF_ERR_LOOKUP;
+            return CF_ERR_LOOKUP;
+        }
+        old_data = (const char*)git_blob_rawcontent(old_blob);
+        old_size = git_blob_rawsize(old_blob);
+    }
+
+    if (req->has_new) {
+        if (git_blob_lookup(&new_blob, repo, &req->new_oid) != 0) {
+            if (old_blob) git_blob_free(old_blob);
+            result->error = CF_ERR_LOOKUP;
+            return CF_ERR_LOOKUP;
+        }
+        new_data = (const char*)git_blob_rawcontent(new_blob);
+        new_size = git_blob_rawsize(new_blob);
+    }
+
+    ret = compute_diff_generic(old_data, old_size, new_data, new_size,
+                               req->algorithm, same_blob(req), buf, result);
+
+    if (old_blob) git_blob_free(old_blob);
+    if (new_blob) git_blob_free(new_blob);
+
+    return ret;
+}
+
+/*
+ * Resolve one side of a diff request to a buffer, either from data supplied
+ * by the caller or from the batch preload set.
+ */
+static int resolve_diff_side(
+    int present,
+    const void* supplied_data,
+    size_t supplied_size,
+    const git_oid* oid,
+    cf_preloaded_blob* preloaded,
+    int preloaded_count,
+    const char** out_data,
+    size_t* out_size
+) {
+    *out_data = NULL;
+    *out_size = 0;
+
+    if (!present) {
+        return CF_OK;
+    }
+
+    if (supplied_data) {
+        *out_data = (const char*)supplied_data;
+        *out_size = supplied_size;
+        return CF_OK;
+    }
+
+    cf_preloaded_blob* blob = find_preloaded_blob(preloaded, preloaded_count, oid);
+    if (blob != NULL && blob->too_large) {
+        return CF_ERR_TOO_LARGE;
+    }
+    if (blob == NULL || !blob->valid) {
+        return CF_ERR_LOOKUP;
+    }
+
+    *out_data = blob->data;
+    *out_size = blob->size;
+    return CF_OK;
+}
+
+/* Diff one request of a batch against the preload set */
+static int diff_batch_request(
+    const cf_diff_request* req,
+    cf_preloaded_blob* preloaded,
+    int preloaded_count,
+    cf_op_buffer* buf,
+    cf_diff_result* result
+) {
+    const char *old_data, *new_data;
+    size_t old_size, new_size;
+
+    cf_init_diff_result(result, 0);
+
+    int err = resolve_diff_side(req->has_old, req->old_data, req->old_size, &req->old_oid,
+                                preloaded, preloaded_count, &old_data, &old_size);
+    if (err == CF_OK) {
+        err = resolve_diff_side(req->has_new, req->new_data, req->new_size, &req->new_oid,
+                                preloaded, preloaded_count, &new_data, &new_size);
+    }
+    if (err != CF_OK) {
+        result->error = err;
+        return err;
+    }
+
+    return compute_diff_generic(old_data, old_size, new_data, new_size,
+                                req->algorithm, same_blob(req), buf, result);
+}
+
+/*
+ * Diff one request, appending its ops to the calling thread's buffer and
+ * recording the buffer-local op range. Failed diffs leave no ops behind.
+ */
+static int diff_into_buffer(
+    git_repository* repo,
+    const cf_diff_request* req,
+    cf_preloaded_blob* preloaded,
+    int preloaded_count,
+    int use_preload,
+    cf_op_buffer* buf,
+    cf_diff_flat_result* flat
+) {
+    int start = buf->count;
+    uint64_t start_ns = cf_stats_now();
+    cf_diff_result res;
+    int ret;
+
+    if (use_preload) {
+        ret = diff_batch_request(req, preloaded, preloaded_count, buf, &res);
+    } else {
+        ret = compute_single_diff(repo, req, buf, &res);
+    }
+
+    flat->old_lines = res.old_lines;
+    flat->new_lines = res.new_lines;
+    flat->error = ret;
+    flat->op_offset = 0;
+    flat->op_count = 0;
+
+    if (ret != CF_OK) {
+        cf_stats_record(CF_LATENCY_DIFF, start_ns);
+        buf->count = start;
+        return ret;
+    }
+
+    flat->op_offset = (uint64_t)start;
+    flat->op_count = buf->count - start;
+
+    cf_stats_record(CF_LATENCY_DIFF, start_ns);
+    cf_stats_add(CF_STAT_DIFFS, 1);
+    cf_stats_add(CF_STAT_DIFF_OPS, (uint64_t)flat->op_count);
+    return CF_OK;
+}
+
+/* Mark every result of a failed batch with the same error */
+static void fail_flat_results(cf_diff_flat_result* results, int count, int error) {
+    for (int i = 0; i < count; i++) {
+        results[i].old_lines = 0;
+        results[i].new_lines = 0;
+        results[i].op_offset = 0;
+        results[i].op_count = 0;
+        results[i].error = error;
+    }
+}
+
+/*
+ * Compute diffs for multiple blob pairs into one flat op arena, and into a
+ * parallel position arena when out_pos is not NULL.
+ *
+ * Optimizations:
+ * 1. Preloads all unique blobs in sorted order for pack cache efficiency
+ * 2. Diffs the preloaded buffers directly (avoids re-lookup)
+ * 3. Single ODB refresh for the entire batch
+ * 4. One op buffer per thread, stitched into a single arena at the end
+ *
+ * cost (may be NULL) splits the call into its preload and diff phases;
+ * without a preload, blob reads count as diff time.
+ */
+static int batch_diff_flat(
+    git_repository* repo,
+    const cf_diff_request* requests,
+    int count,
+    cf_diff_op* ops_buf,
+    size_t ops_capacity,
+    cf_diff_op** out_ops,
+    cf_diff_op_pos** out_pos,
+    size_t* out_op_count,
+    cf_diff_flat_result* results,
+    cf_batch_cost* cost
+) {
+    *out_ops = NULL;
+    *out_op_count = 0;
+    if (out_pos != NULL) {
+        *out_pos = NULL;
+    }
+    if (cost != NULL) {
+        memset(cost, 0, sizeof(*cost));
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    uint64_t start_ns = cf_stats_now();
+
+    /* Get ODB for direct access and preload all blobs. On failure, fall
+     * back to per-request blob lookups. */
+    git_odb* odb = NULL;
+    cf_odb_cache* cache = NULL;
+    cf_preloaded_blob* preloaded = NULL;
+    int preloaded_count = 0;
+    int use_preload = 0;
+
+    if (git_repository_odb(&odb, repo) == 0) {
+        /* Refresh ODB once for the entire batch */
+        git_odb_refresh(odb);
+        cache = cf_odb_cache_acquire(repo);
+        use_preload = preload_blobs_for_diff(repo, odb, cache, requests, count, &preloaded, &preloaded_count) == CF_OK;
+    }
+
+    uint64_t preloaded_bytes = 0;
+    for (int i = 0; i < preloaded_count; i++) {
+        if (preloaded[i].valid) {
+            preloaded_bytes += preloaded[i].size;
+        }
+    }
+    uint64_t diff_start_ns = cf_stats_now();
+
+    /* Only parallelize preloaded batches: compute_diff_generic is pure
+     * computation on buffers. The grant scales with the batch size and is
+     * bounded by the budget shared with other concurrent batch calls. */
+    int thread_count = use_preload ? cf_acquire_threads(count) : 1;
+
+    cf_op_buffer* buffers = (cf_op_buffer*)calloc(thread_count, sizeof(cf_op_buffer));
+    int* owner = (int*)malloc((size_t)count * sizeof(int));
+    size_t* bases = (size_t*)malloc((size_t)thread_count * sizeof(size_t));
+    int success_count = 0;
+
+    if (buffers == NULL || owner == NULL || bases == NULL) {
+        fail_flat_results(results, count, CF_ERR_NOMEM);
+        goto cleanup;
+    }
+
+    for (int t = 0; t < thread_count; t++) {
+        buffers[t].want_pos = out_pos != NULL;
+    }
+
+#ifdef _OPENMP
+    if (thread_count > 1) {
+        #pragma omp parallel num_threads(thread_count) reduction(+:success_count)
+        {
+            int tid = omp_get_thread_num();
+
+            #pragma omp for schedule(dynamic, 4)
+            for (int i = 0; i < count; i++) {
+                owner[i] = tid;
+                if (diff_into_buffer(repo, &requests[i], preloaded, preloaded_count, 1,
+                                     &buffers[tid], &results[i]) == CF_OK) {
+                    success_count++;
+                }
+            }
+            cf_alloc_batch_end();
+        }
+    } else
+#endif
+    {
+        /* Sequential fallback for small batches or non-OpenMP builds */
+        for (int i = 0; i < count; i++) {
+            owner[i] = 0;
+            if (diff_into_buffer(repo, &requests[i], preloaded, preloaded_count, use_preload,
+                                 &buffers[0], &results[i]) == CF_OK) {
+                success_count++;
+            }
+        }
+    }
+
+    /* Lay the per-thread buffers out back to back */
+    size_t total = 0;
+    for (int t = 0; t < thread_count; t++) {
+        bases[t] = total;
+        total += (size_t)buffers[t].count;
+    }
+
+    cf_diff_op* arena = ops_buf;
+    if (total > ops_capacity || ops_buf == NULL) {
+        arena = (cf_diff_op*)malloc((total > 0 ? total : 1) * sizeof(cf_diff_op));
+        if (arena == NULL) {
+            fail_flat_results(results, count, CF_ERR_NOMEM);
+            success_count = 0;
+            goto cleanup;
+        }
+        *out_ops = arena;
+    }
+
+    cf_diff_op_pos* pos_arena = NULL;
+    if (out_pos != NULL) {
+        pos_arena = (cf_diff_op_pos*)malloc((total > 0 ? total : 1) * sizeof(cf_diff_op_pos));
+        if (pos_arena == NULL) {
+            if (*out_ops != NULL) {
+                free(*out_ops);
+                *out_ops = NULL;
+            }
+            fail_flat_results(results, count, CF_ERR_NOMEM);
+            success_count = 0;
+            goto cleanup;
+        }
+        *out_pos = pos_arena;
+    }
+
+    for (int t = 0; t < thread_count; t++) {
+        if (buffers[t].count > 0) {
+            memcpy(arena + bases[t], buffers[t].ops, (size_t)buffers[t].count * sizeof(cf_diff_op));
+            if (pos_arena != NULL) {
+                memcpy(pos_arena + bases[t], buffers[t].pos, (size_t)buffers[t].count * sizeof(cf_diff_op_pos));
+            }
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (results[i].error == CF_OK) {
+            results[i].op_offset += bases[owner[i]];
+        }
+    }
+
+    *out_op_count = total;
+    uint64_t arena_bytes = (uint64_t)total *
+                           (sizeof(cf_diff_op) + (pos_arena != NULL ? sizeof(cf_diff_op_pos) : 0));
+    cf_stats_add(CF_STAT_OP_ARENA_BYTES, arena_bytes);
+
+    if (cost != NULL) {
+        cost->bytes_inflated = preloaded_bytes;
+        cost->bytes_copied = arena_bytes;
+        cost->inflate_ns = diff_start_ns - start_ns;
+        cost->diff_ns = cf_stats_now() - diff_start_ns;
+        cost->peak_bytes = preloaded_bytes + arena_bytes;
+    }
+
+cleanup:
+    if (buffers != NULL) {
+        for (int t = 0; t < thread_count; t++) {
+            free(buffers[t].ops);
+            free(buffers[t].pos);
+        }
+    }
+    free(buffers);
+    free(owner);
+    free(bases);
+    if (use_preload) cf_release_threads(thread_count);
+    free_preloaded_blobs(preloaded, preloaded_count);
+    cf_odb_cache_free(cache);
+    if (odb) git_odb_free(odb);
+    cf_alloc_batch_end();
+
+    return success_count;
+}
+
+int cf_batch_diff_blobs_flat(
+    git_repository* repo,
+    const cf_diff_request* requests,
+    int count,
+    cf_diff_op* ops_buf,
+    size_t ops_capacity,
+    cf_diff_op** out_ops,
+    size_t* out_op_count,
+    cf_diff_flat_result* results,
+    cf_batch_cost* cost
+) {
+    return batch_diff_flat(repo, requests, count, ops_buf, ops_capacity,
+                           out_ops, NULL, out_op_count, results, cost);
+}
+
+/*
+ * Positional variant of cf_batch_diff_blobs_flat: both arenas are malloc'd.
+ */
+int cf_batch_diff_blobs_positions(
+    git_repository* repo,
+    const cf_diff_request* requests,
+    int count,
+    cf_diff_op** out_ops,
+    cf_diff_op_pos** out_pos,
+    size_t* out_op_count,
+    cf_diff_flat_result* results,
+    cf_batch_cost* cost
+) {
+    return batch_diff_flat(repo, requests, count, NULL, 0,
+                           out_ops, out_pos, out_op_count, results, cost);
+}
+
+/*
+ * Compute diffs for multiple blob pairs in a single call.
+ *
+ * Runs the flat batch and hands each result an exact-size copy of its ops.
+ */
+int cf_batch_diff_blobs(
+    git_repository* repo,
+    const cf_diff_request* requests,
+    int count,
+    cf_diff_result* results
+) {
+    if (count == 0) {
+        return 0;
+    }
+
+    cf_diff_flat_result* flat = (cf_diff_flat_result*)malloc((size_t)count * sizeof(cf_diff_flat_result));
+    if (flat == NULL) {
+        for (int i = 0; i < count; i++) {
+            cf_init_diff_result(&results[i], 0);
+            results[i].error = CF_ERR_NOMEM;
+        }
+        return 0;
+    }
+
+    cf_diff_op* ops = NULL;
+    size_t op_total = 0;
+    int success_count = cf_batch_diff_blobs_flat(repo, requests, count, NULL, 0, &ops, &op_total, flat, NULL);
+
+    for (int i = 0; i < count; i++) {
+        cf_init_diff_result(&results[i], 0);
+        results[i].old_lines = flat[i].old_lines;
+        results[i].new_lines = flat[i].new_lines;
+        results[i].error = flat[i].error;
+
+        if (flat[i].error == CF_OK &&
+            commit_ops(ops + flat[i].op_offset, flat[i].op_count, &results[i]) != CF_OK) {
+            success_count--;
+        }
+    }
+
+    free(ops);
+    free(flat);
+
+    return success_count;
+}
+
+/*
+ * Free tree diff result.
+ */
+void cf_free_tree_diff_result(cf_tree_diff_result* result) {
+    if (result == NULL) return;
+    free(result->changes);
+    result->changes = NULL;
+    free(result->paths);
+    result->paths = NULL;
+    result->paths_size = 0;
+}
+
+/* ============================================================================
+ * Tree Diff Filters
+ * ============================================================================ */
+
+struct cf_tree_filter {
+    git_pathspec* includes;     /* NULL lets every path through */
+    git_pathspec* excludes;     /* NULL excludes nothing */
+    char** skip_dirs;           /* Without leading or trailing '/' */
+    int* skip_anchored;         /* 1 if skip_dirs[i] only matches at the root */
+    int skip_dir_count;
+    size_t max_blob_size;       /* 0 = no limit */
+    cf_rename_detector* renames;    /* NULL = no rename detection */
+};
+
+/* Compile patterns (with or without the '!' prefix) into one pathspec */
+static int compile_pathspec(git_pathspec** out, const char* const* patterns, int count, int negative) {
+    char** strings = (char**)malloc((size_t)count * sizeof(char*));
+    if (strings == NULL) {
+        return CF_ERR_NOMEM;
+    }
+
+    size_t n = 0;
+    for (int i = 0; i < count; i++) {
+        if ((patterns[i][0] == '!') == negative) {
+            strings[n++] = (char*)(negative ? patterns[i] + 1 : patterns[i]);
+        }
+    }
+
+    int ret = CF_OK;
+    *out = NULL;
+    if (n > 0) {
+        git_strarray array = { strings, n };
+        if (git_pathspec_new(out, &array) != 0) {
+            ret = CF_ERR_NOMEM;
+        }
+    }
+    free(strings);
+    return ret;
+}
+
+cf_tree_filter* cf_tree_filter_new(
+    const char* const* pathspecs,
+    int pathspec_count,
+    const char* const* skip_dirs,
+    int skip_dir_count,
+    size_t max_blob_size
+) {
+    cf_tree_filter* filter = (cf_tree_filter*)calloc(1, sizeof(cf_tree_filter));
+    if (filter == NULL) {
+        return NULL;
+    }
+    filter->max_blob_size = max_blob_size;
+
+    if (compile_pathspec(&filter->includes, pathspecs, pathspec_count, 0) != CF_OK ||
+        compile_pathspec(&filter->excludes, pathspecs, pathspec_count, 1) != CF_OK) {
+        cf_tree_filter_free(filter);
+        return NULL;
+    }
+
+    if (skip_dir_count > 0) {
+        filter->skip_dirs = (char**)calloc(skip_dir_count, sizeof(char*));
+        filter->skip_anchored = (int*)calloc(skip_dir_count, sizeof(int));
+        if (filter->skip_dirs == NULL || filter->skip_anchored == NULL) {
+            cf_tree_filter_free(filter);
+            return NULL;
+        }
+    }
+
+    for (int i = 0; i < skip_dir_count; i++) {
+        const char* dir = skip_dirs[i];
+        int anchored = dir[0] == '/';
+        while (*dir == '/') dir++;
+
+        size_t len = strlen(dir);
+        while (len > 0 && dir[len - 1] == '/') len--;
+        if (len == 0) {
+            continue;
+        }
+
+        char* copy = (char*)malloc(len + 1);
+        if (copy == NULL) {
+            cf_tree_filter_free(filter);
+            return NULL;
+        }
+        memcpy(copy, dir, len);
+        copy[len] = '\0';
+
+        filter->skip_dirs[filter->skip_dir_count] = copy;
+        filter->skip_anchored[filter->skip_dir_count] = anchored;
+        filter->skip_dir_count++;
+    }
+
+    return filter;
+}
+
+void cf_tree_filter_free(cf_tree_filter* filter) {
+    if (filter == NULL) {
+        return;
+    }
+    if (filter->includes) git_pathspec_free(filter->includes);
+    if (filter->excludes) git_pathspec_free(filter->excludes);
+    for (int i = 0; i < filter->skip_dir_count; i++) {
+        free(filter->skip_dirs[i]);
+    }
+    free(filter->skip_dirs);
+    free(filter->skip_anchored);
+    cf_rename_detector_free(filter->renames);
+    free(filter);
+}
+
+int cf_tree_filter_set_renames(cf_tree_filter* filter, int threshold, int limit, size_t max_signatures) {
+    cf_rename_detector* det = cf_rename_detector_new(threshold, limit, max_signatures);
+    if (det == NULL) {
+        return CF_ERR_NOMEM;
+    }
+    cf_rename_detector_free(filter->renames);
+    filter->renames = det;
+    return CF_OK;
+}
+
+/* 1 if path lies below dir, i.e. dir is one of its leading path components */
+static int path_in_dir(const char* path, const char* dir, int anchored) {
+    size_t len = strlen(dir);
+    const char* p = path;
+
+    while ((p = strstr(p, dir)) != NULL) {
+        int starts_component = p == path || p[-1] == '/';
+        if (starts_component && p[len] == '/' && (!anchored || p == path)) {
+            return 1;
+        }
+        if (anchored) {
+            return 0;
+        }
+        p++;
+    }
+    return 0;
+}
+
+int cf_tree_filter_matches(const cf_tree_filter* filter, const char* path) {
+    if (filter == NULL) {
+        return 1;
+    }
+
+    for (int i = 0; i < filter->skip_dir_count; i++) {
+        if (path_in_dir(path, filter->skip_dirs[i], filter->skip_anchored[i])) {
+            return 0;
+        }
+    }
+
+    if (filter->includes != NULL && !git_pathspec_matches_path(filter->includes, GIT_PATHSPEC_DEFAULT, path)) {
+        return 0;
+    }
+    if (filter->excludes != NULL && git_pathspec_matches_path(filter->excludes, GIT_PATHSPEC_DEFAULT, path)) {
+        return 0;
+    }
+    return 1;
+}
+
+/* State of one filtered tree diff */
+typedef struct {
+    const cf_tree_filter* filter;
+    git_odb* odb;               /* For blob sizes, only with a size limit */
+} cf_tree_filter_run;
+
+/* 1 if one side of a delta is a blob larger than the limit */
+static int file_too_large(const cf_tree_filter_run* run, const git_diff_file* file) {
+    if (file->mode == 0 || file->mode == 0160000 || file->mode == 0040000 || git_oid_iszero(&file->id)) {
+        return 0;
+    }
+
+    /* Tree diffs do not load blobs, so the size usually has to be probed */
+    size_t size = (size_t)file->size;
+    if (size == 0 && run->odb != NULL) {
+        git_object_t type;
+        if (git_odb_read_header(&size, &type, run->odb, &file->id) != 0) {
+            return 0;
+        }
+    }
+    return size > run->filter->max_blob_size;
+}
+
+/* libgit2 delta callback: a positive return drops the delta */
+static int tree_filter_notify(
+    const git_diff* diff_so_far,
+    const git_diff_delta* delta,
+    const char* matched_pathspec,
+    void* payload
+) {
+    const cf_tree_filter_run* run = (const cf_tree_filter_run*)payload;
+    (void)diff_so_far;
+    (void)matched_pathspec;
+
+    /* Renames are paired after the diff, so both sides of a delta share a path */
+    if (!cf_tree_filter_matches(run->filter, delta->new_file.path)) {
+        return 1;
+    }
+
+    if (run->filter->max_blob_size > 0 &&
+        (file_too_large(run, &delta->old_file) || file_too_large(run, &delta->new_file))) {
+        return 1;
+    }
+    return 0;
+}
+
+/* Copy a path into the arena at *used; returns its offset */
+static uint32_t append_path(char* arena, size_t* used, const char* path, size_t len) {
+    uint32_t off = (uint32_t)*used;
+    memcpy(arena + *used, path, len + 1);
+    *used += len + 1;
+    return off;
+}
+
+static void init_tree_diff_result(cf_tree_diff_result* result) {
+    result->changes = NULL;
+    result->count = 0;
+    result->capacity = 0;
+    result->error = CF_OK;
+    result->paths = NULL;
+    result->paths_size = 0;
+}
 
-    /* Add trailing equal block for remaining unchanged lines */
-    if (result->old_lines > ctx.old_line_pos) {
-        int remaining = result->old_lines - ctx.old_line_pos;
-        add_op(&ctx, CF_DIFF_EQUAL, remaining);
-        flush_op(&ctx);
+/*
+ * Make room for more changes and path bytes. Arrays grow to at least double
+ * their size, so a fresh result is sized exactly and a batch result that
+ * keeps growing reallocates O(log n) times.
+ */
+static int reserve_tree_diff(
+    cf_tree_diff_result* result,
+    size_t* paths_capacity,
+    size_t more_changes,
+    size_t more_path_bytes
+) {
+    size_t need = (size_t)result->count + more_changes;
+    if (need > (size_t)result->capacity) {
+        size_t cap = (size_t)result->capacity * 2;
+        if (cap < need) cap = need;
+        if (cap > INT_MAX) return CF_ERR_NOMEM;
+        cf_change* grown = (cf_change*)realloc(result->changes, cap * sizeof(cf_change));
+        if (grown == NULL) return CF_ERR_NOMEM;
+        result->changes = grown;
+        result->capacity = (int)cap;
     }
 
+    need = result->paths_size + more_path_bytes;
+    if (need > UINT32_MAX) {
+        return CF_ERR_NOMEM;
+    }
+    if (need > *paths_capacity) {
+        size_t cap = *paths_capacity * 2;
+        if (cap < need) cap = need;
+        char* grown = (char*)realloc(result->paths, cap);
+        if (grown == NULL) return CF_ERR_NOMEM;
+        result->paths = grown;
+        *paths_capacity = cap;
+    }
     return CF_OK;
 }
 
 /*
- * Compute diffs for multiple blob pairs in a single call.
- *
- * Optimizations:
- * 1. Preloads all unique blobs in sorted order for pack cache efficiency
- * 2. Uses git_diff_buffers instead of git_diff_blobs (avoids re-lookup)
- * 3. Single ODB refresh for the entire batch
+ * Append every delta of a diff to result, tagged with commit_index.
+ * With pair_of (see cf_detect_renames) an added file that became a rename
+ * takes its old side from the deleted file, which is left out.
+ * Paths are sized in a first pass so the arena grows at most once per diff.
  */
-int cf_batch_diff_blobs(
-    git_repository* repo,
-    const cf_diff_request* requests,
-    int count,
-    cf_diff_result* results
+static int append_tree_diff_deltas(
+    git_diff* diff,
+    const int* pair_of,
+    int commit_index,
+    cf_tree_diff_result* result,
+    size_t* paths_capacity
 ) {
-    if (count == 0) {
-        return 0;
+    size_t num_deltas = git_diff_num_deltas(diff);
+    if (num_deltas == 0) {
+        return CF_OK;
     }
 
-    /* Get ODB for direct access */
-    git_odb* odb = NULL;
-    int err = git_repository_odb(&odb, repo);
-    if (err != 0) {
-        /* Fall back to basic diff on ODB error */
-        int success_count = 0;
-        for (int i = 0; i < count; i++) {
-            if (compute_single_diff(repo, &requests[i], &results[i]) == CF_OK) {
-                success_count++;
-            }
+    size_t path_bytes = 0;
+    for (size_t i = 0; i < num_deltas; i++) {
+        if (pair_of != NULL && pair_of[i] == CF_RENAME_SOURCE) {
+            continue;
+        }
+        const git_diff_delta* delta = git_diff_get_delta(diff, i);
+        const git_diff_file* old_file = pair_of != NULL && pair_of[i] >= 0
+            ? &git_diff_get_delta(diff, (size_t)pair_of[i])->old_file : &delta->old_file;
+        path_bytes += strlen(delta->new_file.path) + 1;
+        if (strcmp(old_file->path, delta->new_file.path) != 0) {
+            path_bytes += strlen(old_file->path) + 1;
         }
-        return success_count;
     }
 
-    /* Refresh ODB once for the entire batch */
-    git_odb_refresh(odb);
-
-    /* Preload all blobs */
-    cf_preloaded_blob* preloaded = NULL;
-    int preloaded_count = 0;
-    err = preload_blobs_for_diff(odb, requests, count, &preloaded, &preloaded_count);
+    int err = reserve_tree_diff(result, paths_capacity, num_deltas, path_bytes);
     if (err != CF_OK) {
-        git_odb_free(odb);
-        /* Fall back to basic diff */
-        int success_count = 0;
-        for (int i = 0; i < count; i++) {
-            if (compute_single_diff(repo, &requests[i], &results[i]) == CF_OK) {
-                success_count++;
-            }
-        }
-        return success_count;
+        return err;
     }
 
-    /* Compute diffs - parallelized with OpenMP for large batches.
-     * compute_diff_generic is pure computation on buffers, no shared state.
-     * Each thread writes to its own results[i] slot.
-     */
-    int success_count = 0;
+    for (size_t i = 0; i < num_deltas; i++) {
+        if (pair_of != NULL && pair_of[i] == CF_RENAME_SOURCE) {
+            continue;
+        }
 
-#ifdef _OPENMP
-    /* Only parallelize for sufficiently large batches to amortize thread overhead */
-    if (count >= 8) {
-        #pragma omp parallel for reduction(+:success_count) schedule(dynamic, 4)
-        for (int i = 0; i < count; i++) {
-            const char *old_data = NULL, *new_data = NULL;
-            size_t old_size = 0, new_size = 0;
-            int skip = 0;
-
-            if (requests[i].has_old) {
-                if (requests[i].old_data) {
-                    old_data = (const char*)requests[i].old_data;
-                    old_size = requests[i].old_size;
-                } else {
-                    cf_preloaded_blob* blob = find_preloaded_blob(preloaded, preloaded_count, &requests[i].old_oid);
-                    if (blob && blob->valid) {
-                        old_data = blob->data;
-                        old_size = blob->size;
-                    } else {
-                        results[i].error = CF_ERR_LOOKUP;
-                        skip = 1;
-                    }
-                }
-            }
+        const git_diff_delta* delta = git_diff_get_delta(diff, i);
+        const git_diff_file* old_file = &delta->old_file;
+        cf_change* change = &result->changes[result->count];
 
-            if (!skip && requests[i].has_new) {
-                if (requests[i].new_data) {
-                    new_data = (const char*)requests[i].new_data;
-                    new_size = requests[i].new_size;
-                } else {
-                    cf_preloaded_blob* blob = find_preloaded_blob(preloaded, preloaded_count, &requests[i].new_oid);
-                    if (blob && blob->valid) {
-                        new_data = blob->data;
-                        new_size = blob->size;
-                    } else {
-                        results[i].error = CF_ERR_LOOKUP;
-                        skip = 1;
-                    }
-                }
-            }
+        change->status = delta->status;
+        if (pair_of != NULL && pair_of[i] >= 0) {
+            old_file = &git_diff_get_delta(diff, (size_t)pair_of[i])->old_file;
+            change->status = GIT_DELTA_RENAMED;
+        }
+        change->commit_index = commit_index;
 
-            if (!skip && compute_diff_generic(old_data, old_size, new_data, new_size, &results[i]) == CF_OK) {
-                success_count++;
-            }
+        size_t new_len = strlen(delta->new_file.path);
+        change->new_path_off = append_path(result->paths, &result->paths_size, delta->new_file.path, new_len);
+        change->new_path_len = (uint32_t)new_len;
+        memcpy(change->new_oid, delta->new_file.id.id, 20);
+        change->new_size = delta->new_file.size;
+        change->new_mode = delta->new_file.mode;
+
+        if (strcmp(old_file->path, delta->new_file.path) == 0) {
+            change->old_path_off = change->new_path_off;
+            change->old_path_len = change->new_path_len;
+        } else {
+            size_t old_len = strlen(old_file->path);
+            change->old_path_off = append_path(result->paths, &result->paths_size, old_file->path, old_len);
+            change->old_path_len = (uint32_t)old_len;
         }
-    } else
-#endif
-    {
-        /* Sequential fallback for small batches or non-OpenMP builds */
-        for (int i = 0; i < count; i++) {
-            const char *old_data = NULL, *new_data = NULL;
-            size_t old_size = 0, new_size = 0;
-
-            if (requests[i].has_old) {
-                if (requests[i].old_data) {
-                    old_data = (const char*)requests[i].old_data;
-                    old_size = requests[i].old_size;
-                } else {
-                    cf_preloaded_blob* blob = find_preloaded_blob(preloaded, preloaded_count, &requests[i].old_oid);
-                    if (blob && blob->valid) {
-                        old_data = blob->data;
-                        old_size = blob->size;
-                    } else {
-                        results[i].error = CF_ERR_LOOKUP;
-                        continue;
-                    }
-                }
-            }
+        memcpy(change->old_oid, old_file->id.id, 20);
+        change->old_size = old_file->size;
+        change->old_mode = old_file->mode;
 
-            if (requests[i].has_new) {
-                if (requests[i].new_data) {
-                    new_data = (const char*)requests[i].new_data;
-                    new_size = requests[i].new_size;
-                } else {
-                    cf_preloaded_blob* blob = find_preloaded_blob(preloaded, preloaded_count, &requests[i].new_oid);
-                    if (blob && blob->valid) {
-                        new_data = blob->data;
-                        new_size = blob->size;
-                    } else {
-                        results[i].error = CF_ERR_LOOKUP;
-                        continue;
-                    }
-                }
-            }
+        result->count++;
+    }
+    return CF_OK;
+}
 
-            if (compute_diff_generic(old_data, old_size, new_data, new_size, &results[i]) == CF_OK) {
-                success_count++;
-            }
+/* Diff two (possibly NULL) trees and append the deltas filter lets through */
+static int diff_trees_into(
+    git_repository* repo,
+    git_tree* old_tree,
+    git_tree* new_tree,
+    const cf_tree_filter* filter,
+    int commit_index,
+    cf_tree_diff_result* result,
+    size_t* paths_capacity
+) {
+    git_diff* diff = NULL;
+    git_diff_options opts = GIT_DIFF_OPTIONS_INIT;
+    cf_tree_filter_run run = { filter, NULL };
+    uint64_t start_ns = cf_stats_now();
+    int first_change = result->count;
+
+    if (filter != NULL) {
+        if (filter->max_blob_size > 0 && git_repository_odb(&run.odb, repo) != 0) {
+            run.odb = NULL;
         }
+        opts.notify_cb = tree_filter_notify;
+        opts.payload = &run;
     }
 
-    free_preloaded_blobs(preloaded, preloaded_count);
-    git_odb_free(odb);
+    int diff_err = git_diff_tree_to_tree(&diff, repo, old_tree, new_tree, &opts);
+    if (run.odb != NULL) {
+        git_odb_free(run.odb);
+    }
+    if (diff_err != 0) {
+        return CF_ERR_DIFF;
+    }
 
-    return success_count;
-}
+    int* pair_of = NULL;
+    int ret = CF_OK;
 
-/*
- * Free tree diff result.
- */
-void cf_free_tree_diff_result(cf_tree_diff_result* result) {
-    if (result == NULL) return;
-    if (result->changes != NULL) {
-        for (int i = 0; i < result->count; i++) {
-            free(result->changes[i].old_path);
-            free(result->changes[i].new_path);
+    size_t num_deltas = git_diff_num_deltas(diff);
+    if (filter != NULL && filter->renames != NULL && num_deltas > 1) {
+        pair_of = (int*)malloc(num_deltas * sizeof(int));
+        if (pair_of == NULL) {
+            ret = CF_ERR_NOMEM;
+        } else {
+            int renames = cf_detect_renames(filter->renames, repo, diff, pair_of);
+            if (renames < 0) {
+                ret = renames;
+            } else if (renames == 0) {
+                free(pair_of);
+                pair_of = NULL;
+            }
         }
-        free(result->changes);
-        result->changes = NULL;
     }
+
+    if (ret == CF_OK) {
+        ret = append_tree_diff_deltas(diff, pair_of, commit_index, result, paths_capacity);
+    }
+    free(pair_of);
+    git_diff_free(diff);
+
+    cf_stats_record(CF_LATENCY_TREE_DIFF, start_ns);
+    cf_stats_add(CF_STAT_TREE_DIFFS, 1);
+    cf_stats_add(CF_STAT_TREE_DELTAS, (uint64_t)(result->count - first_change));
+    return ret;
 }
 
 /*
@@ -594,17 +2299,15 @@ int cf_tree_diff(
     git_repository* repo,
     git_oid* old_tree_oid,
     git_oid* new_tree_oid,
+    const cf_tree_filter* filter,
     cf_tree_diff_result* result
 ) {
     git_tree* old_tree = NULL;
     git_tree* new_tree = NULL;
-    git_diff* diff = NULL;
+    size_t paths_capacity = 0;
     int ret = CF_OK;
 
-    result->changes = NULL;
-    result->count = 0;
-    result->capacity = 0;
-    result->error = CF_OK;
+    init_tree_diff_result(result);
 
     /* Lookup trees */
     if (old_tree_oid != NULL && !git_oid_iszero(old_tree_oid)) {
@@ -621,57 +2324,338 @@ int cf_tree_diff(
         }
     }
 
-    /* Compute diff */
-    git_diff_options opts = GIT_DIFF_OPTIONS_INIT;
-    if (git_diff_tree_to_tree(&diff, repo, old_tree, new_tree, &opts) != 0) {
-        ret = CF_ERR_DIFF;
-        goto cleanup;
+    ret = diff_trees_into(repo, old_tree, new_tree, filter, 0, result, &paths_capacity);
+
+cleanup:
+    if (old_tree) git_tree_free(old_tree);
+    if (new_tree) git_tree_free(new_tree);
+
+    result->error = ret;
+    if (ret != CF_OK) {
+        cf_free_tree_diff_result(result);
+    }
+    return ret;
+}
+
+/* Tree of a commit, or NULL with *err set */
+static git_tree* lookup_commit_tree(git_repository* repo, const git_oid* commit_oid, git_oid* parent_oid, int* has_parent, int* err) {
+    git_commit* commit = NULL;
+    git_tree* tree = NULL;
+
+    if (git_commit_lookup(&commit, repo, commit_oid) != 0) {
+        *err = CF_ERR_LOOKUP;
+        return NULL;
     }
 
-    /* Allocate result array */
-    size_t num_deltas = git_diff_num_deltas(diff);
-    if (num_deltas > 0) {
-        result->changes = (cf_change*)malloc(num_deltas * sizeof(cf_change));
-        if (result->changes == NULL) {
-            ret = CF_ERR_NOMEM;
-            goto cleanup;
+    if (parent_oid != NULL) {
+        *has_parent = git_commit_parentcount(commit) > 0;
+        if (*has_parent) {
+            git_oid_cpy(parent_oid, git_commit_parent_id(commit, 0));
         }
-        result->capacity = num_deltas;
     }
 
-    /* Iterate deltas and populate result */
-    for (size_t i = 0; i < num_deltas; i++) {
-        const git_diff_delta* delta = git_diff_get_delta(diff, i);
-        cf_change* change = &result->changes[result->count];
+    if (git_tree_lookup(&tree, repo, git_commit_tree_id(commit)) != 0) {
+        *err = CF_ERR_LOOKUP;
+    }
+    git_commit_free(commit);
+    return tree;
+}
 
-        change->status = delta->status;
-        
-        change->old_path = strdup(delta->old_file.path);
-        memcpy(change->old_oid, delta->old_file.id.id, 20);
-        change->old_size = delta->old_file.size;
-        change->old_mode = delta->old_file.mode;
+/*
+ * Tree-diff a list of commits against their parents in one call.
+ */
+int cf_batch_tree_diff(
+    git_repository* repo,
+    const cf_commit_diff_request* requests,
+    int count,
+    const cf_tree_filter* filter,
+    cf_tree_diff_result* result,
+    cf_commit_diff_info* infos,
+    cf_batch_cost* cost
+) {
+    size_t paths_capacity = 0;
+    int success_count = 0;
+    uint64_t start_ns = cf_stats_now();
 
-        change->new_path = strdup(delta->new_file.path);
-        memcpy(change->new_oid, delta->new_file.id.id, 20);
-        change->new_size = delta->new_file.size;
-        change->new_mode = delta->new_file.mode;
+    /* Tree of the previous request's commit, reused when it is the next base */
+    git_oid prev_commit;
+    git_tree* prev_tree = NULL;
 
-        if (change->old_path == NULL || change->new_path == NULL) {
-            ret = CF_ERR_NOMEM;
-            goto cleanup;
+    init_tree_diff_result(result);
+
+    for (int i = 0; i < count; i++) {
+        const cf_commit_diff_request* req = &requests[i];
+        cf_commit_diff_info* info = &infos[i];
+        int err = CF_OK;
+
+        info->change_offset = result->count;
+        info->change_count = 0;
+        size_t paths_start = result->paths_size;
+        memset(info->tree_oid, 0, sizeof(info->tree_oid));
+
+        git_oid base_oid;
+        int has_base = req->has_parent;
+        if (has_base) {
+            git_oid_cpy(&base_oid, &req->parent_oid);
         }
 
-        result->count++;
+        git_tree* tree = lookup_commit_tree(repo, &req->commit_oid, has_base ? NULL : &base_oid, &has_base, &err);
+        git_tree* base_tree = NULL;
+        int owns_base = 0;
+
+        if (err == CF_OK && has_base) {
+            if (prev_tree != NULL && git_oid_equal(&base_oid, &prev_commit)) {
+                base_tree = prev_tree;
+            } else {
+                base_tree = lookup_commit_tree(repo, &base_oid, NULL, NULL, &err);
+                owns_base = 1;
+            }
+        }
+
+        if (err == CF_OK) {
+            memcpy(info->tree_oid, git_tree_id(tree)->id, GIT_OID_RAWSZ);
+
+            /* Metadata-only commits share their parent's tree: nothing to diff */
+            if (base_tree == NULL || !git_oid_equal(git_tree_id(base_tree), git_tree_id(tree))) {
+                err = diff_trees_into(repo, base_tree, tree, filter, i, result, &paths_capacity);
+            }
+        }
+
+        if (owns_base && base_tree != NULL) {
+            git_tree_free(base_tree);
+        }
+
+        if (err != CF_OK) {
+            /* Drop a partial append so the ranges stay exact */
+            result->count = info->change_offset;
+            result->paths_size = paths_start;
+            if (tree != NULL) git_tree_free(tree);
+        } else {
+            info->change_count = result->count - info->change_offset;
+            success_count++;
+
+            if (prev_tree != NULL) git_tree_free(prev_tree);
+            prev_tree = tree;
+            git_oid_cpy(&prev_commit, &req->commit_oid);
+        }
+        info->error = err;
+    }
+
+    if (prev_tree != NULL) {
+        git_tree_free(prev_tree);
+    }
+    cf_alloc_batch_end();
+
+    if (cost != NULL) {
+        memset(cost, 0, sizeof(*cost));
+        cost->diff_ns = cf_stats_now() - start_ns;
+        cost->peak_bytes = (uint64_t)result->count * sizeof(cf_change) + result->paths_size;
+    }
+
+    return success_count;
+}
+
+/* ============================================================================
+ * Fused Commit Diffs
+ * ============================================================================ */
+
+/* Tree entries the Go side treats as files (not submodules or trees) */
+static int is_file_mode(uint16_t mode) {
+    return mode != 0160000 && mode != 0040000;
+}
+
+static int compare_blob_requests(const void* a, const void* b) {
+    return memcmp(a, b, GIT_OID_RAWSZ);
+}
+
+/* Borrowed blob for oid in a result array sorted by OID, or NULL */
+static const cf_blob_borrow_result* find_borrowed_blob(
+    const cf_blob_borrow_result* blobs,
+    int count,
+    const unsigned char* oid
+) {
+    int left = 0, right = count - 1;
+    while (left <= right) {
+        int mid = (left + right) / 2;
+        int cmp = memcmp(oid, blobs[mid].oid, GIT_OID_RAWSZ);
+        if (cmp == 0) {
+            return blobs[mid].error == CF_OK ? &blobs[mid] : NULL;
+        } else if (cmp < 0) {
+            right = mid - 1;
+        } else {
+            left = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+/* Add one side of a change to the blob request list */
+static void add_blob_request(cf_blob_request* reqs, int* n, const unsigned char* oid, uint16_t mode) {
+    if (!is_file_mode(mode)) {
+        return;
+    }
+    git_oid id;
+    memcpy(id.id, oid, GIT_OID_RAWSZ);
+    if (git_oid_iszero(&id)) {
+        return;
+    }
+    memcpy(&reqs[*n].oid, &id, sizeof(git_oid));
+    (*n)++;
+}
+
+/* Borrow every unique blob referenced by the changes, sorted by OID */
+static int borrow_changed_blobs(git_repository* repo, cf_commit_diffs_result* result, cf_batch_cost* cost) {
+    const cf_tree_diff_result* changes = &result->changes;
+    cf_blob_request* reqs = (cf_blob_request*)malloc((size_t)changes->count * 2 * sizeof(cf_blob_request));
+    if (reqs == NULL) {
+        return CF_ERR_NOMEM;
+    }
+
+    int n = 0;
+    for (int i = 0; i < changes->count; i++) {
+        const cf_change* c = &changes->changes[i];
+        if (c->status != GIT_DELTA_ADDED) {
+            add_blob_request(reqs, &n, c->old_oid, c->old_mode);
+        }
+        if (c->status != GIT_DELTA_DELETED) {
+            add_blob_request(reqs, &n, c->new_oid, c->new_mode);
+        }
+    }
+
+    qsort(reqs, n, sizeof(cf_blob_request), compare_blob_requests);
+    int unique = 0;
+    for (int i = 0; i < n; i++) {
+        if (unique == 0 || memcmp(&reqs[i].oid, &reqs[unique - 1].oid, GIT_OID_RAWSZ) != 0) {
+            reqs[unique++] = reqs[i];
+        }
+    }
+
+    if (unique > 0) {
+        result->blobs = (cf_blob_borrow_result*)calloc(unique, sizeof(cf_blob_borrow_result));
+        if (result->blobs == NULL) {
+            free(reqs);
+            return CF_ERR_NOMEM;
+        }
+        cf_batch_borrow_blobs(repo, reqs, unique, result->blobs, cost);
+        result->blob_count = unique;
+    }
+
+    free(reqs);
+    return CF_OK;
+}
+
+void cf_free_commit_diffs_result(cf_commit_diffs_result* result) {
+    if (result == NULL) return;
+    cf_free_tree_diff_result(&result->changes);
+    free(result->diffs);
+    result->diffs = NULL;
+    free(result->ops);
+    result->ops = NULL;
+    result->op_count = 0;
+    if (result->blobs != NULL) {
+        cf_release_blobs(result->blobs, result->blob_count);
+        free(result->blobs);
+        result->blobs = NULL;
+    }
+    result->blob_count = 0;
+}
+
+int cf_batch_commit_diffs(
+    git_repository* repo,
+    const cf_commit_diff_request* requests,
+    int count,
+    int algorithm,
+    int flags,
+    const cf_tree_filter* filter,
+    cf_commit_diffs_result* result,
+    cf_commit_diff_info* infos,
+    cf_batch_cost* cost
+) {
+    memset(result, 0, sizeof(*result));
+
+    /* Phase costs; each phase overwrites its own */
+    cf_batch_cost tree_cost = {0}, blob_cost = {0}, diff_cost = {0};
+
+    int success_count = cf_batch_tree_diff(repo, requests, count, filter, &result->changes, infos, &tree_cost);
+    int change_count = result->changes.count;
+    if (change_count == 0) {
+        if (cost != NULL) {
+            *cost = tree_cost;
+        }
+        return success_count;
+    }
+
+    cf_diff_request* diff_reqs = (cf_diff_request*)calloc(change_count, sizeof(cf_diff_request));
+    cf_diff_flat_result* flat = (cf_diff_flat_result*)malloc((size_t)change_count * sizeof(cf_diff_flat_result));
+    int* change_of = (int*)malloc((size_t)change_count * sizeof(int));
+    result->diffs = (cf_diff_flat_result*)calloc(change_count, sizeof(cf_diff_flat_result));
+    int ret = CF_OK;
+
+    if (diff_reqs == NULL || flat == NULL || change_of == NULL || result->diffs == NULL) {
+        ret = CF_ERR_NOMEM;
+        goto cleanup;
+    }
+
+    if ((flags & CF_FUSED_WANT_BLOBS) && (ret = borrow_changed_blobs(repo, result, &blob_cost)) != CF_OK) {
+        goto cleanup;
+    }
+
+    /* One diff request per modified (or renamed) file; borrowed buffers skip the preload */
+    int diff_count = 0;
+    for (int i = 0; i < change_count; i++) {
+        const cf_change* c = &result->changes.changes[i];
+        int modified = c->status == GIT_DELTA_MODIFIED || c->status == GIT_DELTA_RENAMED ||
+                       c->status == GIT_DELTA_COPIED;
+        if (!modified || !is_file_mode(c->old_mode) || !is_file_mode(c->new_mode)) {
+            continue;
+        }
+
+        cf_diff_request* req = &diff_reqs[diff_count];
+        memcpy(req->old_oid.id, c->old_oid, GIT_OID_RAWSZ);
+        memcpy(req->new_oid.id, c->new_oid, GIT_OID_RAWSZ);
+        req->has_old = 1;
+        req->has_new = 1;
+        req->algorithm = algorithm;
+
+        const cf_blob_borrow_result* old_blob = find_borrowed_blob(result->blobs, result->blob_count, c->old_oid);
+        const cf_blob_borrow_result* new_blob = find_borrowed_blob(result->blobs, result->blob_count, c->new_oid);
+        if (old_blob != NULL && new_blob != NULL && old_blob->size > 0 && new_blob->size > 0) {
+            req->old_data = old_blob->data;
+            req->old_size = old_blob->size;
+            req->new_data = new_blob->data;
+            req->new_size = new_blob->size;
+        }
+
+        change_of[diff_count++] = i;
+    }
+
+    if (diff_count > 0) {
+        cf_batch_diff_blobs_flat(repo, diff_reqs, diff_count, NULL, 0, &result->ops, &result->op_count, flat,
+                                 &diff_cost);
+        for (int k = 0; k < diff_count; k++) {
+            result->diffs[change_of[k]] = flat[k];
+        }
     }
 
 cleanup:
-    if (diff) git_diff_free(diff);
-    if (old_tree) git_tree_free(old_tree);
-    if (new_tree) git_tree_free(new_tree);
+    free(diff_reqs);
+    free(flat);
+    free(change_of);
+
+    if (cost != NULL) {
+        *cost = tree_cost;
+        cf_cost_add(cost, &blob_cost);
+        cf_cost_add(cost, &diff_cost);
+    }
 
-    result->error = ret;
     if (ret != CF_OK) {
-        cf_free_tree_diff_result(result);
+        cf_free_commit_diffs_result(result);
+        for (int i = 0; i < count; i++) {
+            infos[i].change_offset = 0;
+            infos[i].change_count = 0;
+            infos[i].error = ret;
+        }
+        return 0;
     }
-    return ret;
+    return success_count;
 }
@@ -0,0 +1,334 @@
+/*
+ * Codefang Git Library - Cross-Batch Object Cache
+ *
+ * Consecutive commits share most of their blobs: the new side of one diff is
+ * usually the old side of the next. libgit2 does not cache blobs by default,
+ * so each batch would read and inflate them from the pack again. This cache
+ * keeps references to decompressed git_odb_object buffers across batches:
+ * 1. Keyed by OID, evicted least recently used first
+ * 2. Bounded by the total size of the cached objects
+ * 3. Attached to repository handles, so every cf_batch_* loader of a handle
+ *    shares it without extra arguments
+ * 4. Hits hand out another reference to the same buffer, never a copy
+ */
+
+#include "codefang_git.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Initial number of hash buckets (power of two, doubles with the entry count) */
+#define CF_ODB_CACHE_INITIAL_BUCKETS 256
+
+typedef struct cf_cache_entry {
+    git_oid oid;
+    git_odb_object* obj;            /* Reference owned by the cache */
+    size_t size;
+    struct cf_cache_entry* hnext;   /* Bucket chain */
+    struct cf_cache_entry* prev;    /* LRU list, head is most recently used */
+    struct cf_cache_entry* next;
+} cf_cache_entry;
+
+struct cf_odb_cache {
+    pthread_mutex_t lock;
+    atomic_int refs;
+    cf_cache_entry** buckets;
+    size_t bucket_count;
+    size_t entry_count;
+    size_t bytes;
+    size_t max_bytes;
+    cf_cache_entry* head;
+    cf_cache_entry* tail;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+};
+
+/* Repository handle -> attached cache */
+typedef struct cf_cache_binding {
+    git_repository* repo;
+    cf_odb_cache* cache;
+    struct cf_cache_binding* next;
+} cf_cache_binding;
+
+static pthread_mutex_t binding_lock = PTHREAD_MUTEX_INITIALIZER;
+static cf_cache_binding* bindings = NULL;
+
+/* OIDs are uniformly distributed, so their leading bytes are a good hash */
+static size_t bucket_of(const cf_odb_cache* cache, const git_oid* oid) {
+    uint64_t h;
+    memcpy(&h, oid->id, sizeof(h));
+    return (size_t)h & (cache->bucket_count - 1);
+}
+
+static cf_cache_entry* find_entry(const cf_odb_cache* cache, const git_oid* oid) {
+    cf_cache_entry* e = cache->buckets[bucket_of(cache, oid)];
+    while (e != NULL && memcmp(e->oid.id, oid->id, GIT_OID_RAWSZ) != 0) {
+        e = e->hnext;
+    }
+    return e;
+}
+
+static void lru_unlink(cf_odb_cache* cache, cf_cache_entry* e) {
+    if (e->prev) e->prev->next = e->next; else cache->head = e->next;
+    if (e->next) e->next->prev = e->prev; else cache->tail = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void lru_push_front(cf_odb_cache* cache, cf_cache_entry* e) {
+    e->prev = NULL;
+    e->next = cache->head;
+    if (cache->head) cache->head->prev = e; else cache->tail = e;
+    cache->head = e;
+}
+
+/* Double the bucket array; on allocation failure chains just get longer */
+static void grow_buckets(cf_odb_cache* cache) {
+    size_t new_count = cache->bucket_count * 2;
+    cf_cache_entry** grown = (cf_cache_entry**)calloc(new_count, sizeof(cf_cache_entry*));
+    if (grown == NULL) {
+        return;
+    }
+
+    cf_cache_entry** old = cache->buckets;
+    size_t old_count = cache->bucket_count;
+    cache->buckets = grown;
+    cache->bucket_count = new_count;
+
+    for (size_t i = 0; i < old_count; i++) {
+        cf_cache_entry* e = old[i];
+        while (e != NULL) {
+            cf_cache_entry* next = e->hnext;
+            size_t b = bucket_of(cache, &e->oid);
+            e->hnext = grown[b];
+            grown[b] = e;
+            e = next;
+        }
+    }
+    free(old);
+}
+
+static void remove_entry(cf_odb_cache* cache, cf_cache_entry* e) {
+    cf_cache_entry** link = &cache->buckets[bucket_of(cache, &e->oid)];
+    while (*link != e) {
+        link = &(*link)->hnext;
+    }
+    *link = e->hnext;
+
+    lru_unlink(cache, e);
+    cache->entry_count--;
+    cache->bytes -= e->size;
+    git_odb_object_free(e->obj);
+    free(e);
+}
+
+/*
+ * Create a cache holding at most max_bytes of object data.
+ * Returns NULL if max_bytes is 0 or on allocation failure. The caller owns
+ * one reference, dropped with cf_odb_cache_free.
+ */
+cf_odb_cache* cf_odb_cache_new(size_t max_bytes) {
+    if (max_bytes == 0) {
+        return NULL;
+    }
+
+    cf_odb_cache* cache = (cf_odb_cache*)calloc(1, sizeof(cf_odb_cache));
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    cache->buckets = (cf_cache_entry**)calloc(CF_ODB_CACHE_INITIAL_BUCKETS, sizeof(cf_cache_entry*));
+    if (cache->buckets == NULL || pthread_mutex_init(&cache->lock, NULL) != 0) {
+        free(cache->buckets);
+        free(cache);
+        return NULL;
+    }
+
+    cache->bucket_count = CF_ODB_CACHE_INITIAL_BUCKETS;
+    cache->max_bytes = max_bytes;
+    atomic_init(&cache->refs, 1);
+    return cache;
+}
+
+/*
+ * Drop a reference to the cache. The last reference releases every cached
+ * object. Safe to call with NULL.
+ */
+void cf_odb_cache_free(cf_odb_cache* cache) {
+    if (cache == NULL || atomic_fetch_sub_explicit(&cache->refs, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    while (cache->head != NULL) {
+        remove_entry(cache, cache->head);
+    }
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->buckets);
+    free(cache);
+}
+
+/*
+ * Attach a cache to a repository handle, replacing any previous one.
+ * Several handles on the same repository may share one cache; NULL detaches.
+ */
+int cf_odb_cache_attach(git_repository* repo, cf_odb_cache* cache) {
+    cf_odb_cache* previous = NULL;
+    int ret = CF_OK;
+
+    pthread_mutex_lock(&binding_lock);
+
+    cf_cache_binding** link = &bindings;
+    while (*link != NULL && (*link)->repo != repo) {
+        link = &(*link)->next;
+    }
+
+    if (*link != NULL) {
+        cf_cache_binding* binding = *link;
+        previous = binding->cache;
+        if (cache != NULL) {
+            binding->cache = cache;
+        } else {
+            *link = binding->next;
+            free(binding);
+        }
+    } else if (cache != NULL) {
+        cf_cache_binding* binding = (cf_cache_binding*)malloc(sizeof(cf_cache_binding));
+        if (binding == NULL) {
+            ret = CF_ERR_NOMEM;
+        } else {
+            binding->repo = repo;
+            binding->cache = cache;
+            binding->next = bindings;
+            bindings = binding;
+        }
+    }
+
+    if (ret == CF_OK && cache != NULL) {
+        atomic_fetch_add_explicit(&cache->refs, 1, memory_order_relaxed);
+    }
+
+    pthread_mutex_unlock(&binding_lock);
+
+    cf_odb_cache_free(previous);
+    return ret;
+}
+
+/*
+ * Get the cache attached to a repository handle, or NULL. The returned
+ * reference keeps the cache alive for the duration of a batch and must be
+ * dropped with cf_odb_cache_free.
+ */
+cf_odb_cache* cf_odb_cache_acquire(git_repository* repo) {
+    cf_odb_cache* cache = NULL;
+
+    pthread_mutex_lock(&binding_lock);
+    for (cf_cache_binding* b = bindings; b != NULL; b = b->next) {
+        if (b->repo == repo) {
+            cache = b->cache;
+            atomic_fetch_add_explicit(&cache->refs, 1, memory_order_relaxed);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&binding_lock);
+
+    return cache;
+}
+
+/* git_odb_read, counted and timed in the statistics */
+static int timed_odb_read(git_odb_object** out, git_odb* odb, const git_oid* oid) {
+    uint64_t start = cf_stats_now();
+    int err = git_odb_read(out, odb, oid);
+
+    cf_stats_record(CF_LATENCY_OBJECT_READ, start);
+    if (err == 0) {
+        cf_stats_add(CF_STAT_OBJECTS_READ, 1);
+        cf_stats_add(CF_STAT_BYTES_INFLATED, git_odb_object_size(*out));
+    }
+    return err;
+}
+
+/*
+ * Read an object through the cache (git_odb_read when cache is NULL).
+ *
+ * On a hit, *out is a new reference to the cached buffer. On a miss the
+ * object is read from odb and, if it fits, cached, evicting least recently
+ * used objects until the cache is back under its limit. Returns the
+ * git_odb_read error code. Thread-safe; the pack read happens unlocked.
+ */
+int cf_odb_cache_read(git_odb_object** out, cf_odb_cache* cache, git_odb* odb, const git_oid* oid) {
+    if (cache == NULL) {
+        return timed_odb_read(out, odb, oid);
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    cf_cache_entry* hit = find_entry(cache, oid);
+    if (hit != NULL) {
+        cache->hits++;
+        lru_unlink(cache, hit);
+        lru_push_front(cache, hit);
+        int err = git_odb_object_dup(out, hit->obj);
+        pthread_mutex_unlock(&cache->lock);
+        return err;
+    }
+    cache->misses++;
+    pthread_mutex_unlock(&cache->lock);
+
+    int err = timed_odb_read(out, odb, oid);
+    if (err != 0) {
+        return err;
+    }
+
+    size_t size = git_odb_object_size(*out);
+    if (size > cache->max_bytes) {
+        return 0;
+    }
+
+    cf_cache_entry* e = (cf_cache_entry*)malloc(sizeof(cf_cache_entry));
+    if (e == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+
+    /* Another thread may have cached it while we were reading */
+    if (find_entry(cache, oid) != NULL || git_odb_object_dup(&e->obj, *out) != 0) {
+        pthread_mutex_unlock(&cache->lock);
+        free(e);
+        return 0;
+    }
+
+    memcpy(&e->oid, oid, sizeof(git_oid));
+    e->size = size;
+
+    size_t b = bucket_of(cache, oid);
+    e->hnext = cache->buckets[b];
+    cache->buckets[b] = e;
+    lru_push_front(cache, e);
+    cache->entry_count++;
+    cache->bytes += size;
+
+    while (cache->bytes > cache->max_bytes && cache->tail != e) {
+        remove_entry(cache, cache->tail);
+        cache->evictions++;
+    }
+
+    if (cache->entry_count > cache->bucket_count) {
+        grow_buckets(cache);
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+    return 0;
+}
+
+/* Snapshot the cache counters */
+void cf_odb_cache_get_stats(cf_odb_cache* cache, cf_odb_cache_stats* stats) {
+    pthread_mutex_lock(&cache->lock);
+    stats->hits = cache->hits;
+    stats->misses = cache->misses;
+    stats->evictions = cache->evictions;
+    stats->entries = cache->entry_count;
+    stats->bytes = cache->bytes;
+    stats->max_bytes = cache->max_bytes;
+    pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,519 @@
+/*
+ * Codefang Git Library - Rename Detection
+ *
+ * Tree diffs report a moved file as a deletion plus an addition. Pairing
+ * them with git_diff_find_similar would load and hash both blobs of every
+ * candidate pair on every commit, although a history walk keeps comparing
+ * the same blobs. Renames are paired natively after the tree diff instead:
+ * 1. Identical blobs pair by OID first, without reading any object
+ * 2. Other pairs are scored by hashsig similarity; signatures are cached by
+ *    blob OID across diffs and workers, so each blob is read and hashed once
+ * 3. Inexact matching is bounded like git's renameLimit, and pairs whose
+ *    sizes alone rule out the threshold are never compared
+ * 4. Pairs are assigned best score first, each file joining one rename
+ */
+
+#include "codefang_git.h"
+#include <git2/sys/hashsig.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Initial number of signature cache buckets (power of two, doubles with the entry count) */
+#define CF_RENAME_CACHE_INITIAL_BUCKETS 256
+
+/* pair_of value of a deleted file that became the source of a rename */
+#define CF_RENAME_SOURCE (-2)
+
+typedef struct cf_sig_entry {
+    git_oid oid;
+    git_hashsig* sig;               /* NULL if the blob cannot be compared */
+    size_t size;
+    int pins;                       /* Diffs currently using the entry */
+    int evicted;                    /* Out of the cache, freed on the last unpin */
+    struct cf_sig_entry* hnext;     /* Bucket chain */
+    struct cf_sig_entry* prev;      /* LRU list, head is most recently used */
+    struct cf_sig_entry* next;
+} cf_sig_entry;
+
+typedef struct {
+    pthread_mutex_t lock;
+    int threshold;                  /* Minimum similarity percent of an inexact rename */
+    size_t limit;                   /* Deleted or added files above which only exact renames are found */
+    size_t max_entries;
+    cf_sig_entry** buckets;
+    size_t bucket_count;
+    size_t entry_count;
+    cf_sig_entry* head;
+    cf_sig_entry* tail;
+} cf_rename_detector;
+
+/* Deleted or added file taking part in rename detection */
+typedef struct {
+    int delta;                      /* Index in the tree diff */
+    const git_oid* oid;
+    const char* path;
+    cf_sig_entry* entry;            /* Pinned signature, inexact matching only */
+} cf_rename_side;
+
+/* Scored source/target pair */
+typedef struct {
+    int score;
+    int src;
+    int tgt;
+} cf_rename_pair;
+
+static size_t sig_bucket_of(const cf_rename_detector* det, const git_oid* oid) {
+    uint64_t h;
+    memcpy(&h, oid->id, sizeof(h));
+    return (size_t)h & (det->bucket_count - 1);
+}
+
+static cf_sig_entry* find_sig_entry(const cf_rename_detector* det, const git_oid* oid) {
+    cf_sig_entry* e = det->buckets[sig_bucket_of(det, oid)];
+    while (e != NULL && memcmp(e->oid.id, oid->id, GIT_OID_RAWSZ) != 0) {
+        e = e->hnext;
+    }
+    return e;
+}
+
+static void sig_lru_unlink(cf_rename_detector* det, cf_sig_entry* e) {
+    if (e->prev) e->prev->next = e->next; else det->head = e->next;
+    if (e->next) e->next->prev = e->prev; else det->tail = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void sig_lru_push_front(cf_rename_detector* det, cf_sig_entry* e) {
+    e->prev = NULL;
+    e->next = det->head;
+    if (det->head) det->head->prev = e; else det->tail = e;
+    det->head = e;
+}
+
+static void free_sig_entry(cf_sig_entry* e) {
+    if (e->sig != NULL) {
+        git_hashsig_free(e->sig);
+    }
+    free(e);
+}
+
+/* Double the bucket array; on allocation failure chains just get longer */
+static void grow_sig_buckets(cf_rename_detector* det) {
+    size_t new_count = det->bucket_count * 2;
+    cf_sig_entry** grown = (cf_sig_entry**)calloc(new_count, sizeof(cf_sig_entry*));
+    if (grown == NULL) {
+        return;
+    }
+
+    cf_sig_entry** old = det->buckets;
+    size_t old_count = det->bucket_count;
+    det->buckets = grown;
+    det->bucket_count = new_count;
+
+    for (size_t i = 0; i < old_count; i++) {
+        cf_sig_entry* e = old[i];
+        while (e != NULL) {
+            cf_sig_entry* next = e->hnext;
+            size_t b = sig_bucket_of(det, &e->oid);
+            e->hnext = grown[b];
+            grown[b] = e;
+            e = next;
+        }
+    }
+    free(old);
+}
+
+/* Drop an entry from the cache; a pinned one is freed by its last unpin */
+static void evict_sig_entry(cf_rename_detector* det, cf_sig_entry* e) {
+    cf_sig_entry** link = &det->buckets[sig_bucket_of(det, &e->oid)];
+    while (*link != e) {
+        link = &(*link)->hnext;
+    }
+    *link = e->hnext;
+
+    sig_lru_unlink(det, e);
+    det->entry_count--;
+
+    if (e->pins > 0) {
+        e->evicted = 1;
+    } else {
+        free_sig_entry(e);
+    }
+}
+
+/*
+ * Create a detector. threshold (percent), limit and max_signatures fall back
+ * to the CF_RENAME_DEFAULT_* values when 0 or out of range; a negative limit
+ * allows exact renames only. Returns NULL on allocation failure.
+ */
+static cf_rename_detector* cf_rename_detector_new(int threshold, int limit, size_t max_signatures) {
+    cf_rename_detector* det = (cf_rename_detector*)calloc(1, sizeof(cf_rename_detector));
+    if (det == NULL) {
+        return NULL;
+    }
+
+    det->buckets = (cf_sig_entry**)calloc(CF_RENAME_CACHE_INITIAL_BUCKETS, sizeof(cf_sig_entry*));
+    if (det->buckets == NULL || pthread_mutex_init(&det->lock, NULL) != 0) {
+        free(det->buckets);
+        free(det);
+        return NULL;
+    }
+
+    det->bucket_count = CF_RENAME_CACHE_INITIAL_BUCKETS;
+    det->threshold = threshold > 0 && threshold <= 100 ? threshold : CF_RENAME_DEFAULT_THRESHOLD;
+    det->limit = limit > 0 ? (size_t)limit : limit < 0 ? 0 : CF_RENAME_DEFAULT_LIMIT;
+    det->max_entries = max_signatures > 0 ? max_signatures : CF_RENAME_DEFAULT_SIGNATURES;
+    return det;
+}
+
+/* Free a detector and its signatures. No diff may be using it. */
+static void cf_rename_detector_free(cf_rename_detector* det) {
+    if (det == NULL) {
+        return;
+    }
+    while (det->head != NULL) {
+        evict_sig_entry(det, det->head);
+    }
+    pthread_mutex_destroy(&det->lock);
+    free(det->buckets);
+    free(det);
+}
+
+/*
+ * Compute the signature of a blob. Empty, unreadable and too large blobs
+ * get none and never match inexactly.
+ */
+static cf_sig_entry* compute_sig_entry(cf_odb_cache* cache, git_odb* odb, const git_oid* oid) {
+    cf_sig_entry* e = (cf_sig_entry*)calloc(1, sizeof(cf_sig_entry));
+    if (e == NULL) {
+        return NULL;
+    }
+    git_oid_cpy(&e->oid, oid);
+
+    if (odb == NULL || cf_blob_too_large(odb, oid, &e->size)) {
+        return e;
+    }
+
+    git_odb_object* obj = NULL;
+    if (cf_odb_cache_read(&obj, cache, odb, oid) != 0) {
+        return e;
+    }
+
+    e->size = git_odb_object_size(obj);
+    if (e->size > 0 &&
+        git_hashsig_create(&e->sig, (const char*)git_odb_object_data(obj), e->size,
+                           GIT_HASHSIG_SMART_WHITESPACE | GIT_HASHSIG_ALLOW_SMALL_FILES) != 0) {
+        e->sig = NULL;
+    }
+    git_odb_object_free(obj);
+    return e;
+}
+
+/*
+ * Pin the cached signature of every side, computing the missing ones
+ * unlocked. Only the cache lookups and inserts hold the lock.
+ */
+static int pin_signatures(cf_rename_detector* det, git_repository* repo, cf_rename_side* sides, int count) {
+    int missing = 0;
+
+    pthread_mutex_lock(&det->lock);
+    for (int i = 0; i < count; i++) {
+        cf_sig_entry* e = find_sig_entry(det, sides[i].oid);
+        if (e != NULL) {
+            e->pins++;
+            sig_lru_unlink(det, e);
+            sig_lru_push_front(det, e);
+        } else {
+            missing++;
+        }
+        sides[i].entry = e;
+    }
+    pthread_mutex_unlock(&det->lock);
+
+    if (missing == 0) {
+        return CF_OK;
+    }
+
+    git_odb* odb = NULL;
+    if (git_repository_odb(&odb, repo) != 0) {
+        odb = NULL;
+    }
+    cf_odb_cache* cache = cf_odb_cache_acquire(repo);
+    int ret = CF_OK;
+
+    for (int i = 0; i < count; i++) {
+        if (sides[i].entry != NULL) {
+            continue;
+        }
+
+        cf_sig_entry* e = compute_sig_entry(cache, odb, sides[i].oid);
+        if (e == NULL) {
+            ret = CF_ERR_NOMEM;
+            break;
+        }
+
+        pthread_mutex_lock(&det->lock);
+
+        /* Another diff (or an earlier side) may have cached it meanwhile */
+        cf_sig_entry* existing = find_sig_entry(det, &e->oid);
+        if (existing != NULL) {
+            free_sig_entry(e);
+            e = existing;
+            sig_lru_unlink(det, e);
+        } else {
+            size_t b = sig_bucket_of(det, &e->oid);
+            e->hnext = det->buckets[b];
+            det->buckets[b] = e;
+            det->entry_count++;
+        }
+        e->pins++;
+        sig_lru_push_front(det, e);
+        sides[i].entry = e;
+
+        while (det->entry_count > det->max_entries && det->tail != e) {
+            evict_sig_entry(det, det->tail);
+        }
+        if (det->entry_count > det->bucket_count) {
+            grow_sig_buckets(det);
+        }
+
+        pthread_mutex_unlock(&det->lock);
+    }
+
+    cf_odb_cache_free(cache);
+    if (odb != NULL) {
+        git_odb_free(odb);
+    }
+    return ret;
+}
+
+static void unpin_signatures(cf_rename_detector* det, cf_rename_side* sides, int count) {
+    pthread_mutex_lock(&det->lock);
+    for (int i = 0; i < count; i++) {
+        cf_sig_entry* e = sides[i].entry;
+        if (e != NULL && --e->pins == 0 && e->evicted) {
+            free_sig_entry(e);
+        }
+        sides[i].entry = NULL;
+    }
+    pthread_mutex_unlock(&det->lock);
+}
+
+/* Regular files, executables and symlinks can be renamed */
+static int rename_candidate_mode(uint16_t mode) {
+    uint16_t type = mode & 0170000;
+    return type == 0100000 || type == 0120000;
+}
+
+static int compare_sides_by_oid(const void* a, const void* b) {
+    const cf_rename_side* x = (const cf_rename_side*)a;
+    const cf_rename_side* y = (const cf_rename_side*)b;
+    int c = memcmp(x->oid->id, y->oid->id, GIT_OID_RAWSZ);
+    return c != 0 ? c : x->delta - y->delta;
+}
+
+/* Best score first; ties go to the earlier target, then the earlier source */
+static int compare_rename_pairs(const void* a, const void* b) {
+    const cf_rename_pair* x = (const cf_rename_pair*)a;
+    const cf_rename_pair* y = (const cf_rename_pair*)b;
+    if (x->score != y->score) return y->score - x->score;
+    if (x->tgt != y->tgt) return x->tgt - y->tgt;
+    return x->src - y->src;
+}
+
+static const char* base_name(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash != NULL ? slash + 1 : path;
+}
+
+/*
+ * Pair the deleted (sources) with the added (targets) files that share a
+ * blob, like git preferring a source with the same file name. Sources are
+ * sorted by OID; matched sides get delta -1.
+ */
+static int pair_exact_renames(cf_rename_side* srcs, int src_count, cf_rename_side* tgts, int tgt_count, int* pair_of) {
+    int found = 0;
+
+    qsort(srcs, (size_t)src_count, sizeof(cf_rename_side), compare_sides_by_oid);
+
+    for (int same_name = 1; same_name >= 0; same_name--) {
+        for (int t = 0; t < tgt_count; t++) {
+            if (tgts[t].delta < 0) {
+                continue;
+            }
+
+            int lo = 0, hi = src_count;
+            while (lo < hi) {
+                int mid = lo + (hi - lo) / 2;
+                if (memcmp(srcs[mid].oid->id, tgts[t].oid->id, GIT_OID_RAWSZ) < 0) lo = mid + 1; else hi = mid;
+            }
+
+            for (int s = lo; s < src_count && memcmp(srcs[s].oid->id, tgts[t].oid->id, GIT_OID_RAWSZ) == 0; s++) {
+                if (srcs[s].delta < 0 ||
+                    (same_name && strcmp(base_name(srcs[s].path), base_name(tgts[t].path)) != 0)) {
+                    continue;
+                }
+                pair_of[tgts[t].delta] = srcs[s].delta;
+                pair_of[srcs[s].delta] = CF_RENAME_SOURCE;
+                srcs[s].delta = -1;
+                tgts[t].delta = -1;
+                found++;
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+/* Drop the matched (delta -1) sides, keeping order */
+static int compact_sides(cf_rename_side* sides, int count) {
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        if (sides[i].delta >= 0) {
+            sides[n++] = sides[i];
+        }
+    }
+    return n;
+}
+
+/* Score every source/target pair that can reach the threshold and assign the best ones */
+static int pair_similar_renames(
+    const cf_rename_detector* det,
+    const cf_rename_side* srcs,
+    int src_count,
+    const cf_rename_side* tgts,
+    int tgt_count,
+    int* pair_of
+) {
+    size_t cap = 0, n = 0;
+    cf_rename_pair* pairs = NULL;
+    int found = 0;
+
+    for (int t = 0; t < tgt_count; t++) {
+        const cf_sig_entry* te = tgts[t].entry;
+        if (te->sig == NULL) {
+            continue;
+        }
+
+        for (int s = 0; s < src_count; s++) {
+            const cf_sig_entry* se = srcs[s].entry;
+            if (se->sig == NULL) {
+                continue;
+            }
+
+            /* Similarity cannot exceed the ratio of the sizes */
+            size_t lo = se->size < te->size ? se->size : te->size;
+            size_t hi = se->size < te->size ? te->size : se->size;
+            if ((double)lo * 100.0 < (double)hi * (double)det->threshold) {
+                continue;
+            }
+
+            int score = git_hashsig_compare(se->sig, te->sig);
+            if (score < det->threshold) {
+                continue;
+            }
+
+            if (n == cap) {
+                size_t grown_cap = cap ? cap * 2 : 64;
+                cf_rename_pair* grown = (cf_rename_pair*)realloc(pairs, grown_cap * sizeof(cf_rename_pair));
+                if (grown == NULL) {
+                    free(pairs);
+                    return CF_ERR_NOMEM;
+                }
+                pairs = grown;
+                cap = grown_cap;
+            }
+            pairs[n].score = score;
+            pairs[n].src = s;
+            pairs[n].tgt = t;
+            n++;
+        }
+    }
+
+    if (n > 1) {
+        qsort(pairs, n, sizeof(cf_rename_pair), compare_rename_pairs);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        int src_delta = srcs[pairs[i].src].delta;
+        int tgt_delta = tgts[pairs[i].tgt].delta;
+        if (pair_of[src_delta] != -1 || pair_of[tgt_delta] != -1) {
+            continue;
+        }
+        pair_of[tgt_delta] = src_delta;
+        pair_of[src_delta] = CF_RENAME_SOURCE;
+        found++;
+    }
+
+    free(pairs);
+    return found;
+}
+
+/*
+ * Find the renames of a tree diff. pair_of (one per delta) is set to the
+ * delta index of the rename source for added files that became renames,
+ * CF_RENAME_SOURCE for the deleted files they came from and -1 otherwise.
+ * Returns the number of renames or CF_ERR_NOMEM.
+ */
+static int cf_detect_renames(cf_rename_detector* det, git_repository* repo, const git_diff* diff, int* pair_of) {
+    size_t num_deltas = git_diff_num_deltas(diff);
+    int src_count = 0, tgt_count = 0;
+
+    for (size_t i = 0; i < num_deltas; i++) {
+        const git_diff_delta* delta = git_diff_get_delta(diff, i);
+        pair_of[i] = -1;
+        if (delta->status == GIT_DELTA_DELETED && rename_candidate_mode(delta->old_file.mode)) {
+            src_count++;
+        } else if (delta->status == GIT_DELTA_ADDED && rename_candidate_mode(delta->new_file.mode)) {
+            tgt_count++;
+        }
+    }
+    if (src_count == 0 || tgt_count == 0) {
+        return 0;
+    }
+
+    cf_rename_side* srcs = (cf_rename_side*)calloc((size_t)src_count, sizeof(cf_rename_side));
+    cf_rename_side* tgts = (cf_rename_side*)calloc((size_t)tgt_count, sizeof(cf_rename_side));
+    if (srcs == NULL || tgts == NULL) {
+        free(srcs);
+        free(tgts);
+        return CF_ERR_NOMEM;
+    }
+
+    int s = 0, t = 0;
+    for (size_t i = 0; i < num_deltas; i++) {
+        const git_diff_delta* delta = git_diff_get_delta(diff, i);
+        if (delta->status == GIT_DELTA_DELETED && rename_candidate_mode(delta->old_file.mode)) {
+            srcs[s].delta = (int)i;
+            srcs[s].path = delta->old_file.path;
+            srcs[s++].oid = &delta->old_file.id;
+        } else if (delta->status == GIT_DELTA_ADDED && rename_candidate_mode(delta->new_file.mode)) {
+            tgts[t].delta = (int)i;
+            tgts[t].path = delta->new_file.path;
+            tgts[t++].oid = &delta->new_file.id;
+        }
+    }
+
+    int found = pair_exact_renames(srcs, src_count, tgts, tgt_count, pair_of);
+    src_count = compact_sides(srcs, src_count);
+    tgt_count = compact_sides(tgts, tgt_count);
+
+    /* Like git's renameLimit: refactors too large for the pairwise search keep exact renames only */
+    if (src_count > 0 && tgt_count > 0 &&
+        (size_t)src_count * (size_t)tgt_count <= det->limit * det->limit) {
+        int ret = pin_signatures(det, repo, srcs, src_count);
+        if (ret == CF_OK) {
+            ret = pin_signatures(det, repo, tgts, tgt_count);
+        }
+        if (ret == CF_OK) {
+            ret = pair_similar_renames(det, srcs, src_count, tgts, tgt_count, pair_of);
+        }
+        unpin_signatures(det, srcs, src_count);
+        unpin_signatures(det, tgts, tgt_count);
+        found = ret < 0 ? ret : found + ret;
+    }
+
+    free(srcs);
+    free(tgts);
+    return found;
+}
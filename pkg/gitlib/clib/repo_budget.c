@@ -0,0 +1,362 @@
+/*
+ * Codefang Git Library - Per-Repository Budgets
+ *
+ * libgit2's pack window and object cache limits are process-wide, so when
+ * one process analyzes many repositories a single large one can take the
+ * whole mapped-pack budget and keep it. A budget groups the handles opened
+ * on one repository and bounds what they hold:
+ * 1. A window share: the blob bytes read through the handles are charged
+ *    by the caller after every batch call; past the share, a release of the
+ *    group's pack windows is due
+ * 2. A cache share: the group's handles read through an object cache of
+ *    their own, sized for the repository
+ * 3. A fleet-wide limit on mapped pack bytes and open pack files across all
+ *    repositories, set through libgit2's mwindow limits: past it, libgit2
+ *    closes the least recently used windows, those of cold repositories
+ *    first
+ *
+ * libgit2 neither reports mapped bytes per repository nor unmaps the windows
+ * of an object database that is still in use, and it shares open packs
+ * between all object databases of a path. Blob bytes read therefore stand in
+ * for the pages faulted in, and windows are released by dropping the object
+ * databases of all of the group's handles at a point where the caller knows
+ * none of them is in use (cf_repo_budget_release_windows), then reopening
+ * one for them. The packs are unmapped unless handles outside the group
+ * still read them. Charging never touches the handles, so it is safe from
+ * any thread.
+ */
+
+#include "codefang_git.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct cf_repo_budget {
+    atomic_int refs;
+    cf_repo_limits limits;
+    cf_odb_cache* cache;
+
+    /* Under budget_lock */
+    uint64_t batches;
+    uint64_t bytes_inflated;
+    uint64_t peak_bytes;
+    uint64_t window_bytes;          /* Charged since the windows were last released */
+    uint64_t window_closes;
+    uint64_t last_used_ns;
+    uint64_t handles;
+    struct cf_repo_budget* next;    /* Registry of live budgets */
+};
+
+/* Repository handle -> budget */
+typedef struct cf_budget_binding {
+    git_repository* repo;
+    cf_repo_budget* budget;
+    struct cf_budget_binding* next;
+} cf_budget_binding;
+
+static pthread_mutex_t budget_lock = PTHREAD_MUTEX_INITIALIZER;
+static cf_budget_binding* budget_bindings = NULL;
+static cf_repo_budget* budgets = NULL;
+
+/* libgit2 mwindow limits in force before a fleet limit replaced them (under budget_lock) */
+typedef struct {
+    int get_opt;
+    int set_opt;
+    int saved;
+    size_t previous;
+} cf_fleet_limit;
+
+static cf_fleet_limit fleet_mapped = {GIT_OPT_GET_MWINDOW_MAPPED_LIMIT, GIT_OPT_SET_MWINDOW_MAPPED_LIMIT, 0, 0};
+static cf_fleet_limit fleet_files = {GIT_OPT_GET_MWINDOW_FILE_LIMIT, GIT_OPT_SET_MWINDOW_FILE_LIMIT, 0, 0};
+
+/* Bindings exist; lets batch charges skip the lock when budgets are unused */
+static atomic_int budget_binding_count;
+
+static cf_budget_binding* find_binding(git_repository* repo) {
+    cf_budget_binding* b = budget_bindings;
+    while (b != NULL && b->repo != repo) {
+        b = b->next;
+    }
+    return b;
+}
+
+/* Open an object database on the objects directory of repo */
+static int open_objects_odb(git_odb** out, git_repository* repo) {
+    const char* commondir = git_repository_commondir(repo);
+    if (commondir == NULL) {
+        return CF_ERR_LOOKUP;
+    }
+
+    size_t dir_len = strlen(commondir);
+    char* objects_path = (char*)malloc(dir_len + sizeof("/objects"));
+    if (objects_path == NULL) {
+        return CF_ERR_NOMEM;
+    }
+    memcpy(objects_path, commondir, dir_len);
+    if (dir_len > 0 && objects_path[dir_len - 1] == '/') {
+        dir_len--;
+    }
+    memcpy(objects_path + dir_len, "/objects", sizeof("/objects"));
+
+    int err = git_odb_open(out, objects_path);
+    free(objects_path);
+    return err == 0 ? CF_OK : CF_ERR_LOOKUP;
+}
+
+/*
+ * Install value as a libgit2 mwindow limit, or restore the limit it replaced
+ * when value is 0 (under budget_lock)
+ */
+static int set_fleet_limit(cf_fleet_limit* limit, size_t value) {
+    if (value == 0) {
+        if (!limit->saved) {
+            return CF_OK;
+        }
+        value = limit->previous;
+        limit->saved = 0;
+    } else if (!limit->saved) {
+        int err = git_libgit2_opts(limit->get_opt, &limit->previous);
+        if (err != 0) {
+            return err;
+        }
+        limit->saved = 1;
+    }
+
+    return git_libgit2_opts(limit->set_opt, value);
+}
+
+/*
+ * Create a budget with the given limits. The caller owns one reference.
+ * Returns NULL on allocation failure.
+ */
+cf_repo_budget* cf_repo_budget_new(const cf_repo_limits* limits) {
+    cf_repo_budget* budget = (cf_repo_budget*)calloc(1, sizeof(cf_repo_budget));
+    if (budget == NULL) {
+        return NULL;
+    }
+
+    budget->limits = *limits;
+    if (limits->cache_bytes > 0 && (budget->cache = cf_odb_cache_new(limits->cache_bytes)) == NULL) {
+        free(budget);
+        return NULL;
+    }
+    atomic_init(&budget->refs, 1);
+
+    pthread_mutex_lock(&budget_lock);
+    budget->last_used_ns = cf_stats_now();
+    budget->next = budgets;
+    budgets = budget;
+    pthread_mutex_unlock(&budget_lock);
+
+    return budget;
+}
+
+/*
+ * Drop a reference to the budget. The last one, taken once every handle is
+ * detached, unregisters it and releases its cache. Safe to call with NULL.
+ */
+void cf_repo_budget_free(cf_repo_budget* budget) {
+    if (budget == NULL || atomic_fetch_sub_explicit(&budget->refs, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    pthread_mutex_lock(&budget_lock);
+    cf_repo_budget** link = &budgets;
+    while (*link != budget) {
+        link = &(*link)->next;
+    }
+    *link = budget->next;
+    pthread_mutex_unlock(&budget_lock);
+
+    cf_odb_cache_free(budget->cache);
+    free(budget);
+}
+
+/*
+ * Attach a budget to a repository handle, replacing any previous one, and the
+ * budget's object cache if it has one. NULL detaches the handle, and its
+ * object cache if that is the budget's. Detach before freeing the handle.
+ */
+int cf_repo_budget_attach(git_repository* repo, cf_repo_budget* budget) {
+    cf_repo_budget* previous = NULL;
+    int ret = CF_OK;
+
+    pthread_mutex_lock(&budget_lock);
+
+    cf_budget_binding** link = &budget_bindings;
+    while (*link != NULL && (*link)->repo != repo) {
+        link = &(*link)->next;
+    }
+
+    if (*link != NULL) {
+        cf_budget_binding* binding = *link;
+        previous = binding->budget;
+        previous->handles--;
+        if (budget != NULL) {
+            binding->budget = budget;
+        } else {
+            *link = binding->next;
+            free(binding);
+            atomic_fetch_sub_explicit(&budget_binding_count, 1, memory_order_relaxed);
+        }
+    } else if (budget != NULL) {
+        cf_budget_binding* binding = (cf_budget_binding*)malloc(sizeof(cf_budget_binding));
+        if (binding == NULL) {
+            ret = CF_ERR_NOMEM;
+        } else {
+            binding->repo = repo;
+            binding->budget = budget;
+            binding->next = budget_bindings;
+            budget_bindings = binding;
+            atomic_fetch_add_explicit(&budget_binding_count, 1, memory_order_relaxed);
+        }
+    }
+
+    if (ret == CF_OK && budget != NULL) {
+        budget->handles++;
+        atomic_fetch_add_explicit(&budget->refs, 1, memory_order_relaxed);
+    }
+
+    pthread_mutex_unlock(&budget_lock);
+
+    if (ret == CF_OK && budget != NULL && budget->cache != NULL) {
+        ret = cf_odb_cache_attach(repo, budget->cache);
+    } else if (ret == CF_OK && budget == NULL && previous != NULL && previous->cache != NULL) {
+        cf_odb_cache* attached = cf_odb_cache_acquire(repo);
+        if (attached == previous->cache) {
+            cf_odb_cache_attach(repo, NULL);
+        }
+        cf_odb_cache_free(attached);
+    }
+
+    cf_repo_budget_free(previous);
+    return ret;
+}
+
+/*
+ * Charge a finished batch call on repo to its budget, if any. Only updates
+ * the accounting, so it may run on any thread; the release of the windows
+ * it makes due is left to the caller.
+ */
+void cf_repo_budget_charge(git_repository* repo, const cf_batch_cost* cost) {
+    if (atomic_load_explicit(&budget_binding_count, memory_order_relaxed) == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&budget_lock);
+    cf_budget_binding* binding = find_binding(repo);
+    if (binding != NULL) {
+        cf_repo_budget* budget = binding->budget;
+        budget->batches++;
+        budget->bytes_inflated += cost->bytes_inflated;
+        budget->window_bytes += cost->bytes_inflated;
+        budget->last_used_ns = cf_stats_now();
+        if (cost->peak_bytes > budget->peak_bytes) {
+            budget->peak_bytes = cost->peak_bytes;
+        }
+    }
+    pthread_mutex_unlock(&budget_lock);
+}
+
+/*
+ * Release the pack windows of all handles attached to budget: move each to
+ * an empty object database, so that their own ones are freed and the packs
+ * only they read are unmapped, then give them one freshly opened on the
+ * repository. None of the handles may be in use while this runs. If the
+ * reopen fails, the handles are left on the empty database and lookups
+ * through them fail until they are reopened.
+ * Returns CF_OK, CF_ERR_NOMEM or CF_ERR_LOOKUP.
+ */
+int cf_repo_budget_release_windows(cf_repo_budget* budget) {
+    int ret = CF_OK;
+    git_odb* empty = NULL;
+
+    pthread_mutex_lock(&budget_lock);
+
+    git_repository* first = NULL;
+    for (cf_budget_binding* b = budget_bindings; b != NULL; b = b->next) {
+        if (b->budget == budget) {
+            first = b->repo;
+            break;
+        }
+    }
+
+    if (first != NULL && git_odb_new(&empty) != 0) {
+        ret = CF_ERR_NOMEM;
+    }
+    for (cf_budget_binding* b = budget_bindings; ret == CF_OK && first != NULL && b != NULL; b = b->next) {
+        if (b->budget == budget && git_repository_set_odb(b->repo, empty) != 0) {
+            ret = CF_ERR_LOOKUP;
+        }
+    }
+
+    git_odb* fresh = NULL;
+    if (ret == CF_OK && first != NULL) {
+        ret = open_objects_odb(&fresh, first);
+    }
+    for (cf_budget_binding* b = budget_bindings; ret == CF_OK && first != NULL && b != NULL; b = b->next) {
+        if (b->budget != budget) {
+            continue;
+        }
+        if (git_repository_set_odb(b->repo, fresh) != 0) {
+            ret = CF_ERR_LOOKUP;
+        }
+        cf_pack_locator_forget(b->repo);
+    }
+
+    if (ret == CF_OK) {
+        budget->window_bytes = 0;
+        budget->window_closes++;
+    }
+
+    pthread_mutex_unlock(&budget_lock);
+
+    git_odb_free(fresh);
+    git_odb_free(empty);
+    return ret;
+}
+
+/*
+ * Bound the pack bytes mapped by libgit2 across all repositories
+ * (GIT_OPT_SET_MWINDOW_MAPPED_LIMIT). 0 restores the limit in force before.
+ * Returns 0 or a libgit2 error code.
+ */
+int cf_repo_budget_set_fleet_limit(size_t window_bytes) {
+    pthread_mutex_lock(&budget_lock);
+    int ret = set_fleet_limit(&fleet_mapped, window_bytes);
+    pthread_mutex_unlock(&budget_lock);
+    return ret;
+}
+
+/*
+ * Bound the pack files kept open by libgit2 across all repositories
+ * (GIT_OPT_SET_MWINDOW_FILE_LIMIT). 0 restores the limit in force before.
+ * Returns 0 or a libgit2 error code.
+ */
+int cf_repo_budget_set_fleet_file_limit(size_t files) {
+    pthread_mutex_lock(&budget_lock);
+    int ret = set_fleet_limit(&fleet_files, files);
+    pthread_mutex_unlock(&budget_lock);
+    return ret;
+}
+
+/* Snapshot the accounting of a budget */
+void cf_repo_budget_get_stats(cf_repo_budget* budget, cf_repo_budget_stats* stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    pthread_mutex_lock(&budget_lock);
+    stats->batches = budget->batches;
+    stats->bytes_inflated = budget->bytes_inflated;
+    stats->peak_bytes = budget->peak_bytes;
+    stats->window_bytes = budget->window_bytes;
+    stats->window_closes = budget->window_closes;
+    stats->handles = budget->handles;
+    stats->idle_ns = cf_stats_now() - budget->last_used_ns;
+    stats->release_due = budget->limits.window_bytes > 0 && budget->window_bytes > budget->limits.window_bytes;
+    pthread_mutex_unlock(&budget_lock);
+
+    if (budget->cache != NULL) {
+        cf_odb_cache_get_stats(budget->cache, &stats->cache);
+    }
+}
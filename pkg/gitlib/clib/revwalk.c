@@ -0,0 +1,334 @@
+/*
+ * Codefang Git Library - Batched Commit Walk
+ *
+ * Enumerating history through git2go costs a cgo call per commit and a
+ * full git_commit lookup (object, cache entry, parsed signatures and
+ * message) before the caller has even decided to look at it. This walk
+ * returns the metadata of many commits per call instead:
+ * 1. libgit2's revwalk does the sorting, parents and commit times come from
+ *    the commit-graph file when the repository has one
+ * 2. Commit objects are read raw from the ODB and only the header lines up
+ *    to "committer" are parsed; the message is never touched
+ * 3. Parent OIDs and signature strings go into caller-owned arenas, so a
+ *    batch costs no allocations on either side
+ * 4. The since filter is applied here, so skipping commits stays in C
+ */
+
+#include "codefang_git.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CF_OID_HEX_LEN 40
+
+struct cf_revwalk {
+    git_revwalk* walk;
+    git_odb* odb;
+    cf_revwalk_options opts;
+    git_oid pending;        /* Commit that did not fit the last batch */
+    int has_pending;
+    int done;
+    int failed;             /* The walk ended with an error rather than GIT_ITEROVER */
+};
+
+/* A byte range of the raw commit */
+typedef struct {
+    const char* data;
+    size_t len;
+} cf_span;
+
+/* A signature line before its strings are copied into the arena */
+typedef struct {
+    cf_span name;
+    cf_span email;
+    int64_t time;
+    int32_t offset;
+} cf_raw_sig;
+
+int cf_revwalk_new(cf_revwalk** out, git_repository* repo, const git_oid* start, const cf_revwalk_options* opts) {
+    cf_revwalk* w = (cf_revwalk*)calloc(1, sizeof(cf_revwalk));
+    if (w == NULL) {
+        return CF_ERR_NOMEM;
+    }
+
+    if (git_revwalk_new(&w->walk, repo) != 0 || git_repository_odb(&w->odb, repo) != 0) {
+        cf_revwalk_free(w);
+        return CF_ERR_LOOKUP;
+    }
+
+    if (opts != NULL) {
+        w->opts = *opts;
+    }
+
+    if (git_revwalk_sorting(w->walk, w->opts.sort) != 0) {
+        cf_revwalk_free(w);
+        return CF_ERR_LOOKUP;
+    }
+
+    if (w->opts.first_parent) {
+        git_revwalk_simplify_first_parent(w->walk);
+    }
+
+    int err = start != NULL ? git_revwalk_push(w->walk, start) : git_revwalk_push_head(w->walk);
+    if (err != 0) {
+        cf_revwalk_free(w);
+        return CF_ERR_LOOKUP;
+    }
+
+    *out = w;
+    return CF_OK;
+}
+
+void cf_revwalk_free(cf_revwalk* walk) {
+    if (walk == NULL) {
+        return;
+    }
+    git_odb_free(walk->odb);
+    git_revwalk_free(walk->walk);
+    free(walk);
+}
+
+/* Last occurrence of c in [data, data + len), or NULL */
+static const char* find_last(const char* data, size_t len, char c) {
+    while (len > 0) {
+        len--;
+        if (data[len] == c) {
+            return data + len;
+        }
+    }
+    return NULL;
+}
+
+/* Parse a decimal number, advancing *p. Returns 0 if there are no digits. */
+static int parse_decimal(const char** p, const char* end, int64_t* value) {
+    const char* s = *p;
+    int64_t v = 0;
+
+    while (s < end && *s >= '0' && *s <= '9') {
+        v = v * 10 + (*s - '0');
+        s++;
+    }
+    if (s == *p) {
+        return 0;
+    }
+    *value = v;
+    *p = s;
+    return 1;
+}
+
+/*
+ * Parse "Name <email> 1700000000 +0100" as libgit2 does: the email is
+ * delimited by the last '<' and '>', a missing or malformed time is zero.
+ */
+static int parse_signature(const char* line, const char* end, cf_raw_sig* sig) {
+    const char* email_end = find_last(line, (size_t)(end - line), '>');
+    if (email_end == NULL) {
+        return -1;
+    }
+    const char* email_start = find_last(line, (size_t)(email_end - line), '<');
+    if (email_start == NULL) {
+        return -1;
+    }
+
+    const char* name_start = line;
+    const char* name_end = email_start;
+    while (name_start < name_end && *name_start == ' ') {
+        name_start++;
+    }
+    while (name_end > name_start && name_end[-1] == ' ') {
+        name_end--;
+    }
+
+    sig->name.data = name_start;
+    sig->name.len = (size_t)(name_end - name_start);
+    sig->email.data = email_start + 1;
+    sig->email.len = (size_t)(email_end - email_start - 1);
+    sig->time = 0;
+    sig->offset = 0;
+
+    const char* p = email_end + 1;
+    while (p < end && *p == ' ') {
+        p++;
+    }
+    if (!parse_decimal(&p, end, &sig->time)) {
+        return 0;
+    }
+    while (p < end && *p == ' ') {
+        p++;
+    }
+    if (p < end && (*p == '+' || *p == '-')) {
+        int negative = *p == '-';
+        int64_t hhmm = 0;
+
+        p++;
+        if (parse_decimal(&p, end, &hhmm)) {
+            int32_t minutes = (int32_t)((hhmm / 100) * 60 + hhmm % 100);
+            sig->offset = negative ? -minutes : minutes;
+        }
+    }
+    return 0;
+}
+
+/* If the line at *p starts with key, point *value at the rest of it and advance *p past it */
+static int header_line(const char** p, const char* end, const char* key, const char** value, const char** value_end) {
+    size_t key_len = strlen(key);
+    size_t avail = (size_t)(end - *p);
+
+    if (avail <= key_len || memcmp(*p, key, key_len) != 0 || (*p)[key_len] != ' ') {
+        return 0;
+    }
+
+    const char* start = *p + key_len + 1;
+    const char* nl = (const char*)memchr(start, '\n', (size_t)(end - start));
+    if (nl == NULL) {
+        return 0;
+    }
+
+    *value = start;
+    *value_end = nl;
+    *p = nl + 1;
+    return 1;
+}
+
+static int parse_oid_line(const char* value, const char* value_end, git_oid* oid) {
+    if (value_end - value != CF_OID_HEX_LEN) {
+        return -1;
+    }
+    return git_oid_fromstrn(oid, value, CF_OID_HEX_LEN);
+}
+
+/* Append a string to the arena (space was checked by the caller) */
+static cf_arena_str arena_put(cf_commit_batch* batch, size_t* used, cf_span s) {
+    cf_arena_str out = {(uint32_t)*used, (uint32_t)s.len};
+
+    memcpy(batch->strings + *used, s.data, s.len);
+    *used += s.len;
+    return out;
+}
+
+/*
+ * Parse the header of a raw commit into the next slot of batch. Returns
+ * CF_OK, CF_ERR_ARENA_FULL if it does not fit the remaining buffer space,
+ * or CF_ERR_LOOKUP if the header is malformed.
+ */
+static int parse_commit(const git_oid* oid, const char* data, size_t size, cf_commit_batch* batch, int64_t* author_time) {
+    const char* p = data;
+    const char* end = data + size;
+    const char* value;
+    const char* value_end;
+    cf_commit_info* info = &batch->commits[batch->commit_count];
+    size_t parents = 0;
+    cf_raw_sig author;
+    cf_raw_sig committer;
+
+    if (!header_line(&p, end, "tree", &value, &value_end) || parse_oid_line(value, value_end, &info->tree_oid) != 0) {
+        return CF_ERR_LOOKUP;
+    }
+
+    /* Parents go straight into the free part of the parent array */
+    while (header_line(&p, end, "parent", &value, &value_end)) {
+        size_t slot = batch->parent_count + parents;
+        git_oid parent;
+
+        if (parse_oid_line(value, value_end, &parent) != 0) {
+            return CF_ERR_LOOKUP;
+        }
+        if (slot < batch->parent_cap) {
+            git_oid_cpy(&batch->parents[slot], &parent);
+        }
+        parents++;
+    }
+
+    if (!header_line(&p, end, "author", &value, &value_end) || parse_signature(value, value_end, &author) != 0) {
+        return CF_ERR_LOOKUP;
+    }
+    if (!header_line(&p, end, "committer", &value, &value_end) || parse_signature(value, value_end, &committer) != 0) {
+        return CF_ERR_LOOKUP;
+    }
+
+    size_t strings = author.name.len + author.email.len + committer.name.len + committer.email.len;
+    if (batch->parent_count + parents > batch->parent_cap || batch->string_len + strings > batch->string_cap ||
+        batch->string_len + strings > UINT32_MAX) {
+        return CF_ERR_ARENA_FULL;
+    }
+
+    size_t used = batch->string_len;
+
+    git_oid_cpy(&info->oid, oid);
+    info->parent_start = (uint32_t)batch->parent_count;
+    info->parent_count = (uint32_t)parents;
+    info->author.name = arena_put(batch, &used, author.name);
+    info->author.email = arena_put(batch, &used, author.email);
+    info->author.time = author.time;
+    info->author.offset = author.offset;
+    info->committer.name = arena_put(batch, &used, committer.name);
+    info->committer.email = arena_put(batch, &used, committer.email);
+    info->committer.time = committer.time;
+    info->committer.offset = committer.offset;
+
+    batch->parent_count += parents;
+    batch->string_len = used;
+    *author_time = author.time;
+    return CF_OK;
+}
+
+int cf_revwalk_next_batch(cf_revwalk* walk, cf_commit_batch* batch) {
+    batch->commit_count = 0;
+    batch->parent_count = 0;
+    batch->string_len = 0;
+
+    while (!walk->done && batch->commit_count < batch->commit_cap) {
+        git_oid oid;
+
+        if (walk->has_pending) {
+            git_oid_cpy(&oid, &walk->pending);
+            walk->has_pending = 0;
+        } else {
+            int err = git_revwalk_next(&oid, walk->walk);
+            if (err == GIT_ITEROVER) {
+                walk->done = 1;
+                break;
+            }
+            if (err != 0) {
+                walk->done = 1;
+                walk->failed = 1;
+                break;
+            }
+        }
+
+        git_odb_object* obj = NULL;
+        if (cf_odb_cache_read(&obj, NULL, walk->odb, &oid) != 0) {
+            continue;
+        }
+
+        int64_t author_time = 0;
+        int err = git_odb_object_type(obj) == GIT_OBJECT_COMMIT
+                      ? parse_commit(&oid, (const char*)git_odb_object_data(obj), git_odb_object_size(obj), batch,
+                                     &author_time)
+                      : CF_ERR_LOOKUP;
+        git_odb_object_free(obj);
+
+        if (err == CF_ERR_ARENA_FULL) {
+            git_oid_cpy(&walk->pending, &oid);
+            walk->has_pending = 1;
+            if (batch->commit_count == 0) {
+                return CF_ERR_ARENA_FULL;
+            }
+            break;
+        }
+        if (err != CF_OK) {
+            continue;
+        }
+
+        if (walk->opts.has_since && author_time < walk->opts.since) {
+            walk->done = 1;
+            break;
+        }
+        batch->commit_count++;
+    }
+    cf_alloc_batch_end();
+
+    if (batch->commit_count == 0 && walk->failed) {
+        return CF_ERR_LOOKUP;
+    }
+    return (int)batch->commit_count;
+}
@@ -0,0 +1,103 @@
+/*
+ * Codefang Git Library - Hot-Path Statistics
+ *
+ * Process-wide counters and latency histograms for the batch calls, so the
+ * time spent reading objects versus diffing them can be seen from Go:
+ * 1. Relaxed atomics only; nothing here orders other memory
+ * 2. Call sites add per object or per diff, never per line or op
+ * 3. Latencies go into log2 buckets starting at CF_STATS_LATENCY_BASE_NS
+ * 4. cf_get_stats takes a snapshot; counters only ever grow
+ */
+
+#include "codefang_git.h"
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    atomic_uint_fast64_t count;
+    atomic_uint_fast64_t sum_ns;
+    atomic_uint_fast64_t buckets[CF_STATS_LATENCY_BUCKETS];
+} cf_latency_counters;
+
+static atomic_uint_fast64_t cf_counters[CF_STAT_COUNT];
+static cf_latency_counters cf_latencies[CF_LATENCY_COUNT];
+
+uint64_t cf_stats_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void cf_stats_add(cf_stat stat, uint64_t value) {
+    atomic_fetch_add_explicit(&cf_counters[stat], value, memory_order_relaxed);
+}
+
+/* Bucket i holds latencies below CF_STATS_LATENCY_BASE_NS << i */
+static int latency_bucket(uint64_t ns) {
+    uint64_t scaled = ns / CF_STATS_LATENCY_BASE_NS;
+    if (scaled == 0) {
+        return 0;
+    }
+
+    int bucket = 64 - __builtin_clzll(scaled);
+    return bucket < CF_STATS_LATENCY_BUCKETS ? bucket : CF_STATS_LATENCY_BUCKETS - 1;
+}
+
+void cf_stats_record(cf_latency latency, uint64_t start_ns) {
+    uint64_t now = cf_stats_now();
+    uint64_t ns = now > start_ns ? now - start_ns : 0;
+    cf_latency_counters* l = &cf_latencies[latency];
+
+    atomic_fetch_add_explicit(&l->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&l->sum_ns, ns, memory_order_relaxed);
+    atomic_fetch_add_explicit(&l->buckets[latency_bucket(ns)], 1, memory_order_relaxed);
+}
+
+static void snapshot_latency(cf_latency latency, cf_latency_stats* out) {
+    const cf_latency_counters* l = &cf_latencies[latency];
+
+    out->count = atomic_load_explicit(&l->count, memory_order_relaxed);
+    out->sum_ns = atomic_load_explicit(&l->sum_ns, memory_order_relaxed);
+    for (int i = 0; i < CF_STATS_LATENCY_BUCKETS; i++) {
+        out->buckets[i] = atomic_load_explicit(&l->buckets[i], memory_order_relaxed);
+    }
+}
+
+void cf_cost_add(cf_batch_cost* cost, const cf_batch_cost* part) {
+    cost->bytes_inflated += part->bytes_inflated;
+    cost->bytes_copied += part->bytes_copied;
+    cost->inflate_ns += part->inflate_ns;
+    cost->diff_ns += part->diff_ns;
+    cost->peak_bytes += part->peak_bytes;
+}
+
+/*
+ * Snapshot all statistics. Counters are read one by one while other
+ * threads keep adding, so a snapshot is only consistent per counter.
+ */
+void cf_get_stats(cf_stats* out) {
+    memset(out, 0, sizeof(*out));
+
+    uint64_t counters[CF_STAT_COUNT];
+    for (int i = 0; i < CF_STAT_COUNT; i++) {
+        counters[i] = atomic_load_explicit(&cf_counters[i], memory_order_relaxed);
+    }
+
+    out->objects_read = counters[CF_STAT_OBJECTS_READ];
+    out->bytes_inflated = counters[CF_STAT_BYTES_INFLATED];
+    out->preload_dedups = counters[CF_STAT_PRELOAD_DEDUPS];
+    out->diffs = counters[CF_STAT_DIFFS];
+    out->diff_ops = counters[CF_STAT_DIFF_OPS];
+    out->op_buffer_grows = counters[CF_STAT_OP_BUFFER_GROWS];
+    out->op_arena_bytes = counters[CF_STAT_OP_ARENA_BYTES];
+    out->tree_diffs = counters[CF_STAT_TREE_DIFFS];
+    out->tree_deltas = counters[CF_STAT_TREE_DELTAS];
+    out->pool_allocs = counters[CF_STAT_POOL_ALLOCS];
+    out->pool_fallbacks = counters[CF_STAT_POOL_FALLBACKS];
+    out->pool_bytes = counters[CF_STAT_POOL_BYTES];
+
+    snapshot_latency(CF_LATENCY_OBJECT_READ, &out->object_read);
+    snapshot_latency(CF_LATENCY_DIFF, &out->diff);
+    snapshot_latency(CF_LATENCY_TREE_DIFF, &out->tree_diff);
+}
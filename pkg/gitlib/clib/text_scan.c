@@ -0,0 +1,310 @@
+/*
+ * Codefang Git Library - Text Scanning Kernels
+ *
+ * Newline counting and binary (NUL byte) detection run on every blob that
+ * crosses the batch APIs, so they are vectorized:
+ * 1. SSE2 baseline and AVX2 (selected at runtime) on x86-64
+ * 2. NEON on arm64
+ * 3. Scalar fallback everywhere else
+ *
+ * Newlines are counted with wide byte compares accumulated into 8-bit lane
+ * counters that are widened every 255 blocks, so there is no per-newline
+ * branch. cf_scan_text fuses both checks so each blob is read only once.
+ */
+
+#include "codefang_git.h"
+#include <stdatomic.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#define CF_SCAN_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define CF_SCAN_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Blocks accumulated in 8-bit lane counters before they could overflow */
+#define CF_SCAN_MAX_BLOCKS 255
+
+/*
+ * A scan kernel counts '\n' bytes in [p, p+n). When check_nul is set it
+ * stops early and sets *has_nul on the first NUL byte; the returned count
+ * is then meaningless.
+ */
+typedef size_t (*cf_scan_fn)(const unsigned char* p, size_t n, int check_nul, int* has_nul);
+
+/* Scalar kernel, also used for the tails of the vector kernels */
+static size_t scan_scalar(const unsigned char* p, size_t n, int check_nul, int* has_nul) {
+    size_t count = 0;
+
+    if (!check_nul) {
+        const unsigned char* end = p + n;
+        while (p < end) {
+            const unsigned char* newline = memchr(p, '\n', end - p);
+            if (newline == NULL) {
+                break;
+            }
+            count++;
+            p = newline + 1;
+        }
+        return count;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (p[i] == '\0') {
+            *has_nul = 1;
+            return count;
+        }
+        count += p[i] == '\n';
+    }
+    return count;
+}
+
+#ifdef CF_SCAN_X86
+static size_t scan_sse2(const unsigned char* p, size_t n, int check_nul, int* has_nul) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i zero = _mm_setzero_si128();
+    size_t count = 0;
+    size_t i = 0;
+
+    while (n - i >= 16) {
+        size_t blocks = (n - i) / 16;
+        if (blocks > CF_SCAN_MAX_BLOCKS) blocks = CF_SCAN_MAX_BLOCKS;
+
+        __m128i acc = zero;
+        __m128i nul_any = zero;
+        for (size_t b = 0; b < blocks; b++, i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+            /* Matching lanes are 0xFF (-1), so subtracting counts them */
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(v, newline));
+            if (check_nul) {
+                nul_any = _mm_or_si128(nul_any, _mm_cmpeq_epi8(v, zero));
+            }
+        }
+
+        if (check_nul && _mm_movemask_epi8(nul_any) != 0) {
+            *has_nul = 1;
+            return count;
+        }
+
+        __m128i sums = _mm_sad_epu8(acc, zero);
+        count += (size_t)_mm_cvtsi128_si64(sums) + (size_t)_mm_cvtsi128_si64(_mm_srli_si128(sums, 8));
+    }
+
+    return count + scan_scalar(p + i, n - i, check_nul, has_nul);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_avx2(const unsigned char* p, size_t n, int check_nul, int* has_nul) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i zero = _mm256_setzero_si256();
+    size_t count = 0;
+    size_t i = 0;
+
+    while (n - i >= 32) {
+        size_t blocks = (n - i) / 32;
+        if (blocks > CF_SCAN_MAX_BLOCKS) blocks = CF_SCAN_MAX_BLOCKS;
+
+        __m256i acc = zero;
+        __m256i nul_any = zero;
+        for (size_t b = 0; b < blocks; b++, i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+            acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(v, newline));
+            if (check_nul) {
+                nul_any = _mm256_or_si256(nul_any, _mm256_cmpeq_epi8(v, zero));
+            }
+        }
+
+        if (check_nul && !_mm256_testz_si256(nul_any, nul_any)) {
+            *has_nul = 1;
+            return count;
+        }
+
+        __m256i sums = _mm256_sad_epu8(acc, zero);
+        count += (size_t)_mm256_extract_epi64(sums, 0) + (size_t)_mm256_extract_epi64(sums, 1) +
+                 (size_t)_mm256_extract_epi64(sums, 2) + (size_t)_mm256_extract_epi64(sums, 3);
+    }
+
+    return count + scan_sse2(p + i, n - i, check_nul, has_nul);
+}
+#endif /* CF_SCAN_X86 */
+
+#ifdef CF_SCAN_NEON
+static size_t scan_neon(const unsigned char* p, size_t n, int check_nul, int* has_nul) {
+    const uint8x16_t newline = vdupq_n_u8('\n');
+    const uint8x16_t zero = vdupq_n_u8(0);
+    size_t count = 0;
+    size_t i = 0;
+
+    while (n - i >= 16) {
+        size_t blocks = (n - i) / 16;
+        if (blocks > CF_SCAN_MAX_BLOCKS) blocks = CF_SCAN_MAX_BLOCKS;
+
+        uint8x16_t acc = zero;
+        uint8x16_t nul_any = zero;
+        for (size_t b = 0; b < blocks; b++, i += 16) {
+            uint8x16_t v = vld1q_u8(p + i);
+            acc = vsubq_u8(acc, vceqq_u8(v, newline));
+            if (check_nul) {
+                nul_any = vorrq_u8(nul_any, vceqq_u8(v, zero));
+            }
+        }
+
+        if (check_nul && vmaxvq_u8(nul_any) != 0) {
+            *has_nul = 1;
+            return count;
+        }
+
+        count += vaddlvq_u8(acc);
+    }
+
+    return count + scan_scalar(p + i, n - i, check_nul, has_nul);
+}
+#endif /* CF_SCAN_NEON */
+
+/* Pick the widest kernel the running CPU supports */
+static cf_scan_fn select_scan_kernel(void) {
+#if defined(CF_SCAN_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return scan_avx2;
+    }
+    return scan_sse2;
+#elif defined(CF_SCAN_NEON)
+    return scan_neon;
+#else
+    return scan_scalar;
+#endif
+}
+
+/* Resolved on first use; every thread resolves to the same kernel */
+static _Atomic(cf_scan_fn) scan_kernel = NULL;
+
+static size_t scan_newlines(const char* data, size_t size, int check_nul, int* has_nul) {
+    cf_scan_fn fn = atomic_load_explicit(&scan_kernel, memory_order_relaxed);
+    if (fn == NULL) {
+        fn = select_scan_kernel();
+        atomic_store_explicit(&scan_kernel, fn, memory_order_relaxed);
+    }
+    return fn((const unsigned char*)data, size, check_nul, has_nul);
+}
+
+/*
+ * Count lines in a buffer.
+ *
+ * Matches Go's CountLines behavior:
+ * - Count number of '\n'
+ * - If last byte is not '\n', add 1
+ * - Empty buffer is 0 lines
+ */
+int cf_count_lines(const char* data, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+
+    int has_nul = 0;
+    size_t count = scan_newlines(data, size, 0, &has_nul);
+
+    /* If file doesn't end with newline, the last segment is a line too */
+    if (data[size - 1] != '\n') {
+        count++;
+    }
+
+    return (int)count;
+}
+
+/*
+ * Check if data appears to be binary.
+ *
+ * Checks for null bytes in the first CF_BINARY_CHECK_LEN bytes.
+ */
+int cf_is_binary(const char* data, size_t size) {
+    size_t check_len = size < CF_BINARY_CHECK_LEN ? size : CF_BINARY_CHECK_LEN;
+
+    if (check_len == 0) {
+        return 0;
+    }
+
+    int has_nul = 0;
+    scan_newlines(data, check_len, 1, &has_nul);
+    return has_nul;
+}
+
+/*
+ * Detect binary content and count lines in one pass.
+ *
+ * The first CF_BINARY_CHECK_LEN bytes are checked for NUL bytes and counted
+ * in the same sweep, and the rest of the buffer is only counted when the
+ * prefix is text. Returns 1 (with *line_count = 0) for binary data,
+ * otherwise 0 with the same line count as cf_count_lines.
+ */
+int cf_scan_text(const char* data, size_t size, int* line_count) {
+    *line_count = 0;
+
+    if (size == 0) {
+        return 0;
+    }
+
+    size_t check_len = size < CF_BINARY_CHECK_LEN ? size : CF_BINARY_CHECK_LEN;
+    int has_nul = 0;
+
+    size_t count = scan_newlines(data, check_len, 1, &has_nul);
+    if (has_nul) {
+        return 1;
+    }
+
+    count += scan_newlines(data + check_len, size - check_len, 0, &has_nul);
+    if (data[size - 1] != '\n') {
+        count++;
+    }
+
+    *line_count = (int)count;
+    return 0;
+}
+
+/*
+ * Incremental scan for blobs too large to hold whole. The first
+ * CF_BINARY_CHECK_LEN bytes are checked for NUL bytes as they arrive, so
+ * chunk boundaries do not change the result.
+ */
+void cf_text_scanner_init(cf_text_scanner* scan) {
+    memset(scan, 0, sizeof(*scan));
+}
+
+void cf_text_scanner_update(cf_text_scanner* scan, const char* data, size_t size) {
+    if (scan->is_binary || size == 0) {
+        return;
+    }
+
+    size_t check_len = 0;
+    if (scan->scanned < CF_BINARY_CHECK_LEN) {
+        check_len = CF_BINARY_CHECK_LEN - scan->scanned;
+        if (check_len > size) {
+            check_len = size;
+        }
+    }
+
+    int has_nul = 0;
+    scan->newlines += scan_newlines(data, check_len, 1, &has_nul);
+    if (has_nul) {
+        scan->is_binary = 1;
+        return;
+    }
+
+    scan->newlines += scan_newlines(data + check_len, size - check_len, 0, &has_nul);
+    scan->scanned += size;
+    scan->last = data[size - 1];
+}
+
+int cf_text_scanner_finish(const cf_text_scanner* scan, int* line_count) {
+    *line_count = 0;
+
+    if (scan->is_binary) {
+        return 1;
+    }
+    if (scan->scanned > 0) {
+        *line_count = (int)(scan->newlines + (scan->last != '\n'));
+    }
+    return 0;
+}
@@ -3,8 +3,8 @@
  */
 
 #include "codefang_git.h"
+#include <stdatomic.h>
 #include <stdlib.h>
-#include <string.h>
 #ifdef __GLIBC__
 #include <malloc.h>
 #endif
@@ -19,12 +19,95 @@
  */
 void cf_init() {
 #ifdef _OPENMP
-    // Disable nested parallelism by default to avoid thread oversubscription
-    // when running inside Go goroutines.
-    omp_set_num_threads(1);
+    // Batch calls size their teams explicitly from the shared thread budget.
+    // Disable dynamic adjustment and nested teams so a call never spawns
+    // more threads than it was granted.
+    omp_set_dynamic(0);
+    omp_set_max_active_levels(1);
 #endif
 }
 
+/*
+ * Process-wide thread budget for cf_batch_* calls.
+ *
+ * Every concurrent batch call (one per Go worker) reserves threads from the
+ * same budget, so the total number of threads clib runs at once never
+ * exceeds it no matter how many workers are active. A call that finds the
+ * budget exhausted still runs, sequentially, on its calling thread.
+ */
+#ifdef _OPENMP
+static atomic_int cf_thread_budget = 1;
+static atomic_int cf_threads_in_use = 0;
+#endif
+
+/*
+ * Set the maximum number of threads all batch calls may use at once.
+ * Returns the effective budget: always 1 in builds without OpenMP.
+ */
+int cf_set_parallelism(int max_threads) {
+#ifdef _OPENMP
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+    atomic_store_explicit(&cf_thread_budget, max_threads, memory_order_relaxed);
+    return max_threads;
+#else
+    (void)max_threads;
+    return 1;
+#endif
+}
+
+/*
+ * Reserve threads for a batch of work_items independent items.
+ *
+ * Grants at most one thread per CF_PARALLEL_MIN_ITEMS_PER_THREAD items and
+ * never more than the budget has spare, but always at least the calling
+ * thread. The grant must be returned with cf_release_threads.
+ */
+int cf_acquire_threads(int work_items) {
+#ifdef _OPENMP
+    int want = work_items / CF_PARALLEL_MIN_ITEMS_PER_THREAD;
+    int budget = atomic_load_explicit(&cf_thread_budget, memory_order_relaxed);
+    if (want > budget) want = budget;
+    if (want < 1) want = 1;
+
+    int in_use = atomic_load_explicit(&cf_threads_in_use, memory_order_relaxed);
+    for (;;) {
+        int grant = budget - in_use;
+        if (grant > want) grant = want;
+        if (grant < 1) grant = 1;
+
+        if (atomic_compare_exchange_weak_explicit(&cf_threads_in_use, &in_use, in_use + grant,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            return grant;
+        }
+    }
+#else
+    (void)work_items;
+    return 1;
+#endif
+}
+
+/* Return threads reserved with cf_acquire_threads to the budget */
+void cf_release_threads(int granted) {
+#ifdef _OPENMP
+    atomic_fetch_sub_explicit(&cf_threads_in_use, granted, memory_order_relaxed);
+#else
+    (void)granted;
+#endif
+}
+
+/* Process-wide large blob threshold, see cf_set_large_blob_threshold */
+static atomic_size_t cf_large_blob_limit = 0;
+
+void cf_set_large_blob_threshold(size_t bytes) {
+    atomic_store_explicit(&cf_large_blob_limit, bytes, memory_order_relaxed);
+}
+
+size_t cf_large_blob_threshold(void) {
+    return atomic_load_explicit(&cf_large_blob_limit, memory_order_relaxed);
+}
+
 /*
  * Configure libgit2 global memory limits.
  *
@@ -33,10 +116,14 @@ void cf_init() {
  * cache_max_size: maximum bytes for the global object cache (decompressed
  *   objects like commits, trees, blobs). Default is 256 MiB.
  *
- * Both are global settings shared across all repository handles.
+ * alloc_pool_size: address space of the pooled allocator for libgit2's
+ *   small allocations (alloc_pool.c); 0 keeps libgit2's allocator.
+ *
+ * All are global settings shared across all repository handles.
  * Must be called before opening repositories for full effect.
  */
-int cf_configure_memory(size_t mwindow_mapped_limit, size_t cache_max_size, int malloc_arena_max) {
+int cf_configure_memory(size_t mwindow_mapped_limit, size_t cache_max_size, int malloc_arena_max,
+                        size_t alloc_pool_size) {
     int err = 0;
     if (mwindow_mapped_limit > 0) {
         err = git_libgit2_opts(GIT_OPT_SET_MWINDOW_MAPPED_LIMIT, mwindow_mapped_limit);
@@ -56,67 +143,29 @@ int cf_configure_memory(size_t mwindow_mapped_limit, size_t cache_max_size, int
         mallopt(M_ARENA_MAX, malloc_arena_max);
     }
 #endif
-    return 0;
-}
-
-/*
- * Count lines in a buffer.
- *
- * Matches Go's CountLines behavior:
- * - Count number of '\n'
- * - If last byte is not '\n', add 1
- * - Empty buffer is 0 lines
- */
-int cf_count_lines(const char* data, size_t size) {
-    if (size == 0) {
-        return 0;
-    }
-
-    int count = 0;
-    const char* ptr = data;
-    const char* end = data + size;
-
-    while (ptr < end) {
-        // Optimized search for newline
-        const char* newline = memchr(ptr, '\n', end - ptr);
-        if (newline == NULL) {
-            break;
-        }
-        count++;
-        ptr = newline + 1;
-    }
-
-    /* If file doesn't end with newline, the last segment is a line too */
-    if (size > 0 && data[size - 1] != '\n') {
-        count++;
+    if (alloc_pool_size > 0) {
+        err = cf_alloc_pool_install(alloc_pool_size);
+        if (err != 0) return err;
     }
-
-    return count;
+    return 0;
 }
 
 /*
- * Check if data appears to be binary.
+ * Share the object database of source with repo.
  *
- * Checks for null bytes in the first CF_BINARY_CHECK_LEN bytes.
+ * Each git_repository otherwise opens its own git_odb with its own pack
+ * backends, pack index state and object cache, so N worker handles pay for
+ * N copies. git_odb is safe for concurrent use from several threads;
+ * git_repository_set_odb takes its own reference, so ours is dropped here.
  */
-int cf_is_binary(const char* data, size_t size) {
-    size_t check_len = size < CF_BINARY_CHECK_LEN ? size : CF_BINARY_CHECK_LEN;
-
-    if (check_len == 0) {
-        return 0;
-    }
-
-    // Quick check for common null byte binary indicator
-    const char* ptr = data;
-    const char* end = data + check_len;
-    while (ptr < end) {
-        if (*ptr == '\0') {
-            return 1;
-        }
-        ptr++;
-    }
-
-    return 0;
+int cf_repository_share_odb(git_repository* repo, git_repository* source) {
+    git_odb* odb = NULL;
+    int err = git_repository_odb(&odb, source);
+    if (err != 0) return err;
+
+    err = git_repository_set_odb(repo, odb);
+    git_odb_free(odb);
+    return err;
 }
 
 /*
@@ -144,7 +193,8 @@ void cf_free_diff_results(cf_diff_result* results, int count) {
 }
 
 /*
- * Initialize a diff result with pre-allocated ops array.
+ * Initialize a diff result, optionally pre-allocating the ops array.
+ * A capacity of 0 leaves ops NULL; batch diffs size it to the real op count.
  */
 int cf_init_diff_result(cf_diff_result* result, int capacity) {
     result->old_lines = 0;
@@ -152,8 +202,14 @@ int cf_init_diff_result(cf_diff_result* result, int capacity) {
     result->op_count = 0;
     result->op_capacity = capacity;
     result->error = 0;
+    result->ops = NULL;
+
+    if (capacity <= 0) {
+        result->op_capacity = 0;
+        return CF_OK;
+    }
 
-    result->ops = (cf_diff_op*)malloc(capacity * sizeof(cf_diff_op));
+    result->ops = (cf_diff_op*)malloc((size_t)capacity * sizeof(cf_diff_op));
     if (result->ops == NULL) {
         result->error = CF_ERR_NOMEM;
         return CF_ERR_NOMEM;
@@ -5,7 +5,6 @@ import (
 	"errors"
 	"fmt"
 	"io"
-	"time"
 
 	git2go "github.com/libgit2/git2go/v34"
 
@@ -18,9 +17,12 @@ var ErrParentNotFound = errors.New("parent commit not found")
 // errTestCommitNoTree is returned when attempting to get a tree from a test commit.
 var errTestCommitNoTree = errors.New("get commit tree: test commit has no tree")
 
-// Commit wraps a libgit2 commit.
+// Commit wraps a libgit2 commit. Commits produced by a CommitIter carry
+// the metadata read by its CommitWalk and look up the libgit2 commit only
+// when its message or native object is needed.
 type Commit struct {
 	commit   *git2go.Commit
+	info     *CommitInfo
 	repo     *Repository
 	testHash *Hash // used for testing when commit is nil.
 }
@@ -32,8 +34,25 @@ func NewCommitForTest(h Hash) *Commit {
 	}
 }
 
+// native returns the libgit2 commit, looking it up on first use for a
+// commit read by a CommitWalk. Nil for test doubles or if the lookup fails.
+func (c *Commit) native() *git2go.Commit {
+	if c.commit == nil && c.info != nil && c.repo != nil {
+		commit, err := c.repo.repo.LookupCommit(c.info.Hash.ToOid())
+		if err == nil {
+			c.commit = commit
+		}
+	}
+
+	return c.commit
+}
+
 // Hash returns the commit hash.
 func (c *Commit) Hash() Hash {
+	if c.info != nil {
+		return c.info.Hash
+	}
+
 	if c.commit == nil {
 		if c.testHash != nil {
 			return *c.testHash
@@ -47,6 +66,10 @@ func (c *Commit) Hash() Hash {
 
 // Author returns the commit author. Zero value when commit is a test double (nil internal).
 func (c *Commit) Author() Signature {
+	if c.info != nil {
+		return c.info.Author
+	}
+
 	if c.commit == nil {
 		return Signature{}
 	}
@@ -62,6 +85,10 @@ func (c *Commit) Author() Signature {
 
 // Committer returns the commit committer. Zero value when commit is a test double (nil internal).
 func (c *Commit) Committer() Signature {
+	if c.info != nil {
+		return c.info.Committer
+	}
+
 	if c.commit == nil {
 		return Signature{}
 	}
@@ -77,15 +104,20 @@ func (c *Commit) Committer() Signature {
 
 // Message returns the commit message. Empty when commit is a test double (nil internal).
 func (c *Commit) Message() string {
-	if c.commit == nil {
+	commit := c.native()
+	if commit == nil {
 		return ""
 	}
 
-	return c.commit.Message()
+	return commit.Message()
 }
 
 // NumParents returns the number of parent commits. Zero when commit is a test double (nil internal).
 func (c *Commit) NumParents() int {
+	if c.info != nil {
+		return len(c.info.Parents)
+	}
+
 	if c.commit == nil {
 		return 0
 	}
@@ -95,6 +127,19 @@ func (c *Commit) NumParents() int {
 
 // Parent returns the nth parent commit. ErrParentNotFound when commit is a test double (nil internal).
 func (c *Commit) Parent(n int) (*Commit, error) {
+	if c.info != nil {
+		if n < 0 || n >= len(c.info.Parents) {
+			return nil, ErrParentNotFound
+		}
+
+		parent, err := c.repo.repo.LookupCommit(c.info.Parents[n].ToOid())
+		if err != nil {
+			return nil, ErrParentNotFound
+		}
+
+		return &Commit{commit: parent, repo: c.repo}, nil
+	}
+
 	if c.commit == nil {
 		return nil, ErrParentNotFound
 	}
@@ -109,6 +154,14 @@ func (c *Commit) Parent(n int) (*Commit, error) {
 
 // ParentHash returns the hash of the nth parent. Zero hash when commit is a test double (nil internal).
 func (c *Commit) ParentHash(n int) Hash {
+	if c.info != nil {
+		if n < 0 || n >= len(c.info.Parents) {
+			return Hash{}
+		}
+
+		return c.info.Parents[n]
+	}
+
 	if c.commit == nil {
 		return Hash{}
 	}
@@ -118,6 +171,10 @@ func (c *Commit) ParentHash(n int) Hash {
 
 // TreeHash returns the hash of the tree associated with this commit. Zero when commit is a test double (nil internal).
 func (c *Commit) TreeHash() Hash {
+	if c.info != nil {
+		return c.info.Tree
+	}
+
 	if c.commit == nil {
 		return Hash{}
 	}
@@ -127,6 +184,15 @@ func (c *Commit) TreeHash() Hash {
 
 // Tree returns the tree associated with this commit. Error when commit is a test double (nil internal).
 func (c *Commit) Tree() (*Tree, error) {
+	if c.info != nil {
+		tree, err := c.repo.repo.LookupTree(c.info.Tree.ToOid())
+		if err != nil {
+			return nil, fmt.Errorf("get commit tree: %w", err)
+		}
+
+		return &Tree{tree: tree, repo: c.repo}, nil
+	}
+
 	if c.commit == nil {
 		return nil, errTestCommitNoTree
 	}
@@ -193,49 +259,50 @@ func (c *Commit) Free() {
 
 // Native returns the underlying libgit2 commit.
 func (c *Commit) Native() *git2go.Commit {
-	return c.commit
+	return c.native()
 }
 
-// CommitIter iterates over commits.
+// CommitIter iterates over commits. It reads commit metadata from a
+// CommitWalk in batches, so each Commit is served without a libgit2 lookup.
 type CommitIter struct {
-	walk  *git2go.RevWalk
+	walk  *CommitWalk
 	repo  *Repository
-	since *time.Time
+	batch []CommitInfo
+	pos   int
 }
 
-// Next returns the next commit in the iteration.
-func (ci *CommitIter) Next() (*Commit, error) {
-	if ci.walk == nil {
-		return nil, io.EOF
-	}
-
-	for {
-		oid := new(git2go.Oid)
-
-		err := ci.walk.Next(oid)
-		if err != nil {
-			ci.walk.Free()
-			ci.walk = nil
-
-			return nil, io.EOF
+// fill makes sure the current batch has a commit left, reading the next
+// batch if needed. Walk errors end the iteration like its end does.
+func (ci *CommitIter) fill() error {
+	for ci.pos == len(ci.batch) {
+		if ci.walk == nil {
+			return io.EOF
 		}
 
-		commit, err := ci.repo.repo.LookupCommit(oid)
+		batch, err := ci.walk.NextBatch(DefaultCommitWalkBatch)
 		if err != nil {
-			continue
+			ci.Close()
+
+			return io.EOF
 		}
 
-		// Check since filter.
-		if ci.since != nil && commit.Author().When.Before(*ci.since) {
-			commit.Free()
-			ci.walk.Free()
-			ci.walk = nil
+		ci.batch, ci.pos = batch, 0
+	}
 
-			return nil, io.EOF
-		}
+	return nil
+}
 
-		return &Commit{commit: commit, repo: ci.repo}, nil
+// Next returns the next commit in the iteration.
+func (ci *CommitIter) Next() (*Commit, error) {
+	err := ci.fill()
+	if err != nil {
+		return nil, err
 	}
+
+	info := &ci.batch[ci.pos]
+	ci.pos++
+
+	return &Commit{info: info, repo: ci.repo}, nil
 }
 
 // ForEach calls the callback for each commit.
@@ -272,41 +339,16 @@ func (ci *CommitIter) Skip(n int) error {
 	return nil
 }
 
-// skip1 advances the iterator by one commit without looking up the full object.
-// Returns [io.EOF] when the walk is exhausted. Respects the since filter.
+// skip1 advances the iterator by one commit without creating a Commit.
+// Returns [io.EOF] when the walk is exhausted. Respects the since filter,
+// which the walk applies natively.
 func (ci *CommitIter) skip1() error {
-	if ci.walk == nil {
-		return io.EOF
-	}
-
-	oid := new(git2go.Oid)
-
-	err := ci.walk.Next(oid)
+	err := ci.fill()
 	if err != nil {
-		ci.walk.Free()
-		ci.walk = nil
-
-		return io.EOF
+		return err
 	}
 
-	// When a since filter is active, we must look up the commit to check
-	// the author timestamp. This is slower but necessary for correctness.
-	if ci.since != nil {
-		commit, lookupErr := ci.repo.repo.LookupCommit(oid)
-		if lookupErr != nil {
-			return io.EOF
-		}
-
-		before := commit.Author().When.Before(*ci.since)
-		commit.Free()
-
-		if before {
-			ci.walk.Free()
-			ci.walk = nil
-
-			return io.EOF
-		}
-	}
+	ci.pos++
 
 	return nil
 }
@@ -314,7 +356,9 @@ func (ci *CommitIter) skip1() error {
 // Close releases resources.
 func (ci *CommitIter) Close() {
 	if ci.walk != nil {
-		ci.walk.Free()
+		ci.walk.Close()
 		ci.walk = nil
 	}
+
+	ci.batch, ci.pos = nil, 0
 }
@@ -0,0 +1,216 @@
+package gitlib
+
+/*
+#include <stdlib.h>
+#include "codefang_git.h"
+*/
+import "C"
+
+import (
+	"io"
+	"time"
+	"unsafe"
+
+	git2go "github.com/libgit2/git2go/v34"
+)
+
+// Default buffer sizes of a CommitWalk batch.
+const (
+	// DefaultCommitWalkBatch is the number of commits a CommitIter reads per call into C.
+	DefaultCommitWalkBatch = 256
+	// commitWalkParentsPerCommit is the initial parent array size per commit slot.
+	commitWalkParentsPerCommit = 2
+	// commitWalkStringsPerCommit is the initial string arena size per commit slot.
+	commitWalkStringsPerCommit = 96
+)
+
+// CommitInfo is the metadata of one commit as read by a CommitWalk.
+type CommitInfo struct {
+	Hash      Hash
+	Tree      Hash
+	Parents   []Hash
+	Author    Signature
+	Committer Signature
+}
+
+// CommitWalk enumerates history in batches of commit metadata. The C layer
+// parses only the commit headers, so no git2go commit is looked up and no
+// message is decoded while walking. Not safe for concurrent use; close the
+// walk before freeing its repository.
+type CommitWalk struct {
+	walk        *C.cf_revwalk
+	repo        *Repository
+	batch       C.cf_commit_batch
+	commitAlloc int
+	zones       map[int32]*time.Location
+}
+
+// WalkCommits starts a batched walk from HEAD with the same order and
+// filters as Log.
+func (r *Repository) WalkCommits(opts *LogOptions) (*CommitWalk, error) {
+	repoPtr := r.nativePtr()
+	if repoPtr == nil {
+		return nil, ErrRepositoryPointer
+	}
+
+	// Topological order ensures we never diff against a descendant; prevents
+	// negative burndown values when branches have different timestamps.
+	sortFlags := git2go.SortTime | git2go.SortTopological
+
+	var cOpts C.cf_revwalk_options
+
+	if opts != nil {
+		if opts.Reverse {
+			sortFlags |= git2go.SortReverse
+		}
+
+		if opts.FirstParent {
+			cOpts.first_parent = 1
+		}
+
+		if opts.Since != nil {
+			// Commit times are whole seconds: round up so that a commit is
+			// kept exactly when it is not before Since.
+			since := opts.Since.Unix()
+			if opts.Since.Nanosecond() > 0 {
+				since++
+			}
+
+			cOpts.has_since = 1
+			cOpts.since = C.int64_t(since)
+		}
+	}
+
+	cOpts.sort = C.uint(sortFlags)
+
+	w := &CommitWalk{repo: r, zones: make(map[int32]*time.Location)}
+
+	rc := C.cf_revwalk_new(&w.walk, (*C.git_repository)(repoPtr), nil, &cOpts)
+	if rc != C.CF_OK {
+		return nil, ErrCommitWalk
+	}
+
+	return w, nil
+}
+
+// NextBatch returns the metadata of up to limit further commits, or io.EOF
+// once the walk is over.
+func (w *CommitWalk) NextBatch(limit int) ([]CommitInfo, error) {
+	if w.walk == nil {
+		return nil, io.EOF
+	}
+
+	if limit <= 0 {
+		limit = DefaultCommitWalkBatch
+	}
+
+	w.reserve(limit, limit*commitWalkParentsPerCommit, limit*commitWalkStringsPerCommit)
+	w.batch.commit_cap = C.size_t(limit)
+
+	for {
+		rc := C.cf_revwalk_next_batch(w.walk, &w.batch)
+
+		switch {
+		case rc == C.CF_ERR_ARENA_FULL:
+			// The next commit alone does not fit: an octopus merge or huge
+			// signatures. Grow both arenas and retry it.
+			w.reserve(limit, int(w.batch.parent_cap)*2+1, int(w.batch.string_cap)*2)
+
+			continue
+		case rc < 0:
+			return nil, ErrCommitWalk
+		case rc == 0:
+			return nil, io.EOF
+		}
+
+		return w.decodeBatch(), nil
+	}
+}
+
+// reserve grows the batch buffers to at least the given capacities.
+func (w *CommitWalk) reserve(commits, parents, strings int) {
+	if commits > w.commitAlloc {
+		C.free(unsafe.Pointer(w.batch.commits))
+		w.batch.commits = (*C.cf_commit_info)(C.malloc(C.size_t(commits) * C.sizeof_cf_commit_info))
+		w.commitAlloc = commits
+	}
+
+	if parents > int(w.batch.parent_cap) {
+		C.free(unsafe.Pointer(w.batch.parents))
+		w.batch.parents = (*C.git_oid)(C.malloc(C.size_t(parents) * C.sizeof_git_oid))
+		w.batch.parent_cap = C.size_t(parents)
+	}
+
+	if strings > int(w.batch.string_cap) {
+		C.free(unsafe.Pointer(w.batch.strings))
+		w.batch.strings = (*C.char)(C.malloc(C.size_t(strings)))
+		w.batch.string_cap = C.size_t(strings)
+	}
+}
+
+// decodeBatch copies the filled batch into Go values. All strings of the
+// batch share one allocation, as do all parent hashes.
+func (w *CommitWalk) decodeBatch() []CommitInfo {
+	infos := unsafe.Slice(w.batch.commits, int(w.batch.commit_count))
+	cParents := unsafe.Slice(w.batch.parents, int(w.batch.parent_count))
+	arena := C.GoStringN(w.batch.strings, C.int(w.batch.string_len))
+
+	parents := make([]Hash, len(cParents))
+	for i := range cParents {
+		parents[i] = cOidToHash(&cParents[i].id)
+	}
+
+	out := make([]CommitInfo, len(infos))
+
+	for i := range infos {
+		info := &infos[i]
+		start := int(info.parent_start)
+		end := start + int(info.parent_count)
+
+		out[i] = CommitInfo{
+			Hash:      cOidToHash(&info.oid.id),
+			Tree:      cOidToHash(&info.tree_oid.id),
+			Parents:   parents[start:end:end],
+			Author:    w.signature(arena, &info.author),
+			Committer: w.signature(arena, &info.committer),
+		}
+	}
+
+	return out
+}
+
+func (w *CommitWalk) signature(arena string, sig *C.cf_commit_sig) Signature {
+	offset := int32(sig.offset)
+
+	zone, ok := w.zones[offset]
+	if !ok {
+		zone = time.FixedZone("", int(offset)*60)
+		w.zones[offset] = zone
+	}
+
+	return Signature{
+		Name:  arenaString(arena, sig.name),
+		Email: arenaString(arena, sig.email),
+		When:  time.Unix(int64(sig.time), 0).In(zone),
+	}
+}
+
+func arenaString(arena string, s C.cf_arena_str) string {
+	start := int(s.offset)
+
+	return arena[start : start+int(s.len)]
+}
+
+// Close releases the walk and its buffers. Safe to call more than once.
+func (w *CommitWalk) Close() {
+	if w.walk != nil {
+		C.cf_revwalk_free(w.walk)
+		w.walk = nil
+	}
+
+	C.free(unsafe.Pointer(w.batch.commits))
+	C.free(unsafe.Pointer(w.batch.parents))
+	C.free(unsafe.Pointer(w.batch.strings))
+	w.batch = C.cf_commit_batch{}
+	w.commitAlloc = 0
+}
@@ -0,0 +1,132 @@
+package gitlib_test
+
+import (
+	"context"
+	"errors"
+	"io"
+	"testing"
+	"time"
+
+	git2go "github.com/libgit2/git2go/v34"
+	"github.com/stretchr/testify/require"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
+)
+
+func TestCommitWalk_NextBatchMatchesLookup(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	tr.createFile("a.txt", "a")
+	base := tr.commit("base")
+
+	tr.createFile("b.txt", "b")
+	branch := tr.commitToRef("refs/heads/side", "side", base)
+
+	tr.createFile("c.txt", "c")
+	mainHash := tr.commit("main")
+	tr.createMergeCommit("merge", mainHash, branch)
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	walk, err := repo.WalkCommits(&gitlib.LogOptions{})
+	require.NoError(t, err)
+
+	defer walk.Close()
+
+	// Batches of two: the walk must carry on where the previous batch ended.
+	var infos []gitlib.CommitInfo
+
+	for {
+		batch, batchErr := walk.NextBatch(2)
+		if errors.Is(batchErr, io.EOF) {
+			break
+		}
+
+		require.NoError(t, batchErr)
+		require.LessOrEqual(t, len(batch), 2)
+
+		infos = append(infos, batch...)
+	}
+
+	require.Len(t, infos, 4)
+
+	for _, info := range infos {
+		commit, lookupErr := repo.LookupCommit(context.Background(), info.Hash)
+		require.NoError(t, lookupErr)
+
+		require.Equal(t, commit.TreeHash(), info.Tree)
+		require.Len(t, info.Parents, commit.NumParents())
+
+		for i, parent := range info.Parents {
+			require.Equal(t, commit.ParentHash(i), parent)
+		}
+
+		require.Equal(t, commit.Author().Name, info.Author.Name)
+		require.Equal(t, commit.Author().Email, info.Author.Email)
+		require.True(t, commit.Author().When.Equal(info.Author.When))
+		require.Equal(t, commit.Committer().Name, info.Committer.Name)
+		require.True(t, commit.Committer().When.Equal(info.Committer.When))
+
+		commit.Free()
+	}
+
+	_, err = walk.NextBatch(2)
+	require.ErrorIs(t, err, io.EOF)
+}
+
+func TestCommitWalk_SignatureTimeZone(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	tr.createFile("a.txt", "a")
+	headHash := tr.commit("init")
+
+	head, err := tr.native.LookupCommit(headHash.ToOid())
+	require.NoError(t, err)
+
+	defer head.Free()
+
+	tree, err := head.Tree()
+	require.NoError(t, err)
+
+	defer tree.Free()
+
+	when := time.Date(2024, 3, 1, 12, 0, 0, 0, time.FixedZone("", -(5*60+30)*60))
+	sig := &git2go.Signature{Name: "Zoned Author", Email: "zoned@example.com", When: when}
+
+	_, err = tr.native.CreateCommit("HEAD", sig, sig, "zoned", tree, head)
+	require.NoError(t, err)
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	iter, err := repo.Log(&gitlib.LogOptions{})
+	require.NoError(t, err)
+
+	defer iter.Close()
+
+	commit, err := iter.Next()
+	require.NoError(t, err)
+
+	author := commit.Author()
+	require.Equal(t, "Zoned Author", author.Name)
+	require.Equal(t, "zoned@example.com", author.Email)
+	require.True(t, when.Equal(author.When))
+
+	_, offset := author.When.Zone()
+	require.Equal(t, -(5*60+30)*60, offset)
+
+	// The message is only looked up on demand.
+	require.Equal(t, "zoned", commit.Message())
+	commit.Free()
+}
@@ -0,0 +1,64 @@
+package gitlib
+
+import (
+	"errors"
+	"fmt"
+	"strings"
+)
+
+// ErrUnknownDiffAlgorithm is returned when a diff algorithm name is not recognized.
+var ErrUnknownDiffAlgorithm = errors.New("unknown diff algorithm")
+
+// DiffAlgorithm selects the line matching algorithm used by BatchDiffBlobs.
+type DiffAlgorithm int
+
+// Diff algorithms.
+const (
+	// DiffAlgorithmMyers is git's default algorithm.
+	DiffAlgorithmMyers DiffAlgorithm = 0
+	// DiffAlgorithmMinimal makes Myers search for the smallest possible diff.
+	DiffAlgorithmMinimal DiffAlgorithm = 1
+	// DiffAlgorithmPatience anchors on unique lines and avoids Myers' worst
+	// case on large files with many changes.
+	DiffAlgorithmPatience DiffAlgorithm = 2
+	// DiffAlgorithmHistogram anchors on the least frequent lines, like git's
+	// histogram diff, falling back to Myers when every line is too common.
+	// Runs as patience unless ConfigureNativeLineDiff is on.
+	DiffAlgorithmHistogram DiffAlgorithm = 3
+)
+
+// DiffEngine identifies the implementation computing line diffs, so diffs
+// persisted across runs can be told apart from those of another engine.
+type DiffEngine int
+
+// Diff engines.
+const (
+	// DiffEngineLibgit2 diffs with libgit2's xdiff, the default.
+	DiffEngineLibgit2 DiffEngine = 1
+	// DiffEngineNative diffs with the C layer's native line engine (see
+	// ConfigureNativeLineDiff). Bump it when the engine's output changes.
+	DiffEngineNative DiffEngine = 2
+)
+
+var diffAlgorithmNames = map[string]DiffAlgorithm{
+	"myers":     DiffAlgorithmMyers,
+	"minimal":   DiffAlgorithmMinimal,
+	"patience":  DiffAlgorithmPatience,
+	"histogram": DiffAlgorithmHistogram,
+}
+
+// ParseDiffAlgorithm resolves a diff algorithm name (myers, minimal, patience,
+// histogram). An empty name selects Myers.
+func ParseDiffAlgorithm(name string) (DiffAlgorithm, error) {
+	normalized := strings.ToLower(strings.TrimSpace(name))
+	if normalized == "" {
+		return DiffAlgorithmMyers, nil
+	}
+
+	algorithm, ok := diffAlgorithmNames[normalized]
+	if !ok {
+		return DiffAlgorithmMyers, fmt.Errorf("%w: %s", ErrUnknownDiffAlgorithm, name)
+	}
+
+	return algorithm, nil
+}
@@ -0,0 +1,374 @@
+package gitlib_test
+
+import (
+	"bytes"
+	"context"
+	"errors"
+	"fmt"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"regexp"
+	"strconv"
+	"strings"
+	"testing"
+
+	"github.com/stretchr/testify/require"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
+)
+
+func TestParseDiffAlgorithm(t *testing.T) {
+	t.Parallel()
+
+	tests := []struct {
+		name     string
+		expected gitlib.DiffAlgorithm
+	}{
+		{"", gitlib.DiffAlgorithmMyers},
+		{"myers", gitlib.DiffAlgorithmMyers},
+		{"minimal", gitlib.DiffAlgorithmMinimal},
+		{" Patience ", gitlib.DiffAlgorithmPatience},
+		{"histogram", gitlib.DiffAlgorithmHistogram},
+	}
+
+	for _, tt := range tests {
+		algorithm, err := gitlib.ParseDiffAlgorithm(tt.name)
+		require.NoError(t, err, tt.name)
+		require.Equal(t, tt.expected, algorithm, tt.name)
+	}
+
+	_, err := gitlib.ParseDiffAlgorithm("bogus")
+	require.ErrorIs(t, err, gitlib.ErrUnknownDiffAlgorithm)
+}
+
+// diffRNG is a splitmix64 PRNG for deterministic inputs (math/rand triggers gosec G404).
+type diffRNG struct {
+	state uint64
+}
+
+func (r *diffRNG) intn(n int) int {
+	r.state += 0x9e3779b97f4a7c15
+	z := r.state
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9
+	z = (z ^ (z >> 27)) * 0x94d049bb133111eb
+
+	return int((z ^ (z >> 31)) % uint64(n))
+}
+
+// randomText builds lines drawn from a small alphabet, so most lines repeat.
+func (r *diffRNG) randomText(lines, alphabet int) []byte {
+	var buf bytes.Buffer
+
+	for range lines {
+		ending := "\n"
+		if r.intn(8) == 0 {
+			ending = "\r\n"
+		}
+
+		fmt.Fprintf(&buf, "L%d%s", r.intn(alphabet), ending)
+	}
+
+	if r.intn(4) == 0 && buf.Len() > 0 {
+		buf.Truncate(buf.Len() - 1)
+	}
+
+	return buf.Bytes()
+}
+
+// mutate deletes, replaces and inserts lines of text.
+func (r *diffRNG) mutate(text []byte, alphabet int) []byte {
+	var buf bytes.Buffer
+
+	for _, line := range bytes.SplitAfter(text, []byte("\n")) {
+		switch r.intn(10) {
+		case 0:
+		case 1:
+			fmt.Fprintf(&buf, "M%d\n", r.intn(alphabet))
+		case 2:
+			buf.Write(line)
+			fmt.Fprintf(&buf, "N%d\n", r.intn(alphabet))
+		default:
+			buf.Write(line)
+		}
+	}
+
+	return buf.Bytes()
+}
+
+type diffPair struct {
+	name     string
+	old, new []byte
+}
+
+// repeatedLinesPair returns blocks of unmatched lines separated by a line
+// repeated often enough that Myers discards it, unlike a minimal diff.
+func repeatedLinesPair() diffPair {
+	var oldText, newText strings.Builder
+
+	for i := range 20 {
+		for j := range 4 {
+			fmt.Fprintf(&oldText, "old %d %d\n", i, j)
+			fmt.Fprintf(&newText, "new %d %d\n", i, j)
+		}
+
+		oldText.WriteString("}\n")
+		newText.WriteString("}\n")
+	}
+
+	return diffPair{"repeated lines amid changes", []byte(oldText.String()), []byte(newText.String())}
+}
+
+// diffParityInputs returns fixtures for the edge cases of line matching plus
+// randomized pairs.
+func diffParityInputs() []diffPair {
+	sameRun := strings.Repeat("same\n", 300)
+	common := strings.Repeat("x\n", 100)
+
+	pairs := []diffPair{
+		{"empty old", nil, []byte("a\nb\n")},
+		{"empty new", []byte("a\nb\n"), nil},
+		{"no trailing newline", []byte("a\nb\nc"), []byte("a\nb\nc\n")},
+		{"no trailing newline both", []byte("a\nb"), []byte("a\nc")},
+		{"crlf", []byte("a\r\nb\r\nc\r\n"), []byte("a\nb\r\nc\n")},
+		{"identical run insert", []byte(sameRun), []byte(sameRun[:500] + "new\n" + sameRun[500:])},
+		{"identical run delete", []byte(sameRun + "tail\n"), []byte(sameRun[:1000] + "tail\n")},
+		{"duplicated block", []byte("a\nb\nc\n"), []byte("a\nb\na\nb\nc\n")},
+		{"histogram fallback", []byte(common + "y\n" + common), []byte(common + "z\n" + common + "x\n")},
+		{"histogram fallback interleaved", []byte(strings.Repeat("x\ny\n", 80)), []byte(strings.Repeat("y\nx\n", 80))},
+		repeatedLinesPair(),
+	}
+
+	rng := &diffRNG{state: 1}
+
+	for i := range 200 {
+		alphabet := 1 + rng.intn(12)
+		oldText := rng.randomText(1+rng.intn(60), alphabet)
+
+		newText := rng.mutate(oldText, alphabet)
+		if i%2 == 0 {
+			newText = rng.randomText(1+rng.intn(60), alphabet)
+		}
+
+		pairs = append(pairs, diffPair{fmt.Sprintf("random %d", i), oldText, newText})
+	}
+
+	for i := range 4 {
+		alphabet := 30
+		if i%2 == 1 {
+			alphabet = 4000
+		}
+
+		oldText := rng.randomText(3000, alphabet)
+		pairs = append(pairs, diffPair{fmt.Sprintf("large %d", i), oldText, rng.mutate(oldText, alphabet)})
+	}
+
+	return pairs
+}
+
+// diffOps diffs every pair with algorithm on the current engine.
+func diffOps(t *testing.T, bridge *gitlib.CGOBridge, pairs []diffPair, algorithm gitlib.DiffAlgorithm) [][]gitlib.DiffOp {
+	t.Helper()
+
+	requests := make([]gitlib.DiffRequest, len(pairs))
+	for i, pair := range pairs {
+		requests[i] = gitlib.DiffRequest{
+			OldHash: gitlib.Hash{0: 1}, NewHash: gitlib.Hash{0: 2},
+			OldData: pair.old, NewData: pair.new,
+			HasOld: pair.old != nil, HasNew: pair.new != nil,
+			Algorithm: algorithm,
+		}
+	}
+
+	results := bridge.BatchDiffBlobs(requests)
+	ops := make([][]gitlib.DiffOp, len(results))
+
+	for i := range results {
+		require.NoError(t, results[i].Error, pairs[i].name)
+		ops[i] = results[i].Ops
+	}
+
+	return ops
+}
+
+// TestConfigureNativeLineDiff_MatchesLibgit2 checks the native engine
+// produces the same ops as libgit2's git_diff_buffers for Myers and minimal.
+func TestConfigureNativeLineDiff_MatchesLibgit2(t *testing.T) { //nolint:paralleltest // Process-wide setting.
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	bridge := gitlib.NewCGOBridge(repo)
+	pairs := diffParityInputs()
+
+	defer gitlib.ConfigureNativeLineDiff(false)
+
+	for _, algorithm := range []gitlib.DiffAlgorithm{gitlib.DiffAlgorithmMyers, gitlib.DiffAlgorithmMinimal} {
+		gitlib.ConfigureNativeLineDiff(false)
+		want := diffOps(t, bridge, pairs, algorithm)
+
+		gitlib.ConfigureNativeLineDiff(true)
+		got := diffOps(t, bridge, pairs, algorithm)
+
+		for i := range pairs {
+			require.Equal(t, want[i], got[i], "algorithm %d, %s", algorithm, pairs[i].name)
+		}
+	}
+}
+
+// equalLines counts the lines ops keep.
+func equalLines(ops []gitlib.DiffOp) int {
+	count := 0
+
+	for _, op := range ops {
+		if op.Type == gitlib.DiffOpEqual {
+			count += op.LineCount
+		}
+	}
+
+	return count
+}
+
+// TestConfigureNativeLineDiff_MinimalKeepsRepeatedLines checks a minimal
+// diff matches the repeated lines a Myers diff discards, as xdiff does.
+func TestConfigureNativeLineDiff_MinimalKeepsRepeatedLines(t *testing.T) { //nolint:paralleltest // Process-wide setting.
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	bridge := gitlib.NewCGOBridge(repo)
+	pairs := []diffPair{repeatedLinesPair()}
+
+	gitlib.ConfigureNativeLineDiff(true)
+	defer gitlib.ConfigureNativeLineDiff(false)
+
+	myers := diffOps(t, bridge, pairs, gitlib.DiffAlgorithmMyers)[0]
+	minimal := diffOps(t, bridge, pairs, gitlib.DiffAlgorithmMinimal)[0]
+
+	// Myers only keeps the common last line; minimal keeps every "}".
+	require.Equal(t, 1, equalLines(myers))
+	require.Equal(t, 20, equalLines(minimal))
+	require.NotEqual(t, myers, minimal)
+}
+
+// gitHunkHeader matches the hunk line of a zero-context unified diff.
+var gitHunkHeader = regexp.MustCompile(`^@@ -(\d+)(?:,(\d+))? \+(\d+)(?:,(\d+))? @@`)
+
+// gitDiffOps diffs a pair with the git command line, which libgit2 cannot
+// do for histogram, and converts its hunks into run-length ops.
+func gitDiffOps(t *testing.T, dir string, pair diffPair, algorithm string) []gitlib.DiffOp {
+	t.Helper()
+
+	oldPath, newPath := filepath.Join(dir, "old"), filepath.Join(dir, "new")
+	require.NoError(t, os.WriteFile(oldPath, pair.old, 0o600))
+	require.NoError(t, os.WriteFile(newPath, pair.new, 0o600))
+
+	cmd := exec.CommandContext(context.Background(), "git", "-c", "diff.indentHeuristic=false",
+		"diff", "--no-index", "--no-color", "-U0", "--diff-algorithm="+algorithm, oldPath, newPath)
+	cmd.Env = append(os.Environ(), "HOME="+dir, "GIT_CONFIG_NOSYSTEM=1")
+
+	out, err := cmd.Output()
+
+	var exitErr *exec.ExitError
+	if err != nil && (!errors.As(err, &exitErr) || exitErr.ExitCode() != 1) {
+		require.NoError(t, err)
+	}
+
+	var ops []gitlib.DiffOp
+
+	push := func(opType gitlib.DiffOpType, count int) {
+		if count <= 0 {
+			return
+		}
+
+		if len(ops) > 0 && ops[len(ops)-1].Type == opType {
+			ops[len(ops)-1].LineCount += count
+
+			return
+		}
+
+		ops = append(ops, gitlib.DiffOp{Type: opType, LineCount: count})
+	}
+
+	hunkCount := func(s string) int {
+		if s == "" {
+			return 1
+		}
+
+		n, convErr := strconv.Atoi(s)
+		require.NoError(t, convErr)
+
+		return n
+	}
+
+	pos := 0
+
+	for _, line := range strings.Split(string(out), "\n") {
+		m := gitHunkHeader.FindStringSubmatch(line)
+		if m == nil {
+			continue
+		}
+
+		oldStart := hunkCount(m[1])
+		oldCount, newCount := hunkCount(m[2]), hunkCount(m[4])
+
+		start := oldStart - 1
+		if oldCount == 0 {
+			start = oldStart
+		}
+
+		push(gitlib.DiffOpEqual, start-pos)
+		push(gitlib.DiffOpDelete, oldCount)
+		push(gitlib.DiffOpInsert, newCount)
+		pos = start + oldCount
+	}
+
+	oldLines := bytes.Count(pair.old, []byte("\n"))
+	if len(pair.old) > 0 && pair.old[len(pair.old)-1] != '\n' {
+		oldLines++
+	}
+
+	push(gitlib.DiffOpEqual, oldLines-pos)
+
+	return ops
+}
+
+// TestConfigureNativeLineDiff_HistogramMatchesGit checks the native histogram
+// diff against git's, including the regions where it falls back to Myers.
+func TestConfigureNativeLineDiff_HistogramMatchesGit(t *testing.T) { //nolint:paralleltest // Process-wide setting.
+	if _, err := exec.LookPath("git"); err != nil {
+		t.Skip("git not installed")
+	}
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	pairs := diffParityInputs()
+
+	gitlib.ConfigureNativeLineDiff(true)
+	defer gitlib.ConfigureNativeLineDiff(false)
+
+	got := diffOps(t, gitlib.NewCGOBridge(repo), pairs, gitlib.DiffAlgorithmHistogram)
+	dir := t.TempDir()
+
+	for i, pair := range pairs {
+		if pair.old == nil || pair.new == nil || bytes.Equal(pair.old, pair.new) {
+			continue
+		}
+
+		require.Equal(t, gitDiffOps(t, dir, pair, "histogram"), got[i], pair.name)
+	}
+}
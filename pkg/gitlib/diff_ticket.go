@@ -0,0 +1,188 @@
+package gitlib
+
+/*
+#include "codefang_git.h"
+*/
+import "C"
+
+import (
+	"runtime"
+	"unsafe"
+)
+
+// DiffTicket is a diff batch running on the native diff worker of a
+// CGOBridge, started by SubmitDiffBatch. Until it is collected with Wait or
+// TryCollect, the bridge rejects other calls with ErrBridgeBusy and the
+// blob data of the requests must not change. Every ticket must be
+// collected. Not safe for concurrent use.
+type DiffTicket struct {
+	bridge    *CGOBridge
+	pinner    runtime.Pinner
+	cResults  []C.cf_diff_flat_result
+	positions bool
+	results   []DiffResult
+	cost      BatchCost
+}
+
+// SubmitDiffBatch starts computing the diffs of requests on the bridge's
+// native worker thread and returns at once, so the caller can consume the
+// previous batch while this one runs. The worker is started on first use
+// and holds one batch at a time: while the ticket is outstanding, further
+// submits and batch calls on the bridge fail with ErrBridgeBusy. With
+// positions set the results carry Positions as from
+// BatchDiffBlobsWithPositions.
+func (b *CGOBridge) SubmitDiffBatch(requests []DiffRequest, positions bool) *DiffTicket {
+	t := &DiffTicket{positions: positions}
+
+	if len(requests) == 0 {
+		return t
+	}
+
+	repoPtr, ptrErr := b.getRepoPtr()
+	if ptrErr != nil {
+		t.results = diffErrorResults(len(requests), ptrErr)
+
+		return t
+	}
+
+	worker := b.diffWorker(repoPtr)
+	if worker == nil {
+		t.results = diffErrorResults(len(requests), ErrDiffMemory)
+
+		return t
+	}
+
+	// The worker reads supplied blob data after this call returns, so it
+	// stays pinned until the ticket is collected.
+	cRequests := b.diffRequestsFor(requests, &t.pinner)
+	t.cResults = make([]C.cf_diff_flat_result, len(requests))
+
+	wantPositions := C.int(0)
+	if positions {
+		wantPositions = 1
+	}
+
+	rc := C.cf_submit_diff_batch(worker, &cRequests[0], C.int(len(requests)), wantPositions)
+	// The worker has its own copy of the requests.
+	clear(cRequests)
+
+	if rc != C.CF_OK {
+		t.pinner.Unpin()
+		t.cResults = nil
+		t.results = diffErrorResults(len(requests), ErrDiffMemory)
+
+		return t
+	}
+
+	t.bridge = b
+	b.inFlight = t
+
+	return t
+}
+
+// diffWorker returns the bridge's native diff worker, starting it for
+// repoPtr if needed. Returns nil if its thread could not be started.
+func (b *CGOBridge) diffWorker(repoPtr unsafe.Pointer) *C.cf_diff_worker {
+	if b.worker == nil {
+		b.worker = C.cf_diff_worker_new((*C.git_repository)(repoPtr))
+		if b.worker != nil {
+			b.workerCleanup = runtime.AddCleanup(b, freeDiffWorker, b.worker)
+		}
+	}
+
+	return b.worker
+}
+
+// freeDiffWorker stops a native diff worker and frees it.
+func freeDiffWorker(worker *C.cf_diff_worker) {
+	C.cf_diff_worker_free(worker)
+}
+
+// Free collects a still outstanding ticket and stops the bridge's native
+// diff worker. The bridge stays usable; a later SubmitDiffBatch starts a
+// new worker. Bridges that are not freed stop their worker when they are
+// garbage collected.
+func (b *CGOBridge) Free() {
+	if b.inFlight != nil {
+		b.inFlight.Wait()
+	}
+
+	if b.worker == nil {
+		return
+	}
+
+	b.workerCleanup.Stop()
+	freeDiffWorker(b.worker)
+	b.worker = nil
+}
+
+// Wait blocks until the batch is done and returns its results, one per
+// request in order.
+func (t *DiffTicket) Wait() []DiffResult {
+	t.collect(true)
+
+	return t.results
+}
+
+// TryCollect returns the results if the batch is done, without blocking.
+func (t *DiffTicket) TryCollect() ([]DiffResult, bool) {
+	if !t.collect(false) {
+		return nil, false
+	}
+
+	return t.results, true
+}
+
+// Cost returns what the batch spent in C, once it is collected. Collecting
+// also makes it the bridge's LastCost.
+func (t *DiffTicket) Cost() BatchCost {
+	return t.cost
+}
+
+// collect moves the results of a finished batch to Go and hands the
+// repository handle back to the bridge. Reports false if the batch is
+// still running and wait is not set.
+func (t *DiffTicket) collect(wait bool) bool {
+	if t.bridge == nil {
+		return true
+	}
+
+	var (
+		cOps     *C.cf_diff_op
+		cPos     *C.cf_diff_op_pos
+		cOpCount C.size_t
+		cCost    C.cf_batch_cost
+		rc       C.int
+	)
+
+	outPos := &cPos
+	if !t.positions {
+		outPos = nil
+	}
+
+	worker := t.bridge.worker
+	if wait {
+		rc = C.cf_wait_diff_batch(worker, &cOps, outPos, &cOpCount, &t.cResults[0], &cCost)
+	} else {
+		rc = C.cf_try_collect_diff_batch(worker, &cOps, outPos, &cOpCount, &t.cResults[0], &cCost)
+	}
+
+	if rc == C.CF_PENDING {
+		return false
+	}
+
+	bridge := t.bridge
+	t.bridge = nil
+	bridge.inFlight = nil
+
+	t.pinner.Unpin()
+	t.cost = newBatchCost(&cCost, len(t.cResults))
+	bridge.lastCost = t.cost
+	t.results = takeFlatDiffResults(cOps, cPos, cOpCount, t.cResults)
+	t.cResults = nil
+
+	// Charged by the collecting goroutine, not the worker thread.
+	C.cf_repo_budget_charge((*C.git_repository)(bridge.repo.nativePtr()), &cCost)
+
+	return true
+}
@@ -0,0 +1,101 @@
+package gitlib
+
+/*
+#include "codefang_git.h"
+*/
+import "C"
+
+import (
+	"time"
+)
+
+// LatencyHistogram is the latency distribution of one native operation.
+// Buckets[i] counts latencies below LatencyBucketBound(i); the last bucket
+// counts everything above the bound before it.
+type LatencyHistogram struct {
+	Count   int64
+	Sum     time.Duration
+	Buckets []int64
+}
+
+// NativeStats is a snapshot of the process-wide hot-path counters of the C
+// layer. All counters only grow; subtract two snapshots to measure a span.
+type NativeStats struct {
+	// ObjectsRead counts objects read from the object database; hits of an
+	// ObjectCache are not included.
+	ObjectsRead int64
+	// BytesInflated is the decompressed size of those objects.
+	BytesInflated int64
+	// PreloadDedups counts blob IDs requested more than once in a diff batch.
+	PreloadDedups int64
+	// Diffs and DiffOps count line diffs computed and the ops they emitted.
+	Diffs   int64
+	DiffOps int64
+	// OpBufferGrows counts reallocations of the per-thread diff op buffers.
+	OpBufferGrows int64
+	// OpArenaBytes is the total size of the op arenas built by diff batches.
+	OpArenaBytes int64
+	// TreeDiffs and TreeDeltas count tree diffs and the changes they kept.
+	TreeDiffs  int64
+	TreeDeltas int64
+	// PoolAllocs and PoolFallbacks count libgit2 allocations the pooled
+	// allocator served and passed to malloc; PoolBytes is the slab memory
+	// it carved. All stay zero unless the pool is installed.
+	PoolAllocs    int64
+	PoolFallbacks int64
+	PoolBytes     int64
+
+	ObjectRead LatencyHistogram
+	Diff       LatencyHistogram
+	TreeDiff   LatencyHistogram
+}
+
+// LatencyBucketCount is the number of buckets of every LatencyHistogram.
+const LatencyBucketCount = int(C.CF_STATS_LATENCY_BUCKETS)
+
+// LatencyBucketBound returns the exclusive upper bound of histogram bucket i.
+// The last bucket has no bound; its value is only a label.
+func LatencyBucketBound(i int) time.Duration {
+	return time.Duration(uint64(C.CF_STATS_LATENCY_BASE_NS) << uint(i))
+}
+
+// ReadNativeStats snapshots the C layer's counters and latency histograms in
+// a single CGO call.
+func ReadNativeStats() NativeStats {
+	var cStats C.cf_stats
+
+	C.cf_get_stats(&cStats)
+
+	return NativeStats{
+		ObjectsRead:   int64(cStats.objects_read),
+		BytesInflated: int64(cStats.bytes_inflated),
+		PreloadDedups: int64(cStats.preload_dedups),
+		Diffs:         int64(cStats.diffs),
+		DiffOps:       int64(cStats.diff_ops),
+		OpBufferGrows: int64(cStats.op_buffer_grows),
+		OpArenaBytes:  int64(cStats.op_arena_bytes),
+		TreeDiffs:     int64(cStats.tree_diffs),
+		TreeDeltas:    int64(cStats.tree_deltas),
+		PoolAllocs:    int64(cStats.pool_allocs),
+		PoolFallbacks: int64(cStats.pool_fallbacks),
+		PoolBytes:     int64(cStats.pool_bytes),
+		ObjectRead:    newLatencyHistogram(&cStats.object_read),
+		Diff:          newLatencyHistogram(&cStats.diff),
+		TreeDiff:      newLatencyHistogram(&cStats.tree_diff),
+	}
+}
+
+// newLatencyHistogram converts one C latency histogram.
+func newLatencyHistogram(cHist *C.cf_latency_stats) LatencyHistogram {
+	hist := LatencyHistogram{
+		Count:   int64(cHist.count),
+		Sum:     time.Duration(cHist.sum_ns),
+		Buckets: make([]int64, LatencyBucketCount),
+	}
+
+	for i := range hist.Buckets {
+		hist.Buckets[i] = int64(cHist.buckets[i])
+	}
+
+	return hist
+}
@@ -0,0 +1,50 @@
+package gitlib_test
+
+import (
+	"testing"
+
+	"github.com/stretchr/testify/require"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
+)
+
+func TestReadNativeStats_CountsDiffs(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	before := gitlib.ReadNativeStats()
+
+	results := gitlib.NewCGOBridge(repo).BatchDiffBlobs([]gitlib.DiffRequest{{
+		OldHash: gitlib.Hash{0: 1},
+		NewHash: gitlib.Hash{0: 2},
+		OldData: []byte("a\nb\n"),
+		NewData: []byte("a\nc\n"),
+		HasOld:  true,
+		HasNew:  true,
+	}})
+	require.Len(t, results, 1)
+	require.NoError(t, results[0].Error)
+
+	after := gitlib.ReadNativeStats()
+
+	// Other tests run in parallel, so counters can only be bounded from below.
+	require.GreaterOrEqual(t, after.Diffs-before.Diffs, int64(1))
+	require.GreaterOrEqual(t, after.DiffOps-before.DiffOps, int64(len(results[0].Ops)))
+	require.GreaterOrEqual(t, after.Diff.Count-before.Diff.Count, int64(1))
+	require.Len(t, after.Diff.Buckets, gitlib.LatencyBucketCount)
+
+	var bucketed int64
+	for _, n := range after.Diff.Buckets {
+		bucketed += n
+	}
+
+	require.Positive(t, bucketed)
+	require.Less(t, gitlib.LatencyBucketBound(0), gitlib.LatencyBucketBound(1))
+}
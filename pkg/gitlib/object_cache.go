@@ -0,0 +1,107 @@
+package gitlib
+
+/*
+#include "codefang_git.h"
+*/
+import "C"
+
+// ObjectCache is a size-bounded LRU of decompressed objects owned by the C
+// library. Every batch blob load and blob diff on a repository handle it is
+// attached to reads through it, so blobs shared by consecutive commits are
+// inflated once and handed out by reference instead of being copied again.
+// Handles opened on the same repository (one per worker) may share a cache.
+type ObjectCache struct {
+	ptr *C.cf_odb_cache
+}
+
+// ObjectCacheStats is a snapshot of the counters of an ObjectCache.
+type ObjectCacheStats struct {
+	Hits      int64
+	Misses    int64
+	Evictions int64
+	Entries   int64
+	Bytes     int64
+	MaxBytes  int64
+}
+
+// NewObjectCache creates a cache holding at most maxBytes of object data.
+func NewObjectCache(maxBytes int64) (*ObjectCache, error) {
+	if maxBytes <= 0 {
+		return nil, ErrObjectCacheSize
+	}
+
+	ptr := C.cf_odb_cache_new(C.size_t(maxBytes))
+	if ptr == nil {
+		return nil, ErrObjectCacheMemory
+	}
+
+	return &ObjectCache{ptr: ptr}, nil
+}
+
+// Stats returns the current counters. A freed cache reports zeros.
+func (c *ObjectCache) Stats() ObjectCacheStats {
+	if c == nil || c.ptr == nil {
+		return ObjectCacheStats{}
+	}
+
+	var st C.cf_odb_cache_stats
+
+	C.cf_odb_cache_get_stats(c.ptr, &st)
+
+	return ObjectCacheStats{
+		Hits:      int64(st.hits),
+		Misses:    int64(st.misses),
+		Evictions: int64(st.evictions),
+		Entries:   int64(st.entries),
+		Bytes:     int64(st.bytes),
+		MaxBytes:  int64(st.max_bytes),
+	}
+}
+
+// Free drops the caller's reference. Repositories the cache is still
+// attached to keep it alive until they are detached or freed.
+func (c *ObjectCache) Free() {
+	if c == nil || c.ptr == nil {
+		return
+	}
+
+	C.cf_odb_cache_free(c.ptr)
+	c.ptr = nil
+}
+
+// AttachObjectCache makes all batch operations on this repository handle read
+// blobs through cache, replacing any previously attached cache.
+func (r *Repository) AttachObjectCache(cache *ObjectCache) error {
+	if cache == nil || cache.ptr == nil {
+		r.DetachObjectCache()
+
+		return nil
+	}
+
+	repoPtr := r.nativePtr()
+	if repoPtr == nil {
+		return ErrRepositoryPointer
+	}
+
+	if C.cf_odb_cache_attach((*C.git_repository)(repoPtr), cache.ptr) != C.CF_OK {
+		return ErrObjectCacheMemory
+	}
+
+	r.objectCache = cache
+
+	return nil
+}
+
+// DetachObjectCache stops this repository handle from using its object cache.
+// Called by Free.
+func (r *Repository) DetachObjectCache() {
+	if r.objectCache == nil {
+		return
+	}
+
+	if repoPtr := r.nativePtr(); repoPtr != nil {
+		C.cf_odb_cache_attach((*C.git_repository)(repoPtr), nil)
+	}
+
+	r.objectCache = nil
+}
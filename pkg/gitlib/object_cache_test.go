@@ -0,0 +1,121 @@
+package gitlib_test
+
+import (
+	"testing"
+
+	"github.com/stretchr/testify/require"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
+)
+
+func TestNewObjectCache_InvalidSize(t *testing.T) {
+	t.Parallel()
+
+	cache, err := gitlib.NewObjectCache(0)
+	require.ErrorIs(t, err, gitlib.ErrObjectCacheSize)
+	require.Nil(t, cache)
+}
+
+func TestObjectCache_SharedAcrossHandlesAndBatches(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	oldOid, err := tr.native.CreateBlobFromBuffer([]byte("a\nb\nc\n"))
+	require.NoError(t, err)
+
+	newOid, err := tr.native.CreateBlobFromBuffer([]byte("a\nx\nc\n"))
+	require.NoError(t, err)
+
+	oldHash, newHash := gitlib.HashFromOid(oldOid), gitlib.HashFromOid(newOid)
+
+	cache, err := gitlib.NewObjectCache(1 << 20)
+	require.NoError(t, err)
+
+	defer cache.Free()
+
+	first, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer first.Free()
+
+	second, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer second.Free()
+
+	require.NoError(t, first.AttachObjectCache(cache))
+	require.NoError(t, second.AttachObjectCache(cache))
+
+	blobs := gitlib.NewCGOBridge(first).BatchLoadBlobs([]gitlib.Hash{oldHash, newHash})
+	require.NoError(t, blobs[0].Error)
+	require.Equal(t, "a\nb\nc\n", string(blobs[0].Data))
+
+	stats := cache.Stats()
+	require.Equal(t, int64(2), stats.Misses)
+	require.Equal(t, int64(0), stats.Hits)
+	require.Equal(t, int64(2), stats.Entries)
+
+	// The other handle diffs the same blobs without reading them again.
+	diffs := gitlib.NewCGOBridge(second).BatchDiffBlobs([]gitlib.DiffRequest{
+		{OldHash: oldHash, NewHash: newHash, HasOld: true, HasNew: true},
+	})
+	require.NoError(t, diffs[0].Error)
+	require.Equal(t, 3, diffs[0].OldLines)
+
+	stats = cache.Stats()
+	require.Equal(t, int64(2), stats.Misses)
+	require.Equal(t, int64(2), stats.Hits)
+	require.Equal(t, int64(12), stats.Bytes)
+
+	// Detached handles bypass the cache.
+	second.DetachObjectCache()
+	gitlib.NewCGOBridge(second).BatchLoadBlobs([]gitlib.Hash{oldHash})
+	require.Equal(t, int64(2), cache.Stats().Hits)
+}
+
+func TestObjectCache_Evicts(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	hashes := make([]gitlib.Hash, 0, 3)
+
+	for _, content := range []string{"first blob\n", "second blob\n", "third blob\n"} {
+		oid, err := tr.native.CreateBlobFromBuffer([]byte(content))
+		require.NoError(t, err)
+
+		hashes = append(hashes, gitlib.HashFromOid(oid))
+	}
+
+	cache, err := gitlib.NewObjectCache(16)
+	require.NoError(t, err)
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	require.NoError(t, repo.AttachObjectCache(cache))
+
+	results := gitlib.NewCGOBridge(repo).BatchLoadBlobs(hashes)
+	for i := range results {
+		require.NoError(t, results[i].Error)
+	}
+
+	stats := cache.Stats()
+	require.Equal(t, int64(3), stats.Misses)
+	require.Equal(t, int64(2), stats.Evictions)
+	require.Equal(t, int64(1), stats.Entries)
+	require.LessOrEqual(t, stats.Bytes, stats.MaxBytes)
+
+	// The repository keeps the cache alive after the owner lets go.
+	cache.Free()
+	require.Equal(t, gitlib.ObjectCacheStats{}, cache.Stats())
+
+	results = gitlib.NewCGOBridge(repo).BatchLoadBlobs(hashes)
+	require.NoError(t, results[2].Error)
+	require.Equal(t, "third blob\n", string(results[2].Data))
+}
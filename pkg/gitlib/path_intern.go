@@ -0,0 +1,70 @@
+package gitlib
+
+import "sync"
+
+// PathInterner maps file paths to stable integer IDs for the lifetime of a run.
+// Attached to a CGOBridge (see CGOBridge.SetPathInterner), it returns the same
+// Go string for a path every time it reappears in a tree diff, so repeated
+// paths cost no allocation, and sets ChangeEntry.PathID so analyzers can key
+// maps on an integer instead of the path. Safe for concurrent use; one
+// interner may be shared by the bridges of several workers.
+type PathInterner struct {
+	mu    sync.RWMutex
+	ids   map[string]uint32
+	paths []string
+}
+
+// NewPathInterner creates an empty path interner.
+func NewPathInterner() *PathInterner {
+	// ID 0 is reserved for "not interned".
+	return &PathInterner{
+		ids:   make(map[string]uint32),
+		paths: []string{""},
+	}
+}
+
+// Intern returns the canonical string and ID for path, assigning a new ID
+// the first time a path is seen.
+func (p *PathInterner) Intern(path []byte) (string, uint32) {
+	p.mu.RLock()
+	id, found := p.ids[string(path)]
+	p.mu.RUnlock()
+
+	if found {
+		return p.Path(id), id
+	}
+
+	p.mu.Lock()
+	defer p.mu.Unlock()
+
+	if id, found = p.ids[string(path)]; found {
+		return p.paths[id], id
+	}
+
+	name := string(path)
+	id = uint32(len(p.paths))
+	p.ids[name] = id
+	p.paths = append(p.paths, name)
+
+	return name, id
+}
+
+// Path returns the path with the given ID, or "" if the ID is unknown.
+func (p *PathInterner) Path(id uint32) string {
+	p.mu.RLock()
+	defer p.mu.RUnlock()
+
+	if int(id) >= len(p.paths) {
+		return ""
+	}
+
+	return p.paths[id]
+}
+
+// Len returns the number of interned paths.
+func (p *PathInterner) Len() int {
+	p.mu.RLock()
+	defer p.mu.RUnlock()
+
+	return len(p.paths) - 1
+}
@@ -0,0 +1,63 @@
+package gitlib_test
+
+import (
+	"sync"
+	"testing"
+
+	"github.com/stretchr/testify/require"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
+)
+
+func TestPathInterner_StableIDs(t *testing.T) {
+	t.Parallel()
+
+	interner := gitlib.NewPathInterner()
+
+	name, id := interner.Intern([]byte("a/b.go"))
+	require.Equal(t, "a/b.go", name)
+	require.NotZero(t, id)
+
+	again, againID := interner.Intern([]byte("a/b.go"))
+	require.Equal(t, id, againID)
+	require.Equal(t, name, again)
+
+	_, otherID := interner.Intern([]byte("c.go"))
+	require.NotEqual(t, id, otherID)
+
+	require.Equal(t, "a/b.go", interner.Path(id))
+	require.Empty(t, interner.Path(0))
+	require.Empty(t, interner.Path(1000))
+	require.Equal(t, 2, interner.Len())
+}
+
+func TestPathInterner_Concurrent(t *testing.T) {
+	t.Parallel()
+
+	interner := gitlib.NewPathInterner()
+	paths := []string{"x.go", "y.go", "z/w.go"}
+	ids := make([][]uint32, 8)
+
+	var wg sync.WaitGroup
+
+	for g := range ids {
+		wg.Add(1)
+
+		go func() {
+			defer wg.Done()
+
+			for _, p := range paths {
+				_, id := interner.Intern([]byte(p))
+				ids[g] = append(ids[g], id)
+			}
+		}()
+	}
+
+	wg.Wait()
+
+	for g := range ids {
+		require.Equal(t, ids[0], ids[g])
+	}
+
+	require.Equal(t, len(paths), interner.Len())
+}
@@ -0,0 +1,249 @@
+package gitlib
+
+/*
+#include "codefang_git.h"
+*/
+import "C"
+
+import (
+	"sort"
+	"sync"
+	"time"
+)
+
+// RepoLimits bounds the native memory one repository may hold while it is
+// scanned next to others. A zero field disables that limit.
+type RepoLimits struct {
+	// WindowBytes is the blob content read before a release of the
+	// repository's pack windows is due (RepoBudgetStats.ReleaseDue). It
+	// counts blob bytes, not mapped bytes: libgit2 does not report those per
+	// repository. SetFleetWindowLimit caps the mapped bytes themselves.
+	WindowBytes int64
+	// CacheBytes is the size of an object cache owned by the budget and
+	// shared by all of its handles.
+	CacheBytes int64
+	// ArenaBytes caps the blob arena and batch memory of analyses of the
+	// repository; it is applied by the caller, not the C layer.
+	ArenaBytes int64
+}
+
+// RepoBudget accounts the batch calls of the repository handles attached to
+// it and keeps their pack windows and object cache within its RepoLimits,
+// so one large repository cannot hold the memory of a whole fleet scan.
+// Each budget holds its own object cache. Batch calls are charged by the
+// goroutine that made them and only update the accounting; once a budget
+// runs past its window share, its owner calls ReleaseWindows at a point
+// where none of the budget's handles is in use, such as between two runs.
+// Across budgets, SetFleetWindowLimit and SetFleetPackFileLimit bound what
+// libgit2 maps, closing the least recently used windows first. Live
+// budgets are reported by ReadRepoBudgetStats under their name. Budgets are
+// meant for embedders that scan several repositories in one process; the
+// CLI does not set one.
+type RepoBudget struct {
+	ptr    *C.cf_repo_budget
+	name   string
+	limits RepoLimits
+}
+
+// RepoBudgetStats is a snapshot of the accounting of a RepoBudget.
+type RepoBudgetStats struct {
+	Name string
+	// Batches counts charged batch calls; BytesInflated is the blob content
+	// they read and PeakBytes the largest peak of a single call.
+	Batches       int64
+	BytesInflated int64
+	PeakBytes     int64
+	// WindowBytes is the blob content read since the pack windows were last
+	// released; WindowCloses counts the releases. ReleaseDue reports that
+	// WindowBytes is past the window share.
+	WindowBytes  int64
+	WindowCloses int64
+	ReleaseDue   bool
+	// Handles is the number of attached repository handles.
+	Handles int64
+	// Idle is the time since the last charged call.
+	Idle  time.Duration
+	Cache ObjectCacheStats
+}
+
+var (
+	repoBudgetsMu sync.Mutex
+	repoBudgets   = map[*RepoBudget]struct{}{}
+)
+
+// NewRepoBudget creates a budget reported under name.
+func NewRepoBudget(name string, limits RepoLimits) (*RepoBudget, error) {
+	cLimits := C.cf_repo_limits{
+		window_bytes: C.size_t(max(limits.WindowBytes, 0)),
+		cache_bytes:  C.size_t(max(limits.CacheBytes, 0)),
+	}
+
+	ptr := C.cf_repo_budget_new(&cLimits)
+	if ptr == nil {
+		return nil, ErrRepoBudgetMemory
+	}
+
+	budget := &RepoBudget{ptr: ptr, name: name, limits: limits}
+
+	repoBudgetsMu.Lock()
+	repoBudgets[budget] = struct{}{}
+	repoBudgetsMu.Unlock()
+
+	return budget, nil
+}
+
+// Name returns the name the budget is reported under.
+func (b *RepoBudget) Name() string {
+	return b.name
+}
+
+// Limits returns the limits the budget was created with.
+func (b *RepoBudget) Limits() RepoLimits {
+	return b.limits
+}
+
+// Stats returns the current accounting. A freed budget reports zeros.
+func (b *RepoBudget) Stats() RepoBudgetStats {
+	if b == nil || b.ptr == nil {
+		return RepoBudgetStats{}
+	}
+
+	var st C.cf_repo_budget_stats
+
+	C.cf_repo_budget_get_stats(b.ptr, &st)
+
+	return RepoBudgetStats{
+		Name:          b.name,
+		Batches:       int64(st.batches),
+		BytesInflated: int64(st.bytes_inflated),
+		PeakBytes:     int64(st.peak_bytes),
+		WindowBytes:   int64(st.window_bytes),
+		WindowCloses:  int64(st.window_closes),
+		Handles:       int64(st.handles),
+		ReleaseDue:    st.release_due != 0,
+		Idle:          time.Duration(st.idle_ns),
+		Cache: ObjectCacheStats{
+			Hits:      int64(st.cache.hits),
+			Misses:    int64(st.cache.misses),
+			Evictions: int64(st.cache.evictions),
+			Entries:   int64(st.cache.entries),
+			Bytes:     int64(st.cache.bytes),
+			MaxBytes:  int64(st.cache.max_bytes),
+		},
+	}
+}
+
+// Free drops the caller's reference and stops reporting the budget.
+// Repositories it is still attached to keep it alive until they are
+// detached or freed.
+func (b *RepoBudget) Free() {
+	if b == nil || b.ptr == nil {
+		return
+	}
+
+	repoBudgetsMu.Lock()
+	delete(repoBudgets, b)
+	repoBudgetsMu.Unlock()
+
+	C.cf_repo_budget_free(b.ptr)
+	b.ptr = nil
+}
+
+// ReadRepoBudgetStats snapshots all live budgets, ordered by name.
+func ReadRepoBudgetStats() []RepoBudgetStats {
+	repoBudgetsMu.Lock()
+	defer repoBudgetsMu.Unlock()
+
+	stats := make([]RepoBudgetStats, 0, len(repoBudgets))
+	for budget := range repoBudgets {
+		stats = append(stats, budget.Stats())
+	}
+
+	sort.Slice(stats, func(i, j int) bool { return stats[i].Name < stats[j].Name })
+
+	return stats
+}
+
+// ReleaseWindows releases the pack windows of all repository handles
+// attached to the budget: they drop their object databases, which unmaps
+// the packs unless handles outside the budget read them, and share one
+// reopened for them. None of the handles may be in use by a batch call
+// meanwhile. If the reopen fails, reads through the handles fail until they
+// are reopened.
+func (b *RepoBudget) ReleaseWindows() error {
+	if b == nil || b.ptr == nil {
+		return ErrRepoBudgetFreed
+	}
+
+	if C.cf_repo_budget_release_windows(b.ptr) != C.CF_OK {
+		return ErrRepoBudgetRelease
+	}
+
+	return nil
+}
+
+// SetFleetWindowLimit bounds the pack bytes libgit2 maps for all
+// repositories of the process together; past it libgit2 closes the least
+// recently used windows, those of cold repositories first. Unlike
+// RepoLimits.WindowBytes it counts mapped bytes. Zero restores the limit in
+// force before the first call, such as one set by ConfigureMemoryLimits.
+func SetFleetWindowLimit(bytes int64) error {
+	if C.cf_repo_budget_set_fleet_limit(C.size_t(max(bytes, 0))) != 0 {
+		return ErrFleetLimit
+	}
+
+	return nil
+}
+
+// SetFleetPackFileLimit bounds the pack files libgit2 keeps open for all
+// repositories of the process together; past it the least recently used
+// ones are closed. Zero restores the limit in force before the first call.
+func SetFleetPackFileLimit(files int) error {
+	if C.cf_repo_budget_set_fleet_file_limit(C.size_t(max(files, 0))) != 0 {
+		return ErrFleetLimit
+	}
+
+	return nil
+}
+
+// AttachBudget charges all batch operations on this repository handle to
+// budget, replacing any previously attached budget. If the budget has an
+// object cache, it replaces the handle's object cache.
+func (r *Repository) AttachBudget(budget *RepoBudget) error {
+	if budget == nil || budget.ptr == nil {
+		r.DetachBudget()
+
+		return nil
+	}
+
+	repoPtr := r.nativePtr()
+	if repoPtr == nil {
+		return ErrRepositoryPointer
+	}
+
+	if C.cf_repo_budget_attach((*C.git_repository)(repoPtr), budget.ptr) != C.CF_OK {
+		return ErrRepoBudgetMemory
+	}
+
+	r.budget = budget
+
+	if budget.limits.CacheBytes > 0 {
+		r.objectCache = nil
+	}
+
+	return nil
+}
+
+// DetachBudget stops charging this repository handle, together with the
+// budget's object cache. Called by Free.
+func (r *Repository) DetachBudget() {
+	if r.budget == nil {
+		return
+	}
+
+	if repoPtr := r.nativePtr(); repoPtr != nil {
+		C.cf_repo_budget_attach((*C.git_repository)(repoPtr), nil)
+	}
+
+	r.budget = nil
+}
@@ -0,0 +1,333 @@
+package gitlib_test
+
+import (
+	"bufio"
+	"context"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"strconv"
+	"strings"
+	"testing"
+
+	"github.com/stretchr/testify/require"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
+)
+
+// findRepoBudgetStats returns the reported stats of the budget named name.
+func findRepoBudgetStats(name string) (gitlib.RepoBudgetStats, bool) {
+	for _, stats := range gitlib.ReadRepoBudgetStats() {
+		if stats.Name == name {
+			return stats, true
+		}
+	}
+
+	return gitlib.RepoBudgetStats{}, false
+}
+
+// createBlobs writes contents as blobs and returns their hashes.
+func createBlobs(t *testing.T, tr *testRepo, contents ...string) []gitlib.Hash {
+	t.Helper()
+
+	hashes := make([]gitlib.Hash, 0, len(contents))
+
+	for _, content := range contents {
+		oid, err := tr.native.CreateBlobFromBuffer([]byte(content))
+		require.NoError(t, err)
+
+		hashes = append(hashes, gitlib.HashFromOid(oid))
+	}
+
+	return hashes
+}
+
+// mappedPackBytes sums the mappings of pack files under prefix in this process.
+func mappedPackBytes(t *testing.T, prefix string) int64 {
+	t.Helper()
+
+	maps, err := os.Open("/proc/self/maps")
+	require.NoError(t, err)
+
+	defer maps.Close()
+
+	var total int64
+
+	scanner := bufio.NewScanner(maps)
+	for scanner.Scan() {
+		fields := strings.Fields(scanner.Text())
+		if len(fields) < 6 || !strings.HasPrefix(fields[5], prefix) || !strings.HasSuffix(fields[5], ".pack") {
+			continue
+		}
+
+		start, end, _ := strings.Cut(fields[0], "-")
+
+		lo, err := strconv.ParseUint(start, 16, 64)
+		require.NoError(t, err)
+
+		hi, err := strconv.ParseUint(end, 16, 64)
+		require.NoError(t, err)
+
+		total += int64(hi - lo)
+	}
+
+	require.NoError(t, scanner.Err())
+
+	return total
+}
+
+// packBlobs moves the blobs of the test repository into a pack file and
+// returns its path.
+func packBlobs(t *testing.T, tr *testRepo, hashes []gitlib.Hash) string {
+	t.Helper()
+
+	var input strings.Builder
+	for _, hash := range hashes {
+		input.WriteString(hash.String() + "\n")
+	}
+
+	pack := exec.CommandContext(context.Background(), "git", "pack-objects", "-q", ".git/objects/pack/pack")
+	pack.Dir = tr.path
+	pack.Stdin = strings.NewReader(input.String())
+
+	name, err := pack.Output()
+	require.NoError(t, err)
+
+	prune := exec.CommandContext(context.Background(), "git", "prune-packed")
+	prune.Dir = tr.path
+	require.NoError(t, prune.Run())
+
+	dir, err := filepath.EvalSymlinks(tr.path)
+	require.NoError(t, err)
+
+	return filepath.Join(dir, ".git", "objects", "pack", "pack-"+strings.TrimSpace(string(name))+".pack")
+}
+
+// skipWithoutPackMaps skips tests that read pack mappings when git or
+// /proc/self/maps is unavailable.
+func skipWithoutPackMaps(t *testing.T) {
+	t.Helper()
+
+	if _, err := exec.LookPath("git"); err != nil {
+		t.Skip("git not installed")
+	}
+
+	if _, err := os.Stat("/proc/self/maps"); err != nil {
+		t.Skip("no /proc/self/maps")
+	}
+}
+
+func TestRepoBudget_ReleaseWindowsUnmapsPacks(t *testing.T) {
+	t.Parallel()
+
+	skipWithoutPackMaps(t)
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	hashes := createBlobs(t, tr, strings.Repeat("packed line\n", 4096), "a\nb\nc\n")
+	packPath := packBlobs(t, tr, hashes)
+
+	budget, err := gitlib.NewRepoBudget("budget-unmap", gitlib.RepoLimits{})
+	require.NoError(t, err)
+
+	defer budget.Free()
+
+	first, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer first.Free()
+
+	second, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer second.Free()
+
+	require.NoError(t, first.AttachBudget(budget))
+	require.NoError(t, second.AttachBudget(budget))
+
+	firstBridge := gitlib.NewCGOBridge(first)
+	secondBridge := gitlib.NewCGOBridge(second)
+
+	require.NoError(t, firstBridge.BatchLoadBlobs(hashes)[1].Error)
+	require.NoError(t, secondBridge.BatchLoadBlobs(hashes)[0].Error)
+	require.Positive(t, mappedPackBytes(t, packPath))
+
+	// Both handles drop their databases, so the shared pack is unmapped.
+	require.NoError(t, budget.ReleaseWindows())
+	require.Zero(t, mappedPackBytes(t, packPath))
+
+	blobs := secondBridge.BatchLoadBlobs(hashes)
+	require.NoError(t, blobs[1].Error)
+	require.Equal(t, "a\nb\nc\n", string(blobs[1].Data))
+	require.Positive(t, mappedPackBytes(t, packPath))
+}
+
+func TestRepoBudget_ChargesAndDuesRelease(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	hashes := createBlobs(t, tr, "a\nb\nc\n", "a\nx\nc\n")
+
+	budget, err := gitlib.NewRepoBudget("budget-windows", gitlib.RepoLimits{WindowBytes: 16})
+	require.NoError(t, err)
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	require.NoError(t, repo.AttachBudget(budget))
+
+	bridge := gitlib.NewCGOBridge(repo)
+	bridge.BatchLoadBlobs(hashes)
+
+	stats, ok := findRepoBudgetStats("budget-windows")
+	require.True(t, ok)
+	require.Equal(t, int64(1), stats.Batches)
+	require.Equal(t, int64(12), stats.BytesInflated)
+	require.Equal(t, int64(12), stats.WindowBytes)
+	require.Equal(t, int64(1), stats.Handles)
+	require.False(t, stats.ReleaseDue)
+
+	// Past the share a release is due; the handle is left alone until then.
+	bridge.BatchLoadBlobs(hashes)
+
+	stats = budget.Stats()
+	require.True(t, stats.ReleaseDue)
+	require.Equal(t, int64(24), stats.WindowBytes)
+	require.Zero(t, stats.WindowCloses)
+
+	require.NoError(t, budget.ReleaseWindows())
+
+	stats = budget.Stats()
+	require.False(t, stats.ReleaseDue)
+	require.Zero(t, stats.WindowBytes)
+	require.Equal(t, int64(1), stats.WindowCloses)
+
+	blobs := bridge.BatchLoadBlobs(hashes[:1])
+	require.NoError(t, blobs[0].Error)
+	require.Equal(t, "a\nb\nc\n", string(blobs[0].Data))
+
+	repo.DetachBudget()
+	require.Zero(t, budget.Stats().Handles)
+
+	budget.Free()
+
+	_, ok = findRepoBudgetStats("budget-windows")
+	require.False(t, ok)
+	require.Equal(t, gitlib.RepoBudgetStats{}, budget.Stats())
+	require.ErrorIs(t, budget.ReleaseWindows(), gitlib.ErrRepoBudgetFreed)
+}
+func TestRepoBudget_OwnsObjectCache(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	hashes := createBlobs(t, tr, "a\nb\nc\n", "a\nx\nc\n")
+
+	budget, err := gitlib.NewRepoBudget("budget-cache", gitlib.RepoLimits{CacheBytes: 1 << 20})
+	require.NoError(t, err)
+
+	defer budget.Free()
+
+	first, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer first.Free()
+
+	second, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer second.Free()
+
+	require.NoError(t, first.AttachBudget(budget))
+	require.NoError(t, second.AttachBudget(budget))
+
+	gitlib.NewCGOBridge(first).BatchLoadBlobs(hashes)
+
+	diffs := gitlib.NewCGOBridge(second).BatchDiffBlobs([]gitlib.DiffRequest{
+		{OldHash: hashes[0], NewHash: hashes[1], HasOld: true, HasNew: true},
+	})
+	require.NoError(t, diffs[0].Error)
+
+	stats := budget.Stats()
+	require.Equal(t, int64(2), stats.Handles)
+	require.Equal(t, int64(2), stats.Batches)
+	require.Equal(t, int64(2), stats.Cache.Misses)
+	require.Equal(t, int64(2), stats.Cache.Hits)
+
+	// Detaching the budget also detaches its cache.
+	second.DetachBudget()
+	gitlib.NewCGOBridge(second).BatchLoadBlobs(hashes[:1])
+	require.Equal(t, int64(2), budget.Stats().Cache.Hits)
+}
+
+func TestSetFleetWindowLimit_ClosesColdestWindows(t *testing.T) { //nolint:paralleltest // Process-wide setting.
+	skipWithoutPackMaps(t)
+
+	cold := newTestRepo(t)
+	defer cold.cleanup()
+
+	hot := newTestRepo(t)
+	defer hot.cleanup()
+
+	coldHashes := createBlobs(t, cold, strings.Repeat("cold line\n", 4096))
+	hotHashes := createBlobs(t, hot, strings.Repeat("hot line\n", 4096))
+	coldPack := packBlobs(t, cold, coldHashes)
+	hotPack := packBlobs(t, hot, hotHashes)
+
+	coldRepo, err := gitlib.OpenRepository(cold.path)
+	require.NoError(t, err)
+
+	defer coldRepo.Free()
+
+	hotRepo, err := gitlib.OpenRepository(hot.path)
+	require.NoError(t, err)
+
+	defer hotRepo.Free()
+
+	require.NoError(t, gitlib.SetFleetWindowLimit(1))
+
+	defer func() { require.NoError(t, gitlib.SetFleetWindowLimit(0)) }()
+
+	require.NoError(t, gitlib.NewCGOBridge(coldRepo).BatchLoadBlobs(coldHashes)[0].Error)
+	require.Positive(t, mappedPackBytes(t, coldPack))
+
+	// Mapping the hot pack past the limit closes the idle window of the cold one.
+	require.NoError(t, gitlib.NewCGOBridge(hotRepo).BatchLoadBlobs(hotHashes)[0].Error)
+	require.Positive(t, mappedPackBytes(t, hotPack))
+	require.Zero(t, mappedPackBytes(t, coldPack))
+}
+
+func TestSetFleetPackFileLimit_KeepsPacksReadable(t *testing.T) { //nolint:paralleltest // Process-wide setting.
+	skipWithoutPackMaps(t)
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	first := createBlobs(t, tr, "a\nb\nc\n")
+	packBlobs(t, tr, first)
+
+	second := createBlobs(t, tr, "a\nx\nc\n")
+	packBlobs(t, tr, second)
+
+	require.NoError(t, gitlib.SetFleetPackFileLimit(1))
+
+	defer func() { require.NoError(t, gitlib.SetFleetPackFileLimit(0)) }()
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	// With one open pack allowed, each read closes the other pack.
+	bridge := gitlib.NewCGOBridge(repo)
+	for _, hashes := range [][]gitlib.Hash{first, second, first} {
+		blobs := bridge.BatchLoadBlobs(hashes)
+		require.NoError(t, blobs[0].Error)
+	}
+}
@@ -10,8 +10,11 @@ import (
 
 // Repository wraps a libgit2 repository.
 type Repository struct {
-	repo *git2go.Repository
-	path string
+	repo           *git2go.Repository
+	path           string
+	objectCache    *ObjectCache
+	budget         *RepoBudget
+	treeDiffFilter *TreeDiffFilter
 }
 
 // OpenRepository opens a git repository at the given path.
@@ -31,6 +34,10 @@ func (r *Repository) Path() string {
 
 // Free releases the repository resources.
 func (r *Repository) Free() {
+	r.DetachBudget()
+	r.DetachObjectCache()
+	r.forgetPackLocator()
+
 	if r.repo != nil {
 		r.repo.Free()
 		r.repo = nil
@@ -95,53 +102,20 @@ type LogOptions struct {
 	Reverse     bool       // Yield oldest commits first (adds git2go.SortReverse).
 }
 
-// Log returns a commit iterator starting from HEAD.
+// Log returns a commit iterator starting from HEAD. Commits are read in
+// batches by a CommitWalk (see WalkCommits).
 func (r *Repository) Log(opts *LogOptions) (*CommitIter, error) {
-	walk, err := r.repo.Walk()
-	if err != nil {
-		return nil, fmt.Errorf("create revwalk: %w", err)
-	}
-
-	// Start from HEAD.
-	headRef, err := r.repo.Head()
-	if err != nil {
-		walk.Free()
-
-		return nil, fmt.Errorf("get HEAD: %w", err)
-	}
-	defer headRef.Free()
-
-	err = walk.Push(headRef.Target())
+	walk, err := r.WalkCommits(opts)
 	if err != nil {
-		walk.Free()
-
-		return nil, fmt.Errorf("push HEAD to revwalk: %w", err)
-	}
-
-	// Topological order ensures we never diff against a descendant; prevents
-	// negative burndown values when branches have different timestamps.
-	sortFlags := git2go.SortTime | git2go.SortTopological
-	if opts != nil && opts.Reverse {
-		sortFlags |= git2go.SortReverse
-	}
-
-	walk.Sorting(sortFlags)
-
-	if opts != nil && opts.FirstParent {
-		walk.SimplifyFirstParent()
-	}
-
-	var since *time.Time
-	if opts != nil {
-		since = opts.Since
+		return nil, fmt.Errorf("create commit walk: %w", err)
 	}
 
-	return &CommitIter{walk: walk, repo: r, since: since}, nil
+	return &CommitIter{walk: walk, repo: r}, nil
 }
 
 // CommitCount returns the number of commits matching the given log options.
-// It walks the revision history counting OIDs without looking up full commit
-// objects, making it O(N) in time but O(1) in memory. The Reverse option is
+// It walks the revision history in native batches without creating Commit
+// values, making it O(N) in time but O(1) in memory. The Reverse option is
 // ignored since ordering doesn't affect the count.
 func (r *Repository) CommitCount(opts *LogOptions) (int, error) {
 	iter, err := r.Log(opts)
@@ -0,0 +1,160 @@
+package gitlib
+
+/*
+#include <stdlib.h>
+#include "codefang_git.h"
+*/
+import "C"
+
+import (
+	"runtime"
+	"unsafe"
+)
+
+// TreeDiffFilterOptions selects which changes tree diffs report.
+type TreeDiffFilterOptions struct {
+	// Pathspecs are git pathspecs; a leading '!' excludes. A path passes if it
+	// matches any include pattern (or there are none) and no exclude pattern.
+	Pathspecs []string
+	// SkipDirs are directories whose subtrees are dropped entirely, such as
+	// "vendor" or "node_modules". They match at any depth unless they start
+	// with '/', which anchors them to the repository root.
+	SkipDirs []string
+	// MaxBlobSize drops changes with a blob larger than this many bytes.
+	// Zero means no limit.
+	MaxBlobSize int64
+	// DetectRenames pairs deleted and added files into renames, reported as
+	// Modify changes whose From and To names differ: identical blobs first,
+	// then files at least RenameThreshold percent similar.
+	DetectRenames bool
+	// RenameThreshold is the similarity percentage of an inexact rename.
+	// Zero means 50.
+	RenameThreshold int
+	// RenameLimit skips the similarity search of a diff with more than
+	// RenameLimit squared deleted times added files, like git's
+	// diff.renameLimit. Zero means 1000; negative finds exact renames only.
+	RenameLimit int
+	// RenameSignatures is the number of file similarity signatures cached
+	// across diffs. Zero means 8192.
+	RenameSignatures int
+}
+
+// IsZero reports whether the options filter nothing.
+func (o TreeDiffFilterOptions) IsZero() bool {
+	return len(o.Pathspecs) == 0 && len(o.SkipDirs) == 0 && o.MaxBlobSize <= 0 && !o.DetectRenames
+}
+
+// TreeDiffFilter is a compiled TreeDiffFilterOptions owned by the C library.
+// Set on a repository handle, it makes the CGOBridge tree diffs (TreeDiff,
+// BatchTreeDiff and BatchCommitDiffs) drop unwanted changes inside libgit2,
+// before their paths are copied or their blobs loaded. With rename detection
+// it also pairs renames, caching the similarity signatures of the blobs it
+// compares. A filter may be shared by the handles of several workers.
+type TreeDiffFilter struct {
+	ptr *C.cf_tree_filter
+}
+
+// NewTreeDiffFilter compiles a tree diff filter.
+func NewTreeDiffFilter(opts TreeDiffFilterOptions) (*TreeDiffFilter, error) {
+	pathspecs := newCStrings(opts.Pathspecs)
+	defer freeCStrings(pathspecs)
+
+	skipDirs := newCStrings(opts.SkipDirs)
+	defer freeCStrings(skipDirs)
+
+	var pinner runtime.Pinner
+	defer pinner.Unpin()
+
+	ptr := C.cf_tree_filter_new(
+		cStringsPtr(&pinner, pathspecs),
+		C.int(len(pathspecs)),
+		cStringsPtr(&pinner, skipDirs),
+		C.int(len(skipDirs)),
+		C.size_t(max(opts.MaxBlobSize, 0)),
+	)
+	if ptr == nil {
+		return nil, ErrTreeDiffFilterMemory
+	}
+
+	if opts.DetectRenames {
+		rc := C.cf_tree_filter_set_renames(
+			ptr,
+			C.int(opts.RenameThreshold),
+			C.int(opts.RenameLimit),
+			C.size_t(max(opts.RenameSignatures, 0)),
+		)
+		if rc != C.CF_OK {
+			C.cf_tree_filter_free(ptr)
+
+			return nil, ErrTreeDiffFilterMemory
+		}
+	}
+
+	return &TreeDiffFilter{ptr: ptr}, nil
+}
+
+// Matches reports whether a change to path passes the filter's path rules.
+// Size limits are not considered.
+func (f *TreeDiffFilter) Matches(path string) bool {
+	if f == nil || f.ptr == nil {
+		return true
+	}
+
+	cPath := C.CString(path)
+	defer C.free(unsafe.Pointer(cPath))
+
+	return C.cf_tree_filter_matches(f.ptr, cPath) != 0
+}
+
+// Free releases the compiled filter. Repository handles it is set on must not
+// diff trees afterwards.
+func (f *TreeDiffFilter) Free() {
+	if f == nil || f.ptr == nil {
+		return
+	}
+
+	C.cf_tree_filter_free(f.ptr)
+	f.ptr = nil
+}
+
+// SetTreeDiffFilter makes CGOBridge tree diffs on this repository handle drop
+// the changes filter rejects. Pass nil to report every change again.
+func (r *Repository) SetTreeDiffFilter(filter *TreeDiffFilter) {
+	r.treeDiffFilter = filter
+}
+
+// treeDiffFilterPtr returns the C filter of the handle, or nil.
+func (r *Repository) treeDiffFilterPtr() *C.cf_tree_filter {
+	if r.treeDiffFilter == nil {
+		return nil
+	}
+
+	return r.treeDiffFilter.ptr
+}
+
+// newCStrings copies strings to C memory; release with freeCStrings.
+func newCStrings(strs []string) []*C.char {
+	cStrs := make([]*C.char, len(strs))
+	for i, s := range strs {
+		cStrs[i] = C.CString(s)
+	}
+
+	return cStrs
+}
+
+func freeCStrings(cStrs []*C.char) {
+	for _, s := range cStrs {
+		C.free(unsafe.Pointer(s))
+	}
+}
+
+// cStringsPtr pins a C string array for a call and returns its first element.
+func cStringsPtr(pinner *runtime.Pinner, cStrs []*C.char) **C.char {
+	if len(cStrs) == 0 {
+		return nil
+	}
+
+	pinner.Pin(&cStrs[0])
+
+	return &cStrs[0]
+}
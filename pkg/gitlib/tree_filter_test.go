@@ -0,0 +1,180 @@
+package gitlib_test
+
+import (
+	"context"
+	"strings"
+	"testing"
+
+	"github.com/stretchr/testify/require"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
+)
+
+func TestTreeDiffFilter_Matches(t *testing.T) {
+	t.Parallel()
+
+	filter, err := gitlib.NewTreeDiffFilter(gitlib.TreeDiffFilterOptions{
+		Pathspecs: []string{"*.go", "docs", "!*_gen.go"},
+		SkipDirs:  []string{"node_modules", "/vendor/"},
+	})
+	require.NoError(t, err)
+
+	defer filter.Free()
+
+	for path, want := range map[string]bool{
+		"main.go":                  true,
+		"pkg/a.go":                 true,
+		"docs/index.md":            true,
+		"README.md":                false,
+		"pkg/types_gen.go":         false,
+		"vendor/lib/a.go":          false,
+		"internal/vendor/a.go":     true,
+		"node_modules/x/a.go":      false,
+		"web/node_modules/x/a.go":  false,
+		"web/my_node_modules/a.go": true,
+	} {
+		require.Equal(t, want, filter.Matches(path), path)
+	}
+
+	var none *gitlib.TreeDiffFilter
+	require.True(t, none.Matches("anything"))
+	require.True(t, gitlib.TreeDiffFilterOptions{}.IsZero())
+}
+
+func TestCGOBridge_TreeDiffFilter(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	tr.createFile("main.go", "package main\n")
+	tr.createFile("big.go", strings.Repeat("x", 4096))
+	tr.createFile("vendor/dep/dep.go", "package dep\n")
+	tr.createFile("web/node_modules/m/index.js", "x\n")
+	first := tr.commit("first")
+
+	tr.createFile("main.go", "package main\n\nfunc main() {}\n")
+	tr.createFile("vendor/dep/dep.go", "package dep // v2\n")
+	second := tr.commit("second")
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	filter, err := gitlib.NewTreeDiffFilter(gitlib.TreeDiffFilterOptions{
+		SkipDirs:    []string{"vendor", "node_modules"},
+		MaxBlobSize: 1024,
+	})
+	require.NoError(t, err)
+
+	defer filter.Free()
+
+	bridge := gitlib.NewCGOBridge(repo)
+	requests := []gitlib.CommitDiffRequest{{CommitHash: first}, {CommitHash: second}}
+
+	unfiltered := bridge.BatchTreeDiff(requests)
+	require.Len(t, unfiltered[0].Changes, 4)
+
+	repo.SetTreeDiffFilter(filter)
+
+	results := bridge.BatchTreeDiff(requests)
+	require.Len(t, results, 2)
+
+	for _, res := range results {
+		require.NoError(t, res.Error)
+		require.Len(t, res.Changes, 1)
+		require.Equal(t, "main.go", res.Changes[0].To.Name)
+	}
+
+	fused, _ := bridge.BatchCommitDiffs(requests, gitlib.DiffAlgorithmMyers, false)
+	require.Len(t, fused[1].Changes, 1)
+	require.Len(t, fused[1].FileDiffs, 1)
+
+	commit, err := repo.LookupCommit(context.Background(), first)
+	require.NoError(t, err)
+
+	treeHash := commit.TreeHash()
+	commit.Free()
+
+	changes, err := bridge.TreeDiff(gitlib.ZeroHash(), treeHash)
+	require.NoError(t, err)
+	require.Len(t, changes, 1)
+
+	repo.SetTreeDiffFilter(nil)
+
+	changes, err = bridge.TreeDiff(gitlib.ZeroHash(), treeHash)
+	require.NoError(t, err)
+	require.Len(t, changes, 4)
+}
+
+func TestCGOBridge_TreeDiffFilterRenames(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	body := strings.Repeat("func line() {}\n", 64)
+
+	tr.createFile("old/same.go", body)
+	tr.createFile("old/edited.go", body+"// tail\n")
+	tr.createFile("gone.go", "package gone\n")
+	first := tr.commit("first")
+
+	tr.deleteFile("old/same.go")
+	tr.deleteFile("old/edited.go")
+	tr.deleteFile("gone.go")
+	tr.createFile("new/same.go", body)
+	tr.createFile("new/edited.go", body+"// changed tail\n")
+	tr.createFile("added.go", "package added\n")
+	second := tr.commit("second")
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	filter, err := gitlib.NewTreeDiffFilter(gitlib.TreeDiffFilterOptions{DetectRenames: true})
+	require.NoError(t, err)
+
+	defer filter.Free()
+
+	bridge := gitlib.NewCGOBridge(repo)
+	requests := []gitlib.CommitDiffRequest{{CommitHash: second, ParentHash: first}}
+
+	require.Len(t, bridge.BatchTreeDiff(requests)[0].Changes, 6)
+
+	repo.SetTreeDiffFilter(filter)
+
+	// The second pass reads the signatures from the cache.
+	for range 2 {
+		results := bridge.BatchTreeDiff(requests)
+		require.NoError(t, results[0].Error)
+
+		renames := map[string]string{}
+		actions := map[gitlib.ChangeAction]int{}
+
+		for _, change := range results[0].Changes {
+			actions[change.Action]++
+
+			if change.Action == gitlib.Modify {
+				renames[change.To.Name] = change.From.Name
+			}
+		}
+
+		require.Equal(t, map[string]string{"new/same.go": "old/same.go", "new/edited.go": "old/edited.go"}, renames)
+		require.Equal(t, map[gitlib.ChangeAction]int{gitlib.Modify: 2, gitlib.Insert: 1, gitlib.Delete: 1}, actions)
+	}
+
+	fused, _ := bridge.BatchCommitDiffs(requests, gitlib.DiffAlgorithmMyers, false)
+	require.Len(t, fused[0].Changes, 4)
+	require.Len(t, fused[0].FileDiffs, 2)
+
+	exact, err := gitlib.NewTreeDiffFilter(gitlib.TreeDiffFilterOptions{DetectRenames: true, RenameLimit: -1})
+	require.NoError(t, err)
+
+	defer exact.Free()
+
+	repo.SetTreeDiffFilter(exact)
+	require.Len(t, bridge.BatchTreeDiff(requests)[0].Changes, 5)
+}
@@ -27,18 +27,36 @@ type TreeDiffResponse struct {
 	Error       error
 }
 
+// TreeDiffBatchRequest asks for the tree diffs of several commits at once
+// (see CGOBridge.BatchTreeDiff).
+type TreeDiffBatchRequest struct {
+	Ctx      context.Context //nolint:containedctx // Channel-transported request; context must travel with the request.
+	Requests []CommitDiffRequest
+	Response chan<- TreeDiffBatchResponse
+}
+
+// TreeDiffBatchResponse is the response for a TreeDiffBatchRequest.
+type TreeDiffBatchResponse struct {
+	Results []CommitDiffResult
+}
+
 // BlobBatchRequest asks to load a batch of blobs.
 type BlobBatchRequest struct {
 	Ctx      context.Context //nolint:containedctx // Channel-transported request; context must travel with the request.
 	Hashes   []Hash
 	Response chan<- BlobBatchResponse
 	Arena    []byte
+	// Borrow lends libgit2's object buffers instead of copying them
+	// (see CGOBridge.BatchBorrowBlobs). Arena is ignored when set.
+	Borrow bool
 }
 
 // BlobBatchResponse is the response for a BlobBatchRequest.
 type BlobBatchResponse struct {
 	Blobs   []*CachedBlob
 	Results []BlobResult
+	// Cost is what the batch call spent, for sizing later batches.
+	Cost BatchCost
 }
 
 // DiffBatchRequest asks to compute diffs for a batch of pairs.
@@ -46,16 +64,41 @@ type DiffBatchRequest struct {
 	Ctx      context.Context //nolint:containedctx // Channel-transported request; context must travel with the request.
 	Requests []DiffRequest
 	Response chan<- DiffBatchResponse
+	// Positions also returns where every op starts in both blobs
+	// (see CGOBridge.BatchDiffBlobsWithPositions).
+	Positions bool
 }
 
 // DiffBatchResponse is the response for a DiffBatchRequest.
 type DiffBatchResponse struct {
 	Results []DiffResult
+	// Cost is what the batch call spent, for sizing later batches.
+	Cost BatchCost
+}
+
+// CommitDiffsBatchRequest asks for the changes, blobs and line diffs of
+// several commits at once (see CGOBridge.BatchCommitDiffs).
+type CommitDiffsBatchRequest struct {
+	Ctx       context.Context //nolint:containedctx // Channel-transported request; context must travel with the request.
+	Requests  []CommitDiffRequest
+	Algorithm DiffAlgorithm
+	// WithBlobs also returns the changed blobs (borrowed, not copied).
+	WithBlobs bool
+	Response  chan<- CommitDiffsBatchResponse
+}
+
+// CommitDiffsBatchResponse is the response for a CommitDiffsBatchRequest.
+type CommitDiffsBatchResponse struct {
+	Results []CommitDiffsResult
+	// Blobs holds the unique changed blobs of the batch when WithBlobs was set.
+	Blobs []*CachedBlob
 }
 
-func (TreeDiffRequest) isWorkerRequest()  {}
-func (BlobBatchRequest) isWorkerRequest() {}
-func (DiffBatchRequest) isWorkerRequest() {}
+func (TreeDiffRequest) isWorkerRequest()         {}
+func (TreeDiffBatchRequest) isWorkerRequest()    {}
+func (BlobBatchRequest) isWorkerRequest()        {}
+func (DiffBatchRequest) isWorkerRequest()        {}
+func (CommitDiffsBatchRequest) isWorkerRequest() {}
 
 // Worker manages exclusive, sequential access to the libgit2 Repository.
 // It ensures all CGO calls happen on a single OS thread.
@@ -174,12 +217,24 @@ func (w *Worker) handle(req WorkerRequest) {
 			Error:       err,
 		}
 
+	case TreeDiffBatchRequest:
+		typedReq.Response <- TreeDiffBatchResponse{Results: w.bridge.BatchTreeDiff(typedReq.Requests)}
+
 	case BlobBatchRequest:
-		var results []BlobResult
+		var (
+			results []BlobResult
+			cost    BatchCost
+		)
 
-		// Use Arena loading if provided (zero-copy efficiency).
-		if typedReq.Arena != nil {
+		switch {
+		case typedReq.Borrow:
+			results = w.bridge.BatchBorrowBlobs(typedReq.Hashes)
+			cost = w.bridge.LastCost()
+		case typedReq.Arena != nil:
+			// Use Arena loading if provided (zero-copy efficiency).
+			// The cost is of the batch; single-blob fallbacks are not counted.
 			results = w.bridge.BatchLoadBlobsArena(typedReq.Hashes, typedReq.Arena)
+			cost = w.bridge.LastCost()
 
 			// Handle arena overflow by falling back to standard load.
 			for i := range results {
@@ -191,28 +246,44 @@ func (w *Worker) handle(req WorkerRequest) {
 					}
 				}
 			}
-		} else {
+		default:
 			results = w.bridge.BatchLoadBlobs(typedReq.Hashes)
+			cost = w.bridge.LastCost()
 		}
 
-		blobs := make([]*CachedBlob, len(results))
+		typedReq.Response <- BlobBatchResponse{Blobs: cachedBlobs(results), Results: results, Cost: cost}
 
-		for i, res := range results {
-			if res.Error == nil {
-				blobs[i] = &CachedBlob{
-					hash:      res.Hash,
-					size:      res.Size,
-					Data:      res.Data,
-					lineCount: res.LineCount,
-					keepAlive: res.KeepAlive,
-				}
-			}
+	case DiffBatchRequest:
+		var results []DiffResult
+		if typedReq.Positions {
+			results = w.bridge.BatchDiffBlobsWithPositions(typedReq.Requests)
+		} else {
+			results = w.bridge.BatchDiffBlobs(typedReq.Requests)
 		}
 
-		typedReq.Response <- BlobBatchResponse{Blobs: blobs, Results: results}
+		typedReq.Response <- DiffBatchResponse{Results: results, Cost: w.bridge.LastCost()}
 
-	case DiffBatchRequest:
-		results := w.bridge.BatchDiffBlobs(typedReq.Requests)
-		typedReq.Response <- DiffBatchResponse{Results: results}
+	case CommitDiffsBatchRequest:
+		results, blobs := w.bridge.BatchCommitDiffs(typedReq.Requests, typedReq.Algorithm, typedReq.WithBlobs)
+		typedReq.Response <- CommitDiffsBatchResponse{Results: results, Blobs: cachedBlobs(blobs)}
 	}
 }
+
+// cachedBlobs wraps loaded blobs in CachedBlobs; failed loads stay nil.
+func cachedBlobs(results []BlobResult) []*CachedBlob {
+	blobs := make([]*CachedBlob, len(results))
+
+	for i, res := range results {
+		if res.Error == nil {
+			blobs[i] = &CachedBlob{
+				hash:      res.Hash,
+				size:      res.Size,
+				Data:      res.Data,
+				lineCount: res.LineCount,
+				keepAlive: res.KeepAlive,
+			}
+		}
+	}
+
+	return blobs
+}
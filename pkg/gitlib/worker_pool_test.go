@@ -0,0 +1,66 @@
+package gitlib_test
+
+import (
+	"fmt"
+	"testing"
+
+	"github.com/stretchr/testify/require"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
+)
+
+func TestWorkerPool_SharedObjectDatabase(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	const blobCount = 6
+
+	hashes := make([]gitlib.Hash, blobCount)
+
+	for i := range blobCount {
+		oid, err := tr.native.CreateBlobFromBuffer(fmt.Appendf(nil, "blob %d\n", i))
+		require.NoError(t, err)
+
+		hashes[i] = gitlib.HashFromOid(oid)
+	}
+
+	source, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	reqCh := make(chan gitlib.WorkerRequest, blobCount)
+
+	pool, err := gitlib.NewWorkerPool(source, 3, reqCh)
+	require.NoError(t, err)
+	require.Equal(t, 3, pool.Size())
+	require.Len(t, pool.Repositories(), 3)
+
+	// The shared object database is reference counted and outlives source.
+	source.Free()
+
+	pool.Start()
+
+	respCh := make(chan gitlib.BlobBatchResponse, blobCount)
+	for _, h := range hashes {
+		reqCh <- gitlib.BlobBatchRequest{Hashes: []gitlib.Hash{h}, Response: respCh}
+	}
+
+	seen := make(map[gitlib.Hash]string, blobCount)
+
+	for range blobCount {
+		resp := <-respCh
+		require.Len(t, resp.Blobs, 1)
+		require.NotNil(t, resp.Blobs[0])
+
+		seen[resp.Blobs[0].Hash()] = string(resp.Blobs[0].Data)
+	}
+
+	for i, h := range hashes {
+		require.Equal(t, fmt.Sprintf("blob %d\n", i), seen[h])
+	}
+
+	close(reqCh)
+	pool.Stop()
+	pool.Free()
+}
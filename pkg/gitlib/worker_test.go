@@ -2,7 +2,10 @@ package gitlib_test
 
 import (
 	"context"
+	"strconv"
+	"strings"
 	"testing"
+	"time"
 
 	"github.com/stretchr/testify/require"
 
@@ -164,6 +167,41 @@ func TestWorker_BlobBatchRequestEmpty(t *testing.T) {
 	worker.Stop()
 }
 
+// TestWorker_BlobBatchBorrow checks the worker serves borrowed blobs as CachedBlobs.
+func TestWorker_BlobBatchBorrow(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	oid, err := tr.native.CreateBlobFromBuffer([]byte("one\ntwo\n"))
+	require.NoError(t, err)
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	reqCh := make(chan gitlib.WorkerRequest, 1)
+	worker := gitlib.NewWorker(repo, reqCh)
+	worker.Start()
+
+	respCh := make(chan gitlib.BlobBatchResponse, 1)
+	reqCh <- gitlib.BlobBatchRequest{Hashes: []gitlib.Hash{gitlib.HashFromOid(oid)}, Borrow: true, Response: respCh}
+
+	resp := <-respCh
+	require.Len(t, resp.Blobs, 1)
+	require.NotNil(t, resp.Blobs[0])
+	require.Equal(t, "one\ntwo\n", string(resp.Blobs[0].Data))
+
+	lines, err := resp.Blobs[0].CountLines()
+	require.NoError(t, err)
+	require.Equal(t, 2, lines)
+
+	close(reqCh)
+	worker.Stop()
+}
+
 func TestWorker_TreeDiffRequestInvalidHash(t *testing.T) {
 	t.Parallel()
 
@@ -299,6 +337,617 @@ func TestCGOBridge_BatchDiffBlobsInvalidHash(t *testing.T) {
 	require.Equal(t, gitlib.ErrDiffLookup, results[0].Error)
 }
 
+// TestCGOBridge_BatchDiffBlobsTrivial checks the single-op fast paths for added, deleted and unchanged blobs.
+func TestCGOBridge_BatchDiffBlobsTrivial(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	oid, err := tr.native.CreateBlobFromBuffer([]byte("a\nb\nc\n"))
+	require.NoError(t, err)
+
+	hash := gitlib.HashFromOid(oid)
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	bridge := gitlib.NewCGOBridge(repo)
+	results := bridge.BatchDiffBlobs([]gitlib.DiffRequest{
+		{NewHash: hash, HasNew: true},
+		{OldHash: hash, HasOld: true},
+		{OldHash: hash, NewHash: hash, HasOld: true, HasNew: true},
+	})
+	require.Len(t, results, 3)
+
+	expected := []gitlib.DiffOp{
+		{Type: gitlib.DiffOpInsert, LineCount: 3},
+		{Type: gitlib.DiffOpDelete, LineCount: 3},
+		{Type: gitlib.DiffOpEqual, LineCount: 3},
+	}
+
+	for i, res := range results {
+		require.NoError(t, res.Error)
+		require.Equal(t, []gitlib.DiffOp{expected[i]}, res.Ops)
+	}
+}
+
+// TestCGOBridge_BatchDiffBlobsAlgorithms checks every algorithm yields a consistent op stream.
+func TestCGOBridge_BatchDiffBlobsAlgorithms(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	oldData := []byte("a\nb\nc\nd\ne\nf\n")
+	newData := []byte("a\nc\nb\nd\nx\nf\ng\n")
+
+	bridge := gitlib.NewCGOBridge(repo)
+
+	for _, algorithm := range []gitlib.DiffAlgorithm{
+		gitlib.DiffAlgorithmMyers,
+		gitlib.DiffAlgorithmMinimal,
+		gitlib.DiffAlgorithmPatience,
+		gitlib.DiffAlgorithmHistogram,
+	} {
+		results := bridge.BatchDiffBlobs([]gitlib.DiffRequest{{
+			OldHash:   gitlib.Hash{0: 1},
+			NewHash:   gitlib.Hash{0: 2},
+			OldData:   oldData,
+			NewData:   newData,
+			HasOld:    true,
+			HasNew:    true,
+			Algorithm: algorithm,
+		}})
+		require.Len(t, results, 1)
+		require.NoError(t, results[0].Error)
+
+		var oldSeen, newSeen int
+
+		for _, op := range results[0].Ops {
+			if op.Type != gitlib.DiffOpInsert {
+				oldSeen += op.LineCount
+			}
+
+			if op.Type != gitlib.DiffOpDelete {
+				newSeen += op.LineCount
+			}
+		}
+
+		require.Equal(t, 6, oldSeen, "algorithm %d", algorithm)
+		require.Equal(t, 7, newSeen, "algorithm %d", algorithm)
+	}
+}
+
+// TestCGOBridge_BatchDiffBlobsWithPositions checks every op carries the line
+// and byte offset where it starts in both blobs.
+func TestCGOBridge_BatchDiffBlobsWithPositions(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	oldData := []byte("a\nbb\nc\nd\n")
+	newData := []byte("a\nxyz\nq\nc\nd\n")
+
+	results := gitlib.NewCGOBridge(repo).BatchDiffBlobsWithPositions([]gitlib.DiffRequest{{
+		OldHash: gitlib.Hash{0: 1},
+		NewHash: gitlib.Hash{0: 2},
+		OldData: oldData,
+		NewData: newData,
+		HasOld:  true,
+		HasNew:  true,
+	}})
+	require.Len(t, results, 1)
+	require.NoError(t, results[0].Error)
+
+	require.Equal(t, []gitlib.DiffOp{
+		{Type: gitlib.DiffOpEqual, LineCount: 1},
+		{Type: gitlib.DiffOpDelete, LineCount: 1},
+		{Type: gitlib.DiffOpInsert, LineCount: 2},
+		{Type: gitlib.DiffOpEqual, LineCount: 2},
+	}, results[0].Ops)
+
+	require.Equal(t, []gitlib.DiffOpPosition{
+		{OldLine: 0, NewLine: 0, OldOffset: 0, NewOffset: 0},
+		{OldLine: 1, NewLine: 1, OldOffset: 2, NewOffset: 2},
+		{OldLine: 2, NewLine: 1, OldOffset: 5, NewOffset: 2},
+		{OldLine: 2, NewLine: 3, OldOffset: 5, NewOffset: 8},
+	}, results[0].Positions)
+}
+
+// TestCGOBridge_SubmitDiffBatch checks a batch diffed on the bridge's
+// native worker matches the synchronous batch, whether polled or waited
+// for, and that the bridge rejects other calls while it runs.
+func TestCGOBridge_SubmitDiffBatch(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	bridge := gitlib.NewCGOBridge(repo)
+	requests := []gitlib.DiffRequest{
+		{OldData: []byte("a\nbb\nc\nd\n"), NewData: []byte("a\nxyz\nq\nc\nd\n"), HasOld: true, HasNew: true},
+		{OldData: []byte("x\n"), NewData: []byte("x\ny\n"), HasOld: true, HasNew: true},
+	}
+
+	want := bridge.BatchDiffBlobsWithPositions(requests)
+
+	ticket := bridge.SubmitDiffBatch(requests, true)
+
+	// The worker owns the handle until the ticket is collected.
+	require.ErrorIs(t, bridge.BatchDiffBlobs(requests)[0].Error, gitlib.ErrBridgeBusy)
+	require.ErrorIs(t, bridge.SubmitDiffBatch(requests, false).Wait()[1].Error, gitlib.ErrBridgeBusy)
+
+	got, ok := ticket.TryCollect()
+	for !ok {
+		time.Sleep(time.Millisecond)
+
+		got, ok = ticket.TryCollect()
+	}
+
+	require.Equal(t, want, got)
+	require.Equal(t, want, ticket.Wait())
+	require.Equal(t, want, bridge.BatchDiffBlobsWithPositions(requests))
+
+	got = bridge.SubmitDiffBatch(requests, false).Wait()
+	require.Len(t, got, len(want))
+
+	for i := range want {
+		require.Equal(t, want[i].Ops, got[i].Ops)
+		require.Nil(t, got[i].Positions)
+	}
+
+	require.Empty(t, bridge.SubmitDiffBatch(nil, false).Wait())
+
+	// Freeing collects an outstanding ticket; the next submit starts a new worker.
+	pending := bridge.SubmitDiffBatch(requests, true)
+	bridge.Free()
+	require.Equal(t, want, pending.Wait())
+	require.Equal(t, want, bridge.SubmitDiffBatch(requests, true).Wait())
+	bridge.Free()
+}
+
+// TestCGOBridge_BatchBorrowBlobs checks borrowed blobs match copied ones and can be released.
+func TestCGOBridge_BatchBorrowBlobs(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	contents := [][]byte{
+		[]byte("a\nb\nc"),
+		[]byte(strings.Repeat("line\n", 100)),
+		{'x', 0, 'y'},
+		{},
+	}
+
+	hashes := make([]gitlib.Hash, 0, len(contents)+1)
+
+	for _, data := range contents {
+		oid, err := tr.native.CreateBlobFromBuffer(data)
+		require.NoError(t, err)
+
+		hashes = append(hashes, gitlib.HashFromOid(oid))
+	}
+
+	hashes = append(hashes, gitlib.ZeroHash())
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	bridge := gitlib.NewCGOBridge(repo)
+	borrowed := bridge.BatchBorrowBlobs(hashes)
+	copied := bridge.BatchLoadBlobs(hashes)
+	require.Len(t, borrowed, len(hashes))
+
+	for i := range contents {
+		require.NoError(t, borrowed[i].Error)
+		require.Equal(t, copied[i].Size, borrowed[i].Size)
+		require.Equal(t, copied[i].IsBinary, borrowed[i].IsBinary)
+		require.Equal(t, copied[i].LineCount, borrowed[i].LineCount)
+		require.Equal(t, string(contents[i]), string(borrowed[i].Data))
+
+		owner, ok := borrowed[i].KeepAlive.(*gitlib.BorrowedBlob)
+		require.True(t, ok)
+
+		owner.Release()
+		owner.Release()
+	}
+
+	last := borrowed[len(contents)]
+	require.Equal(t, gitlib.ErrBlobLookup, last.Error)
+	require.Nil(t, last.KeepAlive)
+}
+
+// TestCGOBridge_BatchProbeBlobs checks probed sizes and binary flags against loaded blobs.
+func TestCGOBridge_BatchProbeBlobs(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	contents := [][]byte{
+		[]byte("a\nb\nc"),
+		append([]byte(strings.Repeat("a", 9000)), 0),
+		{'x', 0, 'y'},
+		{},
+	}
+
+	hashes := make([]gitlib.Hash, 0, len(contents)+1)
+
+	for _, data := range contents {
+		oid, err := tr.native.CreateBlobFromBuffer(data)
+		require.NoError(t, err)
+
+		hashes = append(hashes, gitlib.HashFromOid(oid))
+	}
+
+	hashes = append(hashes, gitlib.ZeroHash())
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	bridge := gitlib.NewCGOBridge(repo)
+	loaded := bridge.BatchLoadBlobs(hashes)
+
+	sizes := bridge.BatchProbeBlobs(hashes, false)
+	require.Len(t, sizes, len(hashes))
+
+	probes := bridge.BatchProbeBlobs(hashes, true)
+	require.Len(t, probes, len(hashes))
+
+	for i := range contents {
+		require.NoError(t, sizes[i].Error, "blob %d", i)
+		require.Equal(t, loaded[i].Size, sizes[i].Size, "blob %d", i)
+		require.False(t, sizes[i].Sniffed, "blob %d", i)
+
+		require.NoError(t, probes[i].Error, "blob %d", i)
+		require.Equal(t, loaded[i].Size, probes[i].Size, "blob %d", i)
+		require.True(t, probes[i].Sniffed, "blob %d", i)
+		require.Equal(t, gitlib.NewCachedBlobForTest(contents[i]).IsBinary(), probes[i].IsBinary, "blob %d", i)
+	}
+
+	require.Equal(t, gitlib.ErrBlobLookup, sizes[len(contents)].Error)
+	require.Equal(t, gitlib.ErrBlobLookup, probes[len(contents)].Error)
+}
+
+// TestCGOBridge_BatchLoadBlobsReusesBuffers checks that batches of shrinking
+// and growing size on one bridge see nothing of the previous batch.
+func TestCGOBridge_BatchLoadBlobsReusesBuffers(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	oidA, err := tr.native.CreateBlobFromBuffer([]byte("a\nb\n"))
+	require.NoError(t, err)
+
+	oidB, err := tr.native.CreateBlobFromBuffer([]byte("c\n"))
+	require.NoError(t, err)
+
+	blobA, blobB := gitlib.HashFromOid(oidA), gitlib.HashFromOid(oidB)
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	bridge := gitlib.NewCGOBridge(repo)
+	contents := map[gitlib.Hash]string{blobA: "a\nb\n", blobB: "c\n"}
+
+	for _, batch := range [][]gitlib.Hash{
+		{blobA, gitlib.ZeroHash(), blobB},
+		{blobB},
+		{gitlib.ZeroHash(), blobB, blobA, blobA},
+	} {
+		loaded := bridge.BatchLoadBlobs(batch)
+		borrowed := bridge.BatchBorrowBlobs(batch)
+		probes := bridge.BatchProbeBlobs(batch, true)
+
+		for i, hash := range batch {
+			if hash.IsZero() {
+				require.Equal(t, gitlib.ErrBlobLookup, loaded[i].Error)
+				require.Equal(t, gitlib.ErrBlobLookup, borrowed[i].Error)
+				require.Equal(t, gitlib.ErrBlobLookup, probes[i].Error)
+
+				continue
+			}
+
+			require.NoError(t, loaded[i].Error)
+			require.Equal(t, contents[hash], string(loaded[i].Data))
+			require.NoError(t, borrowed[i].Error)
+			require.Equal(t, contents[hash], string(borrowed[i].Data))
+			require.NoError(t, probes[i].Error)
+			require.Equal(t, int64(len(contents[hash])), probes[i].Size)
+		}
+
+		for _, res := range borrowed {
+			if owner, ok := res.KeepAlive.(*gitlib.BorrowedBlob); ok {
+				owner.Release()
+			}
+		}
+	}
+}
+
+// TestCGOBridge_LastCost checks the cost reported by blob and diff batches.
+func TestCGOBridge_LastCost(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	oldOid, err := tr.native.CreateBlobFromBuffer([]byte("a\nb\n"))
+	require.NoError(t, err)
+
+	newOid, err := tr.native.CreateBlobFromBuffer([]byte("a\nc\nd\n"))
+	require.NoError(t, err)
+
+	oldHash, newHash := gitlib.HashFromOid(oldOid), gitlib.HashFromOid(newOid)
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	bridge := gitlib.NewCGOBridge(repo)
+
+	bridge.BatchLoadBlobs([]gitlib.Hash{oldHash, gitlib.ZeroHash(), newHash})
+
+	cost := bridge.LastCost()
+	require.Equal(t, 3, cost.Items)
+	require.Equal(t, int64(10), cost.BytesInflated)
+	require.Equal(t, int64(10), cost.BytesCopied)
+	require.Equal(t, int64(10), cost.PeakBytes)
+
+	request := gitlib.DiffRequest{OldHash: oldHash, NewHash: newHash, HasOld: true, HasNew: true}
+	diffs := bridge.BatchDiffBlobs([]gitlib.DiffRequest{request})
+	require.NoError(t, diffs[0].Error)
+
+	cost = bridge.LastCost()
+	require.Equal(t, 1, cost.Items)
+	require.Positive(t, cost.BytesCopied)
+	require.GreaterOrEqual(t, cost.PeakBytes, cost.BytesCopied)
+
+	ticket := bridge.SubmitDiffBatch([]gitlib.DiffRequest{request}, false)
+	ticket.Wait()
+	require.Equal(t, 1, ticket.Cost().Items)
+	require.Equal(t, cost.BytesCopied, ticket.Cost().BytesCopied)
+
+	// A collected ticket replaces the cost of the earlier synchronous batch.
+	bridge.BatchLoadBlobs([]gitlib.Hash{oldHash, newHash})
+	require.Equal(t, 2, bridge.LastCost().Items)
+
+	ticket = bridge.SubmitDiffBatch([]gitlib.DiffRequest{request}, false)
+	ticket.Wait()
+	require.Equal(t, ticket.Cost(), bridge.LastCost())
+	require.Equal(t, 1, bridge.LastCost().Items)
+}
+
+// TestCGOBridge_BatchLoadBlobsScanMatchesCachedBlob checks the native line and binary scan against CachedBlob.
+func TestCGOBridge_BatchLoadBlobsScanMatchesCachedBlob(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	const sniffLength = 8000
+
+	manyLines := strings.Repeat("line\n", 20000)
+	contents := [][]byte{
+		[]byte("x"),
+		[]byte("\n"),
+		[]byte("a\nb"),
+		[]byte(strings.Repeat("a", 31) + "\n" + strings.Repeat("b", 33)),
+		[]byte(manyLines),
+		[]byte(manyLines + "tail"),
+		append([]byte(strings.Repeat("a", sniffLength-1)), 0),
+		append([]byte(strings.Repeat("a\n", sniffLength/2)), 0),
+		[]byte(strings.Repeat("\n", 9000)),
+	}
+
+	hashes := make([]gitlib.Hash, len(contents))
+
+	for i, data := range contents {
+		oid, err := tr.native.CreateBlobFromBuffer(data)
+		require.NoError(t, err)
+
+		hashes[i] = gitlib.HashFromOid(oid)
+	}
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	bridge := gitlib.NewCGOBridge(repo)
+	results := bridge.BatchLoadBlobs(hashes)
+	require.Len(t, results, len(contents))
+
+	for i, data := range contents {
+		require.NoError(t, results[i].Error, "blob %d", i)
+
+		blob := gitlib.NewCachedBlobForTest(data)
+		require.Equal(t, blob.IsBinary(), results[i].IsBinary, "blob %d", i)
+
+		if results[i].IsBinary {
+			continue
+		}
+
+		lines, countErr := blob.CountLines()
+		require.NoError(t, countErr)
+		require.Equal(t, lines, results[i].LineCount, "blob %d", i)
+	}
+}
+
+// TestCGOBridge_BatchDiffBlobsManyOps verifies diffs with far more ops than the
+// initial scratch capacity are returned in full and account for every line.
+func TestCGOBridge_BatchDiffBlobsManyOps(t *testing.T) {
+	t.Parallel()
+
+	const lineCount = 2000
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	tr.createFile("f.txt", "a")
+	tr.commit("only")
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	var oldBuf, newBuf strings.Builder
+
+	for i := range lineCount {
+		line := "line " + strconv.Itoa(i) + "\n"
+		oldBuf.WriteString(line)
+
+		if i%2 == 0 {
+			newBuf.WriteString("changed " + line)
+		} else {
+			newBuf.WriteString(line)
+		}
+	}
+
+	bridge := gitlib.NewCGOBridge(repo)
+	req := gitlib.DiffRequest{
+		OldData: []byte(oldBuf.String()),
+		NewData: []byte(newBuf.String()),
+		HasOld:  true,
+		HasNew:  true,
+	}
+	results := bridge.BatchDiffBlobs([]gitlib.DiffRequest{req})
+	require.Len(t, results, 1)
+	require.NoError(t, results[0].Error)
+	require.Greater(t, len(results[0].Ops), lineCount)
+
+	var oldSeen, newSeen int
+
+	for _, op := range results[0].Ops {
+		switch op.Type {
+		case gitlib.DiffOpEqual:
+			oldSeen += op.LineCount
+			newSeen += op.LineCount
+		case gitlib.DiffOpDelete:
+			oldSeen += op.LineCount
+		case gitlib.DiffOpInsert:
+			newSeen += op.LineCount
+		}
+	}
+
+	require.Equal(t, results[0].OldLines, oldSeen)
+	require.Equal(t, results[0].NewLines, newSeen)
+}
+
+// TestCGOBridge_BatchDiffBlobsReusesOpBuffer verifies each result of a batch
+// owns its own slice of the flat op arena across repeated calls on one bridge.
+func TestCGOBridge_BatchDiffBlobsReusesOpBuffer(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	tr.createFile("f.txt", "a")
+	tr.commit("only")
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	requests := []gitlib.DiffRequest{
+		{OldData: []byte("a\nb\n"), NewData: []byte("a\nb\nc\n"), HasOld: true, HasNew: true},
+		{OldData: []byte("a\nb\nc\n"), NewData: []byte("c\n"), HasOld: true, HasNew: true},
+		{OldData: []byte("x\n"), NewData: []byte("x\n"), HasOld: true, HasNew: true},
+	}
+	expected := [][]gitlib.DiffOp{
+		{{Type: gitlib.DiffOpEqual, LineCount: 2}, {Type: gitlib.DiffOpInsert, LineCount: 1}},
+		{{Type: gitlib.DiffOpDelete, LineCount: 2}, {Type: gitlib.DiffOpEqual, LineCount: 1}},
+		{{Type: gitlib.DiffOpEqual, LineCount: 1}},
+	}
+
+	bridge := gitlib.NewCGOBridge(repo)
+
+	for range 3 {
+		results := bridge.BatchDiffBlobs(requests)
+		require.Len(t, results, len(requests))
+
+		for i, res := range results {
+			require.NoError(t, res.Error)
+			require.Equal(t, expected[i], res.Ops, "request %d", i)
+		}
+	}
+}
+
+// TestConfigureParallelism_BatchDiffBlobs verifies batches large enough to go
+// parallel produce the same ops as sequential ones. Not parallel: the thread
+// budget is process-wide.
+func TestConfigureParallelism_BatchDiffBlobs(t *testing.T) {
+	const (
+		parallelThreads = 4
+		requestCount    = 32
+	)
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	tr.createFile("f.txt", "a")
+	tr.commit("only")
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	requests := make([]gitlib.DiffRequest, requestCount)
+	for i := range requests {
+		prefix := strings.Repeat("same\n", i)
+		requests[i] = gitlib.DiffRequest{
+			OldData: []byte(prefix + "old\n"),
+			NewData: []byte(prefix + "new\nextra\n"),
+			HasOld:  true,
+			HasNew:  true,
+		}
+	}
+
+	bridge := gitlib.NewCGOBridge(repo)
+
+	require.Equal(t, 1, gitlib.ConfigureParallelism(1))
+
+	sequential := bridge.BatchDiffBlobs(requests)
+
+	effective := gitlib.ConfigureParallelism(parallelThreads)
+	defer gitlib.ConfigureParallelism(1)
+
+	require.Contains(t, []int{1, parallelThreads}, effective)
+
+	parallel := bridge.BatchDiffBlobs(requests)
+	require.Equal(t, sequential, parallel)
+}
+
 // TestCGOBridge_TreeDiffSameHash verifies TreeDiff returns empty when both tree hashes are equal (skip path).
 func TestCGOBridge_TreeDiffSameHash(t *testing.T) {
 	t.Parallel()
@@ -327,3 +976,361 @@ func TestCGOBridge_TreeDiffSameHash(t *testing.T) {
 	require.NoError(t, err)
 	require.Empty(t, changes)
 }
+
+// TestCGOBridge_TreeDiffPathInterner checks interned tree diffs match plain ones and keep stable path IDs.
+func TestCGOBridge_TreeDiffPathInterner(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	tr.createFile("keep.txt", "v1")
+	tr.createFile("dir/gone.txt", "bye")
+	first := tr.commit("first")
+
+	tr.createFile("keep.txt", "v2")
+	tr.createFile("dir/new.txt", "hi")
+	tr.deleteFile("dir/gone.txt")
+	second := tr.commit("second")
+
+	tr.createFile("keep.txt", "v3")
+	third := tr.commit("third")
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	treeHashes := make([]gitlib.Hash, 0, 3)
+
+	for _, hash := range []gitlib.Hash{first, second, third} {
+		commit, lookupErr := repo.LookupCommit(context.Background(), hash)
+		require.NoError(t, lookupErr)
+
+		treeHashes = append(treeHashes, commit.TreeHash())
+		commit.Free()
+	}
+
+	plain := gitlib.NewCGOBridge(repo)
+	interned := gitlib.NewCGOBridge(repo)
+	interner := gitlib.NewPathInterner()
+	interned.SetPathInterner(interner)
+
+	keepIDs := make([]uint32, 0, 2)
+
+	for i := 1; i < len(treeHashes); i++ {
+		want, wantErr := plain.TreeDiff(treeHashes[i-1], treeHashes[i])
+		require.NoError(t, wantErr)
+
+		got, gotErr := interned.TreeDiff(treeHashes[i-1], treeHashes[i])
+		require.NoError(t, gotErr)
+		require.Len(t, got, len(want))
+
+		for j := range want {
+			require.Equal(t, want[j].Action, got[j].Action)
+			require.Equal(t, want[j].From.Name, got[j].From.Name)
+			require.Equal(t, want[j].To.Name, got[j].To.Name)
+			require.Equal(t, want[j].From.Hash, got[j].From.Hash)
+			require.Equal(t, want[j].To.Hash, got[j].To.Hash)
+			require.Zero(t, want[j].To.PathID)
+
+			if got[j].To.Name == "keep.txt" {
+				require.Equal(t, got[j].From.PathID, got[j].To.PathID)
+				keepIDs = append(keepIDs, got[j].To.PathID)
+			}
+		}
+	}
+
+	require.Len(t, keepIDs, 2)
+	require.Equal(t, keepIDs[0], keepIDs[1])
+	require.Equal(t, "keep.txt", interner.Path(keepIDs[0]))
+	require.Equal(t, 3, interner.Len())
+}
+
+// TestCGOBridge_BatchTreeDiff checks batched commit diffs against per-commit tree diffs.
+func TestCGOBridge_BatchTreeDiff(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	tr.createFile("a.txt", "1")
+	tr.createFile("dir/b.txt", "1")
+	first := tr.commit("first")
+
+	tr.createFile("a.txt", "2")
+	tr.createFile("c.txt", "new")
+	second := tr.commit("second")
+
+	tr.deleteFile("dir/b.txt")
+	third := tr.commit("third")
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	commits := []gitlib.Hash{first, second, third}
+	treeHashes := make([]gitlib.Hash, len(commits))
+
+	for i, hash := range commits {
+		commit, lookupErr := repo.LookupCommit(context.Background(), hash)
+		require.NoError(t, lookupErr)
+
+		treeHashes[i] = commit.TreeHash()
+		commit.Free()
+	}
+
+	bridge := gitlib.NewCGOBridge(repo)
+	results := bridge.BatchTreeDiff([]gitlib.CommitDiffRequest{
+		{CommitHash: first},
+		{CommitHash: second},
+		{CommitHash: third},
+		{CommitHash: third, ParentHash: first},
+		{CommitHash: gitlib.ZeroHash()},
+	})
+	require.Len(t, results, 5)
+
+	expected := []struct{ from, to gitlib.Hash }{
+		{gitlib.ZeroHash(), treeHashes[0]},
+		{treeHashes[0], treeHashes[1]},
+		{treeHashes[1], treeHashes[2]},
+		{treeHashes[0], treeHashes[2]},
+	}
+
+	for i, pair := range expected {
+		require.NoError(t, results[i].Error, "commit %d", i)
+		require.Equal(t, pair.to, results[i].TreeHash, "commit %d", i)
+
+		want, wantErr := bridge.TreeDiff(pair.from, pair.to)
+		require.NoError(t, wantErr)
+		require.Equal(t, want, results[i].Changes, "commit %d", i)
+	}
+
+	require.Len(t, results[0].Changes, 2)
+	require.Equal(t, gitlib.ErrDiffLookup, results[4].Error)
+}
+
+// TestWorker_TreeDiffBatch checks batched tree diffs through the worker.
+func TestWorker_TreeDiffBatch(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	tr.createFile("a.txt", "1")
+	first := tr.commit("first")
+
+	tr.createFile("a.txt", "2")
+	second := tr.commit("second")
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	reqCh := make(chan gitlib.WorkerRequest)
+	worker := gitlib.NewWorker(repo, reqCh)
+	worker.Start()
+
+	respCh := make(chan gitlib.TreeDiffBatchResponse, 1)
+	reqCh <- gitlib.TreeDiffBatchRequest{
+		Ctx:      context.Background(),
+		Requests: []gitlib.CommitDiffRequest{{CommitHash: first}, {CommitHash: second}},
+		Response: respCh,
+	}
+
+	resp := <-respCh
+
+	close(reqCh)
+	worker.Stop()
+
+	require.Len(t, resp.Results, 2)
+	require.NoError(t, resp.Results[0].Error)
+	require.Len(t, resp.Results[0].Changes, 1)
+	require.Equal(t, gitlib.Insert, resp.Results[0].Changes[0].Action)
+	require.NoError(t, resp.Results[1].Error)
+	require.Len(t, resp.Results[1].Changes, 1)
+	require.Equal(t, gitlib.Modify, resp.Results[1].Changes[0].Action)
+	require.Equal(t, "a.txt", resp.Results[1].Changes[0].To.Name)
+}
+
+// TestCGOBridge_BatchCommitDiffs checks fused tree diffs, blob loads and line
+// diffs against the separate bridge calls.
+func TestCGOBridge_BatchCommitDiffs(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	tr.createFile("a.txt", "x\ny\nz\n")
+	tr.createFile("bin", "b\x00in")
+	first := tr.commit("first")
+
+	tr.createFile("a.txt", "x\nY\nz\nw\n")
+	tr.createFile("bin", "b\x00in2")
+	tr.createFile("c.txt", "new\n")
+	second := tr.commit("second")
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	bridge := gitlib.NewCGOBridge(repo)
+	requests := []gitlib.CommitDiffRequest{{CommitHash: first}, {CommitHash: second}}
+	trees := bridge.BatchTreeDiff(requests)
+
+	for _, withBlobs := range []bool{false, true} {
+		results, blobs := bridge.BatchCommitDiffs(requests, gitlib.DiffAlgorithmMyers, withBlobs)
+		require.Len(t, results, 2)
+
+		for i := range results {
+			require.NoError(t, results[i].Error)
+			require.Equal(t, trees[i].Changes, results[i].Changes)
+			require.Equal(t, trees[i].TreeHash, results[i].TreeHash)
+		}
+
+		require.Empty(t, results[0].FileDiffs)
+		require.Len(t, results[1].FileDiffs, 2)
+
+		for _, fileDiff := range results[1].FileDiffs {
+			if fileDiff.Change.To.Name == "bin" {
+				require.Equal(t, gitlib.ErrDiffBinary, fileDiff.Error)
+
+				continue
+			}
+
+			want := bridge.BatchDiffBlobs([]gitlib.DiffRequest{{
+				OldHash: fileDiff.Change.From.Hash, NewHash: fileDiff.Change.To.Hash,
+				HasOld: true, HasNew: true,
+			}})
+			require.Equal(t, "a.txt", fileDiff.Change.To.Name)
+			require.Equal(t, want[0], fileDiff.DiffResult)
+		}
+
+		if !withBlobs {
+			require.Empty(t, blobs)
+
+			continue
+		}
+
+		// a.txt, bin (two versions each) and c.txt, each loaded once.
+		require.Len(t, blobs, 5)
+
+		for _, blob := range blobs {
+			require.NoError(t, blob.Error)
+
+			want := bridge.BatchLoadBlobs([]gitlib.Hash{blob.Hash})
+			require.Equal(t, want[0].Data, blob.Data)
+			blob.KeepAlive.(*gitlib.BorrowedBlob).Release()
+		}
+	}
+}
+
+// TestWorker_CommitDiffsBatch checks fused commit diffs through the worker.
+func TestWorker_CommitDiffsBatch(t *testing.T) {
+	t.Parallel()
+
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	tr.createFile("a.txt", "1\n")
+	first := tr.commit("first")
+
+	tr.createFile("a.txt", "2\n")
+	second := tr.commit("second")
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	reqCh := make(chan gitlib.WorkerRequest)
+	worker := gitlib.NewWorker(repo, reqCh)
+	worker.Start()
+
+	respCh := make(chan gitlib.CommitDiffsBatchResponse, 1)
+	reqCh <- gitlib.CommitDiffsBatchRequest{
+		Ctx:       context.Background(),
+		Requests:  []gitlib.CommitDiffRequest{{CommitHash: first}, {CommitHash: second}},
+		WithBlobs: true,
+		Response:  respCh,
+	}
+
+	resp := <-respCh
+
+	close(reqCh)
+	worker.Stop()
+
+	require.Len(t, resp.Results, 2)
+	require.NoError(t, resp.Results[1].Error)
+	require.Len(t, resp.Results[1].FileDiffs, 1)
+	require.Equal(t, 1, resp.Results[1].FileDiffs[0].OldLines)
+	require.Equal(t, 1, resp.Results[1].FileDiffs[0].NewLines)
+	require.Len(t, resp.Blobs, 2)
+
+	for _, blob := range resp.Blobs {
+		require.NotNil(t, blob)
+
+		lines, countErr := blob.CountLines()
+		require.NoError(t, countErr)
+		require.Equal(t, 1, lines)
+	}
+}
+
+// TestCGOBridge_LargeBlobThreshold changes a process-wide setting, so it
+// does not run in parallel with the other tests.
+func TestCGOBridge_LargeBlobThreshold(t *testing.T) { //nolint:paralleltest // Process-wide setting.
+	tr := newTestRepo(t)
+	defer tr.cleanup()
+
+	small := []byte("a\nb\n")
+	large := []byte(strings.Repeat("generated row\n", 1000) + "tail")
+	largeBinary := append([]byte{'x', 0}, large...)
+
+	hashes := make([]gitlib.Hash, 0, 3)
+
+	for _, data := range [][]byte{small, large, largeBinary} {
+		oid, err := tr.native.CreateBlobFromBuffer(data)
+		require.NoError(t, err)
+
+		hashes = append(hashes, gitlib.HashFromOid(oid))
+	}
+
+	repo, err := gitlib.OpenRepository(tr.path)
+	require.NoError(t, err)
+
+	defer repo.Free()
+
+	gitlib.ConfigureLargeBlobThreshold(1024)
+	defer gitlib.ConfigureLargeBlobThreshold(0)
+
+	bridge := gitlib.NewCGOBridge(repo)
+	arena := make([]byte, 64)
+
+	for _, results := range [][]gitlib.BlobResult{
+		bridge.BatchLoadBlobs(hashes),
+		bridge.BatchBorrowBlobs(hashes),
+		bridge.BatchLoadBlobsArena(hashes, arena),
+	} {
+		require.NoError(t, results[0].Error)
+		require.Equal(t, string(small), string(results[0].Data))
+
+		require.ErrorIs(t, results[1].Error, gitlib.ErrBlobTooLarge)
+		require.Nil(t, results[1].Data)
+		require.Equal(t, int64(len(large)), results[1].Size)
+		require.False(t, results[1].IsBinary)
+		require.Equal(t, 1001, results[1].LineCount)
+
+		require.ErrorIs(t, results[2].Error, gitlib.ErrBlobTooLarge)
+		require.True(t, results[2].IsBinary)
+	}
+
+	diffs := bridge.BatchDiffBlobs([]gitlib.DiffRequest{
+		{OldHash: hashes[1], NewHash: hashes[2], HasOld: true, HasNew: true},
+		{OldHash: hashes[0], NewHash: hashes[0], HasOld: true, HasNew: true},
+	})
+	require.ErrorIs(t, diffs[0].Error, gitlib.ErrDiffTooLarge)
+	require.NoError(t, diffs[1].Error)
+}
@@ -0,0 +1,285 @@
+package observability
+
+import (
+	"context"
+	"fmt"
+	"strconv"
+	"time"
+
+	"go.opentelemetry.io/otel/attribute"
+	"go.opentelemetry.io/otel/metric"
+)
+
+const (
+	metricNativeObjectsRead    = "codefang.native.objects.read.total"
+	metricNativeBytesInflated  = "codefang.native.bytes.inflated.total"
+	metricNativePreloadDedups  = "codefang.native.preload.dedups.total"
+	metricNativeDiffs          = "codefang.native.diffs.total"
+	metricNativeDiffOps        = "codefang.native.diff.ops.total"
+	metricNativeOpBufferGrows  = "codefang.native.op.buffer.grows.total"
+	metricNativeOpArenaBytes   = "codefang.native.op.arena.bytes.total"
+	metricNativeTreeDiffs      = "codefang.native.tree.diffs.total"
+	metricNativeTreeDeltas     = "codefang.native.tree.deltas.total"
+	metricNativePoolAllocs     = "codefang.native.pool.allocs.total"
+	metricNativePoolFallbacks  = "codefang.native.pool.fallbacks.total"
+	metricNativePoolBytes      = "codefang.native.pool.bytes.total"
+	metricNativeLatencyCount   = "codefang.native.latency.count"
+	metricNativeLatencySum     = "codefang.native.latency.sum.seconds"
+	metricNativeLatencyBuckets = "codefang.native.latency.bucket"
+
+	metricNativeRepoBatches       = "codefang.native.repo.batches.total"
+	metricNativeRepoBytesInflated = "codefang.native.repo.bytes.inflated.total"
+	metricNativeRepoPeakBytes     = "codefang.native.repo.peak.bytes"
+	metricNativeRepoWindowBytes   = "codefang.native.repo.window.bytes"
+	metricNativeRepoWindowCloses  = "codefang.native.repo.window.closes.total"
+	metricNativeRepoCacheBytes    = "codefang.native.repo.cache.bytes"
+
+	attrLE   = "le"
+	attrRepo = "repo"
+
+	leInf = "+Inf"
+)
+
+// NativeLatency holds the latency histogram of one native operation.
+// Buckets[i] counts latencies below Bounds[i]; Buckets has one more entry
+// than Bounds for the latencies above the last bound.
+type NativeLatency struct {
+	Op      string
+	Count   int64
+	Sum     time.Duration
+	Bounds  []time.Duration
+	Buckets []int64
+}
+
+// NativeStats holds a snapshot of the native (C) layer's hot-path counters,
+// decoupled from gitlib types. All values only grow.
+type NativeStats struct {
+	ObjectsRead   int64
+	BytesInflated int64
+	PreloadDedups int64
+	Diffs         int64
+	DiffOps       int64
+	OpBufferGrows int64
+	OpArenaBytes  int64
+	TreeDiffs     int64
+	TreeDeltas    int64
+	PoolAllocs    int64
+	PoolFallbacks int64
+	PoolBytes     int64
+	Latencies     []NativeLatency
+	Repositories  []NativeRepo
+}
+
+// NativeRepo holds the accounting of one repository budget of a fleet scan.
+// WindowBytes, PeakBytes and CacheBytes are current levels; the rest only grow.
+type NativeRepo struct {
+	Name          string
+	Batches       int64
+	BytesInflated int64
+	PeakBytes     int64
+	WindowBytes   int64
+	WindowCloses  int64
+	CacheBytes    int64
+}
+
+// nativeRepoInstrument is one per-repository instrument and how to read it.
+type nativeRepoInstrument struct {
+	instrument metric.Int64Observable
+	value      func(*NativeRepo) int64
+}
+
+// nativeCounter is one observable counter and how to read it from a snapshot.
+type nativeCounter struct {
+	instrument metric.Int64ObservableCounter
+	value      func(*NativeStats) int64
+}
+
+// nativeMetrics holds the observable instruments of RegisterNativeMetrics.
+type nativeMetrics struct {
+	snapshot func() NativeStats
+	counters []nativeCounter
+	repos    []nativeRepoInstrument
+	count    metric.Int64ObservableCounter
+	sum      metric.Float64ObservableCounter
+	buckets  metric.Int64ObservableCounter
+}
+
+// RegisterNativeMetrics registers observable counters that report the native
+// layer's counters and latency histograms. snapshot is called once per
+// collection cycle, so one CGO call serves every instrument.
+func RegisterNativeMetrics(mt metric.Meter, snapshot func() NativeStats) error {
+	nm := &nativeMetrics{snapshot: snapshot}
+
+	counterDefs := []struct {
+		name, description, unit string
+		value                   func(*NativeStats) int64
+	}{
+		{metricNativeObjectsRead, "Objects read from the object database", "{object}",
+			func(s *NativeStats) int64 { return s.ObjectsRead }},
+		{metricNativeBytesInflated, "Decompressed bytes of objects read", "By",
+			func(s *NativeStats) int64 { return s.BytesInflated }},
+		{metricNativePreloadDedups, "Duplicate blob IDs dropped by diff batch preloading", "{blob}",
+			func(s *NativeStats) int64 { return s.PreloadDedups }},
+		{metricNativeDiffs, "Line diffs computed", "{diff}",
+			func(s *NativeStats) int64 { return s.Diffs }},
+		{metricNativeDiffOps, "Diff ops emitted", "{op}",
+			func(s *NativeStats) int64 { return s.DiffOps }},
+		{metricNativeOpBufferGrows, "Diff op buffer reallocations", "{realloc}",
+			func(s *NativeStats) int64 { return s.OpBufferGrows }},
+		{metricNativeOpArenaBytes, "Bytes of diff op arenas built", "By",
+			func(s *NativeStats) int64 { return s.OpArenaBytes }},
+		{metricNativeTreeDiffs, "Tree diffs computed", "{diff}",
+			func(s *NativeStats) int64 { return s.TreeDiffs }},
+		{metricNativeTreeDeltas, "Changes kept by tree diffs", "{change}",
+			func(s *NativeStats) int64 { return s.TreeDeltas }},
+		{metricNativePoolAllocs, "libgit2 allocations served by the pooled allocator", "{alloc}",
+			func(s *NativeStats) int64 { return s.PoolAllocs }},
+		{metricNativePoolFallbacks, "libgit2 allocations the pooled allocator passed to malloc", "{alloc}",
+			func(s *NativeStats) int64 { return s.PoolFallbacks }},
+		{metricNativePoolBytes, "Bytes of allocator pool slabs carved", "By",
+			func(s *NativeStats) int64 { return s.PoolBytes }},
+	}
+
+	repoCounterDefs := []struct {
+		name, description, unit string
+		value                   func(*NativeRepo) int64
+	}{
+		{metricNativeRepoBatches, "Batch calls charged to the repository budget, by repo", "{call}",
+			func(r *NativeRepo) int64 { return r.Batches }},
+		{metricNativeRepoBytesInflated, "Blob bytes read by the repository's batch calls, by repo", "By",
+			func(r *NativeRepo) int64 { return r.BytesInflated }},
+		{metricNativeRepoWindowCloses, "Times the repository's pack windows were released, by repo", "{close}",
+			func(r *NativeRepo) int64 { return r.WindowCloses }},
+	}
+
+	repoGaugeDefs := []struct {
+		name, description, unit string
+		value                   func(*NativeRepo) int64
+	}{
+		{metricNativeRepoPeakBytes, "Largest memory held by one batch call of the repository, by repo", "By",
+			func(r *NativeRepo) int64 { return r.PeakBytes }},
+		{metricNativeRepoWindowBytes, "Blob bytes read since the repository's pack windows were released, by repo", "By",
+			func(r *NativeRepo) int64 { return r.WindowBytes }},
+		{metricNativeRepoCacheBytes, "Bytes held by the repository's object cache, by repo", "By",
+			func(r *NativeRepo) int64 { return r.CacheBytes }},
+	}
+
+	observables := make([]metric.Observable, 0,
+		len(counterDefs)+len(repoCounterDefs)+len(repoGaugeDefs)+3) //nolint:mnd // Three latency instruments.
+
+	for _, def := range counterDefs {
+		counter, err := mt.Int64ObservableCounter(def.name,
+			metric.WithDescription(def.description),
+			metric.WithUnit(def.unit),
+		)
+		if err != nil {
+			return fmt.Errorf("create %s: %w", def.name, err)
+		}
+
+		nm.counters = append(nm.counters, nativeCounter{instrument: counter, value: def.value})
+		observables = append(observables, counter)
+	}
+
+	for _, def := range repoCounterDefs {
+		counter, err := mt.Int64ObservableCounter(def.name,
+			metric.WithDescription(def.description),
+			metric.WithUnit(def.unit),
+		)
+		if err != nil {
+			return fmt.Errorf("create %s: %w", def.name, err)
+		}
+
+		nm.repos = append(nm.repos, nativeRepoInstrument{instrument: counter, value: def.value})
+		observables = append(observables, counter)
+	}
+
+	for _, def := range repoGaugeDefs {
+		gauge, err := mt.Int64ObservableGauge(def.name,
+			metric.WithDescription(def.description),
+			metric.WithUnit(def.unit),
+		)
+		if err != nil {
+			return fmt.Errorf("create %s: %w", def.name, err)
+		}
+
+		nm.repos = append(nm.repos, nativeRepoInstrument{instrument: gauge, value: def.value})
+		observables = append(observables, gauge)
+	}
+
+	var err error
+
+	nm.count, err = mt.Int64ObservableCounter(metricNativeLatencyCount,
+		metric.WithDescription("Native operations timed, by operation"),
+		metric.WithUnit("{operation}"),
+	)
+	if err != nil {
+		return fmt.Errorf("create %s: %w", metricNativeLatencyCount, err)
+	}
+
+	nm.sum, err = mt.Float64ObservableCounter(metricNativeLatencySum,
+		metric.WithDescription("Total time of native operations in seconds, by operation"),
+		metric.WithUnit("s"),
+	)
+	if err != nil {
+		return fmt.Errorf("create %s: %w", metricNativeLatencySum, err)
+	}
+
+	nm.buckets, err = mt.Int64ObservableCounter(metricNativeLatencyBuckets,
+		metric.WithDescription("Native operations faster than the le latency bound, by operation"),
+		metric.WithUnit("{operation}"),
+	)
+	if err != nil {
+		return fmt.Errorf("create %s: %w", metricNativeLatencyBuckets, err)
+	}
+
+	observables = append(observables, nm.count, nm.sum, nm.buckets)
+
+	_, err = mt.RegisterCallback(nm.observe, observables...)
+	if err != nil {
+		return fmt.Errorf("register native metrics callback: %w", err)
+	}
+
+	return nil
+}
+
+// observe takes one snapshot and reports every instrument from it. Latency
+// buckets are reported cumulatively, like Prometheus histogram buckets, and
+// repository budgets under their repo attribute.
+func (nm *nativeMetrics) observe(_ context.Context, obs metric.Observer) error {
+	stats := nm.snapshot()
+
+	for _, counter := range nm.counters {
+		obs.ObserveInt64(counter.instrument, counter.value(&stats))
+	}
+
+	for _, latency := range stats.Latencies {
+		opAttr := attribute.String(attrOp, latency.Op)
+
+		obs.ObserveInt64(nm.count, latency.Count, metric.WithAttributes(opAttr))
+		obs.ObserveFloat64(nm.sum, latency.Sum.Seconds(), metric.WithAttributes(opAttr))
+
+		var cumulative int64
+
+		for i, n := range latency.Buckets {
+			cumulative += n
+
+			le := leInf
+			if i < len(latency.Bounds) {
+				le = strconv.FormatFloat(latency.Bounds[i].Seconds(), 'g', -1, 64)
+			}
+
+			obs.ObserveInt64(nm.buckets, cumulative, metric.WithAttributes(opAttr, attribute.String(attrLE, le)))
+		}
+	}
+
+	for i := range stats.Repositories {
+		repo := &stats.Repositories[i]
+		repoAttr := metric.WithAttributes(attribute.String(attrRepo, repo.Name))
+
+		for _, inst := range nm.repos {
+			obs.ObserveInt64(inst.instrument, inst.value(repo), repoAttr)
+		}
+	}
+
+	return nil
+}
@@ -0,0 +1,124 @@
+package observability_test
+
+import (
+	"context"
+	"testing"
+	"time"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+	sdkmetric "go.opentelemetry.io/otel/sdk/metric"
+	"go.opentelemetry.io/otel/sdk/metric/metricdata"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/observability"
+)
+
+func TestNativeMetrics_Exported(t *testing.T) {
+	t.Parallel()
+
+	reader := sdkmetric.NewManualReader()
+	mp := sdkmetric.NewMeterProvider(sdkmetric.WithReader(reader))
+	meter := mp.Meter("test")
+
+	snapshots := 0
+	snapshot := func() observability.NativeStats {
+		snapshots++
+
+		return observability.NativeStats{
+			ObjectsRead:   12,
+			BytesInflated: 4096,
+			Diffs:         5,
+			Latencies: []observability.NativeLatency{{
+				Op:      "diff",
+				Count:   5,
+				Sum:     3 * time.Millisecond,
+				Bounds:  []time.Duration{time.Microsecond, time.Millisecond},
+				Buckets: []int64{1, 3, 1},
+			}},
+		}
+	}
+
+	err := observability.RegisterNativeMetrics(meter, snapshot)
+	require.NoError(t, err)
+
+	var rm metricdata.ResourceMetrics
+
+	err = reader.Collect(context.Background(), &rm)
+	require.NoError(t, err)
+
+	assert.Equal(t, 1, snapshots, "expected one snapshot per collection")
+
+	reads := findMetric(rm, "codefang.native.objects.read.total")
+	require.NotNil(t, reads, "codefang.native.objects.read.total metric not found")
+
+	readsSum, ok := reads.Data.(metricdata.Sum[int64])
+	require.True(t, ok, "expected Sum data type for objects read")
+	require.Len(t, readsSum.DataPoints, 1)
+	assert.Equal(t, int64(12), readsSum.DataPoints[0].Value)
+
+	buckets := findMetric(rm, "codefang.native.latency.bucket")
+	require.NotNil(t, buckets, "codefang.native.latency.bucket metric not found")
+
+	bucketsSum, ok := buckets.Data.(metricdata.Sum[int64])
+	require.True(t, ok, "expected Sum data type for latency buckets")
+
+	byLE := make(map[string]int64, len(bucketsSum.DataPoints))
+
+	for _, dp := range bucketsSum.DataPoints {
+		le, found := dp.Attributes.Value("le")
+		require.True(t, found)
+
+		byLE[le.AsString()] = dp.Value
+	}
+
+	assert.Equal(t, map[string]int64{"1e-06": 1, "0.001": 4, "+Inf": 5}, byLE)
+}
+
+func TestNativeMetrics_RepositoriesLabeled(t *testing.T) {
+	t.Parallel()
+
+	reader := sdkmetric.NewManualReader()
+	mp := sdkmetric.NewMeterProvider(sdkmetric.WithReader(reader))
+	meter := mp.Meter("test")
+
+	snapshot := func() observability.NativeStats {
+		return observability.NativeStats{
+			Repositories: []observability.NativeRepo{
+				{Name: "alpha", Batches: 3, WindowBytes: 100},
+				{Name: "beta", Batches: 7, WindowBytes: 0, WindowCloses: 2},
+			},
+		}
+	}
+
+	err := observability.RegisterNativeMetrics(meter, snapshot)
+	require.NoError(t, err)
+
+	var rm metricdata.ResourceMetrics
+
+	err = reader.Collect(context.Background(), &rm)
+	require.NoError(t, err)
+
+	batches := findMetric(rm, "codefang.native.repo.batches.total")
+	require.NotNil(t, batches, "codefang.native.repo.batches.total metric not found")
+
+	batchesSum, ok := batches.Data.(metricdata.Sum[int64])
+	require.True(t, ok, "expected Sum data type for repository batches")
+
+	byRepo := make(map[string]int64, len(batchesSum.DataPoints))
+
+	for _, dp := range batchesSum.DataPoints {
+		repo, found := dp.Attributes.Value("repo")
+		require.True(t, found)
+
+		byRepo[repo.AsString()] = dp.Value
+	}
+
+	assert.Equal(t, map[string]int64{"alpha": 3, "beta": 7}, byRepo)
+
+	window := findMetric(rm, "codefang.native.repo.window.bytes")
+	require.NotNil(t, window, "codefang.native.repo.window.bytes metric not found")
+
+	windowGauge, ok := window.Data.(metricdata.Gauge[int64])
+	require.True(t, ok, "expected Gauge data type for repository window bytes")
+	require.Len(t, windowGauge.DataPoints, 2)
+}
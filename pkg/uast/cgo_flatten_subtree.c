@@ -0,0 +1,201 @@
+#include "cgo_flatten_subtree.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+typedef struct {
+	uint32_t row;
+	uint32_t column;
+} TSPoint;
+
+typedef struct {
+	uint32_t context[4];
+	const void *id;
+	const void *tree;
+} TSNode;
+
+/* Matches TSTreeCursor in tree-sitter's api.h. */
+typedef struct {
+	const void *tree;
+	const void *id;
+	uint32_t context[3];
+} TSTreeCursor;
+
+extern TSTreeCursor ts_tree_cursor_new(TSNode node);
+extern void ts_tree_cursor_delete(TSTreeCursor *self);
+extern TSNode ts_tree_cursor_current_node(const TSTreeCursor *self);
+extern bool ts_tree_cursor_goto_first_child(TSTreeCursor *self);
+extern bool ts_tree_cursor_goto_next_sibling(TSTreeCursor *self);
+extern bool ts_tree_cursor_goto_parent(TSTreeCursor *self);
+
+extern uint16_t ts_node_symbol(TSNode self);
+extern bool ts_node_is_named(TSNode self);
+extern uint32_t ts_node_start_byte(TSNode self);
+extern uint32_t ts_node_end_byte(TSNode self);
+extern TSPoint ts_node_start_point(TSNode self);
+extern TSPoint ts_node_end_point(TSNode self);
+extern uint32_t ts_node_child_count(TSNode self);
+extern uint32_t ts_node_named_child_count(TSNode self);
+
+#define FLAT_INITIAL_DEPTH 64
+
+/*
+ * Per cursor depth: the entry emitted at that depth, or CF_FLAT_NO_PARENT
+ * for anonymous nodes, and the nearest named ancestor entry below it.
+ */
+typedef struct {
+	uint32_t entry;
+	uint32_t parent;
+} flat_frame;
+
+static void write_entry(cf_flat_node *entry, TSNode node, uint32_t parent) {
+	TSPoint start = ts_node_start_point(node);
+	TSPoint end = ts_node_end_point(node);
+
+	entry->ctx0 = node.context[0];
+	entry->ctx1 = node.context[1];
+	entry->ctx2 = node.context[2];
+	entry->ctx3 = node.context[3];
+	entry->id = node.id;
+	entry->tree = node.tree;
+	entry->start_byte = ts_node_start_byte(node);
+	entry->end_byte = ts_node_end_byte(node);
+	entry->start_row = start.row;
+	entry->start_col = start.column;
+	entry->end_row = end.row;
+	entry->end_col = end.column;
+	entry->parent = parent;
+	entry->subtree_end = 0;
+	entry->named_child_count = ts_node_named_child_count(node);
+	entry->child_count = ts_node_child_count(node);
+	entry->symbol = ts_node_symbol(node);
+	entry->named = ts_node_is_named(node) ? 1 : 0;
+}
+
+/*
+ * Emit the node under the cursor if it is the root or named, and push its
+ * frame. Returns false if the frame stack could not grow.
+ */
+static bool visit(
+	TSTreeCursor *cursor, flat_frame **stack, uint32_t *stack_cap, uint32_t depth,
+	cf_flat_node *out, uint32_t cap, uint32_t *count
+) {
+	TSNode node = ts_tree_cursor_current_node(cursor);
+	uint32_t parent = depth == 0 ? CF_FLAT_NO_PARENT : (*stack)[depth - 1].parent;
+	flat_frame frame = {CF_FLAT_NO_PARENT, parent};
+
+	if (depth >= *stack_cap) {
+		uint32_t new_cap = *stack_cap * 2;
+		flat_frame *grown = realloc(*stack, (size_t)new_cap * sizeof(flat_frame));
+		if (grown == NULL) {
+			return false;
+		}
+		*stack = grown;
+		*stack_cap = new_cap;
+	}
+
+	if (depth == 0 || ts_node_is_named(node)) {
+		if (*count < cap) {
+			write_entry(&out[*count], node, parent);
+		}
+		frame.entry = *count;
+		frame.parent = *count;
+		(*count)++;
+	}
+
+	(*stack)[depth] = frame;
+	return true;
+}
+
+/* Close the frame at depth: its entry's subtree ends at the current count. */
+static void leave(const flat_frame *stack, uint32_t depth, cf_flat_node *out, uint32_t cap, uint32_t count) {
+	uint32_t entry = stack[depth].entry;
+	if (entry != CF_FLAT_NO_PARENT && entry < cap) {
+		out[entry].subtree_end = count;
+	}
+}
+
+int cf_node_flatten_subtree(
+	uint32_t ctx0,
+	uint32_t ctx1,
+	uint32_t ctx2,
+	uint32_t ctx3,
+	uintptr_t id_raw,
+	uintptr_t tree_raw,
+	cf_flat_node *out,
+	uint32_t cap,
+	uint32_t *total
+) {
+	TSNode root;
+	TSTreeCursor cursor;
+	flat_frame *stack;
+	uint32_t stack_cap = FLAT_INITIAL_DEPTH;
+	uint32_t depth = 0;
+	uint32_t count = 0;
+	int rc = CF_FLAT_OK;
+
+	if (total != NULL) {
+		*total = 0;
+	}
+
+	if (out == NULL) {
+		cap = 0;
+	}
+
+	if (id_raw == 0) {
+		return CF_FLAT_OK;
+	}
+
+	stack = malloc((size_t)stack_cap * sizeof(flat_frame));
+	if (stack == NULL) {
+		return CF_FLAT_ERR_NOMEM;
+	}
+
+	root.context[0] = ctx0;
+	root.context[1] = ctx1;
+	root.context[2] = ctx2;
+	root.context[3] = ctx3;
+	root.id = (const void *)id_raw;
+	root.tree = (const void *)tree_raw;
+
+	cursor = ts_tree_cursor_new(root);
+
+	if (!visit(&cursor, &stack, &stack_cap, depth, out, cap, &count)) {
+		rc = CF_FLAT_ERR_NOMEM;
+		goto done;
+	}
+
+	for (;;) {
+		if (ts_tree_cursor_goto_first_child(&cursor)) {
+			depth++;
+		} else {
+			/* Climb until a sibling exists, closing finished subtrees. */
+			for (;;) {
+				leave(stack, depth, out, cap, count);
+				if (depth == 0) {
+					goto done;
+				}
+				if (ts_tree_cursor_goto_next_sibling(&cursor)) {
+					break;
+				}
+				ts_tree_cursor_goto_parent(&cursor);
+				depth--;
+			}
+		}
+
+		if (!visit(&cursor, &stack, &stack_cap, depth, out, cap, &count)) {
+			rc = CF_FLAT_ERR_NOMEM;
+			goto done;
+		}
+	}
+
+done:
+	ts_tree_cursor_delete(&cursor);
+	free(stack);
+
+	if (total != NULL) {
+		*total = count;
+	}
+
+	return rc;
+}
@@ -0,0 +1,46 @@
+package uast
+
+/*
+#include "cgo_flatten_subtree.h"
+*/
+import "C"
+
+type flatNode C.cf_flat_node
+
+const flatNoParent = uint32(C.CF_FLAT_NO_PARENT)
+
+func flattenSubtreeFromParts(
+	ctx0,
+	ctx1,
+	ctx2,
+	ctx3 uint32,
+	idRaw,
+	treeRaw uintptr,
+	nodes []flatNode,
+	total *uint32,
+) bool {
+	var totalNodes C.uint32_t
+	var output *C.cf_flat_node
+	var outputCap C.uint32_t
+
+	if len(nodes) > 0 {
+		output = (*C.cf_flat_node)(&nodes[0])
+		outputCap = C.uint32_t(len(nodes))
+	}
+
+	rc := C.cf_node_flatten_subtree(
+		C.uint32_t(ctx0),
+		C.uint32_t(ctx1),
+		C.uint32_t(ctx2),
+		C.uint32_t(ctx3),
+		C.uintptr_t(idRaw),
+		C.uintptr_t(treeRaw),
+		output,
+		outputCap,
+		&totalNodes,
+	)
+
+	*total = uint32(totalNodes)
+
+	return rc == C.CF_FLAT_OK
+}
@@ -0,0 +1,62 @@
+#ifndef CODEFANG_UAST_CGO_FLATTEN_SUBTREE_H
+#define CODEFANG_UAST_CGO_FLATTEN_SUBTREE_H
+
+#include <stdint.h>
+
+#define CF_FLAT_NO_PARENT UINT32_MAX
+
+#define CF_FLAT_OK 0
+#define CF_FLAT_ERR_NOMEM -1
+
+/*
+ * One named node of a flattened subtree.
+ *
+ * Entries are written in pre-order, so the named children of entry i start
+ * at i + 1 and each following child starts at the subtree_end of the
+ * previous one; the last child ends at the parent's subtree_end. Nodes
+ * nested in hidden or anonymous nodes belong to their nearest named
+ * ancestor, as with ts_node_named_child.
+ */
+typedef struct {
+	uint32_t ctx0;
+	uint32_t ctx1;
+	uint32_t ctx2;
+	uint32_t ctx3;
+	const void *id;
+	const void *tree;
+	uint32_t start_byte;
+	uint32_t end_byte;
+	uint32_t start_row;
+	uint32_t start_col;
+	uint32_t end_row;
+	uint32_t end_col;
+	uint32_t parent;
+	uint32_t subtree_end;
+	uint32_t named_child_count;
+	uint32_t child_count;
+	uint16_t symbol;
+	uint8_t named;
+} cf_flat_node;
+
+/*
+ * Walk the subtree rooted at the given node with one TSTreeCursor and write
+ * the root and all its named descendants in pre-order to out.
+ *
+ * At most cap entries are written; *total always receives the full entry
+ * count, so a caller seeing *total > cap can grow out and call again.
+ * Returns CF_FLAT_OK, or CF_FLAT_ERR_NOMEM if the ancestor stack could not
+ * be allocated.
+ */
+int cf_node_flatten_subtree(
+	uint32_t ctx0,
+	uint32_t ctx1,
+	uint32_t ctx2,
+	uint32_t ctx3,
+	uintptr_t id_raw,
+	uintptr_t tree_raw,
+	cf_flat_node *out,
+	uint32_t cap,
+	uint32_t *total
+);
+
+#endif
@@ -9,7 +9,7 @@ typedef struct {
 
 extern uint32_t ts_node_named_child_count(TSNode self);
 extern TSNode ts_node_named_child(TSNode self, uint32_t child_index);
-extern const char *ts_node_type(TSNode self);
+extern uint16_t ts_node_symbol(TSNode self);
 
 void cf_node_named_children_batch(
 	uint32_t ctx0,
@@ -61,8 +61,8 @@ void cf_node_named_children_batch(
 		out[idx].ctx3 = child.context[3];
 		out[idx].id = child.id;
 		out[idx].tree = child.tree;
-		out[idx].type_ptr = ts_node_type(child);
 		out[idx].named_child_count = ts_node_named_child_count(child);
+		out[idx].symbol = ts_node_symbol(child);
 	}
 
 	if (written != NULL) {
@@ -10,8 +10,8 @@ typedef struct {
 	uint32_t ctx3;
 	const void *id;
 	const void *tree;
-	const char *type_ptr;
 	uint32_t named_child_count;
+	uint16_t symbol;
 } cf_child_info;
 
 void cf_node_named_children_batch(
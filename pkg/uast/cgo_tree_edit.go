@@ -0,0 +1,45 @@
+package uast
+
+/*
+#include <stdint.h>
+
+typedef struct {
+	uint32_t row;
+	uint32_t column;
+} cf_ts_point;
+
+// Matches TSInputEdit in tree-sitter's api.h.
+typedef struct {
+	uint32_t start_byte;
+	uint32_t old_end_byte;
+	uint32_t new_end_byte;
+	cf_ts_point start_point;
+	cf_ts_point old_end_point;
+	cf_ts_point new_end_point;
+} cf_ts_input_edit;
+
+extern void ts_tree_edit(void *self, const cf_ts_input_edit *edit);
+
+static inline void cf_tree_edit(uintptr_t tree_raw, const cf_ts_input_edit *edits, uint32_t count) {
+	for (uint32_t idx = 0; idx < count; idx++) {
+		ts_tree_edit((void *)tree_raw, &edits[idx]);
+	}
+}
+*/
+import "C"
+
+import "unsafe"
+
+// editTreeFromParts applies edits, in order, to the TSTree at treeRaw with
+// one CGO call. TextEdit has the same layout as TSInputEdit.
+func editTreeFromParts(treeRaw uintptr, edits []TextEdit) {
+	if len(edits) == 0 {
+		return
+	}
+
+	C.cf_tree_edit(
+		C.uintptr_t(treeRaw),
+		(*C.cf_ts_input_edit)(unsafe.Pointer(&edits[0])),
+		C.uint32_t(len(edits)),
+	)
+}
@@ -0,0 +1,42 @@
+package uast
+
+import (
+	"unsafe"
+
+	sitter "github.com/alexaandru/go-tree-sitter-bare"
+)
+
+// flattenSubtree writes the node at nodePtr and all its named descendants to
+// nodes in pre-order with one CGO call. total is the full entry count, which
+// exceeds len(nodes) when the buffer was too small. ok is false if the C walk
+// failed to allocate.
+func flattenSubtree(nodePtr unsafe.Pointer, nodes []flatNode) (total uint32, ok bool) {
+	full := (*tsNodeFull)(nodePtr)
+	if full.id == nil {
+		return 0, true
+	}
+
+	ok = flattenSubtreeFromParts(
+		full.context[0],
+		full.context[1],
+		full.context[2],
+		full.context[3],
+		uintptr(full.id),
+		uintptr(full.tree),
+		nodes,
+		&total,
+	)
+
+	return total, ok
+}
+
+// flatToNode rebuilds the tree-sitter node handle of a flattened entry.
+func flatToNode(entry *flatNode) sitter.Node {
+	raw := tsNodeFull{
+		context: [4]uint32{uint32(entry.ctx0), uint32(entry.ctx1), uint32(entry.ctx2), uint32(entry.ctx3)},
+		id:      entry.id,
+		tree:    entry.tree,
+	}
+
+	return *(*sitter.Node)(unsafe.Pointer(&raw))
+}
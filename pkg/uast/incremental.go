@@ -0,0 +1,289 @@
+package uast
+
+import (
+	"bytes"
+	"sync"
+	"sync/atomic"
+	"unsafe"
+
+	sitter "github.com/alexaandru/go-tree-sitter-bare"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
+)
+
+// DefaultTreeCacheSize is the default maximum number of trees kept by a TreeCache.
+const DefaultTreeCacheSize = 1024
+
+// TextPoint is a zero-based row and byte column in a file.
+type TextPoint struct {
+	Row    uint32
+	Column uint32
+}
+
+// TextEdit is one changed byte range of a file, laid out like tree-sitter's
+// TSInputEdit. Edits apply in order, each in the coordinates of the text
+// produced by the edits before it.
+type TextEdit struct {
+	StartByte   uint32
+	OldEndByte  uint32
+	NewEndByte  uint32
+	StartPoint  TextPoint
+	OldEndPoint TextPoint
+	NewEndPoint TextPoint
+}
+
+// LineEdits converts a line diff of oldContent to newContent into the edits
+// that update a tree parsed from oldContent. Each run of deleted and inserted
+// lines between equal lines becomes one edit. ok is false if the line counts
+// of ops do not cover both contents exactly.
+func LineEdits(oldContent, newContent []byte, ops []gitlib.DiffOp) (edits []TextEdit, ok bool) {
+	var (
+		oldPos, newPos int
+		point          TextPoint
+	)
+
+	for idx := 0; idx < len(ops); {
+		if ops[idx].Type == gitlib.DiffOpEqual {
+			oldEnd, _, _, oldOK := advanceLines(oldContent, oldPos, ops[idx].LineCount)
+			newEnd, rows, col, newOK := advanceLines(newContent, newPos, ops[idx].LineCount)
+
+			if !oldOK || !newOK {
+				return nil, false
+			}
+
+			oldPos, newPos = oldEnd, newEnd
+			point = endPoint(point, rows, col)
+			idx++
+
+			continue
+		}
+
+		var deleted, inserted int
+
+		for ; idx < len(ops) && ops[idx].Type != gitlib.DiffOpEqual; idx++ {
+			switch ops[idx].Type {
+			case gitlib.DiffOpDelete:
+				deleted += ops[idx].LineCount
+			case gitlib.DiffOpInsert:
+				inserted += ops[idx].LineCount
+			}
+		}
+
+		oldEnd, oldRows, oldCol, oldOK := advanceLines(oldContent, oldPos, deleted)
+		newEnd, newRows, newCol, newOK := advanceLines(newContent, newPos, inserted)
+
+		if !oldOK || !newOK {
+			return nil, false
+		}
+
+		edit := TextEdit{
+			StartByte:   uint32(newPos),
+			OldEndByte:  uint32(newPos + oldEnd - oldPos),
+			NewEndByte:  uint32(newEnd),
+			StartPoint:  point,
+			OldEndPoint: endPoint(point, oldRows, oldCol),
+			NewEndPoint: endPoint(point, newRows, newCol),
+		}
+
+		edits = append(edits, edit)
+		oldPos, newPos = oldEnd, newEnd
+		point = edit.NewEndPoint
+	}
+
+	if oldPos != len(oldContent) || newPos != len(newContent) {
+		return nil, false
+	}
+
+	return edits, true
+}
+
+// advanceLines skips count lines of data starting at the line beginning at
+// pos. rows is the number of line breaks passed and col the length of a
+// final line without a line break.
+func advanceLines(data []byte, pos, count int) (end int, rows, col uint32, ok bool) {
+	for range count {
+		if pos >= len(data) || col != 0 {
+			return 0, 0, 0, false
+		}
+
+		lineEnd := bytes.IndexByte(data[pos:], '\n')
+		if lineEnd < 0 {
+			col = uint32(len(data) - pos)
+			pos = len(data)
+
+			continue
+		}
+
+		pos += lineEnd + 1
+		rows++
+	}
+
+	return pos, rows, col, true
+}
+
+// endPoint returns the point reached from start after rows line breaks and
+// col further bytes.
+func endPoint(start TextPoint, rows, col uint32) TextPoint {
+	if rows == 0 {
+		return TextPoint{Row: start.Row, Column: start.Column + col}
+	}
+
+	return TextPoint{Row: start.Row + rows, Column: col}
+}
+
+// treeCacheEntry is a node in the LRU doubly-linked list.
+type treeCacheEntry struct {
+	path string
+	hash gitlib.Hash
+	tree *sitter.Tree
+	prev *treeCacheEntry
+	next *treeCacheEntry
+}
+
+// TreeCache keeps the tree-sitter tree of the last parsed version of
+// recently seen paths, so Parser.ParseIncremental can reparse the next
+// version from it. A tree is handed to one parse at a time and returned
+// afterwards. Safe for concurrent use.
+type TreeCache struct {
+	mu       sync.Mutex
+	entries  map[string]*treeCacheEntry
+	head     *treeCacheEntry // Most recently used.
+	tail     *treeCacheEntry // Least recently used.
+	maxTrees int
+	hits     atomic.Int64
+	misses   atomic.Int64
+}
+
+// NewTreeCache creates a tree cache holding at most maxTrees trees.
+func NewTreeCache(maxTrees int) *TreeCache {
+	if maxTrees <= 0 {
+		maxTrees = DefaultTreeCacheSize
+	}
+
+	return &TreeCache{
+		entries:  make(map[string]*treeCacheEntry),
+		maxTrees: maxTrees,
+	}
+}
+
+// take removes and returns the tree of path if it was parsed from hash.
+func (c *TreeCache) take(path string, hash gitlib.Hash) *sitter.Tree {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	entry, exists := c.entries[path]
+	if !exists || entry.hash != hash {
+		c.misses.Add(1)
+
+		return nil
+	}
+
+	c.hits.Add(1)
+	c.removeFromList(entry)
+	delete(c.entries, path)
+
+	return entry.tree
+}
+
+// put stores the tree of path parsed from hash, taking ownership of it.
+func (c *TreeCache) put(path string, hash gitlib.Hash, tree *sitter.Tree) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	if entry, exists := c.entries[path]; exists {
+		entry.tree.Close()
+		entry.hash = hash
+		entry.tree = tree
+		c.removeFromList(entry)
+		c.addToFront(entry)
+
+		return
+	}
+
+	entry := &treeCacheEntry{path: path, hash: hash, tree: tree}
+	c.entries[path] = entry
+	c.addToFront(entry)
+
+	for len(c.entries) > c.maxTrees {
+		c.evictLRU()
+	}
+}
+
+// Close frees all cached trees.
+func (c *TreeCache) Close() {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	for _, entry := range c.entries {
+		entry.tree.Close()
+	}
+
+	c.entries = make(map[string]*treeCacheEntry)
+	c.head = nil
+	c.tail = nil
+}
+
+// Len returns the number of cached trees.
+func (c *TreeCache) Len() int {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	return len(c.entries)
+}
+
+// CacheHits returns the total cache hit count (atomic, lock-free).
+func (c *TreeCache) CacheHits() int64 { return c.hits.Load() }
+
+// CacheMisses returns the total cache miss count (atomic, lock-free).
+func (c *TreeCache) CacheMisses() int64 { return c.misses.Load() }
+
+// addToFront adds an entry to the front of the LRU list.
+func (c *TreeCache) addToFront(entry *treeCacheEntry) {
+	entry.prev = nil
+	entry.next = c.head
+
+	if c.head != nil {
+		c.head.prev = entry
+	}
+
+	c.head = entry
+
+	if c.tail == nil {
+		c.tail = entry
+	}
+}
+
+// removeFromList removes an entry from the LRU list.
+func (c *TreeCache) removeFromList(entry *treeCacheEntry) {
+	if entry.prev != nil {
+		entry.prev.next = entry.next
+	} else {
+		c.head = entry.next
+	}
+
+	if entry.next != nil {
+		entry.next.prev = entry.prev
+	} else {
+		c.tail = entry.prev
+	}
+}
+
+// evictLRU removes and frees the least recently used tree.
+func (c *TreeCache) evictLRU() {
+	if c.tail == nil {
+		return
+	}
+
+	entry := c.tail
+	c.removeFromList(entry)
+	delete(c.entries, entry.path)
+	entry.tree.Close()
+}
+
+// editTree applies edits to tree in place.
+func editTree(tree *sitter.Tree, edits []TextEdit) {
+	root := tree.RootNode()
+	full := (*tsNodeFull)(unsafe.Pointer(&root))
+
+	editTreeFromParts(uintptr(full.tree), edits)
+}
@@ -0,0 +1,156 @@
+package uast
+
+import (
+	"context"
+	"reflect"
+	"testing"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
+)
+
+func TestLineEdits(t *testing.T) {
+	t.Parallel()
+
+	oldContent := []byte("a\nbb\nc\nd")
+	newContent := []byte("a\nxyz\nq\nc\nd")
+
+	ops := []gitlib.DiffOp{
+		{Type: gitlib.DiffOpEqual, LineCount: 1},
+		{Type: gitlib.DiffOpDelete, LineCount: 1},
+		{Type: gitlib.DiffOpInsert, LineCount: 2},
+		{Type: gitlib.DiffOpEqual, LineCount: 2},
+	}
+
+	edits, ok := LineEdits(oldContent, newContent, ops)
+	if !ok {
+		t.Fatal("Expected line ops to match contents")
+	}
+
+	want := []TextEdit{{
+		StartByte:   2,
+		OldEndByte:  5,
+		NewEndByte:  8,
+		StartPoint:  TextPoint{Row: 1},
+		OldEndPoint: TextPoint{Row: 2},
+		NewEndPoint: TextPoint{Row: 3},
+	}}
+
+	if !reflect.DeepEqual(edits, want) {
+		t.Errorf("Expected %+v, got %+v", want, edits)
+	}
+
+	// An edit of the last line without a trailing line break ends mid-row.
+	edits, ok = LineEdits([]byte("a\nb"), []byte("a\nbcd"), []gitlib.DiffOp{
+		{Type: gitlib.DiffOpEqual, LineCount: 1},
+		{Type: gitlib.DiffOpDelete, LineCount: 1},
+		{Type: gitlib.DiffOpInsert, LineCount: 1},
+	})
+	if !ok || len(edits) != 1 {
+		t.Fatalf("Expected one edit, got %+v ok=%v", edits, ok)
+	}
+
+	if edits[0].OldEndPoint != (TextPoint{Row: 1, Column: 1}) || edits[0].NewEndPoint != (TextPoint{Row: 1, Column: 3}) {
+		t.Errorf("Unexpected end points %+v", edits[0])
+	}
+
+	_, ok = LineEdits(oldContent, newContent, ops[:2])
+	if ok {
+		t.Error("Expected ops not covering the contents to be rejected")
+	}
+}
+
+func TestParser_ParseIncremental(t *testing.T) {
+	t.Parallel()
+
+	parser, err := NewParser()
+	if err != nil {
+		t.Fatalf("NewParser failed: %v", err)
+	}
+
+	oldContent := []byte("package main\n\nfunc a() int {\n\treturn 1\n}\n\nfunc b() {}\n")
+	newContent := []byte("package main\n\nfunc a() int {\n\tx := 2\n\treturn x\n}\n\nfunc b() {}\n")
+	oldHash := gitlib.Hash{0: 0x1}
+	newHash := gitlib.Hash{0: 0x2}
+
+	ops := []gitlib.DiffOp{
+		{Type: gitlib.DiffOpEqual, LineCount: 3},
+		{Type: gitlib.DiffOpDelete, LineCount: 1},
+		{Type: gitlib.DiffOpInsert, LineCount: 2},
+		{Type: gitlib.DiffOpEqual, LineCount: 3},
+	}
+
+	edits, ok := LineEdits(oldContent, newContent, ops)
+	if !ok {
+		t.Fatal("Expected line ops to match contents")
+	}
+
+	cache := NewTreeCache(4)
+	defer cache.Close()
+
+	ctx := context.Background()
+
+	// Seed the cache with the old version, then map it again from the cache.
+	for range 2 {
+		before, parseErr := parser.ParseIncremental(ctx, cache, "main.go", oldHash, oldHash, oldContent, nil)
+		if parseErr != nil {
+			t.Fatalf("ParseIncremental failed: %v", parseErr)
+		}
+
+		want, parseErr := parser.Parse(ctx, "main.go", oldContent)
+		if parseErr != nil {
+			t.Fatalf("Parse failed: %v", parseErr)
+		}
+
+		if !reflect.DeepEqual(before, want) {
+			t.Error("Expected the cached tree to map to the same UAST as a full parse")
+		}
+	}
+
+	after, err := parser.ParseIncremental(ctx, cache, "main.go", oldHash, newHash, newContent, edits)
+	if err != nil {
+		t.Fatalf("ParseIncremental failed: %v", err)
+	}
+
+	want, err := parser.Parse(ctx, "main.go", newContent)
+	if err != nil {
+		t.Fatalf("Parse failed: %v", err)
+	}
+
+	if !reflect.DeepEqual(after, want) {
+		t.Error("Expected the incremental reparse to map to the same UAST as a full parse")
+	}
+
+	if cache.CacheHits() != 2 || cache.Len() != 1 {
+		t.Errorf("Expected 2 cache hits and 1 cached tree, got %d and %d", cache.CacheHits(), cache.Len())
+	}
+}
+
+func TestTreeCache_EvictsLeastRecentlyUsed(t *testing.T) {
+	t.Parallel()
+
+	parser, err := NewParser()
+	if err != nil {
+		t.Fatalf("NewParser failed: %v", err)
+	}
+
+	cache := NewTreeCache(2)
+	defer cache.Close()
+
+	content := []byte("package main\n")
+
+	for _, path := range []string{"a.go", "b.go", "c.go"} {
+		_, parseErr := parser.ParseIncremental(context.Background(), cache, path, gitlib.Hash{}, gitlib.Hash{0: 0x1}, content, nil)
+		if parseErr != nil {
+			t.Fatalf("ParseIncremental failed: %v", parseErr)
+		}
+	}
+
+	if cache.Len() != 2 {
+		t.Errorf("Expected 2 cached trees, got %d", cache.Len())
+	}
+
+	if tree := cache.take("a.go", gitlib.Hash{0: 0x1}); tree != nil {
+		tree.Close()
+		t.Error("Expected the least recently used tree to be evicted")
+	}
+}
@@ -10,6 +10,9 @@ import (
 	"maps"
 	"strings"
 
+	sitter "github.com/alexaandru/go-tree-sitter-bare"
+
+	"github.com/Sumatoshi-tech/codefang/pkg/gitlib"
 	"github.com/Sumatoshi-tech/codefang/pkg/uast/pkg/node"
 )
 
@@ -126,6 +129,50 @@ func (parser *Parser) Parse(ctx context.Context, filename string, content []byte
 	return langParser.Parse(ctx, filename, content)
 }
 
+// ParseIncremental parses a file like Parse, reusing the tree-sitter tree
+// that cache holds for filename when that tree was parsed from oldHash.
+// edits describe how content differs from that version (see LineEdits);
+// with newHash equal to oldHash the cached tree is mapped as is. The tree of
+// content is stored back in cache under newHash for the next version.
+// Without a cache, or for languages not parsed by a DSLParser, this is Parse.
+func (parser *Parser) ParseIncremental(
+	ctx context.Context, cache *TreeCache, filename string,
+	oldHash, newHash gitlib.Hash, content []byte, edits []TextEdit,
+) (*node.Node, error) {
+	if cache == nil {
+		return parser.Parse(ctx, filename, content)
+	}
+
+	ext := strings.ToLower(getFileExtension(filename))
+	if ext == "" {
+		return nil, fmt.Errorf("%w for %s", errNoFileExtension, filename)
+	}
+
+	langParser, exists := parser.loader.LanguageParser(ext)
+	if !exists {
+		return nil, fmt.Errorf("%w %s", errNoParser, ext)
+	}
+
+	dslParser, ok := langParser.(*DSLParser)
+	if !ok {
+		return langParser.Parse(ctx, filename, content)
+	}
+
+	var old *sitter.Tree
+	if oldHash == newHash || len(edits) > 0 {
+		old = cache.take(filename, oldHash)
+	}
+
+	canonical, tree, err := dslParser.ParseTree(ctx, content, old, edits)
+	if err != nil {
+		return nil, err
+	}
+
+	cache.put(filename, newHash, tree)
+
+	return canonical, nil
+}
+
 // GetEmbeddedMappings returns all embedded UAST mappings.
 func (parser *Parser) GetEmbeddedMappings() map[string]Map {
 	mappings := make(map[string]Map)
@@ -40,6 +40,7 @@ const maxInternLen = 32
 const (
 	initialInternerCapacity    = 128 // initial capacity for per-parse string interner.
 	initialBatchChildrenBuffer = 32  // small reusable child batch buffer per parse.
+	initialFlatNodesBuffer     = 256 // reusable flattened tree buffer per parse.
 )
 
 // DSLParser implements the UAST LanguageParser interface using DSL-based mappings.
@@ -52,6 +53,7 @@ type DSLParser struct {
 	mappingRules    []mapping.Rule
 	ruleIndex       map[string]int
 	symbolNames     []string
+	symbolRules     []*mapping.Rule
 	internedTypes   map[string]node.Type
 	internedRoles   map[string]node.Role
 	tsParserPool    sync.Pool
@@ -149,6 +151,7 @@ func (parser *DSLParser) initializeLanguage() error {
 	}
 
 	parser.symbolNames = buildSymbolNames(parser.language)
+	parser.symbolRules = buildSymbolRules(parser.symbolNames, parser.mappingRules, parser.ruleIndex)
 
 	return nil
 }
@@ -165,6 +168,24 @@ func buildSymbolNames(language *sitter.Language) []string {
 	return symbolNames
 }
 
+// buildSymbolRules resolves the mapping rule, inheritance included, of every
+// grammar symbol once, so mapping a node is an index into this table instead
+// of a lookup by type name.
+func buildSymbolRules(symbolNames []string, rules []mapping.Rule, ruleIndex map[string]int) []*mapping.Rule {
+	symbolRules := make([]*mapping.Rule, len(symbolNames))
+
+	for symbolID, name := range symbolNames {
+		idx, ok := ruleIndex[name]
+		if !ok {
+			continue
+		}
+
+		symbolRules[symbolID] = resolveRuleInheritance(rules, ruleIndex, &rules[idx])
+	}
+
+	return symbolRules
+}
+
 // Extensions returns the supported file extensions for this parser.
 func (parser *DSLParser) Extensions() []string {
 	return parser.langInfo.Extensions
@@ -178,13 +199,63 @@ func (parser *DSLParser) Parse(ctx context.Context, _ string, content []byte) (*
 	}
 	defer tree.Close()
 
+	return parser.mapTree(tree, content)
+}
+
+// ParseTree is Parse for incremental reparsing. If old is not nil, it must be
+// the tree of the previous version of content: edits are applied to it and
+// tree-sitter reuses its unchanged subtrees. With no edits, old is taken as
+// the tree of content itself and is not reparsed. ParseTree takes ownership
+// of old; the caller owns the returned tree.
+func (parser *DSLParser) ParseTree(
+	ctx context.Context, content []byte, old *sitter.Tree, edits []TextEdit,
+) (*node.Node, *sitter.Tree, error) {
+	tree := old
+
+	if old == nil || len(edits) > 0 {
+		if old != nil {
+			editTree(old, edits)
+		}
+
+		parsed, err := parser.parseTSTreeFrom(ctx, old, content)
+
+		if old != nil {
+			old.Close()
+		}
+
+		if err != nil {
+			return nil, nil, err
+		}
+
+		tree = parsed
+	}
+
+	canonical, err := parser.mapTree(tree, content)
+	if err != nil {
+		tree.Close()
+
+		return nil, nil, err
+	}
+
+	return canonical, tree, nil
+}
+
+// mapTree maps a parsed tree of content to its root UAST node.
+func (parser *DSLParser) mapTree(tree *sitter.Tree, content []byte) (*node.Node, error) {
 	root := tree.RootNode()
 	if root.IsNull() {
 		return nil, errNoRootNode
 	}
 
 	pctx := parser.acquireParseContext(tree, content)
-	canonical := pctx.toCanonicalNode(root, "")
+
+	var canonical *node.Node
+	if pctx.flatten(root) {
+		canonical = pctx.toCanonicalFlat(0, "")
+	} else {
+		canonical = pctx.toCanonicalNode(root, "")
+	}
+
 	parser.releaseParseContext(pctx)
 
 	return canonical, nil
@@ -193,6 +264,13 @@ func (parser *DSLParser) Parse(ctx context.Context, _ string, content []byte) (*
 // parseTSTree parses source bytes into a tree-sitter Tree.
 // The caller is responsible for calling tree.Close().
 func (parser *DSLParser) parseTSTree(ctx context.Context, content []byte) (*sitter.Tree, error) {
+	return parser.parseTSTreeFrom(ctx, nil, content)
+}
+
+// parseTSTreeFrom parses source bytes, reusing the edited tree of the
+// previous version if old is not nil.
+// The caller is responsible for calling tree.Close().
+func (parser *DSLParser) parseTSTreeFrom(ctx context.Context, old *sitter.Tree, content []byte) (*sitter.Tree, error) {
 	tsParser, ok := parser.tsParserPool.Get().(*sitter.Parser)
 	if !ok {
 		return nil, errPoolType
@@ -200,7 +278,7 @@ func (parser *DSLParser) parseTSTree(ctx context.Context, content []byte) (*sitt
 
 	defer parser.tsParserPool.Put(tsParser)
 
-	tree, err := tsParser.ParseString(ctx, nil, content)
+	tree, err := tsParser.ParseString(ctx, old, content)
 	if err != nil {
 		return nil, fmt.Errorf("dsl parser: failed to parse: %w", err)
 	}
@@ -226,11 +304,13 @@ type parseContext struct {
 	alloc           *node.Allocator
 	cursors         []*sitter.TreeCursor
 	batchChildren   []batchChildInfo
+	flatNodes       []flatNode
 	patternMatcher  *mapping.PatternMatcher
 	language        string
 	mappingRules    []mapping.Rule
 	ruleIndex       map[string]int
 	symbolNames     []string
+	symbolRules     []*mapping.Rule
 	internedTypes   map[string]node.Type
 	internedRoles   map[string]node.Role
 	interner        map[string]string
@@ -247,6 +327,7 @@ func (parser *DSLParser) acquireParseContext(tree *sitter.Tree, content []byte)
 		pctx = pooled
 		clear(pctx.interner)
 		pctx.batchChildren = pctx.batchChildren[:0]
+		pctx.flatNodes = pctx.flatNodes[:0]
 		pctx.cursors = pctx.cursors[:0]
 	} else {
 		pctx = &parseContext{
@@ -261,6 +342,7 @@ func (parser *DSLParser) acquireParseContext(tree *sitter.Tree, content []byte)
 	pctx.mappingRules = parser.mappingRules
 	pctx.ruleIndex = parser.ruleIndex
 	pctx.symbolNames = parser.symbolNames
+	pctx.symbolRules = parser.symbolRules
 	pctx.internedTypes = parser.internedTypes
 	pctx.internedRoles = parser.internedRoles
 	pctx.patternMatcher = parser.patternMatcher
@@ -327,7 +409,7 @@ func (ctx *parseContext) nodeType(root sitter.Node) string {
 // toCanonicalNode converts a tree-sitter node to a canonical UAST Node.
 func (ctx *parseContext) toCanonicalNode(root sitter.Node, parentContext string) *node.Node {
 	nodeType := ctx.nodeType(root)
-	mappingRule := ctx.findMappingRule(nodeType)
+	mappingRule := ctx.nodeRule(root, nodeType)
 
 	children := ctx.processChildren(root, mappingRule)
 	if ctx.shouldSkipNode(root, mappingRule) {
@@ -341,12 +423,176 @@ func (ctx *parseContext) toCanonicalNode(root sitter.Node, parentContext string)
 	var roles []node.Role
 
 	if mappingRule != nil {
-		return ctx.createMappedNode(root, mappingRule, children, roles)
+		return ctx.createMappedNode(root, mappingRule, children, roles, ctx.extractPositions(root))
 	}
 
 	return ctx.createUnmappedNode(root, parentContext, nodeType, roles)
 }
 
+// flatten walks the whole tree under root in one C call and stores it in
+// ctx.flatNodes, growing the reused buffer once if it is too small.
+// Returns false if the tree could not be flattened.
+func (ctx *parseContext) flatten(root sitter.Node) bool {
+	nodes := ctx.flatNodes[:cap(ctx.flatNodes)]
+	if len(nodes) == 0 {
+		nodes = make([]flatNode, initialFlatNodesBuffer)
+	}
+
+	total, ok := flattenSubtree(unsafe.Pointer(&root), nodes)
+	if ok && int(total) > len(nodes) {
+		nodes = make([]flatNode, total)
+		total, ok = flattenSubtree(unsafe.Pointer(&root), nodes)
+	}
+
+	if !ok || total == 0 || int(total) > len(nodes) {
+		return false
+	}
+
+	ctx.flatNodes = nodes[:total]
+
+	return true
+}
+
+// toCanonicalFlat is toCanonicalNode over ctx.flatNodes: child iteration,
+// node types, positions and leaf text come from the flattened entries, so
+// only pattern, condition and field lookups still cross into tree-sitter.
+func (ctx *parseContext) toCanonicalFlat(idx uint32, parentContext string) *node.Node {
+	entry := &ctx.flatNodes[idx]
+	root := flatToNode(entry)
+	nodeType := ctx.flatNodeType(entry)
+	mappingRule := ctx.flatRule(entry)
+
+	children := ctx.processFlatChildren(idx, nodeType, mappingRule)
+	if ctx.shouldSkipNode(root, mappingRule) {
+		return nil
+	}
+
+	if ctx.shouldSkipEmptyFile(nodeType, children) {
+		return nil
+	}
+
+	var roles []node.Role
+
+	if mappingRule != nil {
+		return ctx.createMappedNode(root, mappingRule, children, roles, ctx.flatPositions(entry))
+	}
+
+	mappedChildren := ctx.processUnmappedFlatChildren(idx, parentContext)
+
+	if ctx.includeUnmapped {
+		var token string
+		if entry.child_count == 0 {
+			token = ctx.internText(uint(entry.start_byte), uint(entry.end_byte))
+		}
+
+		return ctx.createIncludeUnmappedNode(nodeType, token, ctx.flatPositions(entry), mappedChildren, roles)
+	}
+
+	return ctx.createSyntheticNode(mappedChildren)
+}
+
+// flatNodeType resolves the type of a flattened node from its symbol,
+// falling back to the CGO Type() path for symbols without a name.
+func (ctx *parseContext) flatNodeType(entry *flatNode) string {
+	symbolIndex := int(entry.symbol)
+	if symbolIndex < len(ctx.symbolNames) {
+		symbolName := ctx.symbolNames[symbolIndex]
+		if symbolName != "" {
+			return symbolName
+		}
+	}
+
+	return flatToNode(entry).Type()
+}
+
+// flatRule returns the mapping rule of a flattened node from the per-symbol
+// table, falling back to the lookup by type name for unnamed symbols.
+func (ctx *parseContext) flatRule(entry *flatNode) *mapping.Rule {
+	if rule, ok := ctx.symbolRule(uint16(entry.symbol)); ok {
+		return rule
+	}
+
+	return ctx.findMappingRule(ctx.flatNodeType(entry))
+}
+
+// symbolRule returns the mapping rule of a grammar symbol, which may be nil.
+// ok is false for symbols outside the table or without a name.
+func (ctx *parseContext) symbolRule(symbol uint16) (rule *mapping.Rule, ok bool) {
+	symbolIndex := int(symbol)
+	if symbolIndex >= len(ctx.symbolRules) || ctx.symbolNames[symbolIndex] == "" {
+		return nil, false
+	}
+
+	return ctx.symbolRules[symbolIndex], true
+}
+
+// flatPositions converts the positions of a flattened node.
+func (ctx *parseContext) flatPositions(entry *flatNode) *node.Positions {
+	return ctx.alloc.NewPositions(
+		uint(entry.start_row)+1,
+		uint(entry.start_col)+1,
+		uint(entry.start_byte),
+		uint(entry.end_row)+1,
+		uint(entry.end_col)+1,
+		uint(entry.end_byte),
+	)
+}
+
+// processFlatChildren is processChildren over the named children of the
+// flattened node at idx.
+func (ctx *parseContext) processFlatChildren(idx uint32, nodeType string, mappingRule *mapping.Rule) []*node.Node {
+	entry := &ctx.flatNodes[idx]
+	children := make([]*node.Node, 0, entry.named_child_count)
+
+	childParentCtx := nodeType
+	if mappingRule != nil && mappingRule.UASTSpec.Type != "" {
+		childParentCtx = mappingRule.UASTSpec.Type
+	}
+
+	for child := idx + 1; child < uint32(entry.subtree_end); child = uint32(ctx.flatNodes[child].subtree_end) {
+		childEntry := &ctx.flatNodes[child]
+
+		if mappingRule != nil && ctx.failsChildRule(flatToNode(childEntry), ctx.flatRule(childEntry)) {
+			continue
+		}
+
+		canonical := ctx.toCanonicalFlat(child, childParentCtx)
+		if canonical != nil {
+			children = append(children, canonical)
+		}
+	}
+
+	return children
+}
+
+// processUnmappedFlatChildren is processUnmappedChildren over the named
+// children of the flattened node at idx.
+func (ctx *parseContext) processUnmappedFlatChildren(idx uint32, parentContext string) []*node.Node {
+	var mappedChildren []*node.Node
+
+	end := uint32(ctx.flatNodes[idx].subtree_end)
+
+	for child := idx + 1; child < end; child = uint32(ctx.flatNodes[child].subtree_end) {
+		canonical := ctx.toCanonicalFlat(child, parentContext)
+		if canonical != nil {
+			mappedChildren = append(mappedChildren, canonical)
+		}
+	}
+
+	return mappedChildren
+}
+
+// nodeRule returns the mapping rule of root from the per-symbol table when
+// its symbol can be read without CGO, else by its type name.
+func (ctx *parseContext) nodeRule(root sitter.Node, nodeType string) *mapping.Rule {
+	symbolIndex := int(readSymbol(unsafe.Pointer(&root)))
+	if symbolIndex < len(ctx.symbolRules) && ctx.symbolNames[symbolIndex] == nodeType {
+		return ctx.symbolRules[symbolIndex]
+	}
+
+	return ctx.findMappingRule(nodeType)
+}
+
 // findMappingRule finds a mapping rule for the given node type, resolving inheritance and merging fields.
 func (ctx *parseContext) findMappingRule(nodeType string) *mapping.Rule {
 	idx, ok := ctx.ruleIndex[nodeType]
@@ -359,16 +605,21 @@ func (ctx *parseContext) findMappingRule(nodeType string) *mapping.Rule {
 
 // resolveInheritance recursively merges base rule fields if Extends is set.
 func (ctx *parseContext) resolveInheritance(rule *mapping.Rule) *mapping.Rule {
+	return resolveRuleInheritance(ctx.mappingRules, ctx.ruleIndex, rule)
+}
+
+// resolveRuleInheritance recursively merges base rule fields if Extends is set.
+func resolveRuleInheritance(rules []mapping.Rule, ruleIndex map[string]int, rule *mapping.Rule) *mapping.Rule {
 	if rule.Extends == "" {
 		return rule
 	}
 
-	baseIdx, ok := ctx.ruleIndex[rule.Extends]
+	baseIdx, ok := ruleIndex[rule.Extends]
 	if !ok {
 		return rule
 	}
 
-	base := &ctx.mappingRules[baseIdx]
+	base := &rules[baseIdx]
 
 	merged := *base // Shallow copy.
 
@@ -406,7 +657,7 @@ func (ctx *parseContext) resolveInheritance(rule *mapping.Rule) *mapping.Rule {
 	}
 
 	// Recursively resolve further inheritance.
-	return ctx.resolveInheritance(&merged)
+	return resolveRuleInheritance(rules, ruleIndex, &merged)
 }
 
 // cursorThreshold is the minimum named child count at which cursor-based
@@ -517,7 +768,7 @@ func (ctx *parseContext) processChildrenBatch(
 			return ctx.processChildrenCursor(root, mappingRule, children)
 		}
 
-		if ctx.shouldExcludeChild(child, mappingRule) {
+		if mappingRule != nil && ctx.shouldExcludeBatchChild(child, uint16(batchChildren[idx].symbol)) {
 			continue
 		}
 
@@ -532,6 +783,17 @@ func (ctx *parseContext) processChildrenBatch(
 	return children
 }
 
+// shouldExcludeBatchChild is shouldExcludeChild for a batch child, using the
+// symbol the batch call already read.
+func (ctx *parseContext) shouldExcludeBatchChild(child sitter.Node, symbol uint16) bool {
+	childRule, ok := ctx.symbolRule(symbol)
+	if !ok {
+		childRule = ctx.findMappingRule(ctx.nodeType(child))
+	}
+
+	return ctx.failsChildRule(child, childRule)
+}
+
 // deriveParentContext computes the parent context string for child nodes.
 func (ctx *parseContext) deriveParentContext(root sitter.Node, mappingRule *mapping.Rule) string {
 	if mappingRule != nil && mappingRule.UASTSpec.Type != "" {
@@ -719,7 +981,12 @@ func (ctx *parseContext) shouldExcludeChild(child sitter.Node, mappingRule *mapp
 		return false
 	}
 
-	childRule := ctx.findMappingRule(ctx.nodeType(child))
+	return ctx.failsChildRule(child, ctx.nodeRule(child, ctx.nodeType(child)))
+}
+
+// failsChildRule checks whether child fails the conditions of its own
+// mapping rule.
+func (ctx *parseContext) failsChildRule(child sitter.Node, childRule *mapping.Rule) bool {
 	if childRule == nil {
 		return false
 	}
@@ -735,7 +1002,7 @@ func (ctx *parseContext) shouldSkipEmptyFile(nodeType string, children []*node.N
 // createMappedNode creates a UAST node from a mapped Tree-sitter node.
 func (ctx *parseContext) createMappedNode(
 	root sitter.Node, mappingRule *mapping.Rule,
-	children []*node.Node, roles []node.Role,
+	children []*node.Node, roles []node.Role, pos *node.Positions,
 ) *node.Node {
 	ctx.extractRoles(mappingRule, &roles)
 
@@ -756,7 +1023,7 @@ func (ctx *parseContext) createMappedNode(
 
 	uastNode := ctx.alloc.NewNode(
 		"", nodeType,
-		ctx.extractTokenText(root, mappingRule), roles, ctx.extractPositions(root), props,
+		ctx.extractTokenText(root, mappingRule), roles, pos, props,
 	)
 	uastNode.Children = children
 
@@ -1009,7 +1276,7 @@ func (ctx *parseContext) createUnmappedNode(root sitter.Node, parentContext, nod
 	mappedChildren := ctx.processUnmappedChildren(root, parentContext)
 
 	if ctx.includeUnmapped {
-		return ctx.createIncludeUnmappedNode(root, nodeType, mappedChildren, roles)
+		return ctx.createIncludeUnmappedNode(nodeType, ctx.tokenText(root), ctx.extractPositions(root), mappedChildren, roles)
 	}
 
 	return ctx.createSyntheticNode(mappedChildren)
@@ -1076,12 +1343,12 @@ func (ctx *parseContext) processUnmappedChildrenCursor(root sitter.Node, parentC
 
 // createIncludeUnmappedNode creates a node when IncludeUnmapped is true.
 func (ctx *parseContext) createIncludeUnmappedNode(
-	root sitter.Node, nodeType string,
+	nodeType, token string, pos *node.Positions,
 	mappedChildren []*node.Node, roles []node.Role,
 ) *node.Node {
 	uastNode := ctx.alloc.NewNode(
 		"", node.Type(ctx.language+":"+nodeType),
-		ctx.tokenText(root), roles, ctx.extractPositions(root), nil,
+		token, roles, pos, nil,
 	)
 	uastNode.Children = mappedChildren
 
@@ -1195,9 +1462,11 @@ func (ctx *parseContext) computeChildrenSpan(children []*node.Node) *node.Positi
 // Short strings (≤ maxInternLen) are interned within the current parse to
 // deduplicate repeated identifiers, keywords, and operators.
 func (ctx *parseContext) extractNodeText(tsNode sitter.Node) string {
-	start := tsNode.StartByte()
-	end := tsNode.EndByte()
+	return ctx.internText(tsNode.StartByte(), tsNode.EndByte())
+}
 
+// internText returns an allocated, interned copy of source[start:end].
+func (ctx *parseContext) internText(start, end uint) string {
 	if safeconv.MustUintToInt(end) <= len(ctx.source) {
 		s := string(ctx.source[start:end])
 
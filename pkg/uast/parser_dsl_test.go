@@ -3,6 +3,7 @@ package uast
 import (
 	"context"
 	"os"
+	"reflect"
 	"slices"
 	"strings"
 	"testing"
@@ -1158,6 +1159,11 @@ func f9() { fmt.Println("9") }
 						n.Type(), idx, child.Type(), expectedTypes[idx])
 				}
 
+				if parser.symbolNames[batchChildren[idx].symbol] != expectedTypes[idx] {
+					t.Errorf("node %q child[%d]: symbol %d resolves to %q, want %q",
+						n.Type(), idx, batchChildren[idx].symbol, parser.symbolNames[batchChildren[idx].symbol], expectedTypes[idx])
+				}
+
 				if uint32(batchChildren[idx].named_child_count) != expectedNamedCounts[idx] {
 					t.Errorf("node %q child[%d]: namedChildCount mismatch: batch=%d cursor=%d",
 						n.Type(), idx, batchChildren[idx].named_child_count, expectedNamedCounts[idx])
@@ -1179,6 +1185,220 @@ func f9() { fmt.Println("9") }
 	}
 }
 
+// TestFlattenSubtree_MatchesNamedChildren verifies that the flattened tree
+// lists the same named nodes, in pre-order, as NamedChild traversal.
+func TestFlattenSubtree_MatchesNamedChildren(t *testing.T) {
+	t.Parallel()
+
+	parser := NewDSLParser(strings.NewReader(`[language "go", extensions: ".go"]
+
+source_file <- (source_file) => uast(
+    type: "File",
+    roles: "Module"
+)
+`))
+
+	loadErr := parser.Load()
+	if loadErr != nil {
+		t.Fatalf("Failed to load DSL: %v", loadErr)
+	}
+
+	source := []byte(`package main
+
+import "fmt"
+
+type Point struct{ X, Y int }
+
+func (p Point) Sum() int { return p.X + p.Y }
+
+func main() {
+	for i := range 3 {
+		fmt.Println(Point{X: i, Y: i * 2}.Sum())
+	}
+}
+`)
+
+	tree, err := parser.parseTSTree(context.Background(), source)
+	if err != nil {
+		t.Fatalf("Failed to parse tree: %v", err)
+	}
+	defer tree.Close()
+
+	root := tree.RootNode()
+
+	// A one-entry buffer forces the grow-and-retry path.
+	nodes := make([]flatNode, 1)
+
+	total, ok := flattenSubtree(unsafe.Pointer(&root), nodes)
+	if !ok || int(total) <= len(nodes) {
+		t.Fatalf("Expected a short buffer to report the full count, got total=%d ok=%v", total, ok)
+	}
+
+	nodes = make([]flatNode, total)
+
+	written, ok := flattenSubtree(unsafe.Pointer(&root), nodes)
+	if !ok || written != total {
+		t.Fatalf("Expected %d entries, got %d ok=%v", total, written, ok)
+	}
+
+	next := uint32(0)
+
+	var walkAndCheck func(n sitter.Node, parent uint32)
+
+	walkAndCheck = func(n sitter.Node, parent uint32) {
+		idx := next
+		next++
+
+		if idx >= total {
+			t.Fatalf("Flattened tree has fewer entries than named nodes: %d", total)
+		}
+
+		entry := &nodes[idx]
+		got := flatToNode(entry)
+
+		if got.Type() != n.Type() || uint(entry.start_byte) != n.StartByte() || uint(entry.end_byte) != n.EndByte() {
+			t.Errorf("entry %d: got %q [%d,%d), want %q [%d,%d)",
+				idx, got.Type(), entry.start_byte, entry.end_byte, n.Type(), n.StartByte(), n.EndByte())
+		}
+
+		if parser.symbolNames[entry.symbol] != n.Type() {
+			t.Errorf("entry %d: symbol %d resolves to %q, want %q", idx, entry.symbol, parser.symbolNames[entry.symbol], n.Type())
+		}
+
+		if uint32(entry.parent) != parent {
+			t.Errorf("entry %d (%q): parent %d, want %d", idx, n.Type(), entry.parent, parent)
+		}
+
+		if uint32(entry.named_child_count) != n.NamedChildCount() || uint32(entry.child_count) != n.ChildCount() {
+			t.Errorf("entry %d (%q): child counts %d/%d, want %d/%d", idx, n.Type(),
+				entry.named_child_count, entry.child_count, n.NamedChildCount(), n.ChildCount())
+		}
+
+		for childIdx := range n.NamedChildCount() {
+			walkAndCheck(n.NamedChild(childIdx), idx)
+		}
+
+		if uint32(entry.subtree_end) != next {
+			t.Errorf("entry %d (%q): subtree_end %d, want %d", idx, n.Type(), entry.subtree_end, next)
+		}
+	}
+
+	walkAndCheck(root, flatNoParent)
+
+	if next != total {
+		t.Errorf("Expected %d named nodes, flattened %d", next, total)
+	}
+}
+
+// TestSymbolRules_MatchFindMappingRule verifies that the per-symbol rule table
+// resolves the same rules, inheritance included, as the lookup by type name.
+func TestSymbolRules_MatchFindMappingRule(t *testing.T) {
+	t.Parallel()
+
+	parser := NewDSLParser(strings.NewReader(`[language "go", extensions: ".go"]
+
+function_declaration <- (function_declaration name: (identifier) @name) => uast(
+    type: "Function",
+    roles: "Declaration", "Function",
+    name: "@name"
+)
+
+method_declaration <- (method_declaration) => uast(
+    type: "Method"
+) # Extends function_declaration
+
+identifier <- (identifier) => uast(
+    type: "Identifier"
+)
+`))
+
+	loadErr := parser.Load()
+	if loadErr != nil {
+		t.Fatalf("Failed to load DSL: %v", loadErr)
+	}
+
+	ctx := parser.newParseContext(nil, nil)
+	mapped := 0
+
+	for symbolID, name := range parser.symbolNames {
+		if name == "" {
+			continue
+		}
+
+		got := parser.symbolRules[symbolID]
+		want := ctx.findMappingRule(name)
+
+		if (got == nil) != (want == nil) {
+			t.Fatalf("symbol %d (%q): table rule %v, lookup rule %v", symbolID, name, got, want)
+		}
+
+		if got == nil {
+			continue
+		}
+
+		mapped++
+
+		if !reflect.DeepEqual(*got, *want) {
+			t.Errorf("symbol %d (%q): table rule differs from lookup", symbolID, name)
+		}
+	}
+
+	if mapped < 3 {
+		t.Errorf("Expected every mapped type to have a symbol rule, got %d", mapped)
+	}
+
+	if rule := parser.symbolRules[0]; rule != nil {
+		t.Errorf("Expected no rule for the end symbol, got %q", rule.Name)
+	}
+}
+
+// TestParse_FlatMatchesNodeWalk verifies that mapping over the flattened tree
+// builds the same UAST as the per-node walk.
+func TestParse_FlatMatchesNodeWalk(t *testing.T) {
+	t.Parallel()
+
+	for _, includeUnmapped := range []bool{false, true} {
+		mappingFile, err := os.Open("uastmaps/go.uastmap")
+		if err != nil {
+			t.Fatalf("Failed to open go mapping: %v", err)
+		}
+
+		parser := NewDSLParser(mappingFile)
+		parser.IncludeUnmapped = includeUnmapped
+
+		loadErr := parser.Load()
+		mappingFile.Close()
+
+		if loadErr != nil {
+			t.Fatalf("Failed to load DSL: %v", loadErr)
+		}
+
+		source, err := os.ReadFile("parser_dsl.go")
+		if err != nil {
+			t.Fatalf("Failed to read source: %v", err)
+		}
+
+		flat, err := parser.Parse(context.Background(), "parser_dsl.go", source)
+		if err != nil {
+			t.Fatalf("Parse failed: %v", err)
+		}
+
+		tree, err := parser.parseTSTree(context.Background(), source)
+		if err != nil {
+			t.Fatalf("Failed to parse tree: %v", err)
+		}
+
+		ctx := parser.newParseContext(tree, source)
+		walked := ctx.toCanonicalNode(tree.RootNode(), "")
+
+		tree.Close()
+
+		if !reflect.DeepEqual(flat, walked) {
+			t.Errorf("IncludeUnmapped=%v: flattened parse differs from per-node walk", includeUnmapped)
+		}
+	}
+}
+
 // TestDSLProvider_NameExtractionWithoutChildTypeFallback verifies that name extraction
 // works via ChildByFieldName (the field API) and that nodes without a "name" field
 // correctly get no name property — without relying on child-type scanning fallback.